@@ -0,0 +1,180 @@
+/*
+    LZ4 HC - High Compression Mode of LZ4
+
+   BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ *  Hash chain match finder for the single-shot lz4hc.h API, see lz4hc.h.
+ *  For each position it looks for the longest match in the whole 64KB window
+ *  (up to 2^(level-1) candidates) and defers a match if the next position starts a longer one.
+ */
+
+#include "lz4hc.h"
+#include <stdlib.h>   /* malloc, free */
+#include <string.h>   /* memcpy, memset */
+
+
+/* format rules, see doc/lz4_Block_format.md */
+#define LZ4HC_MINMATCH       4
+#define LZ4HC_MFLIMIT       12   /* the last match starts at least 12 bytes before the end */
+#define LZ4HC_LASTLITERALS   5   /* the last 5 bytes are always literals */
+#define LZ4HC_MAX_DISTANCE  (LZ4HC_MAXD - 1)
+
+
+static unsigned LZ4HC_hash(const unsigned char* ptr)
+{
+    unsigned v;
+    memcpy(&v, ptr, sizeof(v));
+    return (v * 2654435761U) >> (32 - LZ4HC_HASH_LOG);
+}
+
+static void LZ4HC_insert(LZ4HC_CCtx_internal* ctx, const unsigned char* src, int pos)
+{
+    unsigned const h = LZ4HC_hash(src + pos);
+    int const prev = ctx->hashTable[h];
+    unsigned const delta = prev < 0 ? 0 : (unsigned)(pos - prev);
+    ctx->chainTable[pos & LZ4HC_MAXD_MASK] = (unsigned short)(delta > LZ4HC_MAX_DISTANCE ? 0 : delta);
+    ctx->hashTable[h] = pos;
+}
+
+/* returns length of the longest match of `pos`, 0 if there is none */
+static int LZ4HC_findMatch(const LZ4HC_CCtx_internal* ctx, const unsigned char* src, int pos, int matchLimit, int maxAttempts, int* matchPos)
+{
+    int best = 0;
+    int candidate = ctx->hashTable[LZ4HC_hash(src + pos)];
+    int attempts;
+    for (attempts = 0; candidate >= 0 && attempts < maxAttempts; ++attempts) {
+        unsigned short delta;
+        if (pos - candidate > LZ4HC_MAX_DISTANCE) break;
+        /* it can be longer than the best one only if it matches at the best one's length */
+        if (src[candidate + best] == src[pos + best]) {
+            int len = 0;
+            while (pos + len < matchLimit && src[candidate + len] == src[pos + len]) ++len;
+            if (len > best) {
+                best = len;
+                *matchPos = candidate;
+                if (pos + len == matchLimit) break;
+            }
+        }
+        delta = ctx->chainTable[candidate & LZ4HC_MAXD_MASK];
+        if (delta == 0) break;
+        candidate -= delta;
+    }
+    return best >= LZ4HC_MINMATCH ? best : 0;
+}
+
+/* writes bytes of `len` which do not fit in token, returns the token part */
+static unsigned char LZ4HC_writeLength(unsigned char** op, unsigned len)
+{
+    if (len < 15) return (unsigned char)len;
+    len -= 15;
+    for (; len >= 255; len -= 255) *(*op)++ = 255;
+    *(*op)++ = (unsigned char)len;
+    return 15;
+}
+
+int LZ4_sizeofStateHC(void) { return (int)sizeof(LZ4_streamHC_t); }
+
+int LZ4_compress_HC_extStateHC(void* stateHC, const char* source, char* dest, int srcSize, int maxDstSize, int compressionLevel)
+{
+    LZ4HC_CCtx_internal* const ctx = &((LZ4_streamHC_t*)stateHC)->internal_donotuse;
+    const unsigned char* const src = (const unsigned char*)source;
+    unsigned char* op = (unsigned char*)dest;
+    unsigned char* const oend = op + maxDstSize;
+    unsigned char* token;
+    int maxAttempts;
+    int anchor = 0;
+    unsigned literals;
+
+    if (((size_t)stateHC & (sizeof(void*) - 1)) != 0) return 0;   /* state must be aligned */
+    if ((unsigned)srcSize > (unsigned)LZ4_MAX_INPUT_SIZE || maxDstSize <= 0) return 0;
+    if (compressionLevel < 1) compressionLevel = LZ4HC_CLEVEL_DEFAULT;
+    if (compressionLevel > LZ4HC_CLEVEL_MAX) compressionLevel = LZ4HC_CLEVEL_MAX;
+    maxAttempts = 1 << (compressionLevel - 1);
+    memset(ctx->hashTable, 0xff, sizeof(ctx->hashTable));
+
+    if (srcSize > LZ4HC_MFLIMIT) {
+        int const mfLimit = srcSize - LZ4HC_MFLIMIT;
+        int const matchLimit = srcSize - LZ4HC_LASTLITERALS;
+        int nextInsert = 0;
+        int pos = 0;
+        while (pos < mfLimit) {
+            int matchPos = 0;
+            int len;
+            unsigned offset;
+            for (; nextInsert < pos; ++nextInsert) LZ4HC_insert(ctx, src, nextInsert);
+            len = LZ4HC_findMatch(ctx, src, pos, matchLimit, maxAttempts, &matchPos);
+            if (len == 0) {
+                ++pos;
+                continue;
+            }
+
+            /* lazy matching */
+            while (pos + 1 < mfLimit) {
+                int nextMatchPos = 0;
+                int nextLen;
+                LZ4HC_insert(ctx, src, pos);
+                nextInsert = pos + 1;
+                nextLen = LZ4HC_findMatch(ctx, src, pos + 1, matchLimit, maxAttempts, &nextMatchPos);
+                if (nextLen <= len) break;
+                ++pos;
+                len = nextLen;
+                matchPos = nextMatchPos;
+            }
+
+            literals = (unsigned)(pos - anchor);
+            if ((size_t)(oend - op) < 2 + literals / 255 + literals + 2 + 1 + (unsigned)len / 255) return 0;
+            token = op++;
+            *token = (unsigned char)(LZ4HC_writeLength(&op, literals) << 4);
+            memcpy(op, src + anchor, literals);
+            op += literals;
+            offset = (unsigned)(pos - matchPos);
+            *op++ = (unsigned char)offset;
+            *op++ = (unsigned char)(offset >> 8);
+            *token |= LZ4HC_writeLength(&op, (unsigned)(len - LZ4HC_MINMATCH));
+            pos += len;
+            anchor = pos;
+        }
+    }
+
+    literals = (unsigned)(srcSize - anchor);
+    if ((size_t)(oend - op) < 2 + literals / 255 + literals) return 0;
+    token = op++;
+    *token = (unsigned char)(LZ4HC_writeLength(&op, literals) << 4);
+    if (literals > 0) memcpy(op, src + anchor, literals);
+    op += literals;
+    return (int)(op - (unsigned char*)dest);
+}
+
+int LZ4_compress_HC(const char* src, char* dst, int srcSize, int dstCapacity, int compressionLevel)
+{
+    int result;
+    LZ4_streamHC_t* const state = (LZ4_streamHC_t*)malloc(sizeof(LZ4_streamHC_t));
+    if (state == NULL) return 0;
+    result = LZ4_compress_HC_extStateHC(state, src, dst, srcSize, dstCapacity, compressionLevel);
+    free(state);
+    return result;
+}
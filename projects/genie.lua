@@ -20,6 +20,7 @@ local ROOT_DIR = path.getabsolute("../")
 local BINARY_DIR = LOCATION .. "/bin/"
 build_app = false
 local use_basisu = false
+local use_gpu_null = false
 build_studio = true
 local working_dir = nil
 local debug_args = nil
@@ -57,6 +58,8 @@ function linkPlugin(plugin_name)
 	if build_studio then
 		project "studio"
 			links(plugin_name)
+		project "lumix_compile"
+			links(plugin_name)
 	end
 
 	if build_app then
@@ -120,6 +123,11 @@ newoption {
 	description = "Do build app."
 }
 
+newoption {
+	trigger = "gpu-null",
+	description = "Use null GPU backend, which renders nothing, e.g. for benchmarks. Engine still creates a window, on servers run it in Xvfb (xvfb-run); only app -replay_draw_streams with -replay_headless runs without X."
+}
+
 newoption {
 	trigger = "with-basis-universal",
 	description = "Use basis universal compression."
@@ -247,6 +255,10 @@ if _OPTIONS["with-basis-universal"] then
 	use_basisu = true
 end
 
+if _OPTIONS["gpu-null"] then
+	use_gpu_null = true
+end
+
 function detect_plugins()
 	local plugins_dirs = os.matchdirs("../plugins/*")
 	for k, plugin_dir in ipairs(plugins_dirs) do
@@ -580,6 +592,12 @@ if has_plugin("renderer") then
 			"../external/meshoptimizer/vfetchoptimizer.cpp",
 			"../src/renderer/editor/voxelizer_ui.cpp"
 		}
+		if use_gpu_null then
+			defines { "LUMIX_GPU_NULL" }
+			excludes { "../src/renderer/gpu/gpu_gl.cpp" }
+		else
+			excludes { "../src/renderer/gpu/gpu_null.cpp" }
+		end
 		
 		if build_studio then
 			files {
@@ -908,34 +926,8 @@ if build_studio then
 		useLua()
 		defaultConfigurations()
 
-	project "studio"
-		kind "WindowedApp"
-
-		if debug_args then
-			configuration { "Debug" }
-				debugargs { debug_args }
-			configuration {}
-		end
-		if release_args then
-			configuration { "RelWithDebInfo" }
-				debugargs { release_args }
-			configuration {}
-		end
-		
-		if working_dir then
-			debugdir ("../../" .. working_dir)
-		else
-			debugdir "../data"
-		end
-
-		files { "../src/studio/**.cpp" }
-
-		dbgHelp()
-
-		if embed_resources then
-			files { "../src/studio/**.rc" }
-		end
-
+	-- linked by both studio and lumix_compile
+	function linkStudio()
 		includedirs { "../src" }
 
 		if not _OPTIONS["dynamic-plugins"] then	
@@ -947,7 +939,7 @@ if build_studio then
 
 			configuration { "vs*" }
 				links { "psapi", "dxguid", "winmm" }
-			
+		
 			configuration {}
 
 			links { "editor", "engine" }
@@ -957,7 +949,7 @@ if build_studio then
 			linkLib "freetype"
 			useLua()
 			linkLib "recast"
-			
+		
 			if has_plugin("renderer") then
 				linkOpenGL()
 			end
@@ -987,6 +979,52 @@ if build_studio then
 		
 		useLua()
 		defaultConfigurations()
+	end
+
+	project "studio"
+		kind "WindowedApp"
+
+		if debug_args then
+			configuration { "Debug" }
+				debugargs { debug_args }
+			configuration {}
+		end
+		if release_args then
+			configuration { "RelWithDebInfo" }
+				debugargs { release_args }
+			configuration {}
+		end
+		
+		if working_dir then
+			debugdir ("../../" .. working_dir)
+		else
+			debugdir "../data"
+		end
+
+		files { "../src/studio/**.cpp" }
+
+		dbgHelp()
+
+		if embed_resources then
+			files { "../src/studio/**.rc" }
+		end
+
+		linkStudio()
+
+	-- compiles all outdated assets without GUI, e.g. on build machines, see StudioApp::runBatchCompile
+	project "lumix_compile"
+		kind "ConsoleApp"
+
+		if working_dir then
+			debugdir ("../../" .. working_dir)
+		else
+			debugdir "../data"
+		end
+
+		files { "../src/compile/main.cpp" }
+
+		dbgHelp()
+		linkStudio()
 end
 
 if force_build_physx == true then
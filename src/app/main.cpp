@@ -19,6 +19,9 @@
 #include "engine/world.h"
 #include "gui/gui_system.h"
 #include "lua_script/lua_script_system.h"
+#include "engine/stream.h"
+#include "renderer/draw_stream.h"
+#include "renderer/gpu/gpu.h"
 #include "renderer/pipeline.h"
 #include "renderer/render_module.h"
 #include "renderer/renderer.h"
@@ -45,6 +48,17 @@ struct GUIInterface : GUISystem::Interface {
 };
 
 
+static bool isCommandLineOption(const char* option) {
+	char cmd_line[2048];
+	os::getCommandLine(Span(cmd_line));
+
+	CommandLineParser parser(cmd_line);
+	while (parser.next()) {
+		if (parser.currentEquals(option)) return true;
+	}
+	return false;
+}
+
 struct Runner final
 {
 	Runner() 
@@ -113,6 +127,10 @@ struct Runner final
 		OutputMemoryStream data(m_allocator);
 		if (!fs.getContentSync(Path(path), data)) return false;
 
+		// read all files the world needs in parallel, instead of discovering them one dependency at a time
+		OutputMemoryStream manifest(m_allocator);
+		if (fs.getContentSync(FileSystem::getLoadOrderPath(Path(path)), manifest)) fs.prefetch(manifest);
+
 		InputMemoryStream blob(data);
 		EntityMap entity_map(m_allocator);
 
@@ -124,18 +142,6 @@ struct Runner final
 		return true;
 	}
 
-	static bool isWindowCommandLineOption() {
-		char cmd_line[2048];
-		os::getCommandLine(Span(cmd_line));
-
-		CommandLineParser parser(cmd_line);
-		while (parser.next())
-		{
-			if (parser.currentEquals("-window")) return true;
-		}
-		return false;
-	}
-
 	void loadProject() {
 		FileSystem& fs = m_engine->getFileSystem();
 		OutputMemoryStream data(m_allocator);
@@ -151,15 +157,17 @@ struct Runner final
 	void onInit() {
 		Engine::InitArgs init_data;
 		init_data.init_window_args.name = "Lumix App";
+		// read files with io_uring, linux only, used only for unpacked data
+		init_data.file_system_io_uring = isCommandLineOption("-io_uring");
 
 		if (os::fileExists("main.pak")) {
-			init_data.file_system = FileSystem::createPacked("main.pak", m_allocator);
+			init_data.file_system = FileSystem::createPacked("main.pak", m_allocator, init_data.file_system_threads_count);
 		}
 
 		m_engine = Engine::create(static_cast<Engine::InitArgs&&>(init_data), m_allocator);
 		m_engine->init();
 		
-		if (!isWindowCommandLineOption()) {
+		if (!isCommandLineOption("-window")) {
 			os::setFullscreen(m_engine->getWindowHandle());
 			captureMouse(true);
 		}
@@ -182,6 +190,11 @@ struct Runner final
 			m_engine->getFileSystem().processCallbacks();
 		}
 		m_engine->getFileSystem().processCallbacks();
+		m_engine->getFileSystem().stopPrefetch();
+		const FileSystem::PrefetchStats prefetch_stats = m_engine->getFileSystem().getPrefetchStats();
+		if (prefetch_stats.prefetched > 0) {
+			logInfo("Prefetch: ", prefetch_stats.hits, " hits, ", prefetch_stats.misses, " misses, ", prefetch_stats.unused, " unused");
+		}
 
 		os::showCursor(false);
 		onResize();
@@ -266,9 +279,214 @@ struct Runner final
 	GUIInterface m_gui_interface;
 };
 
+// loads all files in the current directory with threads and with io_uring (if available), prints cold and warm times for both
+// cold pass evicts the files from page cache first, where it's not supported (windows) both passes are warm
+// app -benchmark_fs [-io_uring], -io_uring runs io_uring first
+struct FileSystemBenchmark {
+	FileSystemBenchmark() : m_paths(m_allocator) {}
+
+	static void logToOutput(LogLevel level, const char* message) {
+		if (level == LogLevel::ERROR) debug::debugOutput("Error: ");
+		debug::debugOutput(message);
+		debug::debugOutput("\n");
+	}
+
+	void collect(const char* dir) {
+		os::FileIterator* iter = os::createFileIterator(dir[0] ? dir : ".", m_allocator);
+		if (!iter) return;
+		os::FileInfo info;
+		while (os::getNextFile(iter, &info)) {
+			if (info.filename[0] == '.') continue;
+			const Path path = dir[0] ? Path(dir, "/", info.filename) : Path(info.filename);
+			if (info.is_directory) collect(path.c_str());
+			else m_paths.push(path);
+		}
+		os::destroyFileIterator(iter);
+	}
+
+	void onLoaded(Span<const u8> data, bool success) {
+		m_bytes += data.length();
+		if (!success) ++m_failed;
+	}
+
+	bool evict() {
+		bool res = true;
+		for (const Path& path : m_paths) {
+			res = os::evictFromFileCache(path) && res;
+		}
+		return res;
+	}
+
+	void run(bool use_io_uring) {
+		char cwd[MAX_PATH];
+		os::getCurrentDirectory(Span(cwd));
+		UniquePtr<FileSystem> fs = FileSystem::create(cwd, m_allocator, Engine::InitArgs().file_system_threads_count, use_io_uring);
+		for (u32 pass = 0; pass < 2; ++pass) {
+			const bool cold = pass == 0 && evict();
+			m_bytes = 0;
+			m_failed = 0;
+			os::Timer timer;
+			for (const Path& path : m_paths) {
+				fs->getContent(path, makeDelegate<&FileSystemBenchmark::onLoaded>(this));
+			}
+			while (fs->hasWork()) fs->processCallbacks();
+			const float ms = timer.getTimeSinceStart() * 1000;
+			logInfo(use_io_uring ? "io_uring" : "threads", cold ? ", cold: " : ", warm: "
+				, m_paths.size(), " files, ", m_bytes / 1024, " KB, ", ms, " ms, ", m_failed, " failed");
+		}
+	}
+
+	static void benchmark() {
+		registerLogCallback<logToOutput>();
+		FileSystemBenchmark b;
+		b.collect("");
+		const bool io_uring_first = isCommandLineOption("-io_uring");
+		b.run(io_uring_first);
+		b.run(!io_uring_first);
+		unregisterLogCallback<logToOutput>();
+	}
+
+	DefaultAllocator m_allocator;
+	Array<Path> m_paths;
+	u64 m_bytes = 0;
+	u32 m_failed = 0;
+};
+
+// replays draw streams captured by Renderer::captureDrawStreams, without engine and world, and prints time per command type
+// app -replay_draw_streams <capture> [-replay_repeat <count>] [-replay_headless]
+// -replay_headless does not create a window, it works only with the null GPU backend (genie --gpu-null)
+// captures which use objects created before the capture can be replayed only with -replay_headless, see DrawStream::replay
+struct DrawStreamReplay {
+	static bool readFile(const char* path, OutputMemoryStream& content) {
+		os::InputFile file;
+		if (!file.open(path)) return false;
+		content.resize(file.size());
+		const bool res = file.read(content.getMutableData(), content.size());
+		file.close();
+		return res;
+	}
+
+	static int replay() {
+		registerLogCallback<FileSystemBenchmark::logToOutput>();
+		char cmd_line[2048];
+		os::getCommandLine(Span(cmd_line));
+		char path[MAX_PATH] = "";
+		char tmp[32];
+		u32 repeat = 1;
+		bool headless = false;
+		CommandLineParser parser(cmd_line);
+		while (parser.next()) {
+			if (parser.currentEquals("-replay_draw_streams")) {
+				if (!parser.next()) break;
+				parser.getCurrent(path, sizeof(path));
+			}
+			else if (parser.currentEquals("-replay_repeat")) {
+				if (!parser.next()) break;
+				parser.getCurrent(tmp, sizeof(tmp));
+				fromCString(tmp, repeat);
+			}
+			else if (parser.currentEquals("-replay_headless")) {
+				headless = true;
+			}
+		}
+
+		DefaultAllocator allocator;
+		OutputMemoryStream capture(allocator);
+		if (!readFile(path, capture)) {
+			logError("Failed to read ", path);
+			unregisterLogCallback<FileSystemBenchmark::logToOutput>();
+			return 1;
+		}
+
+		os::WindowHandle window = os::INVALID_WINDOW;
+		if (!headless) {
+			os::InitWindowArgs args;
+			args.name = "Draw stream replay";
+			window = os::createWindow(args);
+		}
+		gpu::preinit(allocator, false);
+		int exit_code = 0;
+		if (gpu::init(window, gpu::InitFlags::NONE)) {
+			DrawStream::ReplayStats stats;
+			os::Timer timer;
+			for (u32 i = 0; i < repeat; ++i) {
+				InputMemoryStream blob(capture);
+				// stand-ins are valid only in the null backend, which is the only one that works headless
+				if (!DrawStream::replay(blob, allocator, stats, headless)) {
+					exit_code = 1;
+					break;
+				}
+				gpu::swapBuffers();
+			}
+			const float total_ms = timer.getTimeSinceStart() * 1000;
+			if (exit_code == 0) print(stats, repeat, total_ms);
+			gpu::shutdown();
+		}
+		else {
+			logError("Failed to initialize GPU");
+			exit_code = 1;
+		}
+		if (window != os::INVALID_WINDOW) os::destroyWindow(window);
+		unregisterLogCallback<FileSystemBenchmark::logToOutput>();
+		return exit_code;
+	}
+
+	// app -check_draw_stream, headless, works only with the null GPU backend, see DrawStream::checkBindFiltering
+	static int checkBindFiltering() {
+		registerLogCallback<FileSystemBenchmark::logToOutput>();
+		DefaultAllocator allocator;
+		gpu::preinit(allocator, false);
+		int exit_code = 1;
+		if (gpu::init(os::INVALID_WINDOW, gpu::InitFlags::NONE)) {
+			if (DrawStream::checkBindFiltering(allocator)) {
+				logInfo("Draw stream check passed");
+				exit_code = 0;
+			}
+			gpu::shutdown();
+		}
+		else {
+			logError("Failed to initialize GPU");
+		}
+		unregisterLogCallback<FileSystemBenchmark::logToOutput>();
+		return exit_code;
+	}
+
+	// most expensive commands first
+	static void print(const DrawStream::ReplayStats& stats, u32 repeat, float total_ms) {
+		u32 order[DrawStream::ReplayStats::MAX_COMMANDS];
+		u32 count = 0;
+		for (u32 i = 0; i < DrawStream::ReplayStats::MAX_COMMANDS; ++i) {
+			if (stats.counts[i] == 0) continue;
+			u32 j = count++;
+			for (; j > 0 && stats.ticks[order[j - 1]] < stats.ticks[i]; --j) order[j] = order[j - 1];
+			order[j] = i;
+		}
+
+		const double freq = (double)os::Timer::getFrequency();
+		logInfo(repeat, " replays in ", total_ms, " ms, ", stats.stream_stats.submitted, " submitted, "
+			, stats.stream_stats.elided, " elided, ", stats.skipped_functions, " skipped functions, ", stats.stand_ins, " stand-ins");
+		for (u32 i = 0; i < count; ++i) {
+			const u32 type = order[i];
+			const float ms = float(stats.ticks[type] / freq * 1000);
+			logInfo(DrawStream::getCommandName(type), ": ", stats.counts[type], "x, ", ms, " ms, ", ms * 1000 / stats.counts[type], " us per command");
+		}
+	}
+};
+
 int main(int args, char* argv[])
 {
 	profiler::setThreadName("Main thread");
+	if (isCommandLineOption("-benchmark_fs")) {
+		FileSystemBenchmark::benchmark();
+		return 0;
+	}
+	if (isCommandLineOption("-replay_draw_streams")) {
+		return DrawStreamReplay::replay();
+	}
+	if (isCommandLineOption("-check_draw_stream")) {
+		return DrawStreamReplay::checkBindFiltering();
+	}
+
 	struct Data {
 		Data() : semaphore(0, 1) {}
 		Runner app;
@@ -0,0 +1,40 @@
+#include "editor/studio_app.h"
+#include "engine/command_line_parser.h"
+#include "engine/os.h"
+#include <stdio.h>
+
+static const char* USAGE =
+	"lumix_compile [-data_dir <dir>] [-compile_cache <shared cache dir>] [-compile_cache_limit <MB>] [-pak <dest dir>] [-rescan_sources]\n"
+	"compiles all outdated assets of a project without GUI, e.g. on build machines\n"
+	"-compile_cache_limit removes least recently used cache entries on start, so the caches are at most <MB> big,\n"
+	"  without it only the local cache is trimmed, to 4096 MB; 0 == unlimited\n"
+	"-rescan_sources checks every known source file, not only files in changed directories,\n"
+	"  use it if files could have been edited in place since the last run\n"
+	"exit code is 1 if any asset failed to compile or pak could not be written\n"
+	"\n"
+	"limitations - asset compilers are studio plugins, so it initializes the same way as studio:\n"
+	"  * it creates a hidden window, on Linux it needs a X display, e.g. run it with xvfb-run\n"
+	"  * it does not create a GPU device, so no GPU driver is needed; asset compilers run on CPU\n";
+
+int main(int argc, char* argv[])
+{
+	#ifndef _WIN32
+		Lumix::os::setCommandLine(argc, argv);
+	#endif
+
+	char cmd_line[2048];
+	Lumix::os::getCommandLine(Lumix::Span(cmd_line));
+	Lumix::CommandLineParser parser(cmd_line);
+	while (parser.next()) {
+		if (parser.currentEquals("-help") || parser.currentEquals("--help") || parser.currentEquals("-h")) {
+			printf("%s", USAGE);
+			return 0;
+		}
+	}
+
+	auto* app = Lumix::StudioApp::create();
+	app->runBatchCompile();
+	const int exit_code = app->getExitCode();
+	Lumix::StudioApp::destroy(*app);
+	return exit_code;
+}
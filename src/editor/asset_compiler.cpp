@@ -7,6 +7,7 @@
 #include "editor/utils.h"
 #include "editor/world_editor.h"
 #include "engine/atomic.h"
+#include "engine/command_line_parser.h"
 #include "engine/engine.h"
 #include "engine/hash.h"
 #include "engine/job_system.h"
@@ -21,6 +22,7 @@
 #include "engine/resource.h"
 #include "engine/resource_manager.h"
 #include "lz4/lz4.h"
+#include "lz4/lz4hc.h"
 #include <luacode.h>
 
 // use this if you want to be able to use cached resources without having the original
@@ -45,6 +47,47 @@ struct HashFunc<Path>
 };
 
 
+// asset database, .lumix/resources/_db.bin
+// fixed size records followed by null-terminated strings, so it's used directly from a mapped file
+// layout: AssetDBHeader, AssetDBResource[resource_count], AssetDBDir[dir_count], AssetDBDependency[dependency_count], char strings[strings_size]
+struct AssetDBHeader {
+	static constexpr u32 MAGIC = 'LADB';
+	static constexpr u32 VERSION = 0;
+	u32 magic = MAGIC;
+	u32 version = VERSION;
+	u32 resource_count = 0;
+	u32 dir_count = 0;
+	u32 dependency_count = 0;
+	u32 strings_size = 0;
+};
+
+// resource type is not stored, it's derived from registered extensions, since those can change between runs
+struct AssetDBResource {
+	FilePathHash path_hash;
+	// of the source file, i.e. without subresource
+	u64 last_modified;
+	u64 size;
+	// key of the last compile, see AssetCompilerImpl::compileCached; 0 if unknown
+	StableHash content_hash;
+	// offset in strings
+	u32 path;
+	u32 padding = 0;
+};
+
+// directory is rescanned on startup only if its last modified time changed, i.e. a file was added, removed or renamed in it
+// files edited in place while the editor was closed are detected only with -rescan_sources, see AssetCompilerImpl::rescanChangedSources
+struct AssetDBDir {
+	u64 last_modified;
+	u32 path;
+	u32 padding = 0;
+};
+
+struct AssetDBDependency {
+	u32 dependency;
+	u32 dependent;
+};
+
+
 void AssetCompiler::IPlugin::addSubresources(AssetCompiler& compiler, const Path& path)
 {
 	const ResourceType type = compiler.getResourceType(path);
@@ -59,6 +102,41 @@ struct AssetCompilerImpl : AssetCompiler {
 		u32 generation;
 		Path path;
 		bool compiled = false;
+		bool from_cache = false;
+		float time = 0;
+		StableHash key;
+	};
+
+	// queued source, not yet dispatched to a worker
+	struct PendingCompile {
+		Path path;
+		// size of the source, bigger sources are expected to take longer, so they are started first
+		u64 cost;
+		// length of the longest chain of dependents, dependencies are started before their dependents
+		u32 height;
+	};
+
+	struct CachedDependency {
+		Path dependent;
+		Path dependency;
+	};
+
+	struct SourceInfo {
+		u64 last_modified = 0;
+		u64 size = 0;
+		StableHash content_hash;
+	};
+
+	struct DirInfo {
+		Path path;
+		u64 last_modified = 0;
+	};
+
+	struct CompileState {
+		// compiles of older generations are ignored when they finish
+		u32 generation = 0;
+		bool is_pending = false;
+		u32 running = 0;
 	};
 
 	struct LoadHook : ResourceManagerHub::LoadHook {
@@ -75,21 +153,29 @@ struct AssetCompilerImpl : AssetCompiler {
 		, m_plugins(m_allocator)
 		, m_to_compile(m_allocator)
 		, m_compiled(m_allocator)
+		, m_cached_dependencies(m_allocator)
 		, m_registered_extensions(m_allocator)
 		, m_resources(m_allocator)
-		, m_generations(m_allocator)
+		, m_compile_states(m_allocator)
 		, m_dependencies(m_allocator)
+		, m_dependencies_of(m_allocator)
 		, m_changed_files(m_allocator)
 		, m_changed_dirs(m_allocator)
 		, m_on_list_changed(m_allocator)
 		, m_resource_compiled(m_allocator)
 		, m_on_init_load(m_allocator)
+		, m_compression(m_allocator)
+		, m_cache_entries(m_allocator)
+		, m_compile_stats(m_allocator)
+		, m_sources(m_allocator)
+		, m_dirs(m_allocator)
 	{
 		Engine& engine = app.getEngine();
 		FileSystem& fs = engine.getFileSystem();
 		const char* base_path = fs.getBasePath();
 		m_watcher = FileSystemWatcher::create(base_path, m_allocator);
 		m_watcher->getCallback().bind<&AssetCompilerImpl::onFileChanged>(this);
+		initCache();
 		Path path(base_path, ".lumix/resources");
 		if (!os::dirExists(path)) {
 			if (!os::makePath(path.c_str())) logError("Could not create ", path);
@@ -149,32 +235,7 @@ struct AssetCompilerImpl : AssetCompiler {
 
 	~AssetCompilerImpl()
 	{
-		m_allocator.deallocate(m_lz4_state);
-		os::OutputFile file;
-		FileSystem& fs = m_app.getEngine().getFileSystem();
-		if (fs.open(".lumix/resources/_list.txt_tmp", file)) {
-			file << "resources = {\n";
-			for (const ResourceItem& ri : m_resources) {
-				file << "\"" << ri.path << "\",\n";
-			}
-			file << "}\n\n";
-			file << "dependencies = {\n";
-			for (auto iter = m_dependencies.begin(), end = m_dependencies.end(); iter != end; ++iter) {
-				file << "\t[\"" << iter.key() << "\"] = {\n";
-				for (const Path& p : iter.value()) {
-					file << "\t\t\"" << p << "\",\n";
-				}
-				file << "\t},\n";
-			}
-			file << "}\n";
-
-			file.close();
-			fs.deleteFile(".lumix/resources/_list.txt");
-			fs.moveFile(".lumix/resources/_list.txt_tmp", ".lumix/resources/_list.txt");
-		}
-		else {
-			logError("Could not save .lumix/resources/_list.txt");
-		}
+		saveDB();
 
 		ASSERT(m_plugins.empty());
 		ResourceManagerHub& rm = m_app.getEngine().getResourceManager();
@@ -187,8 +248,12 @@ struct AssetCompilerImpl : AssetCompiler {
 		const char* base_path = fs.getBasePath();
 		m_watcher = FileSystemWatcher::create(base_path, m_allocator);
 		m_watcher->getCallback().bind<&AssetCompilerImpl::onFileChanged>(this);
+		initCache();
 		m_dependencies.clear();
+		m_dependencies_of_dirty = true;
 		m_resources.clear();
+		m_sources.clear();
+		m_dirs.clear();
 		fillDB();
 	}
 
@@ -212,26 +277,110 @@ struct AssetCompilerImpl : AssetCompiler {
 		return writeCompiledResource(src, Span(tmp.data(), (u32)tmp.size()));
 	}
 
+	void setCompression(ResourceType type, Compression compression) override {
+		MutexGuard lock(m_compression_mutex);
+		m_compression.insert(type, compression);
+	}
+
+	Compression getCompression(ResourceType type) const override {
+		MutexGuard lock(m_compression_mutex);
+		auto iter = m_compression.find(type);
+		return iter.isValid() ? iter.value() : Compression::DEFAULT;
+	}
+
+	Compression getCompression(const Path& path) {
+		Compression compression = getCompression(getResourceType(path));
+		if (lua_State* L = getMeta(Path(Path::getResource(path)))) {
+			char tmp[32];
+			if (LuaWrapper::getOptionalStringField(L, LUA_GLOBALSINDEX, "compression", Span(tmp))) {
+				if (equalIStrings(tmp, "none")) compression = Compression::NONE;
+				else if (equalIStrings(tmp, "fast")) compression = Compression::FAST;
+				else if (equalIStrings(tmp, "default")) compression = Compression::DEFAULT;
+				else if (equalIStrings(tmp, "dense")) compression = Compression::DENSE;
+				else logWarning("Unknown compression ", tmp, " in meta of ", path);
+			}
+			lua_close(L);
+		}
+		return compression;
+	}
+
+	// every call or thread has its own state, so compile jobs do not wait for each other
+	i32 compressBlock(Span<const u8> src, u8* dst, i32 dst_capacity, Compression compression) {
+		if (compression == Compression::DENSE) {
+			// too big for thread_local, every worker would keep it
+			void* state = m_allocator.allocate(LZ4_sizeofStateHC(), alignof(LZ4_streamHC_t));
+			const i32 size = LZ4_compress_HC_extStateHC(state, (const char*)src.begin(), (char*)dst, (i32)src.length(), dst_capacity, LZ4HC_CLEVEL_DEFAULT);
+			m_allocator.deallocate(state);
+			#ifdef LUMIX_DEBUG
+				if (size > 0) {
+					Array<u8> tmp(m_allocator);
+					tmp.resize(src.length());
+					const i32 decompressed = LZ4_decompress_safe((const char*)dst, (char*)tmp.begin(), size, (i32)src.length());
+					ASSERT(decompressed == (i32)src.length() && memcmp(tmp.begin(), src.begin(), src.length()) == 0);
+				}
+			#endif
+			return size;
+		}
+
+		constexpr i32 FAST_ACCELERATION = 8;
+		const i32 acceleration = compression == Compression::FAST ? FAST_ACCELERATION : 1;
+		static thread_local LZ4_stream_t state;
+		return LZ4_compress_fast_extState(&state, (const char*)src.begin(), (char*)dst, (i32)src.length(), dst_capacity, acceleration);
+	}
+
+	// data bigger than a few blocks is split in independent blocks, so they can be (de)compressed in parallel
+	bool compress(Span<const u8> data, Compression compression, OutputMemoryStream& out, bool& is_blocks) {
+		const u32 block_size = CompiledResourceHeader::BLOCK_SIZE;
+		if (data.length() <= 2 * block_size) {
+			is_blocks = false;
+			const i32 cap = LZ4_compressBound((i32)data.length());
+			out.resize(cap);
+			const i32 size = compressBlock(data, out.getMutableData(), cap, compression);
+			if (size == 0) return false;
+			out.resize(size);
+			return true;
+		}
+
+		is_blocks = true;
+		const u32 block_count = (data.length() + block_size - 1) / block_size;
+		const i32 block_cap = LZ4_compressBound(block_size);
+		OutputMemoryStream blocks(m_allocator);
+		blocks.resize(u64(block_cap) * block_count);
+		Array<i32> sizes(m_allocator);
+		sizes.resize(block_count);
+		jobs::forEach(block_count, 1, [&](i32 from, i32 to){
+			for (i32 i = from; i < to; ++i) {
+				const u32 offset = i * block_size;
+				const Span<const u8> src(data.begin() + offset, minimum(block_size, data.length() - offset));
+				sizes[i] = compressBlock(src, blocks.getMutableData() + u64(i) * block_cap, block_cap, compression);
+			}
+		});
+
+		out.write(block_size);
+		out.write(block_count);
+		for (i32 size : sizes) {
+			if (size == 0) return false;
+			out.write(u32(size));
+		}
+		for (u32 i = 0; i < block_count; ++i) {
+			out.write(blocks.data() + u64(i) * block_cap, sizes[i]);
+		}
+		return true;
+	}
+
 	bool writeCompiledResource(const Path& path, Span<const u8> data) override {
 		PROFILE_FUNCTION();
-		jobs::enter(&m_lz4_mutex);
 		constexpr u32 COMPRESSION_SIZE_LIMIT = 4096;
 		OutputMemoryStream compressed(m_allocator);
-		i32 compressed_size = 0;
+		bool is_blocks = false;
 		if (data.length() > COMPRESSION_SIZE_LIMIT) {
-			if (!m_lz4_state) {
-				m_lz4_state = (u8*)m_allocator.allocate(LZ4_sizeofState(), 8);
-			}
-			const i32 cap = LZ4_compressBound((i32)data.length());
-			compressed.resize(cap);
-			compressed_size = LZ4_compress_fast_extState(m_lz4_state, (const char*)data.begin(), (char*)compressed.getMutableData(), (i32)data.length(), cap, 1); 
-			if (compressed_size == 0) {
+			const Compression compression = getCompression(path);
+			if (compression != Compression::NONE && !compress(data, compression, compressed, is_blocks)) {
 				logError("Could not compress ", path);
 				return false;
 			}
-			compressed.resize(compressed_size);
 		}
-		jobs::exit(&m_lz4_mutex);
+		const u64 compressed_size = compressed.size();
 
 		FileSystem& fs = m_app.getEngine().getFileSystem();
 		const Path out_path(".lumix/resources/", path.getHash().getHashValue(), ".res");
@@ -242,8 +391,9 @@ struct AssetCompilerImpl : AssetCompiler {
 		}
 		CompiledResourceHeader header;
 		header.decompressed_size = data.length();
-		if (data.length() > COMPRESSION_SIZE_LIMIT && compressed_size < i32(data.length() / 4 * 3)) {
+		if (compressed_size > 0 && compressed_size < data.length() / 4 * 3) {
 			header.flags |= CompiledResourceHeader::COMPRESSED;
+			if (is_blocks) header.flags |= CompiledResourceHeader::BLOCKS;
 			(void)file.write(&header, sizeof(header));
 			(void)file.write(compressed.data(), compressed_size);
 		}
@@ -252,8 +402,366 @@ struct AssetCompilerImpl : AssetCompiler {
 			(void)file.write(data.begin(), data.length());
 		}
 		file.close();
-		if (file.isError()) logError("Could not write ", out_path);
-		return !file.isError();
+		if (file.isError()) {
+			logError("Could not write ", out_path);
+			return false;
+		}
+
+		MutexGuard lock(m_cache_mutex);
+		auto iter = m_cache_entries.find(Path(Path::getResource(path)));
+		if (iter.isValid()) iter.value().outputs.push(path.getHash());
+		return true;
+	}
+
+	// compile cache
+	// compiled resources are stored under a key derived from the content of the source, its meta, all its known dependencies
+	// (including indirect ones), compression settings and the plugin's version, so when the content matches a previous compile
+	// (e.g. after switching branches), the resources are copied from the cache instead of compiled again
+	// an entry is `<key>_<resource hash>.res` files and `<key>.lst`, see CacheEntry, `.lst` is written last
+	// shared cache directory (e.g. on a network drive for build machines) is set with `-compile_cache <dir>`
+	// caches are trimmed on start to `-compile_cache_limit <MB>` by removing least recently used entries, see trimCache
+	// the local cache is limited to DEFAULT_CACHE_LIMIT_MB by default, the shared one only if the limit is set, 0 == unlimited
+	static constexpr u32 CACHE_VERSION = 1;
+	static constexpr u64 DEFAULT_CACHE_LIMIT_MB = 4096;
+
+	// `.lst` layout: u32 output count, FilePathHash outputs[], StableHash dependencies hash, u32 dependency count, null-terminated dependency paths
+	// dependencies are stored, since they can be registered by `compile` itself, a cached compile does not register them
+	// and they are not part of the key if they were unknown before the compile
+	struct CacheEntry {
+		CacheEntry(IAllocator& allocator) : outputs(allocator), dependencies(allocator) {}
+		Array<FilePathHash> outputs;
+		Array<Path> dependencies;
+	};
+
+	void initCache() {
+		const char* base_path = m_app.getEngine().getFileSystem().getBasePath();
+		m_cache_dir = Path(base_path, ".lumix/cache");
+		if (!os::dirExists(m_cache_dir) && !os::makePath(m_cache_dir.c_str())) {
+			logError("Could not create ", m_cache_dir);
+			m_cache_dir = "";
+		}
+
+		char cmd_line[2048];
+		os::getCommandLine(Span(cmd_line));
+		CommandLineParser parser(cmd_line);
+		u64 limit_mb = DEFAULT_CACHE_LIMIT_MB;
+		bool has_limit = false;
+		m_shared_cache_dir = "";
+		while (parser.next()) {
+			if (parser.currentEquals("-compile_cache_limit")) {
+				if (!parser.next()) break;
+				char tmp[32];
+				parser.getCurrent(tmp, lengthOf(tmp));
+				fromCString(tmp, limit_mb);
+				has_limit = true;
+				continue;
+			}
+			if (!parser.currentEquals("-compile_cache")) continue;
+			if (!parser.next()) break;
+
+			char dir[MAX_PATH];
+			parser.getCurrent(dir, lengthOf(dir));
+			m_shared_cache_dir = dir;
+			if (!os::dirExists(m_shared_cache_dir) && !os::makePath(m_shared_cache_dir.c_str())) {
+				logError("Could not create ", m_shared_cache_dir);
+				m_shared_cache_dir = "";
+			}
+		}
+
+		if (limit_mb != 0) {
+			trimCache(m_cache_dir, limit_mb * 1024 * 1024);
+			if (has_limit) trimCache(m_shared_cache_dir, limit_mb * 1024 * 1024);
+		}
+	}
+
+	// removes least recently used entries until the size of `dir` is at most `limit`
+	// entry is used when it's stored or fetched, its `.lst` is (re)written then, so it's the age of `.lst`
+	void trimCache(const Path& dir, u64 limit) {
+		if (dir.isEmpty()) return;
+		PROFILE_FUNCTION();
+
+		struct Entry {
+			u64 key;
+			u64 last_used;
+			u64 size;
+		};
+		Array<Entry> entries(m_allocator);
+		HashMap<u64, u32> key_to_entry(m_allocator);
+		u64 total_size = 0;
+
+		// `<key>.lst`, `<key>.lst_tmp` and `<key>_<resource hash>.res`
+		auto getKey = [](const char* filename, u64& key) {
+			const char* end = filename;
+			while (*end >= '0' && *end <= '9') ++end;
+			if (end == filename || (*end != '.' && *end != '_')) return false;
+			fromCString(StringView(filename, u32(end - filename)), key);
+			return true;
+		};
+
+		os::FileIterator* iter = os::createFileIterator(dir, m_allocator);
+		os::FileInfo info;
+		while (os::getNextFile(iter, &info)) {
+			if (info.is_directory) continue;
+			u64 key;
+			if (!getKey(info.filename, key)) continue;
+
+			const Path path(dir, "/", info.filename);
+			const u64 size = os::getFileSize(path);
+			const u64 last_modified = os::getLastModified(path);
+			auto entry_iter = key_to_entry.find(key);
+			if (!entry_iter.isValid()) {
+				entry_iter = key_to_entry.insert(key, entries.size());
+				entries.push({key, 0, 0});
+			}
+			Entry& entry = entries[entry_iter.value()];
+			entry.size += size;
+			// entries without `.lst` yet, e.g. being stored by someone sharing the directory, are aged by their newest file
+			entry.last_used = maximum(entry.last_used, last_modified);
+			if (endsWith(info.filename, ".lst")) entry.last_used = last_modified;
+			total_size += size;
+		}
+		os::destroyFileIterator(iter);
+
+		if (total_size <= limit) return;
+
+		qsort(entries.begin(), entries.size(), sizeof(entries[0]), [](const void* a, const void* b){
+			const u64 ta = ((const Entry*)a)->last_used;
+			const u64 tb = ((const Entry*)b)->last_used;
+			return ta < tb ? -1 : (ta > tb ? 1 : 0);
+		});
+
+		// `.lst` first, so nobody fetches an entry with missing resources
+		HashMap<u64, bool> to_remove(m_allocator);
+		for (const Entry& entry : entries) {
+			if (total_size <= limit) break;
+			os::deleteFile(Path(dir, "/", entry.key, ".lst"));
+			to_remove.insert(entry.key, true);
+			total_size -= entry.size;
+		}
+
+		iter = os::createFileIterator(dir, m_allocator);
+		while (os::getNextFile(iter, &info)) {
+			if (info.is_directory) continue;
+			u64 key;
+			if (!getKey(info.filename, key) || !to_remove.find(key).isValid()) continue;
+			os::deleteFile(Path(dir, "/", info.filename));
+		}
+		os::destroyFileIterator(iter);
+		logInfo("Removed ", to_remove.size(), " least recently used entries from ", dir);
+	}
+
+	// not os::copyFile, since it can keep the last modified time, which we compare in onBeforeLoad
+	bool copyContent(const Path& from, const Path& to) {
+		os::InputFile in;
+		if (!in.open(from.c_str())) return false;
+		OutputMemoryStream tmp(m_allocator);
+		tmp.resize(in.size());
+		const bool read = in.read(tmp.getMutableData(), tmp.size());
+		in.close();
+		if (!read) return false;
+
+		os::OutputFile out;
+		if (!out.open(to.c_str())) return false;
+		(void)out.write(tmp.data(), tmp.size());
+		out.close();
+		return !out.isError();
+	}
+
+	// appends path and hash of its content to `key_data`, compile jobs run in parallel, so RollingStableHasher can not be used
+	bool hashFile(const Path& path, OutputMemoryStream& content, OutputMemoryStream& key_data) {
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		key_data.writeString(path);
+		content.clear();
+		const bool exists = fs.getContentSync(path, content);
+		key_data.write(exists);
+		if (exists) key_data.write(StableHash(content.data(), (u32)content.size()));
+		return exists;
+	}
+
+	StableHash hashDependencies(Span<const Path> dependencies) {
+		OutputMemoryStream content(m_allocator);
+		OutputMemoryStream key_data(m_allocator);
+		for (const Path& dep : dependencies) hashFile(dep, content, key_data);
+		return StableHash(key_data.data(), (u32)key_data.size());
+	}
+
+	// compression of outputs can depend on the type of any subresource, so all per type settings are part of the key
+	StableHash getCompressionHash() const {
+		MutexGuard lock(m_compression_mutex);
+		// summed, so it does not depend on the order in the hash map
+		u64 sum = 0;
+		for (auto iter = m_compression.begin(), end = m_compression.end(); iter != end; ++iter) {
+			if (iter.value() == Compression::DEFAULT) continue;
+			const u64 tmp[] = { iter.key().type.getHashValue(), (u64)iter.value() };
+			sum += StableHash(tmp, sizeof(tmp)).getHashValue();
+		}
+		return StableHash::fromU64(sum);
+	}
+
+	// `dependencies` are sorted and include indirect dependencies, see collectDependencies
+	bool computeCacheKey(const Path& src, IPlugin& plugin, Span<const Path> dependencies, StableHash& key) {
+		OutputMemoryStream content(m_allocator);
+		OutputMemoryStream key_data(m_allocator);
+		key_data.write(CACHE_VERSION);
+		key_data.write(plugin.getVersion());
+		key_data.write(getCompressionHash());
+		if (!hashFile(src, content, key_data)) return false;
+		hashFile(Path(src, ".meta"), content, key_data);
+		for (const Path& dep : dependencies) hashFile(dep, content, key_data);
+		key = StableHash(key_data.data(), (u32)key_data.size());
+		return true;
+	}
+
+	bool fetchFromCache(const Path& dir, StableHash key, CacheEntry& entry) {
+		if (dir.isEmpty()) return false;
+
+		OutputMemoryStream list_data(m_allocator);
+		os::InputFile list;
+		if (!list.open(Path(dir, "/", key.getHashValue(), ".lst").c_str())) return false;
+		list_data.resize(list.size());
+		const bool read = list.read(list_data.getMutableData(), list_data.size());
+		list.close();
+		if (!read) return false;
+
+		InputMemoryStream blob(list_data);
+		const u32 output_count = blob.read<u32>();
+		if (output_count > blob.remaining() / sizeof(FilePathHash)) return false;
+		entry.outputs.resize(output_count);
+		blob.read(entry.outputs.begin(), entry.outputs.byte_size());
+		const StableHash dependencies_hash = blob.read<StableHash>();
+		const u32 dependency_count = blob.read<u32>();
+		entry.dependencies.clear();
+		if (blob.hasOverflow()) return false;
+		for (u32 i = 0; i < dependency_count; ++i) {
+			const char* dep = blob.readString();
+			if (!dep) return false;
+			entry.dependencies.push(Path(dep));
+		}
+		// dependencies registered during the compile can change without changing the key
+		if (hashDependencies(entry.dependencies) != dependencies_hash) return false;
+
+		const char* base_path = m_app.getEngine().getFileSystem().getBasePath();
+		for (FilePathHash hash : entry.outputs) {
+			const Path cached(dir, "/", key.getHashValue(), "_", hash.getHashValue(), ".res");
+			const Path dst(base_path, ".lumix/resources/", hash.getHashValue(), ".res");
+			if (!copyContent(cached, dst)) return false;
+		}
+		// marks the entry as recently used, see trimCache
+		writeCacheList(dir, key, list_data);
+		return true;
+	}
+
+	void storeInCache(const Path& dir, StableHash key, const CacheEntry& entry) {
+		if (dir.isEmpty()) return;
+
+		const char* base_path = m_app.getEngine().getFileSystem().getBasePath();
+		for (FilePathHash hash : entry.outputs) {
+			const Path compiled(base_path, ".lumix/resources/", hash.getHashValue(), ".res");
+			const Path cached(dir, "/", key.getHashValue(), "_", hash.getHashValue(), ".res");
+			if (!copyContent(compiled, cached)) {
+				logWarning("Could not write ", cached);
+				return;
+			}
+		}
+
+		OutputMemoryStream list_data(m_allocator);
+		list_data.write(u32(entry.outputs.size()));
+		list_data.write(entry.outputs.begin(), entry.outputs.byte_size());
+		list_data.write(hashDependencies(entry.dependencies));
+		list_data.write(u32(entry.dependencies.size()));
+		for (const Path& dep : entry.dependencies) list_data.writeString(dep);
+		writeCacheList(dir, key, list_data);
+	}
+
+	void writeCacheList(const Path& dir, StableHash key, const OutputMemoryStream& list_data) {
+		// write to tmp and move, so other editors sharing the directory never see a partial list
+		const Path tmp_path(dir, "/", key.getHashValue(), ".lst_tmp");
+		const Path list_path(dir, "/", key.getHashValue(), ".lst");
+		os::OutputFile list;
+		if (!list.open(tmp_path.c_str())) {
+			logWarning("Could not write ", tmp_path);
+			return;
+		}
+		(void)list.write(list_data.data(), list_data.size());
+		list.close();
+		if (list.isError() || !os::moveFile(tmp_path, list_path)) {
+			logWarning("Could not write ", list_path);
+			os::deleteFile(tmp_path);
+		}
+	}
+
+	// dependencies of a cached compile are registered on the main thread, in `update`
+	void queueCachedDependencies(const Path& src, Span<const Path> dependencies) {
+		MutexGuard lock(m_compiled_mutex);
+		for (const Path& dep : dependencies) m_cached_dependencies.push({src, dep});
+	}
+
+	// runs on a worker thread
+	bool compileCached(const Path& src, Span<const Path> dependencies, bool& from_cache, StableHash& key) {
+		from_cache = false;
+		IPlugin* plugin = getPlugin(src);
+		if (!plugin) return compile(src);
+
+		if (!computeCacheKey(src, *plugin, dependencies, key)) return compile(src);
+		CacheEntry entry(m_allocator);
+		if (fetchFromCache(m_cache_dir, key, entry)) {
+			queueCachedDependencies(src, entry.dependencies);
+			from_cache = true;
+			return true;
+		}
+		if (fetchFromCache(m_shared_cache_dir, key, entry)) {
+			// so next time we do not need the shared directory
+			storeInCache(m_cache_dir, key, entry);
+			queueCachedDependencies(src, entry.dependencies);
+			from_cache = true;
+			return true;
+		}
+
+		bool track_entry;
+		{
+			MutexGuard lock(m_cache_mutex);
+			// the same source can be compiled concurrently if it's changed during compile, cache only one of them
+			track_entry = !m_cache_entries.find(src).isValid();
+			if (track_entry) m_cache_entries.insert(src, CacheEntry(m_allocator));
+		}
+
+		const bool compiled = compile(src);
+		if (!track_entry) return compiled;
+
+		{
+			MutexGuard lock(m_cache_mutex);
+			auto iter = m_cache_entries.find(src);
+			entry = static_cast<CacheEntry&&>(iter.value());
+			m_cache_entries.erase(iter);
+		}
+		
+		if (compiled && !entry.outputs.empty()) {
+			entry.outputs.removeDuplicates();
+			for (const Path& dep : dependencies) entry.dependencies.push(dep);
+			entry.dependencies.removeDuplicates();
+			sortPaths(entry.dependencies);
+			storeInCache(m_cache_dir, key, entry);
+			storeInCache(m_shared_cache_dir, key, entry);
+		}
+		return compiled;
+	}
+
+	// so the cache key does not depend on the order in which dependencies were registered
+	static void sortPaths(Array<Path>& paths) {
+		qsort(paths.begin(), paths.size(), sizeof(paths[0]), [](const void* a, const void* b){
+			return compareString(((const Path*)a)->c_str(), ((const Path*)b)->c_str());
+		});
+	}
+
+	// all dependencies of `path`, including dependencies of dependencies
+	void collectDependencies(const Path& path, const Path& root, Array<Path>& out) {
+		auto iter = m_dependencies_of.find(path);
+		if (!iter.isValid()) return;
+		for (const Path& dep : iter.value()) {
+			if (dep == root || out.indexOf(dep) >= 0) continue;
+			out.push(dep);
+			collectDependencies(dep, root, out);
+		}
 	}
 
 	static RuntimeHash dirHash(const Path& path) {
@@ -322,8 +830,52 @@ struct AssetCompilerImpl : AssetCompiler {
 	}
 
 	
-	void processDir(StringView dir, u64 list_last_modified)
+	// returns false if `path` did not change since the last update
+	bool updateSourceInfo(const Path& path) {
+		const Path fullpath(m_app.getEngine().getFileSystem().getBasePath(), path);
+		const u64 last_modified = os::getLastModified(fullpath);
+		auto iter = m_sources.find(path.getHash());
+		if (iter.isValid() && iter.value().last_modified == last_modified) return false;
+
+		if (!iter.isValid()) iter = m_sources.insert(path.getHash(), {});
+		iter.value().last_modified = last_modified;
+		iter.value().size = os::getFileSize(fullpath);
+		return true;
+	}
+
+	// adds `path` if it's new or changed since the last scan
+	void scanFile(const Path& path) {
+		char ext[10];
+		copyString(Span(ext), Path::getExtension(path));
+		makeLowercase(Span(ext), ext);
+		if (!m_plugins.find(RuntimeHash(ext)).isValid()) return;
+
+		if (updateSourceInfo(path)) addResource(path);
+	}
+
+	static bool isInDir(StringView path, StringView dir) {
+		if (dir.empty()) return true;
+		return startsWith(path, dir) && path.size() > dir.size() && (path[dir.size()] == '/' || path[dir.size()] == '\\');
+	}
+
+	// without trailing slash, the same as keys in m_dirs
+	static Path getParentDir(StringView path) {
+		StringView dir = Path::getDir(path);
+		if (!dir.empty() && (dir.back() == '\\' || dir.back() == '/')) dir.removeSuffix(1);
+		return Path(dir);
+	}
+
+	void updateDirInfo(const Path& dir) {
+		const Path fullpath(m_app.getEngine().getFileSystem().getBasePath(), dir);
+		auto iter = m_dirs.find(dir.getHash());
+		if (!iter.isValid()) iter = m_dirs.insert(dir.getHash(), {dir, 0});
+		iter.value().last_modified = os::getLastModified(fullpath);
+	}
+
+	// `recursive` == false scans only unknown subdirectories
+	void processDir(StringView dir, bool recursive)
 	{
+		updateDirInfo(Path(dir));
 		FileSystem& fs = m_app.getEngine().getFileSystem();
 		auto* iter = fs.createFileIterator(dir);
 		os::FileInfo info;
@@ -331,39 +883,236 @@ struct AssetCompilerImpl : AssetCompiler {
 		{
 			if (info.filename[0] == '.') continue;
 
-			if (info.is_directory)
-			{
-				char child_path[MAX_PATH];
-				copyString(child_path, dir);
-				if(!dir.empty()) catString(child_path, "/");
-				catString(child_path, info.filename);
-				processDir(child_path, list_last_modified);
+			char child_path[MAX_PATH];
+			copyString(child_path, dir);
+			if(!dir.empty()) catString(child_path, "/");
+			catString(child_path, info.filename);
+			const Path path(child_path[0] == '/' ? child_path + 1 : child_path);
+
+			if (info.is_directory) {
+				if (recursive || !m_dirs.find(path.getHash()).isValid()) processDir(path, true);
+			}
+			else {
+				scanFile(path);
 			}
-			else
+		}
+
+		destroyFileIterator(iter);
+	}
+
+	void removeDir(const Path& dir) {
+		m_dirs.eraseIf([&](const DirInfo& di){ return di.path == dir || isInDir(di.path, dir); });
+		jobs::MutexGuard lock(m_resources_mutex);
+		m_resources.eraseIf([&](const ResourceItem& ri){
+			if (!isInDir(ri.path, dir)) return false;
+			m_sources.erase(Path(Path::getResource(ri.path)).getHash());
+			return true;
+		});
+	}
+
+	// rescans only directories, which changed since the DB was saved
+	void rescanChangedDirs() {
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		Array<Path> changed(m_allocator);
+		for (const DirInfo& di : m_dirs) {
+			const Path fullpath(fs.getBasePath(), di.path);
+			if (os::getLastModified(fullpath) != di.last_modified) changed.push(di.path);
+		}
+
+		for (const Path& dir : changed) {
+			if (!m_dirs.find(dir.getHash()).isValid()) continue;
+			const Path fullpath(fs.getBasePath(), dir);
+			if (!os::dirExists(fullpath)) {
+				removeDir(dir);
+				continue;
+			}
+
+			// removed files
+			const RuntimeHash dir_hash(dir.c_str(), dir.length());
 			{
-				char fullpath[MAX_PATH];
-				copyString(fullpath, dir);
-				if(!dir.empty()) catString(fullpath, "/");
-				catString(fullpath, info.filename);
+				jobs::MutexGuard lock(m_resources_mutex);
+				m_resources.eraseIf([&](const ResourceItem& ri){
+					if (ri.dir_hash != dir_hash) return false;
+					const Path src(Path::getResource(ri.path));
+					if (fs.fileExists(src)) return false;
+					m_sources.erase(src.getHash());
+					fs.deleteFile(Path(".lumix/resources/", ri.path.getHash(), ".res"));
+					return true;
+				});
+			}
+			processDir(dir, false);
+		}
+		if (!changed.empty()) logInfo("Rescanned ", changed.size(), " changed directories");
+	}
 
-				if (fs.getLastModified(fullpath[0] == '/' ? fullpath + 1 : fullpath) > list_last_modified) {
-					addResource(Path(fullpath));
-				}
-				else {
-					Path path(fullpath[0] == '/' ? fullpath + 1 : fullpath);
-					if (!m_resources.find(path.getHash()).isValid()) {
-						addResource(Path(fullpath));
-					}
-				}
+	// editing a file in place does not change last modified time of its directory, so rescanChangedDirs does not see it
+	// this stats every known source, so it's done only on request (-rescan_sources), e.g. after files were synced while the editor was closed
+	void rescanChangedSources() {
+		PROFILE_FUNCTION();
+		Array<Path> sources(m_allocator);
+		{
+			HashMap<FilePathHash, bool> visited(m_allocator);
+			jobs::MutexGuard lock(m_resources_mutex);
+			for (const ResourceItem& ri : m_resources) {
+				const Path src(Path::getResource(ri.path));
+				if (visited.find(src.getHash()).isValid()) continue;
+				visited.insert(src.getHash(), true);
+				sources.push(src);
 			}
 		}
 
-		destroyFileIterator(iter);
+		const char* base_path = m_app.getEngine().getFileSystem().getBasePath();
+		Array<u64> last_modified(m_allocator);
+		last_modified.resize(sources.size());
+		jobs::forEach(sources.size(), 256, [&](i32 from, i32 to){
+			for (i32 i = from; i < to; ++i) {
+				last_modified[i] = os::getLastModified(Path(base_path, sources[i]));
+			}
+		});
+
+		u32 changed = 0;
+		for (i32 i = 0; i < sources.size(); ++i) {
+			// removed sources are handled by rescanChangedDirs
+			if (last_modified[i] == 0) continue;
+			auto iter = m_sources.find(sources[i].getHash());
+			if (iter.isValid() && iter.value().last_modified == last_modified[i]) continue;
+			scanFile(sources[i]);
+			++changed;
+		}
+		if (changed > 0) logInfo("Rescanned ", changed, " changed files");
+	}
+
+	bool loadDB() {
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		const Path db_path(fs.getBasePath(), ".lumix/resources/_db.bin");
+		os::MappedFile file;
+		if (!file.open(db_path.c_str())) return false;
+
+		InputMemoryStream blob(file.data(), file.size());
+		const AssetDBHeader header = blob.read<AssetDBHeader>();
+		if (blob.hasOverflow() || header.magic != AssetDBHeader::MAGIC || header.version != AssetDBHeader::VERSION) {
+			logWarning(db_path, " is invalid or has unsupported version, rescanning all files");
+			return false;
+		}
+		const u64 size = sizeof(header)
+			+ u64(header.resource_count) * sizeof(AssetDBResource)
+			+ u64(header.dir_count) * sizeof(AssetDBDir)
+			+ u64(header.dependency_count) * sizeof(AssetDBDependency)
+			+ header.strings_size;
+		if (size != file.size() || (header.strings_size > 0 && file.data()[size - 1] != 0)) {
+			logWarning(db_path, " is corrupted, rescanning all files");
+			return false;
+		}
+
+		const AssetDBResource* resources = (const AssetDBResource*)(file.data() + sizeof(header));
+		const AssetDBDir* dirs = (const AssetDBDir*)(resources + header.resource_count);
+		const AssetDBDependency* dependencies = (const AssetDBDependency*)(dirs + header.dir_count);
+		const char* strings = (const char*)(dependencies + header.dependency_count);
+		auto getString = [&](u32 offset) { return offset < header.strings_size ? strings + offset : ""; };
+
+		{
+			jobs::MutexGuard lock(m_resources_mutex);
+			for (u32 i = 0; i < header.resource_count; ++i) {
+				const AssetDBResource& r = resources[i];
+				const Path path(getString(r.path));
+				const ResourceType type = getResourceType(path);
+				#ifdef CACHE_MASTER 
+					if (!type.isValid() || !fs.fileExists(Path(".lumix/resources/", r.path_hash, ".res"))) continue;
+				#else
+					if (!type.isValid()) continue;
+				#endif
+				m_resources.insert(r.path_hash, {path, type, dirHash(path)});
+				const FilePathHash src_hash = Path(Path::getResource(path)).getHash();
+				if (!m_sources.find(src_hash).isValid()) m_sources.insert(src_hash, {r.last_modified, r.size, r.content_hash});
+			}
+		}
+
+		for (u32 i = 0; i < header.dir_count; ++i) {
+			const Path path(getString(dirs[i].path));
+			m_dirs.insert(path.getHash(), {path, dirs[i].last_modified});
+		}
+
+		for (u32 i = 0; i < header.dependency_count; ++i) {
+			registerDependency(Path(getString(dependencies[i].dependent)), Path(getString(dependencies[i].dependency)));
+		}
+		return true;
+	}
+
+	void saveDB() {
+		OutputMemoryStream strings(m_allocator);
+		auto addString = [&](StringView str){
+			const u32 offset = (u32)strings.size();
+			strings.write(str.begin, str.size());
+			strings.write('\0');
+			return offset;
+		};
+
+		Array<AssetDBResource> resources(m_allocator);
+		resources.reserve(m_resources.size());
+		for (const ResourceItem& ri : m_resources) {
+			AssetDBResource& r = resources.emplace();
+			r.path_hash = ri.path.getHash();
+			r.path = addString(ri.path);
+			auto iter = m_sources.find(Path(Path::getResource(ri.path)).getHash());
+			r.last_modified = iter.isValid() ? iter.value().last_modified : 0;
+			r.size = iter.isValid() ? iter.value().size : 0;
+			r.content_hash = iter.isValid() ? iter.value().content_hash : StableHash();
+		}
+
+		Array<AssetDBDir> dirs(m_allocator);
+		dirs.reserve(m_dirs.size());
+		for (const DirInfo& di : m_dirs) {
+			AssetDBDir& d = dirs.emplace();
+			d.last_modified = di.last_modified;
+			d.path = addString(di.path);
+		}
+
+		Array<AssetDBDependency> dependencies(m_allocator);
+		for (auto iter = m_dependencies.begin(), end = m_dependencies.end(); iter != end; ++iter) {
+			const u32 dependency = addString(iter.key());
+			for (const Path& p : iter.value()) {
+				dependencies.push({dependency, addString(p)});
+			}
+		}
+
+		AssetDBHeader header;
+		header.resource_count = resources.size();
+		header.dir_count = dirs.size();
+		header.dependency_count = dependencies.size();
+		header.strings_size = (u32)strings.size();
+
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		os::OutputFile file;
+		if (!fs.open(".lumix/resources/_db.bin_tmp", file)) {
+			logError("Could not save .lumix/resources/_db.bin");
+			return;
+		}
+		(void)file.write(&header, sizeof(header));
+		(void)file.write(resources.begin(), resources.byte_size());
+		(void)file.write(dirs.begin(), dirs.byte_size());
+		(void)file.write(dependencies.begin(), dependencies.byte_size());
+		(void)file.write(strings.data(), strings.size());
+		file.close();
+		if (file.isError()) {
+			logError("Could not save .lumix/resources/_db.bin");
+			return;
+		}
+		fs.deleteFile(".lumix/resources/_db.bin");
+		if (!fs.moveFile(".lumix/resources/_db.bin_tmp", ".lumix/resources/_db.bin")) {
+			logError("Could not save .lumix/resources/_db.bin");
+		}
 	}
 
 
 	void registerDependency(const Path& included_from, const Path& dependency) override
 	{
+		{
+			// so it's stored in the compile cache entry
+			MutexGuard lock(m_cache_mutex);
+			auto entry_iter = m_cache_entries.find(Path(Path::getResource(included_from)));
+			if (entry_iter.isValid()) entry_iter.value().dependencies.push(dependency);
+		}
+
 		auto iter = m_dependencies.find(dependency);
 		if (!iter.isValid()) {
 			m_dependencies.insert(dependency, Array<Path>(m_allocator));
@@ -371,10 +1120,40 @@ struct AssetCompilerImpl : AssetCompiler {
 		}
 		if (iter.value().indexOf(included_from) < 0) {
 			iter.value().push(included_from);
+			m_dependencies_of_dirty = true;
 		}
 	}
 
+	static bool isRescanSourcesRequested() {
+		char cmd_line[2048];
+		os::getCommandLine(Span(cmd_line));
+		CommandLineParser parser(cmd_line);
+		while (parser.next()) {
+			if (parser.currentEquals("-rescan_sources")) return true;
+		}
+		return false;
+	}
+
 	void fillDB() {
+		os::Timer timer;
+		if (loadDB()) {
+			for (IPlugin* plugin : m_plugins) {
+				plugin->listLoaded();
+			}
+			#ifndef CACHE_MASTER
+				rescanChangedDirs();
+				if (isRescanSourcesRequested()) rescanChangedSources();
+			#endif
+		}
+		else {
+			loadLegacyList();
+			processDir("", true);
+		}
+		logInfo("Asset database loaded in ", timer.getTimeSinceStart(), " s");
+	}
+
+	// text list used before _db.bin, loaded only if there's no _db.bin, so dependencies are not lost
+	void loadLegacyList() {
 		FileSystem& fs = m_app.getEngine().getFileSystem();
 		const Path list_path(fs.getBasePath(), ".lumix/resources/_list.txt");
 		OutputMemoryStream content(m_allocator);
@@ -424,6 +1203,7 @@ struct AssetCompilerImpl : AssetCompiler {
 
 				lua_getglobal(L, "dependencies");
 				if (lua_type(L, -1) != LUA_TTABLE) return;
+				m_dependencies_of_dirty = true;
 
 				lua_pushnil(L);
 				while (lua_next(L, -2) != 0) {
@@ -453,9 +1233,6 @@ struct AssetCompilerImpl : AssetCompiler {
 				plugin->listLoaded();
 			}
 		}
-
-		const u64 list_last_modified = os::getLastModified(list_path);
-		processDir("", list_last_modified);
 	}
 
 	void onInitFinished() override
@@ -542,15 +1319,7 @@ struct AssetCompilerImpl : AssetCompiler {
 		if (startsWith(filepath, ".lumix/resources/")) return ResourceManagerHub::LoadHook::Action::IMMEDIATE;
 		if (startsWith(filepath, ".lumix/asset_tiles/")) return ResourceManagerHub::LoadHook::Action::IMMEDIATE;
 
-		const FilePathHash hash = res.getPath().getHash();
-		const Path dst_path(".lumix/resources/", hash, ".res");
-		const Path meta_path(filepath, ".meta");
-
-		if (!fs.fileExists(dst_path)
-			|| fs.getLastModified(dst_path) < fs.getLastModified(filepath)
-			|| fs.getLastModified(dst_path) < fs.getLastModified(meta_path)
-			)
-		{
+		if (isOutdated(res.getPath())) {
 			if (!getPlugin(res.getPath())) return ResourceManagerHub::LoadHook::Action::IMMEDIATE;
 			if (!m_init_finished) {
 				res.incRefCount();
@@ -564,33 +1333,143 @@ struct AssetCompilerImpl : AssetCompiler {
 		return ResourceManagerHub::LoadHook::Action::IMMEDIATE;
 	}
 
-	void pushToCompileQueue(const Path& path) {
-		auto iter = m_generations.find(path);
-		if (!iter.isValid()) {
-			iter = m_generations.insert(path, 0);
+	// `path` can be a subresource
+	bool isOutdated(const Path& path) {
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		StringView filepath = Path::getResource(path);
+		const Path dst_path(".lumix/resources/", path.getHash(), ".res");
+		const Path meta_path(filepath, ".meta");
+
+		return !fs.fileExists(dst_path)
+			|| fs.getLastModified(dst_path) < fs.getLastModified(filepath)
+			|| fs.getLastModified(dst_path) < fs.getLastModified(meta_path);
+	}
+
+	u32 compileOutdated() override {
+		Array<Path> outdated(m_allocator);
+		{
+			jobs::MutexGuard lock(m_resources_mutex);
+			for (const ResourceItem& ri : m_resources) {
+				if (isOutdated(ri.path)) outdated.push(Path(Path::getResource(ri.path)));
+			}
 		}
-		else {
-			++iter.value();
+		outdated.removeDuplicates();
+		for (const Path& path : outdated) {
+			if (getPlugin(path)) pushToCompileQueue(path);
 		}
+		return m_batch_remaining_count;
+	}
+
+	bool isCompiling() const override { return m_batch_remaining_count > 0; }
+
+	Span<const CompileStats> getCompileStats() const override { return m_compile_stats; }
 
-		CompileJob job;
-		job.path = path;
-		job.generation = iter.value();
+	CompileStats& getCompileStats(ResourceType type) {
+		for (CompileStats& stats : m_compile_stats) {
+			if (stats.type == type) return stats;
+		}
+		CompileStats& stats = m_compile_stats.emplace();
+		stats.type = type;
+		return stats;
+	}
 
-		m_to_compile.push(job);
+	void pushToCompileQueue(const Path& path) {
+		auto iter = m_compile_states.find(path);
+		if (!iter.isValid()) iter = m_compile_states.insert(path, {});
+		CompileState& state = iter.value();
+		++state.generation;
+		// already queued, it gets the new generation when it's dispatched
+		if (state.is_pending) return;
+
+		state.is_pending = true;
+		const Path fullpath(m_app.getEngine().getFileSystem().getBasePath(), path);
+		m_to_compile.push({path, os::getFileSize(fullpath), 0});
+		m_to_compile_sorted = false;
+		if (m_batch_remaining_count == 0) {
+			m_batch_timer.tick();
+			m_batch_busy_time = 0;
+		}
 		++m_compile_batch_count;
 		++m_batch_remaining_count;
 	}
 
-	CompileJob popCompiledResource()
-	{
-		MutexGuard lock(m_compiled_mutex);
-		if (m_compiled.empty()) return {};
-		const CompileJob p = m_compiled.back();
-		m_compiled.pop();
-		--m_batch_remaining_count;
-		if (m_batch_remaining_count == 0) m_compile_batch_count = 0;
-		return p;
+	void updateDependenciesOf() {
+		if (!m_dependencies_of_dirty) return;
+		m_dependencies_of_dirty = false;
+		m_dependencies_of.clear();
+		for (auto iter = m_dependencies.begin(), end = m_dependencies.end(); iter != end; ++iter) {
+			for (const Path& dependent : iter.value()) {
+				auto dep_iter = m_dependencies_of.find(dependent);
+				if (!dep_iter.isValid()) dep_iter = m_dependencies_of.insert(dependent, Array<Path>(m_allocator));
+				dep_iter.value().push(iter.key());
+			}
+		}
+	}
+
+	u32 getHeight(const Path& path, HashMap<Path, u32>& heights) {
+		auto iter = heights.find(path);
+		if (iter.isValid()) return iter.value();
+		// in case of cyclic dependencies
+		heights.insert(path, 0);
+
+		u32 height = 0;
+		auto dep_iter = m_dependencies.find(path);
+		if (dep_iter.isValid()) {
+			for (const Path& dependent : dep_iter.value()) {
+				height = maximum(height, getHeight(dependent, heights) + 1);
+			}
+		}
+		heights[path] = height;
+		return height;
+	}
+
+	void sortToCompile() {
+		if (m_to_compile_sorted) return;
+		m_to_compile_sorted = true;
+
+		HashMap<Path, u32> heights(m_allocator);
+		for (PendingCompile& pc : m_to_compile) pc.height = getHeight(pc.path, heights);
+		qsort(m_to_compile.begin(), m_to_compile.size(), sizeof(m_to_compile[0]), [](const void* a, const void* b){
+			const PendingCompile* pa = (const PendingCompile*)a;
+			const PendingCompile* pb = (const PendingCompile*)b;
+			if (pa->height != pb->height) return pa->height < pb->height ? -1 : 1;
+			if (pa->cost != pb->cost) return pa->cost < pb->cost ? -1 : 1;
+			return 0;
+		});
+	}
+
+	// waits for its dependencies, which are queued or being compiled
+	bool isBlocked(const Path& path) {
+		auto iter = m_dependencies_of.find(path);
+		if (!iter.isValid()) return false;
+		for (const Path& dependency : iter.value()) {
+			auto state_iter = m_compile_states.find(dependency);
+			if (!state_iter.isValid()) continue;
+			if (state_iter.value().is_pending || state_iter.value().running > 0) return true;
+		}
+		return false;
+	}
+
+	// keeps more jobs in flight than there are workers, so workers do not starve between updates
+	void dispatchCompileJobs() {
+		if (m_to_compile.empty()) return;
+
+		updateDependenciesOf();
+		sortToCompile();
+		const u32 max_in_flight = 2 * jobs::getWorkersCount();
+		for (i32 i = m_to_compile.size() - 1; i >= 0 && m_jobs_in_flight < max_in_flight; --i) {
+			// if everything is blocked, there's a dependency cycle
+			const bool force = m_jobs_in_flight == 0 && i == 0;
+			if (!force && isBlocked(m_to_compile[i].path)) continue;
+
+			const Path path = m_to_compile[i].path;
+			m_to_compile.erase(i);
+			CompileState& state = m_compile_states[path];
+			state.is_pending = false;
+			++state.running;
+			++m_jobs_in_flight;
+			runJob(path, state.generation);
+		}
 	}
 
 	void onGUI() override {
@@ -612,6 +1491,12 @@ struct AssetCompilerImpl : AssetCompiler {
 		if (ImGui::Begin("Resource compilation", nullptr, flags)) {
 			ImGui::TextUnformatted("Compiling resources...");
 			ImGui::ProgressBar(((float)m_compile_batch_count - m_batch_remaining_count) / m_compile_batch_count);
+			const float wall_time = m_batch_timer.getTimeSinceTick();
+			if (wall_time > 0) {
+				const u32 finished = m_compile_batch_count - m_batch_remaining_count;
+				const float utilization = m_batch_busy_time / (wall_time * jobs::getWorkersCount());
+				ImGui::Text("%.1f resources/s, %d%% worker utilization", finished / wall_time, i32(utilization * 100 + 0.5f));
+			}
 			ImGui::TextWrapped("%s", m_res_in_progress.c_str());
 		}
 		ImGui::End();
@@ -627,38 +1512,66 @@ struct AssetCompilerImpl : AssetCompiler {
 		return nullptr;
 	}
 
-	void runOneJob() {
-		if (m_to_compile.empty()) return;
-
-		AssetCompilerImpl::CompileJob p = m_to_compile.back();
-		m_to_compile.pop();
-		auto iter = m_generations.find(p.path);
-		const bool is_most_recent = p.generation == iter.value();
-		if (!is_most_recent) {
-			--m_batch_remaining_count;
-			return;
-		}
-
+	void runJob(const Path& path, u32 generation) {
+		CompileJob p;
+		p.path = path;
+		p.generation = generation;
 		m_res_in_progress = p.path.c_str();
 
-		jobs::runLambda([p, this]() mutable {
+		// m_dependencies is accessed only on main thread
+		Array<Path> dependencies(m_allocator);
+		collectDependencies(p.path, p.path, dependencies);
+		sortPaths(dependencies);
+
+		jobs::runLambda([p, this, dependencies = static_cast<Array<Path>&&>(dependencies)]() mutable {
 			PROFILE_BLOCK("compile asset");
 			profiler::pushString(p.path.c_str());
-			p.compiled = compile(p.path);
+			os::Timer timer;
+			p.compiled = compileCached(p.path, dependencies, p.from_cache, p.key);
+			p.time = timer.getTimeSinceStart();
 			if (!p.compiled) logError("Failed to compile resource ", p.path);
 			MutexGuard lock(m_compiled_mutex);
 			m_compiled.push(p);
 		}, nullptr);
 	}
 
+	void onBatchFinished() {
+		const float wall_time = m_batch_timer.getTimeSinceTick();
+		const float throughput = wall_time > 0 ? m_compile_batch_count / wall_time : 0;
+		const float utilization = wall_time > 0 ? m_batch_busy_time / (wall_time * jobs::getWorkersCount()) : 0;
+		logInfo("Compiled ", m_compile_batch_count, " resources in ", wall_time, " s, ", throughput, " resources/s, ", u32(utilization * 100 + 0.5f), "% worker utilization");
+		m_compile_batch_count = 0;
+	}
+
 	void update() override {
-		for(;;) {
-			runOneJob();
-			CompileJob job = popCompiledResource();
-			if (job.path.isEmpty()) break;
+		dispatchCompileJobs();
+		Array<CompileJob> compiled(m_allocator);
+		Array<CachedDependency> cached_dependencies(m_allocator);
+		{
+			MutexGuard lock(m_compiled_mutex);
+			compiled.swap(m_compiled);
+			cached_dependencies.swap(m_cached_dependencies);
+		}
+		for (const CachedDependency& dep : cached_dependencies) registerDependency(dep.dependent, dep.dependency);
 
-			const u32 generation = m_generations[job.path];
-			if (job.generation != generation) continue;
+		for (const CompileJob& job : compiled) {
+			--m_jobs_in_flight;
+			--m_batch_remaining_count;
+			m_batch_busy_time += job.time;
+			CompileState& state = m_compile_states[job.path];
+			--state.running;
+			if (job.compiled) {
+				auto src_iter = m_sources.find(job.path.getHash());
+				if (src_iter.isValid()) src_iter.value().content_hash = job.key;
+			}
+
+			CompileStats& stats = getCompileStats(getResourceType(job.path));
+			++stats.compiled;
+			if (!job.compiled) ++stats.failed;
+			if (job.from_cache) ++stats.from_cache;
+			stats.time += job.time;
+
+			if (job.generation != state.generation) continue;
 
 			// this can take some time, mutex is probably not the best option
 			jobs::MutexGuard lock(m_resources_mutex);
@@ -682,6 +1595,10 @@ struct AssetCompilerImpl : AssetCompiler {
 				}
 			}
 		}
+		if (!compiled.empty()) {
+			if (m_batch_remaining_count == 0) onBatchFinished();
+			else dispatchCompileJobs();
+		}
 
 		for (;;) {
 			Path path_obj;
@@ -696,21 +1613,16 @@ struct AssetCompilerImpl : AssetCompiler {
 
 			if (!path_obj.isEmpty()) {
 				FileSystem& fs = m_app.getEngine().getFileSystem();
-				const Path list_path(fs.getBasePath(), ".lumix/resources/_list.txt");
-				const u64 list_last_modified = os::getLastModified(list_path);
 				const Path fullpath(fs.getBasePath(), path_obj);
 				if (os::dirExists(fullpath)) {
-					processDir(path_obj, list_last_modified);
+					processDir(path_obj, true);
 					m_on_list_changed.invoke(path_obj);
 				}
 				else {
-					jobs::MutexGuard lock(m_resources_mutex);
-					m_resources.eraseIf([&](const ResourceItem& ri){
-						if (!startsWith(ri.path, path_obj)) return false;
-						return true;
-					});
+					removeDir(path_obj);
 					m_on_list_changed.invoke(path_obj);
 				}
+				updateDirInfo(getParentDir(path_obj));
 			}
 		}
 
@@ -738,12 +1650,16 @@ struct AssetCompilerImpl : AssetCompiler {
 						if (!endsWithInsensitive(ri.path, path_obj)) return false;
 						return true;
 					});
+					m_sources.erase(path_obj.getHash());
 					m_on_list_changed.invoke(path_obj);
 				}
 				else {
+					updateSourceInfo(path_obj);
 					addResource(path_obj);
 					pushToCompileQueue(path_obj);
 				}
+				// so the directory is not rescanned on next start
+				updateDirInfo(getParentDir(path_obj));
 			}
 			else {
 				StringView ext = Path::getExtension(path_obj);
@@ -796,12 +1712,21 @@ struct AssetCompilerImpl : AssetCompiler {
 	Mutex m_changed_mutex;
 	Mutex m_plugin_mutex;
 	jobs::Mutex m_resources_mutex;
-	HashMap<Path, u32> m_generations; 
+	HashMap<Path, CompileState> m_compile_states;
+	// dependency -> dependents
 	HashMap<Path, Array<Path>> m_dependencies; 
+	// dependent -> dependencies, built from m_dependencies when needed
+	HashMap<Path, Array<Path>> m_dependencies_of;
+	bool m_dependencies_of_dirty = true;
 	Array<Path> m_changed_files;
 	Array<Path> m_changed_dirs;
-	Array<CompileJob> m_to_compile;
+	// sorted so the next job to dispatch is at the back
+	Array<PendingCompile> m_to_compile;
+	bool m_to_compile_sorted = true;
+	u32 m_jobs_in_flight = 0;
 	Array<CompileJob> m_compiled;
+	// guarded by m_compiled_mutex, see queueCachedDependencies
+	Array<CachedDependency> m_cached_dependencies;
 	StudioApp& m_app;
 	LoadHook m_load_hook;
 	HashMap<RuntimeHash, IPlugin*> m_plugins;
@@ -812,11 +1737,23 @@ struct AssetCompilerImpl : AssetCompiler {
 	DelegateList<void(Resource&, bool)> m_resource_compiled;
 	bool m_init_finished = false;
 	Array<Resource*> m_on_init_load;
-	u8* m_lz4_state = nullptr;
-	jobs::Mutex m_lz4_mutex;
+	mutable Mutex m_compression_mutex;
+	HashMap<ResourceType, Compression> m_compression;
+	Path m_cache_dir;
+	Path m_shared_cache_dir;
+	Mutex m_cache_mutex;
+	// resources written and dependencies registered by compiles in progress, see compileCached
+	HashMap<Path, CacheEntry> m_cache_entries;
+	Array<CompileStats> m_compile_stats;
+	// persisted in _db.bin
+	HashMap<FilePathHash, SourceInfo> m_sources;
+	HashMap<FilePathHash, DirInfo> m_dirs;
 
 	u32 m_compile_batch_count = 0;
 	u32 m_batch_remaining_count = 0;
+	os::Timer m_batch_timer;
+	// sum of compile times of finished jobs in current batch
+	float m_batch_busy_time = 0;
 	Path m_res_in_progress;
 };
 
@@ -17,6 +17,29 @@ struct LUMIX_EDITOR_API AssetCompiler {
 		virtual bool compile(const Path& src) = 0;
 		virtual void addSubresources(AssetCompiler& compiler, const Path& path);
 		virtual void listLoaded() {}
+		// part of compile cache key, bump when output of `compile` changes for the same input
+		virtual u32 getVersion() const { return 0; }
+	};
+
+	// compression of compiled resources
+	enum class Compression : u8 {
+		NONE,
+		// LZ4 with higher acceleration, faster compile, bigger output
+		FAST,
+		// LZ4_compress_default
+		DEFAULT,
+		// LZ4 HC, slower compile, smaller output, the same decompression speed, e.g. for shipping builds
+		DENSE
+	};
+
+	// compiles since start, per resource type
+	struct CompileStats {
+		ResourceType type;
+		u32 compiled = 0;
+		u32 failed = 0;
+		u32 from_cache = 0;
+		// summed over all compiles in seconds, compiles run in parallel, so it's not the wall time
+		float time = 0;
 	};
 
 	struct ResourceItem {
@@ -35,13 +58,21 @@ struct LUMIX_EDITOR_API AssetCompiler {
 	virtual void addPlugin(IPlugin& plugin, Span<const char*> extensions) = 0;
 	virtual void removePlugin(IPlugin& plugin) = 0;
 	virtual bool compile(const Path& path) = 0;
+	// queues every known resource with missing or outdated compiled file, returns number of queued sources
+	virtual u32 compileOutdated() = 0;
+	// true if any compile is queued or running
+	virtual bool isCompiling() const = 0;
+	virtual Span<const CompileStats> getCompileStats() const = 0;
 	virtual lua_State* getMeta(const Path& res) = 0;
 	virtual void updateMeta(const Path& resource, Span<const u8> data) const = 0;
 	virtual const HashMap<FilePathHash, ResourceItem>& lockResources() = 0;
 	virtual void unlockResources() = 0;
 	virtual void registerDependency(const Path& included_from, const Path& dependency) = 0;
 	virtual void addResource(ResourceType type, const Path& path) = 0;
+	// compressed according to `compression` in resource's meta ("none", "fast", "default", "dense"), or per type setting, DEFAULT if neither is set
 	virtual bool writeCompiledResource(const Path& path, Span<const u8> data) = 0;
+	virtual void setCompression(ResourceType type, Compression compression) = 0;
+	virtual Compression getCompression(ResourceType type) const = 0;
 	virtual bool copyCompile(const Path& src) = 0;
 	virtual DelegateList<void(const Path&)>& listChanged() = 0;
 	virtual DelegateList<void(Resource&, bool)>& resourceCompiled() = 0;
@@ -619,12 +619,47 @@ struct ProfilerUIImpl final : StudioApp::GUIPlugin {
 		return iter.isValid() ? iter.value().name : "Unknown";
 	}
 
+	// budget is edited in MB, 0 == unlimited
+	static bool budgetGUI(const char* id, ResourceManager::Budget& budget) {
+		ImGui::PushID(id);
+		u64 cpu_mb = budget.cpu / (1024 * 1024);
+		u64 gpu_mb = budget.gpu / (1024 * 1024);
+		ImGuiEx::Label("CPU budget (MB)");
+		bool changed = ImGui::DragScalar("##cpu", ImGuiDataType_U64, &cpu_mb, 1);
+		ImGuiEx::Label("GPU budget (MB)");
+		changed = ImGui::DragScalar("##gpu", ImGuiDataType_U64, &gpu_mb, 1) || changed;
+		ImGui::PopID();
+		budget.cpu = cpu_mb * 1024 * 1024;
+		budget.gpu = gpu_mb * 1024 * 1024;
+		return changed;
+	}
+
+	void saveLoadStats(bool json) {
+		OutputMemoryStream blob(m_allocator);
+		ResourceManagerHub& hub = m_engine.getResourceManager();
+		if (json) hub.writeLoadStatsJSON(blob);
+		else hub.writeLoadStatsCSV(blob);
+		const Path path(json ? "load_stats.json" : "load_stats.csv");
+		if (m_engine.getFileSystem().saveContentSync(path, blob)) logInfo("Load stats saved to ", path);
+		else logError("Failed to save ", path);
+	}
+
 	void onGUIResources() {
 		m_resource_filter.gui("Filter");
 	
 		ImGuiEx::Label("Filter size (KB)");
 		ImGui::DragScalar("##fs", ImGuiDataType_U64, &m_resource_size_filter, 1000);
 
+		ResourceManagerHub& hub = m_engine.getResourceManager();
+		ResourceManager::Budget global_budget = hub.getBudget();
+		if (budgetGUI("global", global_budget)) hub.setBudget(global_budget);
+
+		if (ImGui::Button("Save load stats as CSV")) saveLoadStats(false);
+		ImGui::SameLine();
+		if (ImGui::Button("Save load stats as JSON")) saveLoadStats(true);
+		ImGui::SameLine();
+		if (ImGui::Button("Reset load stats")) hub.resetLoadStats();
+
 		static const struct {
 			ResourceType type;
 			const char* name;
@@ -645,11 +680,32 @@ struct ProfilerUIImpl final : StudioApp::GUIPlugin {
 			ResourceManager* resource_manager = m_engine.getResourceManager().get(RESOURCE_TYPES[i].type);
 			ResourceManager::ResourceTable& resources = resource_manager->getResourceTable();
 
-			if (ImGui::BeginTable("resc", 4)) {
+			const ResourceManager::Stats& stats = resource_manager->getStats();
+			ImGui::Text("Resident: CPU %.2f MB, GPU %.2f MB", stats.cpu_resident / (1024.f * 1024.f), stats.gpu_resident / (1024.f * 1024.f));
+			ImGui::Text("Cached: %u, CPU %.2f MB, GPU %.2f MB", stats.cached_count, stats.cpu_cached / (1024.f * 1024.f), stats.gpu_cached / (1024.f * 1024.f));
+			const u32 requests = stats.hits + stats.misses;
+			ImGui::Text("Hit rate: %.1f%% (%u hits, %u misses), %u evictions", requests ? 100.f * stats.hits / requests : 0.f, stats.hits, stats.misses, stats.evictions);
+			ResourceManager::Budget budget = resource_manager->getBudget();
+			if (budgetGUI(RESOURCE_TYPES[i].name, budget)) resource_manager->setBudget(budget);
+
+			const ResourceManager::LoadStats& load_stats = resource_manager->getLoadStats();
+			ImGui::Text("Loaded: %u, read %.2f MB (%.2f MB compressed -> %.2f MB)", load_stats.count
+				, load_stats.bytes_read / (1024.f * 1024.f)
+				, load_stats.compressed_bytes_read / (1024.f * 1024.f)
+				, load_stats.decompressed_size / (1024.f * 1024.f));
+			ImGui::Text("Queue wait %.1f ms, read %.1f ms, decompress %.1f ms, load %.1f ms, dependency wait %.1f ms"
+				, load_stats.queue_wait * 1000
+				, load_stats.read * 1000
+				, load_stats.decompress * 1000
+				, load_stats.load * 1000
+				, load_stats.dependency_wait * 1000);
+
+			if (ImGui::BeginTable("resc", 5)) {
 				ImGui::TableSetupColumn("Path");
 				ImGui::TableSetupColumn("Size");
 				ImGui::TableSetupColumn("State");
 				ImGui::TableSetupColumn("References");
+				ImGui::TableSetupColumn("Load (ms)");
 				ImGui::TableHeadersRow();
 
 				size_t sum = 0;
@@ -672,6 +728,17 @@ struct ProfilerUIImpl final : StudioApp::GUIPlugin {
 					ImGui::TextUnformatted(toString(iter.value()->getState()));
 					ImGui::TableNextColumn();
 					ImGui::Text("%u", iter.value()->getRefCount());
+					ImGui::TableNextColumn();
+					const ResourceLoadStats& stats = iter.value()->getLoadStats();
+					ImGui::Text("%.2f", (stats.queue_wait + stats.read + stats.decompress + stats.load + stats.dependency_wait) * 1000);
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Queue wait: %.2f ms\nRead: %.2f ms\nDecompress: %.2f ms\nLoad: %.2f ms\nDependency wait: %.2f ms"
+							, stats.queue_wait * 1000
+							, stats.read * 1000
+							, stats.decompress * 1000
+							, stats.load * 1000
+							, stats.dependency_wait * 1000);
+					}
 				}
 
 				ImGui::TableNextColumn();
@@ -681,6 +748,7 @@ struct ProfilerUIImpl final : StudioApp::GUIPlugin {
 				ImGui::Text("%.3fKB", sum / 1024.0f);
 				ImGui::TableNextColumn();
 				ImGui::TableNextColumn();
+				ImGui::TableNextColumn();
 
 				ImGui::EndTable();
 			}
@@ -16,6 +16,7 @@
 #include "engine/associative_array.h"
 #include "engine/atomic.h"
 #include "engine/command_line_parser.h"
+#include "engine/crt.h"
 #include "engine/debug.h"
 #include "engine/engine.h"
 #include "engine/file_system.h"
@@ -37,6 +38,7 @@
 #include "settings.h"
 #include "studio_app.h"
 #include "utils.h"
+#include "lz4/lz4.h"
 
 #ifdef _WIN32
 	#include "engine/win/simple_win.h"
@@ -288,6 +290,58 @@ struct StudioAppImpl final : StudioApp
 		semaphore.wait();
 	}
 
+	void runBatchCompile() override {
+		m_is_batch_compile = true;
+		profiler::setThreadName("Main thread");
+		Semaphore semaphore(0, 1);
+		jobs::runLambda([this, &semaphore]() {
+			onInit();
+			batchCompile();
+			onShutdown();
+			semaphore.signal();
+		}, nullptr, 0);
+		semaphore.wait();
+	}
+
+	// command line: [-data_dir <dir>] [-compile_cache <dir>] [-compile_cache_limit <MB>] [-pak <dest dir>]
+	void batchCompile() {
+		os::Timer timer;
+		const u32 queued = m_asset_compiler->compileOutdated();
+		logInfo("Compiling ", queued, " assets");
+		FileSystem& fs = m_engine->getFileSystem();
+		while (m_asset_compiler->isCompiling() || fs.hasWork()) {
+			fs.processCallbacks();
+			m_asset_compiler->update();
+			os::sleep(1);
+		}
+
+		u32 failed = 0;
+		logInfo("type: compiled, failed, from cache, time");
+		for (const AssetCompiler::CompileStats& stats : m_asset_compiler->getCompileStats()) {
+			logInfo(stats.type.str ? stats.type.str : "unknown", ": ", stats.compiled, ", ", stats.failed, ", ", stats.from_cache, ", ", stats.time, " s");
+			failed += stats.failed;
+		}
+		logInfo("Compiling took ", timer.getTimeSinceStart(), " s");
+		m_exit_code = failed > 0 ? 1 : 0;
+
+		char cmd_line[2048];
+		os::getCommandLine(Span(cmd_line));
+		CommandLineParser parser(cmd_line);
+		while (parser.next()) {
+			if (!parser.currentEquals("-pak")) continue;
+			if (!parser.next()) break;
+
+			char dir[MAX_PATH];
+			parser.getCurrent(dir, lengthOf(dir));
+			m_export.dest_dir = dir;
+			if (!endsWith(dir, "/") && !endsWith(dir, "\\")) m_export.dest_dir.append("/");
+			m_export.mode = ExportConfig::Mode::ALL_FILES;
+			m_export.pack = true;
+			if (!exportData()) m_exit_code = 1;
+			break;
+		}
+	}
+
 	
 	static void* imguiAlloc(size_t size, void* user_data) {
 		StudioAppImpl* app = (StudioAppImpl*)user_data;
@@ -353,6 +407,9 @@ struct StudioAppImpl final : StudioApp
 		init_data.init_window_args.user_data = this;
 		init_data.init_window_args.hit_test_callback = &StudioAppImpl::hitTestCallback;
 		init_data.init_window_args.flags = os::InitWindowArgs::NO_DECORATION;
+		// asset compilers do not need a GPU, plugins are still loaded since they register the compilers
+		if (m_is_batch_compile) init_data.init_window_args.flags |= os::InitWindowArgs::HIDDEN | os::InitWindowArgs::NO_TASKBAR_ICON;
+		init_data.no_gpu = m_is_batch_compile;
 		const char* plugins[] = {
 			#define LUMIX_PLUGINS_STRINGS
 				#include "engine/plugins.inl"
@@ -388,12 +445,12 @@ struct StudioAppImpl final : StudioApp
 		initPlugins(); // needs initialized imgui
 		loadSettings(); // needs plugins
 
-		loadWorldFromCommandLine();
+		if (!m_is_batch_compile) loadWorldFromCommandLine();
 
 		m_asset_compiler->onInitFinished();
 		m_asset_browser->onInitFinished();
 		
-		checkScriptCommandLine();
+		if (!m_is_batch_compile) checkScriptCommandLine();
 
 		logInfo("Init took ", init_timer.getTimeSinceStart(), " s");
 		#ifdef _WIN32
@@ -419,12 +476,13 @@ struct StudioAppImpl final : StudioApp
 		m_asset_browser->releaseResources();
 		m_watched_plugin.watcher.reset();
 
-		saveSettings();
+		if (!m_is_batch_compile) saveSettings();
 
 		while (m_engine->getFileSystem().hasWork()) {
 			m_engine->getFileSystem().processCallbacks();
 		}
 
+		discardLoadOrderRecording();
 		m_editor->newWorld();
 
 		destroyAddCmpTreeNode(m_add_cmp_root.child);
@@ -829,6 +887,7 @@ struct StudioAppImpl final : StudioApp
 		showGizmos();
 		
 		m_engine->update(*m_editor->getWorld());
+		updateLoadOrderRecording();
 
 		++m_fps_frame;
 		if (m_fps_timer.getTimeSinceTick() > 1.0f) {
@@ -940,10 +999,61 @@ struct StudioAppImpl final : StudioApp
 			return;
 		}
 
+		if (!additive) {
+			// previous world did not finish loading, its recording is incomplete
+			discardLoadOrderRecording();
+			OutputMemoryStream manifest(m_allocator);
+			if (fs.getContentSync(FileSystem::getLoadOrderPath(path), manifest)) fs.prefetch(manifest);
+			fs.startRecording();
+			m_load_order_world = path;
+			m_load_order_idle_time = 0;
+		}
+
 		InputMemoryStream blob(data); 
 		m_editor->loadWorld(blob, path.c_str(), additive);
 	}
 
+	void discardLoadOrderRecording() {
+		if (m_load_order_world.isEmpty()) return;
+		FileSystem& fs = m_engine->getFileSystem();
+		OutputMemoryStream manifest(m_allocator);
+		fs.stopRecording(manifest);
+		fs.stopPrefetch();
+		m_load_order_world = Path();
+	}
+
+	// files requested while loading a world are saved in FileSystem::getLoadOrderPath(world), once the loading settles down
+	// it's not saved if the world is closed before, see discardLoadOrderRecording
+	// the exporter uses it to order main.pak and the game prefetches it on the next load
+	void updateLoadOrderRecording() {
+		if (m_load_order_world.isEmpty()) return;
+
+		FileSystem& fs = m_engine->getFileSystem();
+		if (fs.hasWork()) {
+			m_load_order_idle_time = 0;
+			return;
+		}
+		// asset compiler can request more files in a few frames
+		m_load_order_idle_time += m_engine->getLastTimeDelta();
+		if (m_load_order_idle_time < 1) return;
+
+		OutputMemoryStream manifest(m_allocator);
+		fs.stopRecording(manifest);
+		fs.stopPrefetch();
+		const FileSystem::PrefetchStats stats = fs.getPrefetchStats();
+		if (stats.prefetched > 0) {
+			logInfo("Load order of ", m_load_order_world, ": ", stats.hits, " hits, ", stats.misses, " misses, ", stats.unused, " unused prefetched files");
+		}
+		// world's resources might be already loaded, nothing to record
+		if (manifest.size() > 0) {
+			const Path load_order_path = FileSystem::getLoadOrderPath(m_load_order_world);
+			const Path dir(fs.getBasePath(), Path::getDir(load_order_path));
+			if (!os::dirExists(dir)) os::makePath(dir.c_str());
+			if (!fs.saveContentSync(load_order_path, manifest)) logError("Failed to save ", load_order_path);
+		}
+		m_load_order_world = Path();
+	}
+
 	void guiWelcomeScreen()
 	{
 		ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings;
@@ -1095,6 +1205,7 @@ struct StudioAppImpl final : StudioApp
 			m_confirm_new = true;
 		}
 		else {
+			discardLoadOrderRecording();
 			m_editor->newWorld();
 			initDefaultWorld();
 		}
@@ -1540,6 +1651,7 @@ struct StudioAppImpl final : StudioApp
 			ImGui::NewLine();
 			alignGUICenter([&](){
 				if (ImGui::Button("Continue")) {
+					discardLoadOrderRecording();
 					m_editor->newWorld();
 					initDefaultWorld();
 					ImGui::CloseCurrentPopup();
@@ -2268,7 +2380,10 @@ struct StudioAppImpl final : StudioApp
 
 		m_is_entity_list_open = m_settings.m_is_entity_list_open;
 
-		if (m_settings.m_is_maximized)
+		if (m_is_batch_compile) {
+			// keep the window hidden
+		}
+		else if (m_settings.m_is_maximized)
 		{
 			os::maximizeWindow(m_main_window);
 		}
@@ -2284,6 +2399,7 @@ struct StudioAppImpl final : StudioApp
 		m_export.dest_dir = "";
 		m_settings.getValue(Settings::LOCAL, "export_dir", Span(m_export.dest_dir.data));
 		m_settings.getValue(Settings::LOCAL, "export_pack", m_export.pack);
+		m_settings.getValue(Settings::LOCAL, "export_compress", m_export.compress);
 		m_file_selector.m_current_dir = m_settings.getStringValue(Settings::LOCAL, "fileselector_dir", "");
 	}
 
@@ -3126,9 +3242,22 @@ struct StudioAppImpl final : StudioApp
 
 		exportDataScan("pipelines/", infos);
 		exportDataScan("universes/", infos);
+		exportLoadOrders(infos);
 		exportFile("lumix.prj", infos);
 	}
 
+	// load order manifests are in .lumix, which is otherwise not exported
+	void exportLoadOrders(AssociativeArray<FilePathHash, ExportFileInfo>& infos) {
+		os::FileIterator* iter = m_engine->getFileSystem().createFileIterator(".lumix/load_order");
+		os::FileInfo info;
+		while (os::getNextFile(iter, &info)) {
+			if (info.is_directory) continue;
+			const Path path(".lumix/load_order/", info.filename);
+			exportFile(path.c_str(), infos);
+		}
+		os::destroyFileIterator(iter);
+	}
+
 
 	void exportFile(const char* file_path, AssociativeArray<FilePathHash, ExportFileInfo>& infos) {
 		const char* base_path = m_engine->getFileSystem().getBasePath();
@@ -3206,6 +3335,7 @@ struct StudioAppImpl final : StudioApp
 		exportDataScan("scripts/", infos);
 		exportDataScan("pipelines/", infos);
 		exportDataScan("universes/", infos);
+		exportLoadOrders(infos);
 		exportFile("lumix.prj", infos);
 	}
 
@@ -3232,6 +3362,12 @@ struct StudioAppImpl final : StudioApp
 			if (ImGui::Checkbox("##pack", &m_export.pack)) {
 				m_settings.setValue(Settings::LOCAL, "export_pack", m_export.pack);
 			}
+			if (m_export.pack) {
+				ImGuiEx::Label("Compress data");
+				if (ImGui::Checkbox("##compress", &m_export.compress)) {
+					m_settings.setValue(Settings::LOCAL, "export_compress", m_export.compress);
+				}
+			}
 			ImGuiEx::Label("Mode");
 			if (ImGui::Combo("##mode", (int*)&m_export.mode, "All files\0Loaded world\0")) {
 				m_settings.setValue(Settings::LOCAL, "export_pack", (i32)m_export.mode);
@@ -3266,6 +3402,143 @@ struct StudioAppImpl final : StudioApp
 	}
 
 
+	// pak key of a file, the same as PackFileSystem uses for lookup
+	static FilePathHash getPackHash(const char* path) {
+		StringView basename = Path::getBasename(path);
+		u64 hash;
+		fromCString(basename, hash);
+		if (basename.size() == 0 || basename[0] < '0' || basename[0] > '9' || hash == 0) return FilePathHash(path);
+		return FilePathHash::fromU64(hash);
+	}
+
+	// files in load order manifests of worlds (see FileSystem::getLoadOrderPath) go first, in the same order, so loading a world reads the pak sequentially
+	// the rest, or everything if there are no manifests, is sorted by source path (not by `.lumix/resources/<hash>.res`),
+	// so subresources of a source and files from the same directory, which are usually loaded together, are close to each other
+	void getPackOrder(AssociativeArray<FilePathHash, ExportFileInfo>& infos, Array<ExportFileInfo*>& out) {
+		FileSystem& fs = m_engine->getFileSystem();
+		Array<bool> added(m_allocator);
+		added.resize(infos.size());
+		for (bool& b : added) b = false;
+
+		OutputMemoryStream manifest(m_allocator);
+		auto addManifest = [&](const Path& world){
+			manifest.clear();
+			if (!fs.getContentSync(FileSystem::getLoadOrderPath(world), manifest)) return;
+			const char* line = (const char*)manifest.data();
+			const char* end = line + manifest.size();
+			while (line < end) {
+				const char* line_end = line;
+				while (line_end < end && *line_end != '\n' && *line_end != '\r') ++line_end;
+				if (line_end > line) {
+					const Path path(StringView(line, line_end));
+					const i32 idx = infos.find(getPackHash(path.c_str()));
+					if (idx >= 0 && !added[idx]) {
+						added[idx] = true;
+						out.push(&infos.at(idx));
+					}
+				}
+				line = line_end + 1;
+			}
+		};
+		if (!m_export.startup_world.isEmpty()) addManifest(m_export.startup_world);
+		forEachWorld([&](const Path& world){ addManifest(world); });
+
+		struct SortItem {
+			ExportFileInfo* info;
+			Path path;
+		};
+		Array<SortItem> rest(m_allocator);
+		{
+			const HashMap<FilePathHash, AssetCompiler::ResourceItem>& resources = m_asset_compiler->lockResources();
+			for (i32 i = 0; i < infos.size(); ++i) {
+				if (added[i]) continue;
+				auto iter = resources.find(infos.getKey(i));
+				rest.push({&infos.at(i), iter.isValid() ? iter.value().path : Path(infos.at(i).path)});
+			}
+			m_asset_compiler->unlockResources();
+		}
+		qsort(rest.begin(), rest.size(), sizeof(rest[0]), [](const void* a, const void* b){
+			return compareString(((const SortItem*)a)->path, ((const SortItem*)b)->path);
+		});
+		for (const SortItem& item : rest) out.push(item.info);
+	}
+
+	// writes main.pak v2, see PackHeader
+	bool exportPack(const char* dest, AssociativeArray<FilePathHash, ExportFileInfo>& infos) {
+		FileSystem& fs = m_engine->getFileSystem();
+		Array<ExportFileInfo*> ordered(m_allocator);
+		ordered.reserve(infos.size());
+		getPackOrder(infos, ordered);
+
+		os::OutputFile file;
+		if (!file.open(dest)) {
+			logError("Could not create ", dest);
+			return false;
+		}
+
+		PackHeader header;
+		header.count = (u32)infos.size();
+		bool success = file.write(&header, sizeof(header));
+		u64 offset = sizeof(header);
+
+		static const u8 zeros[PackHeader::ALIGNMENT] = {};
+		auto align = [&](){
+			const u64 padding = (PackHeader::ALIGNMENT - offset % PackHeader::ALIGNMENT) % PackHeader::ALIGNMENT;
+			success = file.write(zeros, padding) && success;
+			offset += padding;
+		};
+
+		Array<PackEntry> index(m_allocator);
+		index.reserve(ordered.size());
+		OutputMemoryStream src(m_allocator);
+		OutputMemoryStream compressed(m_allocator);
+		for (ExportFileInfo* info : ordered) {
+			src.clear();
+			if (!fs.getContentSync(Path(info->path), src)) {
+				logError("Could not read ", info->path);
+				file.close();
+				return false;
+			}
+
+			align();
+			PackEntry& entry = index.emplace();
+			entry.hash = info->hash;
+			entry.offset = offset;
+			entry.uncompressed_size = src.size();
+			Span<const u8> data = src;
+			if (m_export.compress) {
+				const i32 cap = LZ4_compressBound((i32)src.size());
+				compressed.resize(cap);
+				const i32 compressed_size = LZ4_compress_default((const char*)src.data(), (char*)compressed.getMutableData(), (i32)src.size(), cap);
+				// uncompressed entries are used without a copy, so compress only if it saves at least one aligned block
+				if (compressed_size > 0 && u64(compressed_size) + PackHeader::ALIGNMENT <= src.size()) {
+					data = Span((const u8*)compressed.data(), (u32)compressed_size);
+					entry.flags = PackEntry::COMPRESSED;
+				}
+			}
+			entry.size = data.length();
+			info->offset = offset;
+			success = file.write(data.begin(), data.length()) && success;
+			offset += data.length();
+		}
+
+		align();
+		qsort(index.begin(), index.size(), sizeof(index[0]), [](const void* a, const void* b){
+			const FilePathHash ha = ((const PackEntry*)a)->hash;
+			const FilePathHash hb = ((const PackEntry*)b)->hash;
+			if (ha < hb) return -1;
+			return hb < ha ? 1 : 0;
+		});
+		success = file.write(index.begin(), index.byte_size()) && success;
+		file.close();
+
+		if (!success) {
+			logError("Could not write ", dest);
+			return false;
+		}
+		return true;
+	}
+
 	bool exportData() {
 		if (m_export.dest_dir.empty()) return false;
 
@@ -3295,43 +3568,7 @@ struct StudioAppImpl final : StudioApp
 				logError("No files found while trying to create ", dest);
 				return false;
 			}
-			u64 total_size = 0;
-			for (ExportFileInfo& info : infos) {
-				info.offset = total_size;
-				total_size += info.size;
-			}
-			
-			os::OutputFile file;
-			if (!file.open(dest)) {
-				logError("Could not create ", dest);
-				return false;
-			}
-
-			const u32 count = (u32)infos.size();
-			bool success = file.write(&count, sizeof(count));
-
-			for (auto& info : infos) {
-				success = file.write(&info.hash, sizeof(info.hash)) && success;
-				success = file.write(&info.offset, sizeof(info.offset)) && success;
-				success = file.write(&info.size, sizeof(info.size)) && success;
-			}
-
-			OutputMemoryStream src(m_allocator);
-			for (const ExportFileInfo& info : infos) {
-				src.clear();
-				if (!fs.getContentSync(Path(info.path), src)) {
-					logError("Could not read ", info.path);
-					file.close();
-					return false;
-				}
-				success = file.write(src.data(), src.size()) && success;
-			}
-			file.close();
-
-			if (!success) {
-				logError("Could not write ", dest);
-				return false;
-			}
+			if (!exportPack(dest, infos)) return false;
 		}
 		else {
 			const char* base_path = fs.getBasePath();
@@ -3469,6 +3706,9 @@ struct StudioAppImpl final : StudioApp
 	
 	World::PartitionHandle m_partition_to_destroy;
 	Path m_world_to_load;
+	// world whose load order is being recorded, empty if none
+	Path m_load_order_world;
+	float m_load_order_idle_time = 0;
 	
 	ImTextureID m_logo = nullptr;
 	UniquePtr<AssetBrowser> m_asset_browser;
@@ -3501,6 +3741,7 @@ struct StudioAppImpl final : StudioApp
 		Mode mode = Mode::ALL_FILES;
 
 		bool pack = false;
+		bool compress = false;
 		Path startup_world;
 		StaticString<MAX_PATH> dest_dir;
 	};
@@ -3509,6 +3750,7 @@ struct StudioAppImpl final : StudioApp
 	float m_export_msg_timer = -1;
 	bool m_entity_selection_changed = false;
 	bool m_finished;
+	bool m_is_batch_compile = false;
 	bool m_deferred_game_mode_exit;
 	int m_exit_code;
 
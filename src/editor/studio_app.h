@@ -84,6 +84,8 @@ struct LUMIX_EDITOR_API StudioApp {
 	virtual struct Engine& getEngine() = 0;
 	virtual WorldEditor& getWorldEditor() = 0;
 	virtual void run() = 0;
+	// compiles all outdated assets without GUI and exits, see lumix_compile
+	virtual void runBatchCompile() = 0;
 	virtual int getExitCode() const = 0;
 	
 	virtual struct PropertyGrid& getPropertyGrid() = 0;
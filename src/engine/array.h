@@ -155,7 +155,7 @@ template <typename T> struct Array {
 		ASSERT(count > 0);
 
 		if constexpr (__is_trivially_copyable(T)) {
-			memcpy(m_data + from, m_data + from + count, (m_size - from - count) * sizeof(T));
+			memmove(m_data + from, m_data + from + count, (m_size - from - count) * sizeof(T));
 		}
 		else {
 			for (u32 i = from; i < m_size - count; ++i) {
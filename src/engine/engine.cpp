@@ -70,6 +70,7 @@ struct EngineImpl final : Engine {
 		registerLogCallback<&EngineImpl::logToFile>(this);
 		registerLogCallback<logToDebugOutput>();
 
+		m_no_gpu = init_data.no_gpu;
 		m_window_handle = os::createWindow(init_data.init_window_args);
 		if (m_window_handle == os::INVALID_WINDOW) {
 			logError("Failed to create main window.");
@@ -99,15 +100,16 @@ struct EngineImpl final : Engine {
 			m_file_system = static_cast<UniquePtr<FileSystem>&&>(init_data.file_system);
 		}
 		else if (init_data.working_dir) {
-			m_file_system = FileSystem::create(init_data.working_dir, m_allocator);
+			m_file_system = FileSystem::create(init_data.working_dir, m_allocator, init_data.file_system_threads_count, init_data.file_system_io_uring);
 		}
 		else {
 			char current_dir[MAX_PATH];
 			os::getCurrentDirectory(Span(current_dir)); 
-			m_file_system = FileSystem::create(current_dir, m_allocator);
+			m_file_system = FileSystem::create(current_dir, m_allocator, init_data.file_system_threads_count, init_data.file_system_io_uring);
 		}
 
 		m_resource_manager.init(*m_file_system);
+		m_resource_manager.parseBudgets(cmd_line);
 		m_prefab_resource_manager.create(PrefabResource::TYPE, m_resource_manager);
 
 		m_system_manager = SystemManager::create(*this);
@@ -141,10 +143,12 @@ struct EngineImpl final : Engine {
 
 	~EngineImpl()
 	{
+		m_resource_manager.clearCache();
 		m_prefab_resource_manager.destroy();
 		for (Resource* res : m_lua_resources) {
 			res->decRefCount();
 		}
+		m_resource_manager.clearCache();
 
 		m_system_manager.reset();
 		m_input_system.reset();
@@ -198,6 +202,7 @@ struct EngineImpl final : Engine {
 	}
 
 	os::WindowHandle getWindowHandle() override { return m_window_handle; }
+	bool isGPUDisabled() const override { return m_no_gpu; }
 	IAllocator& getAllocator() override { return m_allocator; }
 	PageAllocator& getPageAllocator() override { return m_page_allocator; }
 
@@ -357,6 +362,7 @@ struct EngineImpl final : Engine {
 		profiler::pushCounter(counter, dt * 1000.f);
 
 		computeSmoothTimeDelta();
+		m_resource_manager.update();
 
 		if (!m_paused || m_next_frame) {
 			{
@@ -489,6 +495,7 @@ private:
 	bool m_paused;
 	bool m_next_frame;
 	os::WindowHandle m_window_handle;
+	bool m_no_gpu = false;
 	lua_State* m_state;
 	os::OutputFile m_log_file;
 	bool m_is_log_file_open = false;
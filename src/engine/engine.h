@@ -24,6 +24,11 @@ struct LUMIX_ENGINE_API Engine {
 		const char* working_dir = nullptr;
 		Span<const char*> plugins;
 		UniquePtr<struct FileSystem> file_system;
+		// used only if file_system is not provided, keep in sync with defaults of FileSystem::create
+		u32 file_system_threads_count = 2;
+		bool file_system_io_uring = false;
+		// nothing is rendered, so systems do not create GPU devices, e.g. for batch tools; the window is still created
+		bool no_gpu = false;
 		os::InitWindowArgs init_window_args;
 	};
 
@@ -37,6 +42,8 @@ struct LUMIX_ENGINE_API Engine {
 	virtual struct World& createWorld(bool is_main_world) = 0;
 	virtual void destroyWorld(World& world) = 0;
 	virtual os::WindowHandle getWindowHandle() = 0;
+	// see InitArgs::no_gpu
+	virtual bool isGPUDisabled() const = 0;
 
 	virtual struct FileSystem& getFileSystem() = 0;
 	virtual struct InputSystem& getInputSystem() = 0;
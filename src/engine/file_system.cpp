@@ -2,10 +2,13 @@
 
 #include "engine/allocator.h"
 #include "engine/array.h"
+#include "engine/crt.h"
 #include "engine/delegate_list.h"
 #include "engine/hash_map.h"
+#include "engine/job_system.h"
 #include "engine/metaprogramming.h"
 #include "engine/log.h"
+#include "engine/math.h"
 #include "engine/sync.h"
 #include "engine/thread.h"
 #include "engine/os.h"
@@ -13,6 +16,7 @@
 #include "engine/profiler.h"
 #include "engine/stream.h"
 #include "engine/string.h"
+#include "lz4/lz4.h"
 
 namespace Lumix {
 
@@ -21,18 +25,51 @@ struct AsyncItem {
 		NONE = 0,
 		FAILED = 1 << 0,
 		CANCELED = 1 << 1,
+		FINISHED = 1 << 2,
+		// content is in `view` instead of `data`
+		VIEW = 1 << 3,
+		// PrepareCallback is running on a worker
+		PREPARING = 1 << 4,
+		// read ahead by prefetch, nobody requested it yet
+		PREFETCH = 1 << 5,
 	};
 
 	AsyncItem(IAllocator& allocator) : data(allocator) {}
 	
 	bool isFailed() const { return isFlagSet(flags, Flags::FAILED); }
 	bool isCanceled() const { return isFlagSet(flags, Flags::CANCELED); }
+	bool isFinished() const { return isFlagSet(flags, Flags::FINISHED); }
+	bool isView() const { return isFlagSet(flags, Flags::VIEW); }
+	bool isPreparing() const { return isFlagSet(flags, Flags::PREPARING); }
+	bool isPrefetch() const { return isFlagSet(flags, Flags::PREFETCH); }
+	Span<const u8> getContent() const { return isView() ? view : Span((const u8*)data.data(), (u32)data.size()); }
 
 	FileSystem::ContentCallback callback;
+	FileSystem::PrepareCallback prepare;
 	OutputMemoryStream data;
+	// memory owned by the file system, e.g. mapped pack file
+	Span<const u8> view;
+	// on_finish of prepare job, allocated on the first prepare in the slot and kept with the slot
+	// separate allocation, since it must not move when m_items grows
+	jobs::Signal* prepare_signal = nullptr;
 	Path path;
+	// AsyncHandle::value, index of slot in lower bits, generation of slot in upper bits
 	u32 id = 0;
 	Flags flags = Flags::NONE;
+	FileSystem::Priority priority = FileSystem::Priority::NORMAL;
+	// raw timestamps
+	u64 deadline;
+	u64 queued;
+	u64 read_start;
+	u64 read_end;
+	// to keep FIFO order of requests with the same priority and deadline
+	u64 sequence;
+	// position in FileSystemImpl::m_queue, NOT_QUEUED if it's not there
+	u32 queue_index = NOT_QUEUED;
+	// of prefetched file, when it was requested by prefetch, to detect files changed before they are claimed
+	u64 last_modified = 0;
+
+	static constexpr u32 NOT_QUEUED = 0xffFFffFF;
 };
 
 struct FileSystemImpl;
@@ -46,32 +83,72 @@ struct FSTask final : Thread {
 
 	~FSTask() = default;
 
-	void stop();
 	int task() override;
 
 private:
+	int batchTask();
+
 	FileSystemImpl& m_fs;
-	bool m_finish = false;
 };
 
 
 struct FileSystemImpl : FileSystem {
-	explicit FileSystemImpl(const char* base_path, IAllocator& allocator)
+	static constexpr u32 SLOT_BITS = 20;
+	static constexpr u32 SLOT_MASK = (1 << SLOT_BITS) - 1;
+	static constexpr u32 MAX_GENERATION = (0xffFFffFF >> SLOT_BITS) - 1; // so AsyncHandle is never invalid
+	static constexpr u32 BATCH_QUEUE_DEPTH = 64;
+
+	explicit FileSystemImpl(const char* base_path, IAllocator& allocator, u32 io_threads_count, bool use_io_uring)
 		: m_allocator(allocator)
+		, m_items(allocator)
+		, m_free_slots(allocator)
 		, m_queue(allocator)	
 		, m_finished(allocator)	
-		, m_last_id(0)
+		, m_tasks(allocator)
+		, m_recorded(allocator)
+		, m_recorded_set(allocator)
+		, m_prefetched(allocator)
 		, m_semaphore(0, 0xffFF)
 	{
 		setBasePath(base_path);
-		m_task.create(*this, m_allocator);
-		m_task->create("Filesystem", true);
+		const u64 freq = os::Timer::getFrequency();
+		m_to_seconds = 1.f / float(freq);
+		io_threads_count = maximum(io_threads_count, 1u);
+		if (use_io_uring) {
+			m_batch_reader = os::createFileBatchReader(BATCH_QUEUE_DEPTH, m_allocator);
+			// single thread drives all reads
+			if (m_batch_reader) io_threads_count = 1;
+			else logInfo("Using threads for asynchronous file reading");
+		}
+		m_tasks.reserve(io_threads_count);
+		for (u32 i = 0; i < io_threads_count; ++i) {
+			FSTask* task = LUMIX_NEW(m_allocator, FSTask)(*this, m_allocator);
+			m_tasks.push(task);
+			task->create("Filesystem", true);
+		}
 	}
 
 	~FileSystemImpl() override {
-		m_task->stop();
-		m_task->destroy();
-		m_task.destroy();
+		stopTasks();
+		for (AsyncItem& item : m_items) {
+			if (item.prepare_signal) LUMIX_DELETE(m_allocator, item.prepare_signal);
+		}
+	}
+
+	// joins IO threads and prepare jobs, derived filesystems call this before they release what those read from
+	void stopTasks() {
+		m_finish = true;
+		for (u32 i = 0; i < (u32)m_tasks.size(); ++i) m_semaphore.signal();
+		for (FSTask* task : m_tasks) {
+			task->destroy();
+			LUMIX_DELETE(m_allocator, task);
+		}
+		m_tasks.clear();
+		os::destroyFileBatchReader(m_batch_reader);
+		m_batch_reader = nullptr;
+		// after IO threads are joined, since a finished read can start a new prepare job
+		// prepare jobs access m_items
+		waitForPrepareJobs();
 	}
 
 
@@ -117,18 +194,122 @@ struct FileSystemImpl : FileSystem {
 		return true;
 	}
 
-	AsyncHandle getContent(const Path& file, const ContentCallback& callback) override
+	// zero-copy access to content, if the file system keeps it in memory; view must outlive the file system
+	virtual bool getContentView(const Path& path, Span<const u8>& view) { return false; }
+
+	// true if item in slot `a` should be read before item in slot `b`
+	bool isBefore(u32 a, u32 b) const {
+		const AsyncItem& item_a = m_items[a];
+		const AsyncItem& item_b = m_items[b];
+		if (item_a.priority != item_b.priority) return item_a.priority > item_b.priority;
+		if (item_a.deadline != item_b.deadline) return item_a.deadline < item_b.deadline;
+		return item_a.sequence < item_b.sequence;
+	}
+
+	// m_queue is a binary heap of slots
+	void pushQueue(u32 slot) {
+		m_items[slot].queue_index = m_queue.size();
+		m_queue.push(slot);
+		siftUp(m_queue.size() - 1);
+	}
+
+	// keeps AsyncItem::queue_index in sync
+	void swapQueue(u32 a, u32 b) {
+		swap(m_queue[a], m_queue[b]);
+		m_items[m_queue[a]].queue_index = a;
+		m_items[m_queue[b]].queue_index = b;
+	}
+
+	void siftUp(u32 idx) {
+		while (idx > 0) {
+			const u32 parent = (idx - 1) / 2;
+			if (!isBefore(m_queue[idx], m_queue[parent])) break;
+			swapQueue(idx, parent);
+			idx = parent;
+		}
+	}
+
+	u32 popQueue() {
+		ASSERT(!m_queue.empty());
+		const u32 res = m_queue[0];
+		m_items[res].queue_index = AsyncItem::NOT_QUEUED;
+		m_queue[0] = m_queue.back();
+		m_queue.pop();
+		const u32 size = m_queue.size();
+		if (size > 0) m_items[m_queue[0]].queue_index = 0;
+		u32 idx = 0;
+		for (;;) {
+			const u32 left = idx * 2 + 1;
+			const u32 right = left + 1;
+			u32 best = idx;
+			if (left < size && isBefore(m_queue[left], m_queue[best])) best = left;
+			if (right < size && isBefore(m_queue[right], m_queue[best])) best = right;
+			if (best == idx) break;
+			swapQueue(idx, best);
+			idx = best;
+		}
+		return res;
+	}
+
+	u32 allocSlot() {
+		if (!m_free_slots.empty()) {
+			const u32 slot = m_free_slots.back();
+			m_free_slots.pop();
+			return slot;
+		}
+		const u32 slot = m_items.size();
+		ASSERT(slot <= SLOT_MASK);
+		m_items.emplace(m_allocator).id = slot;
+		return slot;
+	}
+
+	void freeSlot(u32 slot) {
+		AsyncItem& item = m_items[slot];
+		item.data.free();
+		item.view = Span<const u8>();
+		item.prepare = FileSystem::PrepareCallback();
+		item.path = Path();
+		// bump generation, so stale handles do not match
+		u32 generation = (item.id >> SLOT_BITS) + 1;
+		if (generation > MAX_GENERATION) generation = 0;
+		item.id = (generation << SLOT_BITS) | slot;
+		m_free_slots.push(slot);
+	}
+
+	AsyncHandle getContent(const Path& file, const ContentCallback& callback, Priority priority, float deadline) override {
+		return getPreparedContent(file, PrepareCallback(), callback, priority, deadline);
+	}
+
+	AsyncHandle getPreparedContent(const Path& file, const PrepareCallback& prepare, const ContentCallback& callback, Priority priority, float deadline) override
 	{
 		if (file.isEmpty()) return AsyncHandle::invalid();
 
+		// stat outside of the lock, so IO threads are not blocked
+		const u64 last_modified = isPrefetched(file) ? getLastModified(file) : 0;
+		const u64 now = os::Timer::getRawTimestamp();
 		MutexGuard lock(m_mutex);
 		++m_work_counter;
-		AsyncItem& item = m_queue.emplace(m_allocator);
-		++m_last_id;
-		if (m_last_id == 0) ++m_last_id;
-		item.id = m_last_id;
+		if (m_recording && !m_recorded_set.find(file.getHash()).isValid()) {
+			m_recorded_set.insert(file.getHash(), m_recorded.size());
+			m_recorded.push(file);
+		}
+		if (m_is_prefetching) {
+			const u32 prefetched = claimPrefetched(file, last_modified, prepare, callback, priority, deadline > 0 ? now + u64(deadline / m_to_seconds) : ~u64(0));
+			if (prefetched != 0xffFFffFF) return AsyncHandle(m_items[prefetched].id);
+		}
+
+		const u32 slot = allocSlot();
+		AsyncItem& item = m_items[slot];
 		item.path = file.c_str();
 		item.callback = callback;
+		item.prepare = prepare;
+		item.flags = AsyncItem::Flags::NONE;
+		item.priority = priority;
+		item.deadline = deadline > 0 ? now + u64(deadline / m_to_seconds) : ~u64(0);
+		item.queued = now;
+		item.sequence = m_sequence;
+		++m_sequence;
+		pushQueue(slot);
 		m_semaphore.signal();
 		return AsyncHandle(item.id);
 	}
@@ -137,20 +318,200 @@ struct FileSystemImpl : FileSystem {
 	void cancel(AsyncHandle async) override
 	{
 		MutexGuard lock(m_mutex);
-		for (AsyncItem& item : m_queue) {
-			if (item.id == async.value) {
-				item.flags |= AsyncItem::Flags::CANCELED;
-				--m_work_counter;
-				return;
-			}
+		const u32 slot = async.value & SLOT_MASK;
+		ASSERT(slot < (u32)m_items.size());
+		AsyncItem& item = m_items[slot];
+		ASSERT(item.id == async.value && !item.isCanceled());
+		if (item.id != async.value) return;
+
+		item.flags |= AsyncItem::Flags::CANCELED;
+		// finished items are counted until processCallbacks pops them
+		if (!item.isFinished()) --m_work_counter;
+
+		// prepare callback usually accesses an object, which is destroyed after cancel, so we must wait
+		// not by sleeping, the prepare job can be suspended (e.g. in jobs::forEach) and wait for this worker
+		while (m_items[slot].isPreparing()) {
+			jobs::Signal* signal = m_items[slot].prepare_signal;
+			m_mutex.exit();
+			jobs::wait(signal);
+			m_mutex.enter();
 		}
-		for (AsyncItem& item : m_finished) {
-			if (item.id == async.value) {
-				item.flags |= AsyncItem::Flags::CANCELED;
-				return;
+	}
+
+	// waits until all prepare jobs finish, including the part after their PrepareCallback
+	void waitForPrepareJobs() {
+		for (;;) {
+			jobs::Signal* signal = nullptr;
+			{
+				MutexGuard lock(m_mutex);
+				for (const AsyncItem& item : m_items) {
+					if (item.prepare_signal && item.prepare_signal->counter > 0) {
+						signal = item.prepare_signal;
+						break;
+					}
+				}
 			}
+			if (!signal) return;
+			jobs::wait(signal);
+		}
+	}
+
+	bool isPrefetched(const Path& file) {
+		MutexGuard lock(m_mutex);
+		return m_is_prefetching && m_prefetched.find(file.getHash()).isValid();
+	}
+
+	// called with m_mutex locked, returns slot of prefetched `file` taken over by the request, 0xffFFffFF if there is none
+	// `last_modified` is the current last modified time of `file`, content read before it changed is not used
+	u32 claimPrefetched(const Path& file, u64 last_modified, const PrepareCallback& prepare, const ContentCallback& callback, Priority priority, u64 deadline) {
+		auto iter = m_prefetched.find(file.getHash());
+		if (!iter.isValid()) {
+			++m_prefetch_stats.misses;
+			return 0xffFFffFF;
+		}
+
+		const u32 slot = iter.value();
+		m_prefetched.erase(iter);
+		AsyncItem& item = m_items[slot];
+		// file could have been created or changed since, e.g. by asset compiler, so read it again
+		if (item.isFinished() && (item.isFailed() || last_modified != item.last_modified)) {
+			freeSlot(slot);
+			++m_prefetch_stats.misses;
+			return 0xffFFffFF;
+		}
+
+		++m_prefetch_stats.hits;
+		item.flags &= ~AsyncItem::Flags::PREFETCH;
+		item.callback = callback;
+		item.prepare = prepare;
+		if (item.isFinished()) {
+			dispatch(slot);
+			return slot;
+		}
+
+		// still waiting in the queue, move it to the place it would have as a regular request
+		if (item.queue_index != AsyncItem::NOT_QUEUED) {
+			item.priority = maximum(item.priority, priority);
+			item.deadline = minimum(item.deadline, deadline);
+			siftUp(item.queue_index);
+		}
+		return slot;
+	}
+
+	// called with m_mutex locked, after item in `slot` is read
+	void onRead(u32 slot) {
+		AsyncItem& item = m_items[slot];
+		item.flags |= AsyncItem::Flags::FINISHED;
+		// kept until it's requested or stopPrefetch
+		if (item.isPrefetch()) return;
+		dispatch(slot);
+	}
+
+	// called with m_mutex locked, passes read item either to prepare job or to processCallbacks
+	void dispatch(u32 slot) {
+		AsyncItem& item = m_items[slot];
+		if (!item.prepare.isValid() || item.isFailed()) {
+			m_finished.push(slot);
+			return;
 		}
-		ASSERT(false);
+
+		item.flags |= AsyncItem::Flags::PREPARING;
+		if (!item.prepare_signal) item.prepare_signal = LUMIX_NEW(m_allocator, jobs::Signal);
+		const Span<const u8> content = item.getContent();
+		const PrepareCallback prepare = item.prepare;
+		jobs::runLambda([this, slot, content, prepare](){
+			PROFILE_BLOCK("prepare file content");
+			prepare.invoke(content);
+
+			MutexGuard lock(m_mutex);
+			AsyncItem& item = m_items[slot];
+			item.flags &= ~AsyncItem::Flags::PREPARING;
+			// canceled items are freed in processCallbacks
+			m_finished.push(slot);
+		}, item.prepare_signal);
+	}
+
+
+	const RequestStats& getCallbackStats() const override { return m_callback_stats; }
+
+	void startRecording() override {
+		MutexGuard lock(m_mutex);
+		m_recording = true;
+		m_recorded.clear();
+		m_recorded_set.clear();
+	}
+
+	void stopRecording(OutputMemoryStream& manifest) override {
+		MutexGuard lock(m_mutex);
+		m_recording = false;
+		for (const Path& path : m_recorded) {
+			manifest << path << "\n";
+		}
+		m_recorded.clear();
+		m_recorded_set.clear();
+	}
+
+	void prefetch(Span<const u8> manifest) override {
+		PROFILE_FUNCTION();
+		Array<Path> paths(m_allocator);
+		const char* line = (const char*)manifest.begin();
+		const char* end = (const char*)manifest.end();
+		while (line < end) {
+			const char* line_end = line;
+			while (line_end < end && *line_end != '\n' && *line_end != '\r') ++line_end;
+			if (line_end > line) paths.emplace(StringView(line, line_end));
+			line = line_end + 1;
+		}
+
+		// stat outside of the lock, so IO threads are not blocked
+		// before the read, so a change between this and the read is detected as stale too
+		Array<u64> last_modified(m_allocator);
+		last_modified.resize(paths.size());
+		for (i32 i = 0; i < paths.size(); ++i) last_modified[i] = getLastModified(paths[i]);
+
+		const u64 now = os::Timer::getRawTimestamp();
+		MutexGuard lock(m_mutex);
+		if (!m_is_prefetching) m_prefetch_stats = {};
+		m_is_prefetching = true;
+
+		for (i32 i = 0; i < paths.size(); ++i) {
+			const Path& path = paths[i];
+			if (m_prefetched.find(path.getHash()).isValid()) continue;
+
+			const u32 slot = allocSlot();
+			AsyncItem& item = m_items[slot];
+			item.path = path;
+			item.callback = ContentCallback();
+			item.flags = AsyncItem::Flags::PREFETCH;
+			item.last_modified = last_modified[i];
+			item.priority = Priority::LOW;
+			item.deadline = ~u64(0);
+			item.queued = now;
+			item.sequence = m_sequence;
+			++m_sequence;
+			pushQueue(slot);
+			m_semaphore.signal();
+			m_prefetched.insert(path.getHash(), slot);
+			++m_prefetch_stats.prefetched;
+		}
+	}
+
+	void stopPrefetch() override {
+		MutexGuard lock(m_mutex);
+		for (auto iter = m_prefetched.begin(); iter.isValid(); ++iter) {
+			const u32 slot = iter.value();
+			++m_prefetch_stats.unused;
+			// unfinished items are freed by FSTask
+			if (m_items[slot].isFinished()) freeSlot(slot);
+			else m_items[slot].flags |= AsyncItem::Flags::CANCELED;
+		}
+		m_prefetched.clear();
+		m_is_prefetching = false;
+	}
+
+	PrefetchStats getPrefetchStats() override {
+		MutexGuard lock(m_mutex);
+		return m_prefetch_stats;
 	}
 
 
@@ -216,109 +577,317 @@ struct FileSystemImpl : FileSystem {
 		PROFILE_FUNCTION();
 
 		os::Timer timer;
+		// slots are taken in batches, erasing them one by one from the front of m_finished is O(n^2)
+		// a batch is local, so callbacks can call processCallbacks too
+		Array<u32> batch(m_allocator);
+		u32 processed = 0;
 		for(;;) {
 			m_mutex.enter();
-			if (m_finished.empty()) {
-				m_mutex.exit();
-				break;
+			if (processed == batch.size()) {
+				batch.clear();
+				processed = 0;
+				batch.swap(m_finished);
+				if (batch.empty()) {
+					m_mutex.exit();
+					break;
+				}
 			}
 
-			AsyncItem item = static_cast<AsyncItem&&>(m_finished[0]);
-			m_finished.erase(0);
+			const u32 slot = batch[processed];
+			++processed;
+			AsyncItem& finished = m_items[slot];
+			const bool canceled = finished.isCanceled();
+			const bool failed = finished.isFailed();
+			ContentCallback callback = finished.callback;
+			const Span<const u8> content = finished.getContent();
+			// content stays valid after freeSlot, since we take ownership of data
+			OutputMemoryStream data(static_cast<OutputMemoryStream&&>(finished.data));
+			m_callback_stats.queue_wait = float(finished.read_start - finished.queued) * m_to_seconds;
+			m_callback_stats.read = float(finished.read_end - finished.read_start) * m_to_seconds;
+			m_callback_stats.size = content.length();
+			freeSlot(slot);
 			ASSERT(m_work_counter > 0);
 			--m_work_counter;
 
 			m_mutex.exit();
 
-			if(!item.isCanceled()) {
-				item.callback.invoke(Span((const u8*)item.data.data(), (u32)item.data.size()), !item.isFailed());
+			if(!canceled) {
+				callback.invoke(content, !failed);
 			}
 
 			if (timer.getTimeSinceStart() > 0.1f) {
 				break;
 			}
 		}
+
+		if (processed == batch.size()) return;
+
+		// not processed because of the time limit, they go before slots finished in the meantime
+		MutexGuard lock(m_mutex);
+		batch.eraseRange(0, processed);
+		for (u32 slot : m_finished) batch.push(slot);
+		m_finished.swap(batch);
 	}
 
 	IAllocator& m_allocator;
-	Local<FSTask> m_task;
 	StaticString<MAX_PATH> m_base_path;
-	Array<AsyncItem> m_queue;
+	Array<FSTask*> m_tasks;
+	// nullptr if we read using blocking reads on m_tasks
+	os::FileBatchReader* m_batch_reader = nullptr;
+	// requests, indexed by slot == AsyncHandle::value & SLOT_MASK
+	Array<AsyncItem> m_items;
+	Array<u32> m_free_slots;
+	// slots waiting to be read, heap ordered by isBefore
+	Array<u32> m_queue;
+	// slots waiting for processCallbacks
+	Array<u32> m_finished;
 	u32 m_work_counter = 0;
-	Array<AsyncItem> m_finished;
 	Mutex m_mutex;
 	Semaphore m_semaphore;
-
-	u32 m_last_id;
+	volatile bool m_finish = false;
+	u64 m_sequence = 0;
+	float m_to_seconds;
+	RequestStats m_callback_stats;
+	bool m_recording = false;
+	Array<Path> m_recorded;
+	// path hash -> index in m_recorded
+	HashMap<FilePathHash, u32> m_recorded_set;
+	bool m_is_prefetching = false;
+	// path hash -> slot of item read ahead by prefetch
+	HashMap<FilePathHash, u32> m_prefetched;
+	PrefetchStats m_prefetch_stats;
 };
 
 
+int FSTask::batchTask() {
+	struct Buffer {
+		Buffer(IAllocator& allocator) : data(allocator) {}
+		OutputMemoryStream data;
+		u32 slot;
+	};
+	
+	// reads go directly to these, no need to copy, because buffer is moved to AsyncItem::data
+	Array<Buffer> buffers(m_fs.m_allocator);
+	Array<u32> free_buffers(m_fs.m_allocator);
+	for (u32 i = 0; i < FileSystemImpl::BATCH_QUEUE_DEPTH; ++i) {
+		buffers.emplace(m_fs.m_allocator);
+		free_buffers.push(i);
+	}
+
+	u32 in_flight = 0;
+	for (;;) {
+		// if there are reads in flight, new requests are picked up after some read finishes
+		if (in_flight == 0) m_fs.m_semaphore.wait();
+		if (m_fs.m_finish) break;
+
+		{
+			MutexGuard lock(m_fs.m_mutex);
+			while (!free_buffers.empty() && !m_fs.m_queue.empty()) {
+				const u32 slot = m_fs.popQueue();
+				AsyncItem& item = m_fs.m_items[slot];
+				if (item.isCanceled()) {
+					m_fs.freeSlot(slot);
+					continue;
+				}
+
+				const u32 buffer_idx = free_buffers.back();
+				Buffer& buffer = buffers[buffer_idx];
+				buffer.slot = slot;
+				buffer.data.clear();
+				const Path full_path(m_fs.m_base_path, item.path);
+				item.read_start = os::Timer::getRawTimestamp();
+				if (!os::queueFileRead(m_fs.m_batch_reader, full_path.c_str(), buffer.data, (void*)(uintptr)buffer_idx)) {
+					// can not happen, we never have more than BATCH_QUEUE_DEPTH reads in flight
+					ASSERT(false);
+					m_fs.pushQueue(slot);
+					break;
+				}
+				free_buffers.pop();
+				++in_flight;
+			}
+		}
+		if (in_flight == 0) continue;
+
+		os::FileBatchResult results[FileSystemImpl::BATCH_QUEUE_DEPTH];
+		const u32 count = os::waitFileBatchReader(m_fs.m_batch_reader, Span(results));
+
+		MutexGuard lock(m_fs.m_mutex);
+		const u64 now = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < count; ++i) {
+			const u32 buffer_idx = (u32)(uintptr)results[i].user_ptr;
+			Buffer& buffer = buffers[buffer_idx];
+			AsyncItem& item = m_fs.m_items[buffer.slot];
+			if (item.isCanceled()) {
+				m_fs.freeSlot(buffer.slot);
+			}
+			else {
+				item.read_end = now;
+				item.data = static_cast<OutputMemoryStream&&>(buffer.data);
+				if (!results[i].success) {
+					logError("Could not read ", item.path);
+					item.flags |= AsyncItem::Flags::FAILED;
+				}
+				m_fs.onRead(buffer.slot);
+			}
+			free_buffers.push(buffer_idx);
+			--in_flight;
+		}
+	}
+
+	// buffers must outlive reads in flight
+	while (in_flight > 0) {
+		os::FileBatchResult results[FileSystemImpl::BATCH_QUEUE_DEPTH];
+		in_flight -= os::waitFileBatchReader(m_fs.m_batch_reader, Span(results));
+	}
+	return 0;
+}
+
+
 int FSTask::task()
 {
-	while (!m_finish) {
+	if (m_fs.m_batch_reader) return batchTask();
+
+	for (;;) {
 		m_fs.m_semaphore.wait();
-		if (m_finish) break;
+		if (m_fs.m_finish) break;
 
 		Path path;
+		u32 slot;
 		{
 			MutexGuard lock(m_fs.m_mutex);
-			ASSERT(!m_fs.m_queue.empty());
-			path = m_fs.m_queue[0].path;
-			if (m_fs.m_queue[0].isCanceled()) {
-				m_fs.m_queue.erase(0);
+			slot = m_fs.popQueue();
+			AsyncItem& item = m_fs.m_items[slot];
+			if (item.isCanceled()) {
+				m_fs.freeSlot(slot);
 				continue;
 			}
+			path = item.path;
+			item.read_start = os::Timer::getRawTimestamp();
 		}
 
+		PROFILE_BLOCK("read file");
+		profiler::pushString(path.c_str());
 		OutputMemoryStream data(m_fs.m_allocator);
-		bool success = m_fs.getContentSync(path, data);
+		Span<const u8> view;
+		const bool is_view = m_fs.getContentView(path, view);
+		bool success = is_view;
+		if (is_view) {
+			// fault the pages in here, so the callback does not stall on disk
+			u8 sum = 0;
+			for (u64 i = 0; i < view.length(); i += 4096) sum += view.begin()[i];
+			volatile u8 sink = sum;
+			(void)sink;
+		}
+		else {
+			success = m_fs.getContentSync(path, data);
+		}
 
 		{
 			MutexGuard lock(m_fs.m_mutex);
-			if (!m_fs.m_queue[0].isCanceled()) {
-				m_fs.m_finished.emplace(static_cast<AsyncItem&&>(m_fs.m_queue[0]));
-				m_fs.m_finished.back().data = static_cast<OutputMemoryStream&&>(data);
-				if(!success) {
-					m_fs.m_finished.back().flags |= AsyncItem::Flags::FAILED;
-				}
+			AsyncItem& item = m_fs.m_items[slot];
+			if (item.isCanceled()) {
+				m_fs.freeSlot(slot);
+			}
+			else {
+				item.read_end = os::Timer::getRawTimestamp();
+				item.data = static_cast<OutputMemoryStream&&>(data);
+				item.view = view;
+				if (is_view) item.flags |= AsyncItem::Flags::VIEW;
+				if (!success) item.flags |= AsyncItem::Flags::FAILED;
+				m_fs.onRead(slot);
 			}
-			m_fs.m_queue.erase(0);
 		}
 	}
 	return 0;
 }
 
 
-void FSTask::stop()
-{
-	m_finish = true;
-	m_fs.m_semaphore.signal();
-}
-
 struct PackFileSystem : FileSystemImpl {
-	PackFileSystem(const char* pak_path, IAllocator& allocator) 
-		: FileSystemImpl("pack://", allocator) 
-		, m_map(allocator)
+	PackFileSystem(const char* pak_path, IAllocator& allocator, u32 io_threads_count) 
+		: FileSystemImpl("pack://", allocator, io_threads_count, false) 
+		, m_v1_index(allocator)
 	{
 		if (!m_file.open(pak_path)) {
-			logError("Failed to open game.pak");
+			logError("Failed to open ", pak_path);
 			return;
 		}
-		const u32 count = m_file.read<u32>();
-		for (u32 i = 0; i < count; ++i) {
-			const FilePathHash hash = m_file.read<FilePathHash>();
-			PackFile& f = m_map.insert(hash);
-			f.offset = m_file.read<u64>();
-			f.size = m_file.read<u64>();
+		if (!loadIndex()) {
+			logError("Corrupted ", pak_path);
+			m_index = Span<const PackEntry>();
 		}
 	}
 
 	~PackFileSystem() {
+		// IO threads and prepare jobs read from the mapping
+		stopTasks();
 		m_file.close();
 	}
 
-	bool getContentSync(const Path& path, OutputMemoryStream& content) override {
-		ASSERT(content.size() == 0);
+	bool loadIndex() {
+		const u64 file_size = m_file.size();
+		const PackHeader* header = (const PackHeader*)m_file.data();
+		if (file_size < sizeof(PackHeader) || header->magic != PackHeader::MAGIC) return loadV1Index();
+		if (header->version != PackHeader::VERSION) return false;
+		
+		const u64 index_size = u64(header->count) * sizeof(PackEntry);
+		if (index_size > file_size - sizeof(PackHeader)) return false;
+		
+		// index is at the end of file, already sorted, so we use it in place
+		const u64 index_offset = file_size - index_size;
+		m_index = Span((const PackEntry*)(m_file.data() + index_offset), header->count);
+		return validateIndex(index_offset);
+	}
+
+	// v1 index is converted to sorted v2 entries, so lookup is the same for both
+	bool loadV1Index() {
+		InputMemoryStream blob(m_file.data(), m_file.size());
+		const u32 count = blob.read<u32>();
+		if (blob.hasOverflow() || u64(count) * (sizeof(FilePathHash) + 2 * sizeof(u64)) > blob.remaining()) return false;
+
+		m_v1_index.resize(count);
+		for (PackEntry& entry : m_v1_index) {
+			entry.hash = blob.read<FilePathHash>();
+			entry.offset = blob.read<u64>();
+			entry.size = blob.read<u64>();
+			entry.uncompressed_size = entry.size;
+		}
+		// offsets in v1 are relative to the end of header
+		const u64 header_size = blob.getPosition();
+		for (PackEntry& entry : m_v1_index) entry.offset += header_size;
+
+		qsort(m_v1_index.begin(), m_v1_index.size(), sizeof(m_v1_index[0]), [](const void* a, const void* b){
+			const FilePathHash ha = ((const PackEntry*)a)->hash;
+			const FilePathHash hb = ((const PackEntry*)b)->hash;
+			if (ha < hb) return -1;
+			return hb < ha ? 1 : 0;
+		});
+		m_index = Span((const PackEntry*)m_v1_index.begin(), m_v1_index.size());
+		return validateIndex(m_file.size());
+	}
+
+	bool validateIndex(u64 data_end) const {
+		for (u32 i = 0, c = m_index.length(); i < c; ++i) {
+			const PackEntry& entry = m_index[i];
+			if (entry.offset > data_end || entry.size > data_end - entry.offset) return false;
+			if (i > 0 && entry.hash < m_index[i - 1].hash) return false;
+		}
+		return true;
+	}
+
+	// m_index and m_file are immutable after constructor, so this does not need any lock
+	const PackEntry* find(FilePathHash hash) const {
+		u32 lo = 0;
+		u32 hi = m_index.length();
+		while (lo < hi) {
+			const u32 mid = (lo + hi) / 2;
+			if (m_index[mid].hash < hash) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo < m_index.length() && m_index[lo].hash == hash) return &m_index[lo];
+		return nullptr;
+	}
+
+	const PackEntry* find(const Path& path) const {
 		StringView basename = Path::getBasename(path);
 		u64 hashu64;
 		fromCString(basename, hashu64);
@@ -326,41 +895,58 @@ struct PackFileSystem : FileSystemImpl {
 		if (basename[0] < '0' || basename[0] > '9' || hashu64 == 0) {
 			hash = path.getHash();
 		}
-		auto iter = m_map.find(hash);
-		if (!iter.isValid()) {
-			iter = m_map.find(path.getHash());
-			if (!iter.isValid()) return false;
-		}
+		const PackEntry* entry = find(hash);
+		if (!entry) entry = find(path.getHash());
+		return entry;
+	}
 
-		content.resize(iter.value().size);
-		MutexGuard lock(m_mutex);
-		const u32 header_size = sizeof(u32) + m_map.size() * (2 * sizeof(u64) + sizeof(FilePathHash));
-		if (!m_file.seek(iter.value().offset + header_size) || !m_file.read(content.getMutableData(), content.size())) {
-			logError("Could not read ", path);
-			return false;
+	bool getContentView(const Path& path, Span<const u8>& view) override {
+		const PackEntry* entry = find(path);
+		// compressed entries go through getContentSync
+		if (!entry || (entry->flags & PackEntry::COMPRESSED)) return false;
+		view = Span(m_file.data() + entry->offset, (u32)entry->size);
+		return true;
+	}
+
+	bool getContentSync(const Path& path, OutputMemoryStream& content) override {
+		ASSERT(content.size() == 0);
+		const PackEntry* entry = find(path);
+		if (!entry) return false;
+		
+		if (entry->flags & PackEntry::COMPRESSED) {
+			content.resize(entry->uncompressed_size);
+			const i32 res = LZ4_decompress_safe((const char*)m_file.data() + entry->offset, (char*)content.getMutableData(), (i32)entry->size, (i32)content.size());
+			if (res != (i32)content.size()) {
+				logError("Could not decompress ", path);
+				return false;
+			}
+			return true;
 		}
 
+		content.write(m_file.data() + entry->offset, entry->size);
 		return true;
 	}
-	
-	struct PackFile {
-		u64 offset;
-		u64 size;
-	};
 
-	HashMap<FilePathHash, PackFile> m_map;
-	os::InputFile m_file;
+	// points either to m_file (v2) or to m_v1_index
+	Span<const PackEntry> m_index;
+	Array<PackEntry> m_v1_index;
+	os::MappedFile m_file;
 };
 
 
-UniquePtr<FileSystem> FileSystem::create(const char* base_path, IAllocator& allocator)
+UniquePtr<FileSystem> FileSystem::create(const char* base_path, IAllocator& allocator, u32 io_threads_count, bool use_io_uring)
+{
+	return UniquePtr<FileSystemImpl>::create(allocator, base_path, allocator, io_threads_count, use_io_uring);
+}
+
+Path FileSystem::getLoadOrderPath(const Path& world)
 {
-	return UniquePtr<FileSystemImpl>::create(allocator, base_path, allocator);
+	return Path(".lumix/load_order/w", world.getHash().getHashValue(), ".txt");
 }
 
-UniquePtr<FileSystem> FileSystem::createPacked(const char* pak_path, IAllocator& allocator)
+UniquePtr<FileSystem> FileSystem::createPacked(const char* pak_path, IAllocator& allocator, u32 io_threads_count)
 {
-	return UniquePtr<PackFileSystem>::create(allocator, pak_path, allocator);
+	return UniquePtr<PackFileSystem>::create(allocator, pak_path, allocator, io_threads_count);
 }
 
 
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "engine/hash.h"
 #include "engine/lumix.h"
 
 namespace Lumix {
 
 template <typename T> struct Delegate;
 template <typename T> struct UniquePtr;
+struct Path;
 
 namespace os {
 	struct FileIterator;
@@ -13,8 +15,38 @@ namespace os {
 	struct OutputFile;
 }
 
+// main.pak v2 layout:
+// PackHeader, padding, entries' data (each aligned to PackHeader::ALIGNMENT, in load order), PackEntry[count] sorted by hash
+// v1 layout (still loadable): u32 count, {FilePathHash, u64 offset, u64 size}[count], data; offsets relative to end of header
+struct PackHeader {
+	static constexpr u32 MAGIC = 0x324B4150; // "PAK2"
+	static constexpr u32 VERSION = 2;
+	static constexpr u32 ALIGNMENT = 4096;
+
+	u32 magic = MAGIC;
+	u32 version = VERSION;
+	u32 count = 0;
+	u32 reserved = 0;
+};
+
+struct PackEntry {
+	enum Flags : u32 {
+		NONE = 0,
+		COMPRESSED = 1 << 0 // LZ4 block
+	};
+
+	FilePathHash hash;
+	u64 offset; // from start of pak
+	u64 size; // size in pak
+	u64 uncompressed_size;
+	u32 flags = NONE;
+	u32 reserved = 0;
+};
+
 struct LUMIX_ENGINE_API FileSystem {
 	using ContentCallback = Delegate<void(Span<const u8>, bool)>;
+	// called on a worker thread with content of successfully read file, before ContentCallback
+	using PrepareCallback = Delegate<void(Span<const u8>)>;
 
 	struct LUMIX_ENGINE_API AsyncHandle {
 		static AsyncHandle invalid() { return AsyncHandle(0xffFFffFF); };
@@ -23,8 +55,35 @@ struct LUMIX_ENGINE_API FileSystem {
 		bool isValid() const { return value != 0xffFFffFF; }
 	};
 
-	static UniquePtr<FileSystem> create(const char* base_path, struct IAllocator& allocator);
-	static UniquePtr<FileSystem> createPacked(const char* pak_path, struct IAllocator& allocator);
+	// requests with higher priority are read first, requests with the same priority are ordered by deadline
+	enum class Priority : u8 {
+		LOW,
+		NORMAL,
+		HIGH
+	};
+
+	// timing of a single getContent request, in seconds
+	struct RequestStats {
+		float queue_wait = 0; // from getContent to start of reading
+		float read = 0;
+		u64 size = 0;
+	};
+
+	// getContent requests matched against the manifest passed to prefetch
+	struct PrefetchStats {
+		u32 prefetched = 0; // files listed in manifest
+		u32 hits = 0; // requests of prefetched files
+		u32 misses = 0; // requests of files not in manifest
+		u32 unused = 0; // prefetched files nobody requested before stopPrefetch
+	};
+
+	// `io_threads_count` defaults to the same value as Engine::InitArgs::file_system_threads_count
+	// `use_io_uring` - read files in batches using io_uring, linux only, falls back to `io_threads_count` threads if not available
+	static UniquePtr<FileSystem> create(const char* base_path, struct IAllocator& allocator, u32 io_threads_count = 2, bool use_io_uring = false);
+	// pak file is memory mapped, getContent callbacks get a view into the mapping
+	// load order manifest of `world`, it's in .lumix, so it's not in version control; the name is not a number, since pak maps such names to resources
+	static Path getLoadOrderPath(const Path& world);
+	static UniquePtr<FileSystem> createPacked(const char* pak_path, struct IAllocator& allocator, u32 io_threads_count = 2);
 
 	virtual ~FileSystem() {}
 
@@ -44,8 +103,26 @@ struct LUMIX_ENGINE_API FileSystem {
 
 	[[nodiscard]] virtual bool saveContentSync(const struct Path& file, Span<const u8> content) = 0;
 	[[nodiscard]] virtual bool getContentSync(const struct Path& file, struct OutputMemoryStream& content) = 0;
-	virtual AsyncHandle getContent(const Path& file, const ContentCallback& callback) = 0;
+	// `deadline` is in seconds from now, 0 == no deadline
+	// data passed to `callback` is read-only and valid only inside the callback
+	virtual AsyncHandle getContent(const Path& file, const ContentCallback& callback, Priority priority = Priority::NORMAL, float deadline = 0) = 0;
+	// same as getContent, but `prepare` is called on a worker thread first, so CPU heavy work (decompression, parsing) does not block the main thread
+	// `callback` is then called on the main thread with the same content; the request counts as work (see hasWork) until `callback` returns
+	virtual AsyncHandle getPreparedContent(const Path& file, const PrepareCallback& prepare, const ContentCallback& callback, Priority priority = Priority::NORMAL, float deadline = 0) = 0;
+	// after cancel returns, PrepareCallback of the request is not running and it will not be called
 	virtual void cancel(AsyncHandle handle) = 0;
+	// valid only inside ContentCallback, stats of the request the callback belongs to
+	virtual const RequestStats& getCallbackStats() const = 0;
+
+	// load order manifest - text, one path per line, saved by the editor in getLoadOrderPath(world)
+	// records every distinct path requested by getContent, in order of the first request
+	virtual void startRecording() = 0;
+	virtual void stopRecording(struct OutputMemoryStream& manifest) = 0;
+	// reads all files in manifest with low priority, getContent of such file then uses the content read ahead
+	virtual void prefetch(Span<const u8> manifest) = 0;
+	// frees prefetched content nobody requested, resets stats on next prefetch
+	virtual void stopPrefetch() = 0;
+	virtual PrefetchStats getPrefetchStats() = 0;
 };
 
 } // namespace Lumix
@@ -0,0 +1,460 @@
+#include "engine/allocator.h"
+#include "engine/array.h"
+#include "engine/log.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace Lumix::os {
+
+// there's no liburing dependency, we talk to the kernel directly
+static int io_uring_setup(u32 entries, io_uring_params* params) {
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd, u32 to_submit, u32 min_complete, u32 flags) {
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int io_uring_register(int fd, u32 opcode, void* arg, u32 nr_args) {
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+struct FileBatchReader {
+	enum class Op : u32 {
+		OPEN,
+		STATX,
+		READ,
+		CLOSE
+	};
+
+	// open and statx run in parallel, then reads until whole file is read, then close
+	struct Request {
+		char path[MAX_PATH];
+		OutputMemoryStream* content = nullptr;
+		void* user_ptr = nullptr;
+		struct statx stat;
+		int fd = -1;
+		u64 read = 0;
+		u32 pending_ops = 0;
+		bool failed = false;
+		// result was not returned yet
+		bool active = false;
+	};
+
+	FileBatchReader(IAllocator& allocator)
+		: allocator(allocator)
+		, requests(allocator)
+		, free_requests(allocator)
+		, results(allocator)
+		, orphaned(allocator)
+	{}
+
+	IAllocator& allocator;
+	int ring_fd = -1;
+
+	u32* sq_head;
+	u32* sq_tail;
+	u32 sq_mask;
+	u32 sq_entries;
+	u32* sq_array;
+	io_uring_sqe* sqes;
+	u32* cq_head;
+	u32* cq_tail;
+	u32 cq_mask;
+	io_uring_cqe* cqes;
+
+	void* sq_ptr = MAP_FAILED;
+	size_t sq_size = 0;
+	void* cq_ptr = MAP_FAILED;
+	size_t cq_size = 0;
+	void* sqes_ptr = MAP_FAILED;
+	size_t sqes_size = 0;
+
+	u32 to_submit = 0;
+	u32 in_flight = 0;
+	// io_uring_enter failed, the ring is not used anymore and reads are done synchronously
+	bool broken = false;
+	// ops of broken ring, which could not be reaped, can still write to the reader's memory, so it's never freed
+	bool leak = false;
+	Array<Request> requests;
+	Array<u32> free_requests;
+	Array<FileBatchResult> results;
+	// content of failed requests, which the kernel can still write to, taken from the caller, see breakRing
+	Array<OutputMemoryStream> orphaned;
+
+	// completions of NOPs and cancels used by breakRing
+	static constexpr u64 IGNORED_USER_DATA = ~u64(0);
+};
+
+static void release(FileBatchReader* reader) {
+	if (reader->sqes_ptr != MAP_FAILED) munmap(reader->sqes_ptr, reader->sqes_size);
+	if (reader->cq_ptr != MAP_FAILED && reader->cq_ptr != reader->sq_ptr) munmap(reader->cq_ptr, reader->cq_size);
+	if (reader->sq_ptr != MAP_FAILED) munmap(reader->sq_ptr, reader->sq_size);
+	if (reader->ring_fd >= 0) ::close(reader->ring_fd);
+	if (reader->leak) {
+		logWarning("Leaking io_uring reader, it has unfinished reads");
+		return;
+	}
+	LUMIX_DELETE(reader->allocator, reader);
+}
+
+static bool isSupported(int ring_fd) {
+	const u32 ops_count = 256;
+	u8 mem[sizeof(io_uring_probe) + ops_count * sizeof(io_uring_probe_op)] = {};
+	io_uring_probe* probe = (io_uring_probe*)mem;
+	if (io_uring_register(ring_fd, IORING_REGISTER_PROBE, probe, ops_count) < 0) return false;
+
+	const u32 required_ops[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+	for (u32 op : required_ops) {
+		if (op > probe->last_op) return false;
+		if (!(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+	}
+	return true;
+}
+
+FileBatchReader* createFileBatchReader(u32 queue_depth, IAllocator& allocator) {
+	FileBatchReader* reader = LUMIX_NEW(allocator, FileBatchReader)(allocator);
+
+	// each request has at most 2 ops in flight
+	io_uring_params params = {};
+	reader->ring_fd = io_uring_setup(queue_depth * 2, &params);
+	if (reader->ring_fd < 0) {
+		Lumix::logInfo("io_uring is not available (", strerror(errno), ")");
+		release(reader);
+		return nullptr;
+	}
+
+	if (!isSupported(reader->ring_fd)) {
+		Lumix::logInfo("io_uring does not support required operations");
+		release(reader);
+		return nullptr;
+	}
+
+	reader->sq_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	reader->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (single_mmap) reader->sq_size = reader->cq_size = maximum(reader->sq_size, reader->cq_size);
+
+	reader->sq_ptr = mmap(nullptr, reader->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader->ring_fd, IORING_OFF_SQ_RING);
+	if (reader->sq_ptr == MAP_FAILED) {
+		release(reader);
+		return nullptr;
+	}
+
+	reader->cq_ptr = single_mmap
+		? reader->sq_ptr
+		: mmap(nullptr, reader->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader->ring_fd, IORING_OFF_CQ_RING);
+	if (reader->cq_ptr == MAP_FAILED) {
+		release(reader);
+		return nullptr;
+	}
+
+	reader->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	reader->sqes_ptr = mmap(nullptr, reader->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader->ring_fd, IORING_OFF_SQES);
+	if (reader->sqes_ptr == MAP_FAILED) {
+		release(reader);
+		return nullptr;
+	}
+
+	u8* sq = (u8*)reader->sq_ptr;
+	reader->sq_head = (u32*)(sq + params.sq_off.head);
+	reader->sq_tail = (u32*)(sq + params.sq_off.tail);
+	reader->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+	reader->sq_entries = *(u32*)(sq + params.sq_off.ring_entries);
+	reader->sq_array = (u32*)(sq + params.sq_off.array);
+	reader->sqes = (io_uring_sqe*)reader->sqes_ptr;
+
+	u8* cq = (u8*)reader->cq_ptr;
+	reader->cq_head = (u32*)(cq + params.cq_off.head);
+	reader->cq_tail = (u32*)(cq + params.cq_off.tail);
+	reader->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+	reader->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	reader->requests.resize(queue_depth);
+	reader->free_requests.reserve(queue_depth);
+	for (u32 i = 0; i < queue_depth; ++i) reader->free_requests.push(queue_depth - 1 - i);
+	return reader;
+}
+
+void destroyFileBatchReader(FileBatchReader* reader) {
+	if (!reader) return;
+	ASSERT(reader->in_flight == 0);
+	release(reader);
+}
+
+static bool submit(FileBatchReader* reader, u32 min_complete) {
+	for (;;) {
+		const int res = io_uring_enter(reader->ring_fd, reader->to_submit, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+		if (res >= 0) {
+			reader->to_submit -= minimum((u32)res, reader->to_submit);
+			return true;
+		}
+		if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+		logError("io_uring_enter failed: ", strerror(errno));
+		return false;
+	}
+}
+
+static void breakRing(FileBatchReader* reader);
+
+static void readSync(FileBatchReader* reader, const char* path, OutputMemoryStream& content, void* user_ptr) {
+	InputFile file;
+	bool success = file.open(path);
+	if (success) {
+		content.resize(file.size());
+		success = file.read(content.getMutableData(), content.size());
+		file.close();
+	}
+	reader->results.push({user_ptr, success});
+}
+
+static io_uring_sqe& pushSQE(FileBatchReader* reader, u32 request_idx, FileBatchReader::Op op) {
+	const u32 tail = *reader->sq_tail;
+	if (tail - __atomic_load_n(reader->sq_head, __ATOMIC_ACQUIRE) >= reader->sq_entries) {
+		// should not happen, ring has space for 2 ops per request
+		submit(reader, 0);
+	}
+	const u32 idx = tail & reader->sq_mask;
+	io_uring_sqe& sqe = reader->sqes[idx];
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.user_data = ((u64)request_idx << 2) | (u64)op;
+	reader->sq_array[idx] = idx;
+	__atomic_store_n(reader->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++reader->to_submit;
+	++reader->requests[request_idx].pending_ops;
+	return sqe;
+}
+
+static void pushRead(FileBatchReader* reader, u32 request_idx) {
+	FileBatchReader::Request& req = reader->requests[request_idx];
+	io_uring_sqe& sqe = pushSQE(reader, request_idx, FileBatchReader::Op::READ);
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = req.fd;
+	sqe.addr = (u64)(req.content->getMutableData() + req.read);
+	sqe.len = (u32)minimum(req.content->size() - req.read, (u64)1 << 30);
+	sqe.off = req.read;
+}
+
+static void pushClose(FileBatchReader* reader, u32 request_idx) {
+	io_uring_sqe& sqe = pushSQE(reader, request_idx, FileBatchReader::Op::CLOSE);
+	sqe.opcode = IORING_OP_CLOSE;
+	sqe.fd = reader->requests[request_idx].fd;
+}
+
+// returns result to the caller, request's slot is reused after the file is closed
+static void finish(FileBatchReader* reader, u32 request_idx, bool success) {
+	FileBatchReader::Request& req = reader->requests[request_idx];
+	reader->results.push({req.user_ptr, success});
+	req.active = false;
+	--reader->in_flight;
+	if (req.fd >= 0) pushClose(reader, request_idx);
+	else reader->free_requests.push(request_idx);
+}
+
+static void processCompletion(FileBatchReader* reader, const io_uring_cqe& cqe);
+
+static void processCompletions(FileBatchReader* reader) {
+	u32 head = *reader->cq_head;
+	const u32 tail = __atomic_load_n(reader->cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		processCompletion(reader, reader->cqes[head & reader->cq_mask]);
+		++head;
+	}
+	__atomic_store_n(reader->cq_head, head, __ATOMIC_RELEASE);
+}
+
+bool queueFileRead(FileBatchReader* reader, const char* path, OutputMemoryStream& content, void* user_ptr) {
+	while (!reader->broken && reader->free_requests.empty()) {
+		if (reader->in_flight == reader->requests.size()) return false;
+		// some requests are finished and only wait for their file to be closed
+		if (submit(reader, 1)) processCompletions(reader);
+		else breakRing(reader);
+	}
+
+	if (reader->broken) {
+		readSync(reader, path, content, user_ptr);
+		return true;
+	}
+
+	const u32 request_idx = reader->free_requests.back();
+	reader->free_requests.pop();
+	++reader->in_flight;
+
+	FileBatchReader::Request& req = reader->requests[request_idx];
+	copyString(req.path, path);
+	req.content = &content;
+	req.user_ptr = user_ptr;
+	req.fd = -1;
+	req.read = 0;
+	req.pending_ops = 0;
+	req.failed = false;
+	req.active = true;
+
+	io_uring_sqe& open_sqe = pushSQE(reader, request_idx, FileBatchReader::Op::OPEN);
+	open_sqe.opcode = IORING_OP_OPENAT;
+	open_sqe.fd = AT_FDCWD;
+	open_sqe.addr = (u64)req.path;
+	open_sqe.open_flags = O_RDONLY | O_CLOEXEC;
+
+	io_uring_sqe& statx_sqe = pushSQE(reader, request_idx, FileBatchReader::Op::STATX);
+	statx_sqe.opcode = IORING_OP_STATX;
+	statx_sqe.fd = AT_FDCWD;
+	statx_sqe.addr = (u64)req.path;
+	statx_sqe.len = STATX_SIZE;
+	statx_sqe.off = (u64)&req.stat;
+	return true;
+}
+
+static void processCompletion(FileBatchReader* reader, const io_uring_cqe& cqe) {
+	if (cqe.user_data == FileBatchReader::IGNORED_USER_DATA) return;
+	const u32 request_idx = u32(cqe.user_data >> 2);
+	const FileBatchReader::Op op = FileBatchReader::Op(cqe.user_data & 3);
+	FileBatchReader::Request& req = reader->requests[request_idx];
+	ASSERT(req.pending_ops > 0);
+	--req.pending_ops;
+
+	if (reader->broken) {
+		// only reaping, see breakRing
+		if (op == FileBatchReader::Op::OPEN && cqe.res >= 0) req.fd = cqe.res;
+		if (op == FileBatchReader::Op::CLOSE) req.fd = -1;
+		return;
+	}
+
+	switch (op) {
+		case FileBatchReader::Op::OPEN:
+			if (cqe.res < 0) req.failed = true;
+			else req.fd = cqe.res;
+			break;
+		case FileBatchReader::Op::STATX:
+			if (cqe.res < 0) req.failed = true;
+			break;
+		case FileBatchReader::Op::READ:
+			// 0 == file is shorter than statx reported
+			if (cqe.res <= 0) req.failed = true;
+			else req.read += cqe.res;
+			break;
+		case FileBatchReader::Op::CLOSE:
+			reader->free_requests.push(request_idx);
+			return;
+	}
+
+	if (req.pending_ops > 0) return;
+
+	if (req.failed) {
+		finish(reader, request_idx, false);
+		return;
+	}
+
+	if (op != FileBatchReader::Op::READ) {
+		// both open and statx are done
+		req.content->resize(req.stat.stx_size);
+	}
+
+	if (req.read < req.content->size()) pushRead(reader, request_idx);
+	else finish(reader, request_idx, true);
+}
+
+static bool hasPendingOps(FileBatchReader* reader) {
+	for (const FileBatchReader::Request& req : reader->requests) {
+		if (req.pending_ops > 0) return true;
+	}
+	return false;
+}
+
+// io_uring_enter failed, fails all requests in flight, otherwise the caller would wait for them forever
+// ops the kernel already has are canceled and reaped first, since they write to request's memory and content
+static void breakRing(FileBatchReader* reader) {
+	reader->broken = true;
+
+	// ops the kernel did not consume yet become NOPs
+	const u32 head = __atomic_load_n(reader->sq_head, __ATOMIC_ACQUIRE);
+	const u32 tail = *reader->sq_tail;
+	for (u32 i = head; i != tail; ++i) {
+		io_uring_sqe& sqe = reader->sqes[reader->sq_array[i & reader->sq_mask]];
+		if (sqe.user_data == FileBatchReader::IGNORED_USER_DATA) continue;
+		FileBatchReader::Request& req = reader->requests[u32(sqe.user_data >> 2)];
+		--req.pending_ops;
+		if (FileBatchReader::Op(sqe.user_data & 3) == FileBatchReader::Op::CLOSE) {
+			::close(req.fd);
+			req.fd = -1;
+		}
+		memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_NOP;
+		sqe.user_data = FileBatchReader::IGNORED_USER_DATA;
+	}
+	u32 to_submit = tail - head;
+
+	#ifdef IORING_ASYNC_CANCEL_ANY
+		if (tail - head < reader->sq_entries) {
+			const u32 idx = tail & reader->sq_mask;
+			io_uring_sqe& sqe = reader->sqes[idx];
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_ASYNC_CANCEL;
+			sqe.cancel_flags = IORING_ASYNC_CANCEL_ANY;
+			sqe.user_data = FileBatchReader::IGNORED_USER_DATA;
+			reader->sq_array[idx] = idx;
+			__atomic_store_n(reader->sq_tail, tail + 1, __ATOMIC_RELEASE);
+			++to_submit;
+		}
+	#endif
+	reader->to_submit = 0;
+
+	// file ops always finish, so this waits only if io_uring_enter can not even wait for completions
+	constexpr float REAP_TIMEOUT = 5;
+	os::Timer timer;
+	while (hasPendingOps(reader) && timer.getTimeSinceStart() < REAP_TIMEOUT) {
+		const int res = io_uring_enter(reader->ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS);
+		if (res >= 0) to_submit -= minimum((u32)res, to_submit);
+		else if (errno != EINTR) {
+			// completions are still posted to the shared completion ring, so we poll it
+			to_submit = 0;
+			os::sleep(1);
+		}
+		processCompletions(reader);
+	}
+
+	reader->free_requests.clear();
+	for (u32 i = 0, c = reader->requests.size(); i < c; ++i) {
+		FileBatchReader::Request& req = reader->requests[i];
+		if (req.pending_ops > 0) {
+			// can not be reaped, so the memory the kernel writes to must stay alive
+			reader->leak = true;
+			if (req.active) reader->orphaned.emplace(static_cast<OutputMemoryStream&&>(*req.content));
+		}
+		else if (req.fd >= 0) {
+			::close(req.fd);
+		}
+		if (req.active) reader->results.push({req.user_ptr, false});
+		req.active = false;
+		req.fd = -1;
+		if (req.pending_ops == 0) reader->free_requests.push(i);
+	}
+	reader->in_flight = 0;
+	if (reader->leak) logError("io_uring reads could not be reaped");
+}
+
+u32 waitFileBatchReader(FileBatchReader* reader, Span<FileBatchResult> results) {
+	while (reader->results.empty() && reader->in_flight > 0) {
+		if (submit(reader, 1)) processCompletions(reader);
+		else breakRing(reader);
+	}
+	// submit closes and follow-up reads queued while processing completions
+	if (reader->to_submit > 0 && !submit(reader, 0)) breakRing(reader);
+
+	const u32 count = minimum(results.length(), reader->results.size());
+	memcpy(results.begin(), reader->results.begin(), count * sizeof(FileBatchResult));
+	reader->results.eraseRange(0, count);
+	return count;
+}
+
+} // namespace Lumix::os
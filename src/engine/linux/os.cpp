@@ -411,6 +411,54 @@ bool InputFile::seek(u64 pos) {
 }
 
 
+MappedFile::MappedFile() {
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
+MappedFile::~MappedFile() {
+	ASSERT(!m_data);
+}
+
+
+bool MappedFile::open(const char* path) {
+	ASSERT(!m_data);
+	const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	m_size = (u64)st.st_size;
+	if (m_size == 0) {
+		// mmap does not accept zero length
+		::close(fd);
+		return true;
+	}
+
+	void* mem = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// mapping keeps the file alive
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		m_size = 0;
+		return false;
+	}
+	m_data = (const u8*)mem;
+	return true;
+}
+
+
+void MappedFile::close() {
+	if (m_data) munmap((void*)m_data, m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
 u32 getCPUsCount() {
 	return sysconf(_SC_NPROCESSORS_ONLN);
 }
@@ -647,7 +695,7 @@ WindowHandle createWindow(const InitWindowArgs& args) {
 	XSetWindowAttributes attr = {};
 	XChangeWindowAttributes(display, win, CWBackPixel, &attr);
 
-	XMapWindow(display, win);
+	if (!(args.flags & InitWindowArgs::HIDDEN)) XMapWindow(display, win);
 	XStoreName(display, win, args.name && args.name[0] ? args.name : "Lumix App");
 
 	G.ic = XCreateIC(G.im, XNInputStyle, 0 | XIMPreeditNothing | XIMStatusNothing, XNClientWindow, win, NULL);
@@ -1187,6 +1235,19 @@ u64 getLastModified(StringView _path) {
 }
 
 
+bool evictFromFileCache(StringView _path) {
+	char path[MAX_PATH];
+	copyString(path, _path);
+
+	const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+	// dirty pages are not dropped, but files we read are not dirty
+	const bool res = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(fd);
+	return res;
+}
+
+
 bool makePath(const char* path) {
 	char tmp[MAX_PATH];
 	const char* cin = path;
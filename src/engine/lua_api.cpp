@@ -8,6 +8,8 @@
 #include "plugin.h"
 #include "prefab.h"
 #include "reflection.h"
+#include "resource_manager.h"
+#include "stream.h"
 #include "string.h"
 #include "world.h"
 #include <lua.h>
@@ -359,6 +361,41 @@ static int LUA_processFilesystemWork(lua_State* L) {
 }
 
 
+// returns totals of a resource type, durations in seconds, see ResourceManager::LoadStats
+static int LUA_getResourceLoadStats(lua_State* L) {
+	Engine* engine = LuaWrapper::getClosureObject<Engine>(L);
+	const char* type = LuaWrapper::checkArg<const char*>(L, 1);
+	ResourceManager* manager = engine->getResourceManager().get(ResourceType(type));
+	if (!manager) return 0;
+
+	const ResourceManager::LoadStats& stats = manager->getLoadStats();
+	lua_newtable(L);
+	LuaWrapper::setField(L, -1, "count", stats.count);
+	LuaWrapper::setField(L, -1, "bytes_read", stats.bytes_read);
+	LuaWrapper::setField(L, -1, "compressed_bytes_read", stats.compressed_bytes_read);
+	LuaWrapper::setField(L, -1, "decompressed_size", stats.decompressed_size);
+	LuaWrapper::setField(L, -1, "queue_wait", float(stats.queue_wait));
+	LuaWrapper::setField(L, -1, "read", float(stats.read));
+	LuaWrapper::setField(L, -1, "decompress", float(stats.decompress));
+	LuaWrapper::setField(L, -1, "load", float(stats.load));
+	LuaWrapper::setField(L, -1, "dependency_wait", float(stats.dependency_wait));
+	return 1;
+}
+
+
+// writes JSON if path ends with .json, CSV otherwise
+static int LUA_saveResourceLoadStats(lua_State* L) {
+	Engine* engine = LuaWrapper::getClosureObject<Engine>(L);
+	const char* path = LuaWrapper::checkArg<const char*>(L, 1);
+	OutputMemoryStream blob(engine->getAllocator());
+	if (endsWith(path, ".json")) engine->getResourceManager().writeLoadStatsJSON(blob);
+	else engine->getResourceManager().writeLoadStatsCSV(blob);
+	const bool res = engine->getFileSystem().saveContentSync(Path(path), blob);
+	lua_pushboolean(L, res);
+	return 1;
+}
+
+
 static void LUA_startGame(Engine* engine, World* world)
 {
 	if(engine && world) engine->startGame(*world);
@@ -962,6 +999,8 @@ void registerEngineAPI(lua_State* L, Engine* engine)
 	LuaWrapper::createSystemClosure(L, "LumixAPI", engine, "hasFilesystemWork", LUA_hasFilesystemWork);
 	LuaWrapper::createSystemClosure(L, "LumixAPI", engine, "processFilesystemWork", LUA_processFilesystemWork);
 	LuaWrapper::createSystemClosure(L, "LumixAPI", engine, "pause", LUA_pause);
+	LuaWrapper::createSystemClosure(L, "LumixAPI", engine, "getResourceLoadStats", LUA_getResourceLoadStats);
+	LuaWrapper::createSystemClosure(L, "LumixAPI", engine, "saveResourceLoadStats", LUA_saveResourceLoadStats);
 
 	#undef REGISTER_FUNCTION
 
@@ -82,7 +82,7 @@ struct EntityRef
 
 struct ComponentType
 {
-	enum { MAX_TYPES_COUNT = 64 };
+	enum { MAX_TYPES_COUNT = 256 };
 
 	i32 index;
 	bool operator==(const ComponentType& rhs) const { return rhs.index == index; }
@@ -2,6 +2,14 @@
 #include "math.h"
 #include "os.h"
 #include "simd.h"
+#if defined _M_X64 || defined __x86_64__
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#include <immintrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
 
 namespace Lumix
 {
@@ -1512,4 +1520,58 @@ void Matrix::setTranslation(const Vec3& t) {
 	columns[3].z = t.z;
 }
 
-} // namespace Lumix
\ No newline at end of file
+#if defined _M_X64 || defined __x86_64__
+	static void cpuid(u32 leaf, u32 subleaf, u32 (&regs)[4]) {
+		#ifdef _MSC_VER
+			int tmp[4];
+			__cpuidex(tmp, leaf, subleaf);
+			memcpy(regs, tmp, sizeof(regs));
+		#else
+			__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+		#endif
+	}
+
+	// which register states OS saves on context switch
+	static u64 xgetbv() {
+		#ifdef _MSC_VER
+			return _xgetbv(0);
+		#else
+			u32 eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return ((u64)edx << 32) | eax;
+		#endif
+	}
+
+	static SIMDLevel detectSIMDLevel() {
+		u32 regs[4];
+		cpuid(0, 0, regs);
+		if (regs[0] < 7) return SIMDLevel::SSE2;
+
+		cpuid(1, 0, regs);
+		const bool fma = regs[2] & (1 << 12);
+		const bool osxsave = regs[2] & (1 << 27);
+		const bool avx = regs[2] & (1 << 28);
+		if (!fma || !osxsave || !avx) return SIMDLevel::SSE2;
+
+		const u64 xcr0 = xgetbv();
+		// xmm and ymm
+		if ((xcr0 & 0x6) != 0x6) return SIMDLevel::SSE2;
+
+		cpuid(7, 0, regs);
+		const bool avx2 = regs[1] & (1 << 5);
+		const bool avx512f = regs[1] & (1 << 16);
+		if (!avx2) return SIMDLevel::SSE2;
+		// opmask and zmm
+		if (avx512f && (xcr0 & 0xe6) == 0xe6) return SIMDLevel::AVX512;
+		return SIMDLevel::AVX2;
+	}
+#else
+	static SIMDLevel detectSIMDLevel() { return SIMDLevel::SSE2; }
+#endif
+
+SIMDLevel getSIMDLevel() {
+	static const SIMDLevel level = detectSIMDLevel();
+	return level;
+}
+
+} // namespace Lumix
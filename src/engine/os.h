@@ -97,7 +97,9 @@ struct InitWindowArgs {
 	using HitTestCallback = HitTestResult (*)(void*, os::WindowHandle, Point);
 	enum Flags {
 		NO_DECORATION = 1 << 0,
-		NO_TASKBAR_ICON = 1 << 1
+		NO_TASKBAR_ICON = 1 << 1,
+		// window is never shown, e.g. only to have a context for GPU
+		HIDDEN = 1 << 2
 	};
 	const char* name = ""; 
 	const char* icon = nullptr;
@@ -153,6 +155,24 @@ private:
 	void* m_handle;
     bool m_is_error;
 };
+
+
+// whole file mapped read-only to memory, data is valid until close
+struct LUMIX_ENGINE_API MappedFile {
+	MappedFile();
+	~MappedFile();
+
+	[[nodiscard]] bool open(const char* path);
+	void close();
+
+	const u8* data() const { return m_data; }
+	u64 size() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	const u8* m_data;
+	u64 m_size;
+};
 	
 
 struct FileInfo {
@@ -160,6 +180,16 @@ struct FileInfo {
 	char filename[MAX_PATH];
 };
 
+// batched asynchronous reading of whole files, uses io_uring on linux
+// windows deliberately uses synchronous reads, createFileBatchReader returns nullptr if not supported
+// if io_uring fails at runtime, reads in flight fail and following reads are synchronous
+struct FileBatchReader;
+
+struct FileBatchResult {
+	void* user_ptr;
+	bool success;
+};
+
 struct FileIterator;
 
 struct WindowState {
@@ -185,6 +215,16 @@ LUMIX_ENGINE_API FileIterator* createFileIterator(StringView path, IAllocator& a
 LUMIX_ENGINE_API void destroyFileIterator(FileIterator* iterator);
 LUMIX_ENGINE_API bool getNextFile(FileIterator* iterator, FileInfo* info);
 
+// `queue_depth` is the max number of reads in flight
+LUMIX_ENGINE_API FileBatchReader* createFileBatchReader(u32 queue_depth, IAllocator& allocator);
+// there must be no reads in flight
+LUMIX_ENGINE_API void destroyFileBatchReader(FileBatchReader* reader);
+// `content` is resized to file size and must be alive until its result is returned by waitFileBatchReader
+// returns false if `queue_depth` reads are already in flight
+LUMIX_ENGINE_API [[nodiscard]] bool queueFileRead(FileBatchReader* reader, const char* path, OutputMemoryStream& content, void* user_ptr);
+// submits queued reads and blocks until at least one read is finished, returns number of results written to `results`
+LUMIX_ENGINE_API u32 waitFileBatchReader(FileBatchReader* reader, Span<FileBatchResult> results);
+
 LUMIX_ENGINE_API void setCurrentDirectory(StringView path);
 LUMIX_ENGINE_API void getCurrentDirectory(Span<char> path);
 LUMIX_ENGINE_API [[nodiscard]] bool getOpenFilename(Span<char> out, const char* filter, const char* starting_file);
@@ -200,6 +240,8 @@ LUMIX_ENGINE_API size_t getFileSize(StringView path);
 LUMIX_ENGINE_API bool fileExists(StringView path);
 LUMIX_ENGINE_API bool dirExists(StringView path);
 LUMIX_ENGINE_API u64 getLastModified(StringView file);
+// drops file's cached pages, so the next read goes to the disk, returns false if it's not supported
+LUMIX_ENGINE_API bool evictFromFileCache(StringView path);
 LUMIX_ENGINE_API [[nodiscard]] bool makePath(const char* path);
 
 LUMIX_ENGINE_API void setCursor(CursorType type);
@@ -1,7 +1,11 @@
 #include "engine/resource.h"
+#include "engine/array.h"
 #include "engine/hash.h"
+#include "engine/job_system.h"
 #include "engine/log.h"
 #include "engine/lumix.h"
+#include "engine/math.h"
+#include "engine/os.h"
 #include "engine/path.h"
 #include "engine/resource_manager.h"
 #include "engine/stream.h"
@@ -17,9 +21,7 @@ ResourceType::ResourceType(const char* type_name)
 {
 	ASSERT(type_name[0] == 0 || (type_name[0] >= 'a' && type_name[0] <= 'z'));
 	type = RuntimeHash(type_name);
-#ifdef LUMIX_DEBUG
 	str = type_name;
-#endif
 }
 
 
@@ -40,11 +42,23 @@ Resource::Resource(const Path& path, ResourceManager& resource_manager, IAllocat
 
 Resource::~Resource() = default;
 
+static float secondsSince(u64 raw_start) {
+	return float(double(os::Timer::getRawTimestamp() - raw_start) / double(os::Timer::getFrequency()));
+}
+
+void Resource::finishLoadStats() {
+	if (m_dependency_wait_start == 0) return;
+	m_load_stats.dependency_wait = secondsSince(m_dependency_wait_start);
+	m_dependency_wait_start = 0;
+	m_resource_manager.onLoadFinished(*this);
+}
+
 void Resource::refresh() {
 	if (m_current_state == State::EMPTY) return;
 
 	const State old_state = m_current_state;
 	m_current_state = State::EMPTY;	
+	updateMemorySize();
 	m_cb.invoke(old_state, m_current_state, *this);
 	checkState();
 }
@@ -55,7 +69,9 @@ void Resource::checkState()
 	auto old_state = m_current_state;
 	if (m_failed_dep_count > 0 && m_current_state != State::FAILURE)
 	{
+		finishLoadStats();
 		m_current_state = State::FAILURE;
+		updateMemorySize();
 		m_cb.invoke(old_state, m_current_state, *this);
 	}
 
@@ -78,19 +94,136 @@ void Resource::checkState()
 				return;
 			}
 
+			finishLoadStats();
 			m_current_state = State::READY;
+			updateMemorySize();
 			m_cb.invoke(old_state, m_current_state, *this);
 		}
 
 		if (m_empty_dep_count > 0 && m_current_state != State::EMPTY)
 		{
 			m_current_state = State::EMPTY;
+			updateMemorySize();
 			m_cb.invoke(old_state, m_current_state, *this);
 		}
 	}
 }
 
 
+// see CompiledResourceHeader::BLOCKS
+// `total_size` is the size of the whole decompressed content, `dst` can be shorter, only blocks overlapping it are decompressed
+static bool decompressBlocks(Span<const u8> src, Span<u8> dst, u64 total_size, IAllocator& allocator) {
+	InputMemoryStream blob(src);
+	const u32 block_size = blob.read<u32>();
+	const u32 block_count = blob.read<u32>();
+	if (blob.hasOverflow() || block_size == 0 || block_count == 0 || u64(block_count) * block_size < total_size || u64(block_count - 1) * block_size >= total_size) return false;
+	if (dst.length() > total_size) return false;
+	if (u64(block_count) * sizeof(u32) > blob.remaining()) return false;
+
+	// offsets of blocks in src
+	Array<u64> offsets(allocator);
+	offsets.resize(block_count + 1);
+	offsets[0] = blob.getPosition() + block_count * sizeof(u32);
+	for (u32 i = 0; i < block_count; ++i) {
+		offsets[i + 1] = offsets[i] + blob.read<u32>();
+	}
+	if (offsets[block_count] > src.length()) return false;
+
+	const u32 used_block_count = u32((dst.length() + block_size - 1) / block_size);
+	AtomicI32 failed = 0;
+	jobs::forEach(used_block_count, 1, [&](i32 from, i32 to){
+		for (i32 i = from; i < to; ++i) {
+			const u64 dst_offset = u64(i) * block_size;
+			const i32 block_dst_size = i32(minimum(u64(block_size), total_size - dst_offset));
+			const i32 dst_size = i32(minimum(u64(block_dst_size), dst.length() - dst_offset));
+			const char* block_src = (const char*)src.begin() + offsets[i];
+			const i32 block_src_size = i32(offsets[i + 1] - offsets[i]);
+			const i32 res = dst_size == block_dst_size
+				? LZ4_decompress_safe(block_src, (char*)dst.begin() + dst_offset, block_src_size, dst_size)
+				: LZ4_decompress_safe_partial(block_src, (char*)dst.begin() + dst_offset, block_src_size, dst_size, dst_size);
+			if (res != dst_size) failed = 1;
+		}
+	});
+	return failed == 0;
+}
+
+
+bool decompressCompiledResource(Span<const u8> blob, u64 prefix_size, OutputMemoryStream& content, IAllocator& allocator) {
+	const CompiledResourceHeader* header = (const CompiledResourceHeader*)blob.begin();
+	if (blob.length() < sizeof(*header)) return false;
+	if (header->magic != CompiledResourceHeader::MAGIC || header->version != 0) return false;
+
+	const Span<const u8> src = blob.fromLeft(sizeof(*header));
+	if ((header->flags & CompiledResourceHeader::COMPRESSED) == 0) {
+		content.write(src.begin(), minimum(prefix_size, (u64)src.length()));
+		return true;
+	}
+
+	const u64 size = minimum(prefix_size, header->decompressed_size);
+	content.resize(size);
+	const Span<u8> dst(content.getMutableData(), (u32)size);
+	if (header->flags & CompiledResourceHeader::BLOCKS) {
+		return decompressBlocks(src, dst, header->decompressed_size, allocator);
+	}
+	const i32 res = LZ4_decompress_safe_partial((const char*)src.begin(), (char*)dst.begin(), i32(src.length()), i32(size), i32(size));
+	return res == i32(size);
+}
+
+
+bool Resource::loadContent(Span<const u8> blob, bool is_prepare) {
+	auto loadTimed = [&](Span<const u8> content){
+		const u64 start = os::Timer::getRawTimestamp();
+		const bool res = is_prepare ? prepare(content) : load(content);
+		m_load_stats.load += secondsSince(start);
+		return res;
+	};
+
+	if (startsWith(getPath(), ".lumix/asset_tiles/")) {
+		return loadTimed(blob);
+	}
+	
+	const CompiledResourceHeader* header = (const CompiledResourceHeader*)blob.begin();
+	if (blob.length() < sizeof(*header)) {
+		logError("Invalid resource file, please delete .lumix directory");
+		return false;
+	}
+	if (header->magic != CompiledResourceHeader::MAGIC) {
+		logError("Invalid resource file, please delete .lumix directory");
+		return false;
+	}
+	if (header->version != 0) {
+		logError("Unsupported resource file version, please delete .lumix directory");
+		return false;
+	}
+	if (header->flags & CompiledResourceHeader::COMPRESSED) {
+		const u64 decompress_start = os::Timer::getRawTimestamp();
+		OutputMemoryStream tmp(m_resource_manager.m_allocator);
+		tmp.resize(header->decompressed_size);
+		bool decompressed;
+		if (header->flags & CompiledResourceHeader::BLOCKS) {
+			decompressed = decompressBlocks(blob.fromLeft(sizeof(*header)), Span(tmp.getMutableData(), (u32)tmp.size()), header->decompressed_size, m_resource_manager.m_allocator);
+		}
+		else {
+			const i32 res = LZ4_decompress_safe((const char*)blob.begin() + sizeof(*header), (char*)tmp.getMutableData(), i32(blob.length() - sizeof(*header)), (i32)tmp.size());
+			decompressed = res == header->decompressed_size;
+		}
+		m_load_stats.decompress = secondsSince(decompress_start);
+		m_load_stats.decompressed_size = header->decompressed_size;
+		if (!decompressed) {
+			logError("Could not decompress ", getPath());
+			return false;
+		}
+		return loadTimed(tmp);
+	}
+	return loadTimed(blob.fromLeft(sizeof(*header)));
+}
+
+
+void Resource::filePrepare(Span<const u8> blob) {
+	m_prepared = loadContent(blob, true);
+}
+
+
 void Resource::fileLoaded(Span<const u8> blob, bool success) {
 	ASSERT(m_async_op.isValid());
 	m_async_op = FileSystem::AsyncHandle::invalid();
@@ -120,45 +253,31 @@ void Resource::fileLoaded(Span<const u8> blob, bool success) {
 		return;
 	}
 
-	const CompiledResourceHeader* header = (const CompiledResourceHeader*)blob.begin();
 	m_file_size = blob.length();
-	if (startsWith(getPath(), ".lumix/asset_tiles/")) {
-		if (!load(blob)) ++m_failed_dep_count;
-	}
-	else if (blob.length() < sizeof(*header)) {
-		logError("Invalid resource file, please delete .lumix directory");
-		++m_failed_dep_count;
-	}
-	else if (header->magic != CompiledResourceHeader::MAGIC) {
-		logError("Invalid resource file, please delete .lumix directory");
-		++m_failed_dep_count;
+	const FileSystem::RequestStats& request_stats = m_resource_manager.getOwner().getFileSystem().getCallbackStats();
+	m_load_stats.bytes_read = request_stats.size;
+	m_load_stats.queue_wait = request_stats.queue_wait;
+	m_load_stats.read = request_stats.read;
+	if (isPrepareSupported()) {
+		const u64 finalize_start = os::Timer::getRawTimestamp();
+		if (!m_prepared || !finalize()) ++m_failed_dep_count;
+		m_load_stats.load += secondsSince(finalize_start);
 	}
-	else if (header->version != 0) {
-		logError("Unsupported resource file version, please delete .lumix directory");
+	else if (!loadContent(blob, false)) {
 		++m_failed_dep_count;
 	}
-	else if (header->flags & CompiledResourceHeader::COMPRESSED) {
-		OutputMemoryStream tmp(m_resource_manager.m_allocator);
-		tmp.resize(header->decompressed_size);
-		const i32 res = LZ4_decompress_safe((const char*)blob.begin() + sizeof(*header), (char*)tmp.getMutableData(), i32(blob.length() - sizeof(*header)), (i32)tmp.size());
-		if (res != header->decompressed_size || !load(tmp)) {
-			++m_failed_dep_count;
-		}
-	}
-	else {
-		if (!load(blob.fromLeft(sizeof(*header)))) {
-			++m_failed_dep_count;
-		}
-	} 
 
 	ASSERT(m_empty_dep_count > 0);
 	--m_empty_dep_count;
+	m_dependency_wait_start = os::Timer::getRawTimestamp();
 	checkState();
 }
 
 
 void Resource::doUnload()
 {
+	if (m_is_cached) m_resource_manager.removeFromCache(*this);
+
 	if (m_async_op.isValid())
 	{
 		FileSystem& fs = m_resource_manager.getOwner().getFileSystem();
@@ -168,6 +287,7 @@ void Resource::doUnload()
 
 	m_hooked = false;
 	m_desired_state = State::EMPTY;
+	m_dependency_wait_start = 0;
 	unload();
 	ASSERT(m_empty_dep_count <= 1);
 
@@ -187,6 +307,12 @@ void Resource::onCreated(State state)
 	m_desired_state = State::READY;
 	m_failed_dep_count = state == State::FAILURE ? 1 : 0;
 	m_empty_dep_count = 0;
+	updateMemorySize();
+}
+
+
+void Resource::updateMemorySize() {
+	m_resource_manager.updateMemorySize(*this);
 }
 
 
@@ -199,16 +325,23 @@ void Resource::doLoad()
 
 	ASSERT(m_current_state != State::READY);
 
+	m_load_stats = {};
 	FileSystem& fs = m_resource_manager.getOwner().getFileSystem();
 	FileSystem::ContentCallback cb = makeDelegate<&Resource::fileLoaded>(this);
+	const FileSystem::Priority priority = m_resource_manager.getLoadPriority();
+	FileSystem::PrepareCallback prepare_cb;
+	if (isPrepareSupported()) {
+		m_prepared = false;
+		prepare_cb = makeDelegate<&Resource::filePrepare>(this);
+	}
 
 	if (startsWith(m_path, ".lumix/asset_tiles/")) {
-		m_async_op = fs.getContent(m_path, cb);
+		m_async_op = fs.getPreparedContent(m_path, prepare_cb, cb, priority);
 	}
 	else {	
 		const FilePathHash hash = m_path.getHash();
 		const Path res_path(".lumix/resources/", hash, ".res");
-		m_async_op = fs.getContent(res_path, cb);
+		m_async_op = fs.getPreparedContent(res_path, prepare_cb, cb, priority);
 	}
 }
 
@@ -248,7 +381,12 @@ u32 Resource::decRefCount() {
 	ASSERT(m_ref_count > 0);
 	--m_ref_count;
 	if (m_ref_count == 0 && m_resource_manager.m_is_unload_enabled) {
-		doUnload();
+		if (isReady() && m_resource_manager.isCacheEnabled()) {
+			m_resource_manager.addToCache(*this);
+		}
+		else {
+			doUnload();
+		}
 	}
 	return m_ref_count;
 }
@@ -17,9 +17,8 @@ struct LUMIX_ENGINE_API ResourceType {
 	bool operator <(const ResourceType& rhs) const { return rhs.type.getHashValue() < type.getHashValue(); }
 	bool isValid() const { return type.getHashValue() != 0; }
 	RuntimeHash type;
-#ifdef LUMIX_DEBUG
+	// used in load stats reports
 	const char* str = nullptr;
-#endif
 };
 const ResourceType INVALID_RESOURCE_TYPE("");
 
@@ -30,8 +29,13 @@ template <> struct HashFunc<ResourceType> {
 #pragma pack(1)
 struct CompiledResourceHeader {
 	static constexpr u32 MAGIC = 'LRES';
+	// uncompressed size of each but the last block, see BLOCKS
+	static constexpr u32 BLOCK_SIZE = 256 * 1024;
 	enum Flags {
-		COMPRESSED = 1 << 0
+		COMPRESSED = 1 << 0,
+		// with COMPRESSED, data is split in independent LZ4 blocks, which are decompressed in parallel
+		// layout: u32 block_size, u32 block_count, u32 compressed_size[block_count], blocks
+		BLOCKS = 1 << 1
 	};
 	u32 magic = MAGIC;
 	u32 version = 0;
@@ -41,6 +45,21 @@ struct CompiledResourceHeader {
 };
 #pragma pack()
 
+// decompresses the first `prefix_size` bytes of content of a compiled resource file `blob`, i.e. data after CompiledResourceHeader
+// `prefix_size` is clamped to the content size; with CompiledResourceHeader::BLOCKS only blocks covering the prefix are decompressed
+LUMIX_ENGINE_API bool decompressCompiledResource(Span<const u8> blob, u64 prefix_size, struct OutputMemoryStream& content, struct IAllocator& allocator);
+
+// telemetry of the last load of a resource, durations are in seconds
+struct ResourceLoadStats {
+	u64 bytes_read = 0; // as stored, i.e. compressed size of compressed resources
+	u64 decompressed_size = 0; // 0 if not compressed
+	float queue_wait = 0; // file system request waiting for a reader
+	float read = 0;
+	float decompress = 0;
+	float load = 0; // `load` or `prepare` + `finalize`, without decompression
+	float dependency_wait = 0; // from the end of `load` until all dependencies are ready
+};
+
 struct LUMIX_ENGINE_API Resource {
 	friend struct ResourceManager;
 	friend struct ResourceManagerHub;
@@ -63,6 +82,10 @@ struct LUMIX_ENGINE_API Resource {
 	u32 getRefCount() const { return m_ref_count; }
 	ObserverCallback& getObserverCb() { return m_cb; }
 	u64 getFileSize() const { return m_file_size; }
+	const ResourceLoadStats& getLoadStats() const { return m_load_stats; }
+	// approximate memory held by a loaded resource, used by ResourceManager budgets
+	virtual u64 getCPUMemorySize() const { return m_file_size; }
+	virtual u64 getGPUMemorySize() const { return 0; }
 	const Path& getPath() const { return m_path; }
 	struct ResourceManager& getResourceManager() { return m_resource_manager; }
 	u32 decRefCount();
@@ -85,6 +108,12 @@ protected:
 	virtual void onBeforeReady() {}
 	virtual void unload() = 0;
 	virtual bool load(Span<const u8> blob) = 0;
+	// optional two-phase loading, used instead of `load` if `isPrepareSupported` returns true
+	// `prepare` runs on a worker thread, it must touch only data owned by the resource, e.g. parse content into CPU-side staging data
+	// `finalize` then runs on the main thread, only if `prepare` succeeded, e.g. to create GPU objects from the staging data
+	virtual bool isPrepareSupported() const { return false; }
+	virtual bool prepare(Span<const u8> blob) { return false; }
+	virtual bool finalize() { return false; }
 
 	void onCreated(State state);
 	void doUnload();
@@ -100,7 +129,13 @@ protected:
 protected:
 	void doLoad();
 	void fileLoaded(Span<const u8> mem, bool success);
+	void filePrepare(Span<const u8> mem);
+	// checks header, decompresses and calls `load` or `prepare`
+	bool loadContent(Span<const u8> mem, bool is_prepare);
 	void onStateChanged(State old_state, State new_state, Resource&);
+	void finishLoadStats();
+	// call when getCPUMemorySize or getGPUMemorySize of a ready resource changes, e.g. after streaming, see ResourceManager::Stats
+	void updateMemorySize();
 
 	Resource(const Resource&) = delete;
 	void operator=(const Resource&) = delete;
@@ -113,6 +148,21 @@ protected:
 	State m_current_state;
 	FileSystem::AsyncHandle m_async_op;
 	bool m_hooked = false;
+	// result of filePrepare, written on a worker thread before fileLoaded
+	bool m_prepared = false;
+	// unreferenced resources kept loaded by ResourceManager, see ResourceManager::setBudget
+	bool m_is_cached = false;
+	Resource* m_lru_prev = nullptr;
+	Resource* m_lru_next = nullptr;
+	// when the resource was put in cache, compared across all resource managers
+	u64 m_lru_stamp = 0;
+	// memory sizes included in ResourceManager::Stats
+	u64 m_counted_cpu_size = 0;
+	u64 m_counted_gpu_size = 0;
+	// written on a worker thread by filePrepare too
+	ResourceLoadStats m_load_stats;
+	// raw timestamp, when content was loaded and the resource started waiting for dependencies; 0 if not waiting
+	u64 m_dependency_wait_start = 0;
 }; // struct Resource
 
 
@@ -1,7 +1,11 @@
+#include "engine/command_line_parser.h"
 #include "engine/log.h"
 #include "engine/lumix.h"
+#include "engine/math.h"
+#include "engine/profiler.h"
 #include "engine/resource.h"
 #include "engine/resource_manager.h"
+#include "engine/stream.h"
 
 
 namespace Lumix
@@ -11,6 +15,7 @@ void ResourceManager::create(ResourceType type, ResourceManagerHub& owner)
 {
 	owner.add(type, this);
 	m_owner = &owner;
+	m_type = type;
 }
 
 void ResourceManager::destroy()
@@ -25,6 +30,7 @@ void ResourceManager::destroy()
 		destroyResource(*resource);
 	}
 	m_resources.clear();
+	m_lru_head = m_lru_tail = nullptr;
 }
 
 Resource* ResourceManager::get(const Path& path)
@@ -50,8 +56,14 @@ Resource* ResourceManager::load(const Path& path)
 		m_resources.insert(path.getHash(), resource);
 	}
 
+	if (resource->m_is_cached) {
+		removeFromCache(*resource);
+		++m_stats.hits;
+	}
+
 	if(resource->isEmpty() && resource->m_desired_state == Resource::State::EMPTY)
 	{
+		++m_stats.misses;
 		if (m_owner->onBeforeLoad(*resource) == ResourceManagerHub::LoadHook::Action::DEFERRED)
 		{
 			ASSERT(!resource->m_hooked);
@@ -85,6 +97,81 @@ void ResourceManager::removeUnreferenced()
 	}
 }
 
+bool ResourceManager::isCacheEnabled() const {
+	return m_budget.cpu != 0 || m_budget.gpu != 0 || m_owner->hasBudget();
+}
+
+void ResourceManager::addToCache(Resource& resource) {
+	// already cached resource could be referenced by incRefCount, without going through load
+	if (resource.m_is_cached) removeFromCache(resource);
+
+	resource.m_is_cached = true;
+	m_stats.cpu_cached += resource.m_counted_cpu_size;
+	m_stats.gpu_cached += resource.m_counted_gpu_size;
+	++m_stats.cached_count;
+	resource.m_lru_stamp = ++m_owner->m_lru_stamp;
+	resource.m_lru_prev = nullptr;
+	resource.m_lru_next = m_lru_head;
+	if (m_lru_head) m_lru_head->m_lru_prev = &resource;
+	else m_lru_tail = &resource;
+	m_lru_head = &resource;
+}
+
+void ResourceManager::removeFromCache(Resource& resource) {
+	ASSERT(resource.m_is_cached);
+	if (resource.m_lru_prev) resource.m_lru_prev->m_lru_next = resource.m_lru_next;
+	else m_lru_head = resource.m_lru_next;
+	if (resource.m_lru_next) resource.m_lru_next->m_lru_prev = resource.m_lru_prev;
+	else m_lru_tail = resource.m_lru_prev;
+	resource.m_lru_prev = nullptr;
+	resource.m_lru_next = nullptr;
+	resource.m_is_cached = false;
+	m_stats.cpu_cached -= resource.m_counted_cpu_size;
+	m_stats.gpu_cached -= resource.m_counted_gpu_size;
+	--m_stats.cached_count;
+}
+
+void ResourceManager::evictOldest() {
+	ASSERT(m_lru_tail);
+	Resource& resource = *m_lru_tail;
+	removeFromCache(resource);
+	if (resource.getRefCount() > 0) return;
+
+	++m_stats.evictions;
+	// resident sizes are updated by the state change
+	resource.doUnload();
+}
+
+// sizes of resources are counted incrementally, so stats do not have to iterate all resources every frame
+// sums wrap around in the middle, but the result is the same as with signed deltas
+void ResourceManager::updateMemorySize(Resource& resource) {
+	const u64 cpu = resource.isReady() ? resource.getCPUMemorySize() : 0;
+	const u64 gpu = resource.isReady() ? resource.getGPUMemorySize() : 0;
+	m_stats.cpu_resident += cpu - resource.m_counted_cpu_size;
+	m_stats.gpu_resident += gpu - resource.m_counted_gpu_size;
+	if (resource.m_is_cached) {
+		m_stats.cpu_cached += cpu - resource.m_counted_cpu_size;
+		m_stats.gpu_cached += gpu - resource.m_counted_gpu_size;
+	}
+	resource.m_counted_cpu_size = cpu;
+	resource.m_counted_gpu_size = gpu;
+}
+
+void ResourceManager::onLoadFinished(const Resource& resource) {
+	const ResourceLoadStats& stats = resource.getLoadStats();
+	++m_load_stats.count;
+	m_load_stats.bytes_read += stats.bytes_read;
+	if (stats.decompressed_size > 0) {
+		m_load_stats.compressed_bytes_read += stats.bytes_read;
+		m_load_stats.decompressed_size += stats.decompressed_size;
+	}
+	m_load_stats.queue_wait += stats.queue_wait;
+	m_load_stats.read += stats.read;
+	m_load_stats.decompress += stats.decompress;
+	m_load_stats.load += stats.load;
+	m_load_stats.dependency_wait += stats.dependency_wait;
+}
+
 void ResourceManager::reload(const Path& path)
 {
 	Resource* resource = get(path);
@@ -116,11 +203,17 @@ void ResourceManager::enableUnload(bool enable)
 	m_is_unload_enabled = enable;
 	if (!enable) return;
 
+	const bool cache = isCacheEnabled();
 	for (auto* resource : m_resources)
 	{
 		if (resource->getRefCount() == 0)
 		{
-			resource->doUnload();
+			if (cache && resource->isReady()) {
+				if (!resource->m_is_cached) addToCache(*resource);
+			}
+			else {
+				resource->doUnload();
+			}
 		}
 	}
 }
@@ -142,6 +235,7 @@ ResourceManagerHub::ResourceManagerHub(IAllocator& allocator)
 	, m_allocator(allocator)
 	, m_load_hook(nullptr)
 	, m_file_system(nullptr)
+	, m_pending_budgets(allocator)
 {
 }
 
@@ -215,6 +309,57 @@ ResourceManagerHub::LoadHook::Action ResourceManagerHub::onBeforeLoad(Resource&
 void ResourceManagerHub::add(ResourceType type, ResourceManager* rm)
 { 
 	m_resource_managers.insert(type, rm);
+	auto iter = m_pending_budgets.find(type);
+	if (iter.isValid()) {
+		rm->setBudget(iter.value());
+		m_pending_budgets.erase(iter);
+	}
+}
+
+void ResourceManagerHub::setBudget(ResourceType type, const ResourceManager::Budget& budget)
+{
+	auto iter = m_resource_managers.find(type);
+	if (iter.isValid()) iter.value()->setBudget(budget);
+	else m_pending_budgets.insert(type, budget);
+}
+
+static bool parseMB(CommandLineParser& parser, u64& value) {
+	if (!parser.next()) return false;
+	char tmp[32];
+	parser.getCurrent(tmp, sizeof(tmp));
+	u64 mb = 0;
+	if (!fromCString(tmp, mb)) return false;
+	value = mb * 1024 * 1024;
+	return true;
+}
+
+void ResourceManagerHub::parseBudgets(const char* cmd_line)
+{
+	CommandLineParser parser(cmd_line);
+	while (parser.next()) {
+		if (parser.currentEquals("-resource_budget")) {
+			ResourceManager::Budget budget;
+			if (!parseMB(parser, budget.cpu) || !parseMB(parser, budget.gpu)) {
+				logError("Expected -resource_budget <cpu MB> <gpu MB>");
+				return;
+			}
+			setBudget(budget);
+		}
+		else if (parser.currentEquals("-resource_type_budget")) {
+			char type_name[64] = "";
+			if (parser.next()) parser.getCurrent(type_name, sizeof(type_name));
+			ResourceManager::Budget budget;
+			// resource type names are lowercase
+			if (type_name[0] < 'a' || type_name[0] > 'z' || !parseMB(parser, budget.cpu) || !parseMB(parser, budget.gpu)) {
+				logError("Expected -resource_type_budget <type> <cpu MB> <gpu MB>");
+				return;
+			}
+			ResourceType type(type_name);
+			// points to `type_name`, can not outlive this function
+			type.str = nullptr;
+			setBudget(type, budget);
+		}
+	}
 }
 
 void ResourceManagerHub::remove(ResourceType type)
@@ -230,6 +375,192 @@ void ResourceManagerHub::removeUnreferenced()
 	}
 }
 
+static const char* getTypeName(const ResourceManager& manager) {
+	const char* name = manager.getType().str;
+	return name ? name : "unknown";
+}
+
+static bool isOverBudget(const ResourceManager::Budget& budget, u64 cpu, u64 gpu) {
+	return (budget.cpu != 0 && cpu > budget.cpu) || (budget.gpu != 0 && gpu > budget.gpu);
+}
+
+void ResourceManagerHub::update()
+{
+	PROFILE_FUNCTION();
+	u64 cpu = 0;
+	u64 gpu = 0;
+	u64 cached = 0;
+	u64 hits = 0;
+	u64 misses = 0;
+	// O(number of managers), stats are kept up to date by resources, see ResourceManager::updateMemorySize
+	for (ResourceManager* manager : m_resource_managers) {
+		const ResourceManager::Stats& stats = manager->m_stats;
+		// cache can be disabled by removing the budget
+		const bool flush = !manager->isCacheEnabled();
+		while (manager->m_lru_tail && (flush || isOverBudget(manager->m_budget, stats.cpu_resident, stats.gpu_resident))) {
+			manager->evictOldest();
+		}
+		cpu += stats.cpu_resident;
+		gpu += stats.gpu_resident;
+		cached += stats.cpu_cached + stats.gpu_cached;
+		hits += stats.hits;
+		misses += stats.misses;
+
+		if (manager->m_resident_counter == 0xffFFffFF) {
+			// most types are never used, do not clutter the profiler with them
+			if (stats.cpu_resident + stats.gpu_resident == 0) continue;
+			const StaticString<64> resident_name(getTypeName(*manager), " resident (MB)");
+			const StaticString<64> hit_rate_name(getTypeName(*manager), " cache hit rate (%)");
+			manager->m_resident_counter = profiler::createCounter(resident_name, 0);
+			manager->m_hit_rate_counter = profiler::createCounter(hit_rate_name, 0);
+		}
+		profiler::pushCounter(manager->m_resident_counter, float(double(stats.cpu_resident + stats.gpu_resident) / (1024.0 * 1024.0)));
+		const u32 loads = stats.hits + stats.misses;
+		profiler::pushCounter(manager->m_hit_rate_counter, loads > 0 ? float(100.0 * double(stats.hits) / double(loads)) : 0.f);
+	}
+
+	// global budget, evict the least recently used resource of any type
+	while (isOverBudget(m_budget, cpu, gpu)) {
+		ResourceManager* oldest = nullptr;
+		for (ResourceManager* manager : m_resource_managers) {
+			if (!manager->m_lru_tail) continue;
+			if (!oldest || manager->m_lru_tail->m_lru_stamp < oldest->m_lru_tail->m_lru_stamp) oldest = manager;
+		}
+		if (!oldest) break;
+
+		const ResourceManager::Stats& stats = oldest->m_stats;
+		const u64 prev_cpu = stats.cpu_resident;
+		const u64 prev_gpu = stats.gpu_resident;
+		const u64 prev_cached = stats.cpu_cached + stats.gpu_cached;
+		oldest->evictOldest();
+		cpu -= prev_cpu - stats.cpu_resident;
+		gpu -= prev_gpu - stats.gpu_resident;
+		cached -= prev_cached - (stats.cpu_cached + stats.gpu_cached);
+	}
+
+	static u32 cpu_counter = profiler::createCounter("Resources CPU (MB)", 0);
+	static u32 gpu_counter = profiler::createCounter("Resources GPU (MB)", 0);
+	static u32 cached_counter = profiler::createCounter("Cached resources (MB)", 0);
+	static u32 hit_rate_counter = profiler::createCounter("Resource cache hit rate (%)", 0);
+	profiler::pushCounter(cpu_counter, float(double(cpu) / (1024.0 * 1024.0)));
+	profiler::pushCounter(gpu_counter, float(double(gpu) / (1024.0 * 1024.0)));
+	profiler::pushCounter(cached_counter, float(double(cached) / (1024.0 * 1024.0)));
+	profiler::pushCounter(hit_rate_counter, hits + misses > 0 ? float(100.0 * double(hits) / double(hits + misses)) : 0.f);
+}
+
+void ResourceManagerHub::clearCache()
+{
+	// unloading a resource can put its dependencies in cache, so repeat until nothing is cached
+	bool any_cached = true;
+	while (any_cached) {
+		any_cached = false;
+		for (ResourceManager* manager : m_resource_managers) {
+			while (manager->m_lru_tail) {
+				manager->evictOldest();
+				any_cached = true;
+			}
+		}
+	}
+}
+
+static const char* toString(Resource::State state) {
+	switch (state) {
+		case Resource::State::EMPTY: return "empty";
+		case Resource::State::READY: return "ready";
+		case Resource::State::FAILURE: return "failure";
+	}
+	return "unknown";
+}
+
+static void writeJSONString(IOutputStream& out, StringView value) {
+	out << "\"";
+	for (const char* c = value.begin; c != value.end; ++c) {
+		if (*c == '"' || *c == '\\') out << "\\";
+		out.write(c, 1);
+	}
+	out << "\"";
+}
+
+// RFC 4180, paths can contain commas and quotes
+static void writeCSVString(IOutputStream& out, StringView value) {
+	out << "\"";
+	for (const char* c = value.begin; c != value.end; ++c) {
+		if (*c == '"') out << "\"";
+		out.write(c, 1);
+	}
+	out << "\"";
+}
+
+// durations are written in milliseconds
+void ResourceManagerHub::writeLoadStatsCSV(IOutputStream& out) const
+{
+	out << "type,path,state,bytes_read,decompressed_size,queue_wait_ms,read_ms,decompress_ms,load_ms,dependency_wait_ms\n";
+	for (const ResourceManager* manager : m_resource_managers) {
+		const char* type_name = getTypeName(*manager);
+		for (const Resource* res : manager->m_resources) {
+			const ResourceLoadStats& stats = res->getLoadStats();
+			if (stats.bytes_read == 0) continue;
+			out << type_name << ",";
+			writeCSVString(out, res->getPath());
+			out << "," << toString(res->getState())
+				<< "," << stats.bytes_read << "," << stats.decompressed_size
+				<< "," << stats.queue_wait * 1000 << "," << stats.read * 1000 << "," << stats.decompress * 1000
+				<< "," << stats.load * 1000 << "," << stats.dependency_wait * 1000 << "\n";
+		}
+	}
+}
+
+void ResourceManagerHub::writeLoadStatsJSON(IOutputStream& out) const
+{
+	out << "{\n\t\"types\": [";
+	bool first = true;
+	for (const ResourceManager* manager : m_resource_managers) {
+		const ResourceManager::LoadStats& stats = manager->getLoadStats();
+		out << (first ? "\n" : ",\n") << "\t\t{ \"type\": ";
+		first = false;
+		writeJSONString(out, getTypeName(*manager));
+		out << ", \"count\": " << stats.count
+			<< ", \"bytes_read\": " << stats.bytes_read
+			<< ", \"compressed_bytes_read\": " << stats.compressed_bytes_read
+			<< ", \"decompressed_size\": " << stats.decompressed_size
+			<< ", \"queue_wait_ms\": " << stats.queue_wait * 1000
+			<< ", \"read_ms\": " << stats.read * 1000
+			<< ", \"decompress_ms\": " << stats.decompress * 1000
+			<< ", \"load_ms\": " << stats.load * 1000
+			<< ", \"dependency_wait_ms\": " << stats.dependency_wait * 1000 << " }";
+	}
+	out << "\n\t],\n\t\"resources\": [";
+	first = true;
+	for (const ResourceManager* manager : m_resource_managers) {
+		const char* type_name = getTypeName(*manager);
+		for (const Resource* res : manager->m_resources) {
+			const ResourceLoadStats& stats = res->getLoadStats();
+			if (stats.bytes_read == 0) continue;
+			out << (first ? "\n" : ",\n") << "\t\t{ \"type\": ";
+			first = false;
+			writeJSONString(out, type_name);
+			out << ", \"path\": ";
+			writeJSONString(out, res->getPath());
+			out << ", \"state\": \"" << toString(res->getState()) << "\""
+				<< ", \"bytes_read\": " << stats.bytes_read
+				<< ", \"decompressed_size\": " << stats.decompressed_size
+				<< ", \"queue_wait_ms\": " << stats.queue_wait * 1000
+				<< ", \"read_ms\": " << stats.read * 1000
+				<< ", \"decompress_ms\": " << stats.decompress * 1000
+				<< ", \"load_ms\": " << stats.load * 1000
+				<< ", \"dependency_wait_ms\": " << stats.dependency_wait * 1000 << " }";
+		}
+	}
+	out << "\n\t]\n}\n";
+}
+
+void ResourceManagerHub::resetLoadStats()
+{
+	for (ResourceManager* manager : m_resource_managers) {
+		manager->resetLoadStats();
+	}
+}
+
 void ResourceManagerHub::enableUnload(bool enable)
 {
 	for (auto* manager : m_resource_managers)
@@ -1,8 +1,10 @@
 #pragma once
 
 
+#include "engine/file_system.h"
 #include "engine/hash.h"
 #include "engine/hash_map.h"
+#include "engine/resource.h"
 
 
 namespace Lumix
@@ -14,12 +16,57 @@ struct LUMIX_ENGINE_API ResourceManager {
 	friend struct ResourceManagerHub;
 	using ResourceTable = HashMap<FilePathHash, struct Resource*>;
 
+	// in bytes, 0 == unlimited
+	struct Budget {
+		u64 cpu = 0;
+		u64 gpu = 0;
+	};
+
+	struct Stats {
+		// all loaded resources, including cached ones; updated on state and size changes of resources
+		u64 cpu_resident = 0;
+		u64 gpu_resident = 0;
+		// unreferenced resources kept in cache
+		u64 cpu_cached = 0;
+		u64 gpu_cached = 0;
+		u32 cached_count = 0;
+		// hit == load of a cached resource, miss == load which has to read the resource
+		u32 hits = 0;
+		u32 misses = 0;
+		u32 evictions = 0;
+	};
+
+	// sums of ResourceLoadStats of all loads since resetLoadStats, durations are in seconds
+	struct LoadStats {
+		u32 count = 0;
+		u64 bytes_read = 0;
+		// bytes_read and decompressed size of compressed resources
+		u64 compressed_bytes_read = 0;
+		u64 decompressed_size = 0;
+		double queue_wait = 0;
+		double read = 0;
+		double decompress = 0;
+		double load = 0;
+		double dependency_wait = 0;
+	};
+
 	void create(struct ResourceType type, struct ResourceManagerHub& owner);
 	void destroy();
 
 	void enableUnload(bool enable);
+	// priority of file system requests of resources from this manager
+	void setLoadPriority(FileSystem::Priority priority) { m_load_priority = priority; }
+	FileSystem::Priority getLoadPriority() const { return m_load_priority; }
 
 	void removeUnreferenced();
+	// with a budget (or a global one in ResourceManagerHub), unreferenced resources are not unloaded immediately
+	// they are kept in LRU cache, and the least recently used ones are unloaded once the budget is exceeded
+	void setBudget(const Budget& budget) { m_budget = budget; }
+	const Budget& getBudget() const { return m_budget; }
+	const Stats& getStats() const { return m_stats; }
+	const LoadStats& getLoadStats() const { return m_load_stats; }
+	void resetLoadStats() { m_load_stats = {}; }
+	ResourceType getType() const { return m_type; }
 
 	void reload(const struct Path& path);
 	void reload(Resource& resource);
@@ -34,16 +81,34 @@ protected:
 	virtual Resource* createResource(const Path& path) = 0;
 	virtual void destroyResource(Resource& resource) = 0;
 	Resource* get(const Path& path);
+	bool isCacheEnabled() const;
+	void addToCache(Resource& resource);
+	void removeFromCache(Resource& resource);
+	void evictOldest();
+	void updateMemorySize(Resource& resource);
+	void onLoadFinished(const Resource& resource);
 
 protected:
 	IAllocator& m_allocator;
 	ResourceTable m_resources;
 	ResourceManagerHub* m_owner;
 	bool m_is_unload_enabled;
+	FileSystem::Priority m_load_priority = FileSystem::Priority::NORMAL;
+	ResourceType m_type;
+	Budget m_budget;
+	Stats m_stats;
+	LoadStats m_load_stats;
+	// most recently used cached resource is the head
+	Resource* m_lru_head = nullptr;
+	Resource* m_lru_tail = nullptr;
+	// profiler counters, created once the type has something resident
+	u32 m_resident_counter = 0xffFFffFF;
+	u32 m_hit_rate_counter = 0xffFFffFF;
 };
 
 
 struct LUMIX_ENGINE_API ResourceManagerHub {
+	friend struct ResourceManager;
 	using ResourceManagerTable = HashMap<ResourceType, ResourceManager*>;
 
 	struct LUMIX_ENGINE_API LoadHook {
@@ -84,6 +149,22 @@ struct LUMIX_ENGINE_API ResourceManagerHub {
 	void reloadAll();
 	void removeUnreferenced();
 	void enableUnload(bool enable);
+	// over all resource types, see ResourceManager::setBudget
+	void setBudget(const ResourceManager::Budget& budget) { m_budget = budget; }
+	// per type budget, can be set before the type's manager is added
+	void setBudget(ResourceType type, const ResourceManager::Budget& budget);
+	// -resource_budget <cpu MB> <gpu MB>, -resource_type_budget <type> <cpu MB> <gpu MB>, 0 == unlimited
+	void parseBudgets(const char* cmd_line);
+	const ResourceManager::Budget& getBudget() const { return m_budget; }
+	bool hasBudget() const { return m_budget.cpu != 0 || m_budget.gpu != 0; }
+	// evicts cached resources over budgets and reports memory usage to profiler, once per frame
+	void update();
+	// unloads all cached resources
+	void clearCache();
+	// per type totals and last load of every resource, see ResourceLoadStats
+	void writeLoadStatsCSV(struct IOutputStream& out) const;
+	void writeLoadStatsJSON(struct IOutputStream& out) const;
+	void resetLoadStats();
 
 	FileSystem& getFileSystem() { return *m_file_system; }
 
@@ -93,6 +174,10 @@ private:
 	ResourceManagerTable m_resource_managers;
 	FileSystem* m_file_system;
 	LoadHook* m_load_hook;
+	ResourceManager::Budget m_budget;
+	// budgets of types without a manager yet, applied in `add`
+	HashMap<ResourceType, ResourceManager::Budget> m_pending_budgets;
+	u64 m_lru_stamp = 0;
 };
 
 
@@ -15,6 +15,14 @@
 namespace Lumix
 {
 
+// widest vector instruction set usable on the current CPU and OS, detected once
+enum class SIMDLevel : u8 {
+	SSE2,
+	AVX2, // with FMA
+	AVX512 // F
+};
+
+LUMIX_ENGINE_API SIMDLevel getSIMDLevel();
 
 #if defined _WIN32 && !defined __clang__
 	using float4 = __m128;
@@ -0,0 +1,26 @@
+#include "engine/os.h"
+
+
+namespace Lumix::os {
+
+// not implemented on purpose, FileSystem falls back to reading on its IO threads with synchronous reads,
+// unlike open/statx/close on io_uring, overlapped IO would still block in CreateFile
+FileBatchReader* createFileBatchReader(u32 queue_depth, IAllocator& allocator) {
+	return nullptr;
+}
+
+void destroyFileBatchReader(FileBatchReader* reader) {
+	ASSERT(!reader);
+}
+
+bool queueFileRead(FileBatchReader* reader, const char* path, OutputMemoryStream& content, void* user_ptr) {
+	ASSERT(false);
+	return false;
+}
+
+u32 waitFileBatchReader(FileBatchReader* reader, Span<FileBatchResult> results) {
+	ASSERT(false);
+	return 0;
+}
+
+} // namespace Lumix::os
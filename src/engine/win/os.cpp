@@ -198,6 +198,63 @@ bool InputFile::seek(u64 pos)
 }
 
 
+MappedFile::MappedFile()
+{
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
+MappedFile::~MappedFile()
+{
+	ASSERT(!m_data);
+}
+
+
+bool MappedFile::open(const char* path)
+{
+	ASSERT(!m_data);
+	HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == file) return false;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size)) {
+		::CloseHandle(file);
+		return false;
+	}
+	m_size = size.QuadPart;
+	if (m_size == 0) {
+		// empty files can not be mapped
+		::CloseHandle(file);
+		return true;
+	}
+
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	::CloseHandle(file);
+	if (!mapping) {
+		m_size = 0;
+		return false;
+	}
+
+	// view keeps the mapping alive
+	m_data = (const u8*)::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(mapping);
+	if (!m_data) {
+		m_size = 0;
+		return false;
+	}
+	return true;
+}
+
+
+void MappedFile::close()
+{
+	if (m_data) ::UnmapViewOfFile(m_data);
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
 static void fromWChar(Span<char> out, const WCHAR* in)
 {
 	const WCHAR* c = in;
@@ -745,8 +802,10 @@ WindowHandle createWindow(const InitWindowArgs& args) {
 		DragAcceptFiles(hwnd, TRUE);
 	}
 
-	ShowWindow(hwnd, SW_SHOW);
-	DEBUG_CHECK(UpdateWindow(hwnd));
+	if (!(args.flags & InitWindowArgs::HIDDEN)) {
+		ShowWindow(hwnd, SW_SHOW);
+		DEBUG_CHECK(UpdateWindow(hwnd));
+	}
 
 	if (!G.raw_input_registered) {
 		RAWINPUTDEVICE device;
@@ -1327,22 +1386,24 @@ bool dirExists(StringView path)
 u64 getLastModified(StringView path)
 {
 	const WCharStr<MAX_PATH> wpath(path);
-	FILETIME ft;
-	HANDLE handle = CreateFile(wpath, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-	if (handle == INVALID_HANDLE_VALUE) return 0;
-	if (GetFileTime(handle, NULL, NULL, &ft) == FALSE) {
-		CloseHandle(handle);
-		return 0;
-	}
-	CloseHandle(handle);
+	// works for directories too and does not need to open the file
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesEx(wpath, GetFileExInfoStandard, &data)) return 0;
 
 	ULARGE_INTEGER i;
-	i.LowPart = ft.dwLowDateTime;
-	i.HighPart = ft.dwHighDateTime;
+	i.LowPart = data.ftLastWriteTime.dwLowDateTime;
+	i.HighPart = data.ftLastWriteTime.dwHighDateTime;
 	return i.QuadPart;
 }
 
 
+bool evictFromFileCache(StringView path)
+{
+	// standby list can be purged only with admin rights (RAMMap), not per file
+	return false;
+}
+
+
 bool makePath(const char* path)
 {
 	char tmp[MAX_PATH];
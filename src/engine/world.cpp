@@ -47,6 +47,7 @@ World::World(Engine& engine)
 	: m_allocator(engine.getAllocator(), "world")
 	, m_engine(engine)
 	, m_names(m_allocator)
+	, m_name_index(m_allocator)
 	, m_entities(m_allocator)
 	, m_component_added(m_allocator)
 	, m_component_destroyed(m_allocator)
@@ -58,10 +59,14 @@ World::World(Engine& engine)
 	, m_hierarchy(m_allocator)
 	, m_transforms(m_allocator)
 	, m_partitions(m_allocator)
+	, m_archetypes(m_allocator)
+	, m_archetype_map(m_allocator)
 {
 	m_entities.reserve(RESERVED_ENTITIES_COUNT);
 	m_transforms.reserve(RESERVED_ENTITIES_COUNT);
 	memset(m_component_type_map, 0, sizeof(m_component_type_map));
+	const u32 empty_archetype = getArchetype(ComponentMask());
+	ASSERT(empty_archetype == 0);
 
 	PartitionHandle p = createPartition("");
 	setActivePartition(p);
@@ -294,6 +299,58 @@ void World::setPosition(EntityRef entity, const DVec3& pos)
 }
 
 
+static u64 getNameKey(EntityPtr parent, const char* name) {
+	return RuntimeHash(name).getHashValue() ^ ((u64)(u32)parent.index * 0x9E3779B97F4A7C15U);
+}
+
+
+void World::addToNameIndex(EntityRef entity) {
+	const i32 name_idx = m_entities[entity.index].name;
+	if (name_idx < 0) return;
+	EntityName& name = m_names[name_idx];
+	if (!name.name[0]) return;
+	
+	const u64 key = getNameKey(getParent(entity), name.name);
+	name.next_same_key = INVALID_ENTITY;
+	auto iter = m_name_index.find(key);
+	if (!iter.isValid()) {
+		m_name_index.insert(key, entity);
+		return;
+	}
+
+	// appended, so findByName returns the first inserted of entities with the same name and parent
+	EntityName* last = &m_names[m_entities[iter.value().index].name];
+	while (last->next_same_key.isValid()) {
+		last = &m_names[m_entities[last->next_same_key.index].name];
+	}
+	last->next_same_key = entity;
+}
+
+
+void World::removeFromNameIndex(EntityRef entity) {
+	const i32 name_idx = m_entities[entity.index].name;
+	if (name_idx < 0) return;
+	const EntityName& name = m_names[name_idx];
+	if (!name.name[0]) return;
+
+	const u64 key = getNameKey(getParent(entity), name.name);
+	auto iter = m_name_index.find(key);
+	ASSERT(iter.isValid());
+	if (iter.value() == entity) {
+		if (name.next_same_key.isValid()) iter.value() = (EntityRef)name.next_same_key;
+		else m_name_index.erase(iter);
+		return;
+	}
+
+	EntityName* prev = &m_names[m_entities[iter.value().index].name];
+	while (prev->next_same_key != entity) {
+		ASSERT(prev->next_same_key.isValid());
+		prev = &m_names[m_entities[prev->next_same_key.index].name];
+	}
+	prev->next_same_key = name.next_same_key;
+}
+
+
 void World::setEntityName(EntityRef entity, StringView name)
 {
 	int name_idx = m_entities[entity.index].name;
@@ -308,8 +365,10 @@ void World::setEntityName(EntityRef entity, StringView name)
 	}
 	else
 	{
+		removeFromNameIndex(entity);
 		copyString(m_names[name_idx].name, name);
 	}
+	addToNameIndex(entity);
 }
 
 
@@ -323,29 +382,17 @@ const char* World::getEntityName(EntityRef entity) const
 
 EntityPtr World::findByName(EntityPtr parent, const char* name)
 {
-	if (parent.isValid()) {
-		int h_idx = m_entities[parent.index].hierarchy;
-		if (h_idx < 0) return INVALID_ENTITY;
-
-		EntityPtr e = m_hierarchy[h_idx].first_child;
-		while (e.isValid()) {
-			const EntityData& data = m_entities[e.index];
-			int name_idx = data.name;
-			if (name_idx >= 0) {
-				if (equalStrings(m_names[name_idx].name, name)) return e;
-			}
-			e = m_hierarchy[data.hierarchy].next_sibling;
-		}
-	}
-	else
-	{
-		for (int i = 0, c = m_names.size(); i < c; ++i) {
-			if (equalStrings(m_names[i].name, name)) {
-				const EntityData& data = m_entities[m_names[i].entity.index];
-				if (data.hierarchy < 0) return m_names[i].entity;
-				if (!m_hierarchy[data.hierarchy].parent.isValid()) return m_names[i].entity;
-			}
-		}
+	if (!name[0]) return INVALID_ENTITY;
+
+	auto iter = m_name_index.find(getNameKey(parent, name));
+	if (!iter.isValid()) return INVALID_ENTITY;
+
+	EntityPtr e = iter.value();
+	while (e.isValid()) {
+		const EntityName& name_data = m_names[m_entities[e.index].name];
+		// different (parent, name) pairs can collide
+		if (equalStrings(name_data.name, name) && getParent((EntityRef)e) == parent) return e;
+		e = name_data.next_same_key;
 	}
 
 	return INVALID_ENTITY;
@@ -389,8 +436,8 @@ void World::emplaceEntity(EntityRef entity)
 	tr.scale = Vec3(1);
 	data.name = -1;
 	data.hierarchy = -1;
-	data.components = 0;
 	data.valid = true;
+	addToArchetype(entity, 0);
 
 	m_entity_created.invoke(entity);
 }
@@ -421,8 +468,8 @@ EntityRef World::createEntity(const DVec3& position, const Quat& rotation)
 	data->partition = m_active_partition;
 	data->name = -1;
 	data->hierarchy = -1;
-	data->components = 0;
 	data->valid = true;
+	addToArchetype(entity, 0);
 	m_entity_created.invoke(entity);
 
 	return entity;
@@ -438,19 +485,16 @@ void World::destroyEntity(EntityRef entity)
 	}
 	setParent(INVALID_ENTITY, entity);
 
-	u64 mask = entity_data.components;
-	for (int i = 0; i < ComponentType::MAX_TYPES_COUNT; ++i)
-	{
-		if ((mask & ((u64)1 << i)) != 0)
-		{
-			auto original_mask = mask;
+	for (i32 i = 0; i < ComponentType::MAX_TYPES_COUNT && entity_data.archetype != 0; ++i) {
+		const ComponentType type = {i};
+		if (m_archetypes[entity_data.archetype].mask.has(type)) {
 			IModule* module = m_component_type_map[i].module;
 			auto destroy_method = m_component_type_map[i].destroy;
 			destroy_method(module, entity);
-			mask = entity_data.components;
-			ASSERT(original_mask != mask);
+			ASSERT(!m_archetypes[entity_data.archetype].mask.has(type));
 		}
 	}
+	removeFromArchetype(entity);
 
 	entity_data.next = m_first_free_slot;
 	entity_data.prev = -1;
@@ -464,6 +508,7 @@ void World::destroyEntity(EntityRef entity)
 
 	if (entity_data.name >= 0)
 	{
+		removeFromNameIndex(entity);
 		m_entities[m_names.back().entity.index].name = entity_data.name;
 		m_names.swapAndPop(entity_data.name);
 		entity_data.name = -1;
@@ -474,6 +519,41 @@ void World::destroyEntity(EntityRef entity)
 }
 
 
+u32 World::getArchetype(const ComponentMask& mask) {
+	auto iter = m_archetype_map.find(mask);
+	if (iter.isValid()) return iter.value();
+
+	const u32 idx = m_archetypes.size();
+	Archetype& archetype = m_archetypes.emplace(m_allocator);
+	archetype.mask = mask;
+	m_archetype_map.insert(mask, idx);
+	return idx;
+}
+
+
+void World::addToArchetype(EntityRef entity, u32 archetype_idx) {
+	Archetype& archetype = m_archetypes[archetype_idx];
+	EntityData& data = m_entities[entity.index];
+	data.archetype = archetype_idx;
+	data.archetype_idx = archetype.entities.size();
+	archetype.entities.push(entity);
+}
+
+
+void World::removeFromArchetype(EntityRef entity) {
+	const EntityData& data = m_entities[entity.index];
+	Archetype& archetype = m_archetypes[data.archetype];
+	const EntityRef last = archetype.entities.back();
+	m_entities[last.index].archetype_idx = data.archetype_idx;
+	archetype.entities.swapAndPop(data.archetype_idx);
+}
+
+
+WorldQuery World::query(const ComponentMask& mask) const {
+	return WorldQuery(*this, mask);
+}
+
+
 EntityPtr World::getFirstEntity() const
 {
 	for (int i = 0; i < m_entities.size(); ++i)
@@ -538,6 +618,9 @@ void World::setParent(EntityPtr new_parent, EntityRef child)
 		return;
 	}
 
+	// name index is keyed by parent
+	removeFromNameIndex(child);
+
 	auto collectGarbage = [this](EntityRef entity) {
 		Hierarchy& h = m_hierarchy[m_entities[entity.index].hierarchy];
 		if (h.parent.isValid()) return;
@@ -611,6 +694,7 @@ void World::setParent(EntityPtr new_parent, EntityRef child)
 	{
 		if (child_idx >= 0) collectGarbage(child);
 	}
+	addToNameIndex(child);
 }
 
 
@@ -867,6 +951,7 @@ bool World::deserialize(InputMemoryStream& serializer, EntityMap& entity_map, Wo
 
 	u32 count;
 	serializer.read(count);
+	const u32 old_names_count = m_names.size();
 	for (u32 i = 0; i < count; ++i) {
 		EntityName& name = m_names.emplace();
 		serializer.read(name.entity);
@@ -905,6 +990,11 @@ bool World::deserialize(InputMemoryStream& serializer, EntityMap& entity_map, Wo
 		}
 	}
 
+	// after hierarchy, since parents are part of the key
+	for (u32 i = old_names_count, c = m_names.size(); i < c; ++i) {
+		addToNameIndex(m_names[i].entity);
+	}
+
 	i32 module_count;
 	serializer.read(module_count);
 	for (int i = 0; i < module_count; ++i) {
@@ -943,10 +1033,10 @@ const Vec3& World::getScale(EntityRef entity) const
 
 ComponentUID World::getFirstComponent(EntityRef entity) const
 {
-	u64 mask = m_entities[entity.index].components;
+	const ComponentMask& mask = getComponentsMask(entity);
 	for (int i = 0; i < ComponentType::MAX_TYPES_COUNT; ++i)
 	{
-		if ((mask & (u64(1) << i)) != 0)
+		if (mask.has({i}))
 		{
 			IModule* module = m_component_type_map[i].module;
 			return ComponentUID(entity, {i}, module);
@@ -958,10 +1048,10 @@ ComponentUID World::getFirstComponent(EntityRef entity) const
 
 ComponentUID World::getNextComponent(const ComponentUID& cmp) const
 {
-	u64 mask = m_entities[cmp.entity.index].components;
+	const ComponentMask& mask = getComponentsMask((EntityRef)cmp.entity);
 	for (int i = cmp.type.index + 1; i < ComponentType::MAX_TYPES_COUNT; ++i)
 	{
-		if ((mask & (u64(1) << i)) != 0)
+		if (mask.has({i}))
 		{
 			IModule* module = m_component_type_map[i].module;
 			return ComponentUID(cmp.entity, {i}, module);
@@ -973,33 +1063,32 @@ ComponentUID World::getNextComponent(const ComponentUID& cmp) const
 
 ComponentUID World::getComponent(EntityRef entity, ComponentType component_type) const
 {
-	u64 mask = m_entities[entity.index].components;
-	if ((mask & (u64(1) << component_type.index)) == 0) return ComponentUID::INVALID;
+	if (!hasComponent(entity, component_type)) return ComponentUID::INVALID;
 	IModule* module = m_component_type_map[component_type.index].module;
 	return ComponentUID(entity, component_type, module);
 }
 
 
-u64 World::getComponentsMask(EntityRef entity) const
+const ComponentMask& World::getComponentsMask(EntityRef entity) const
 {
-	return m_entities[entity.index].components;
+	return m_archetypes[m_entities[entity.index].archetype].mask;
 }
 
 
 bool World::hasComponent(EntityRef entity, ComponentType component_type) const
 {
-	u64 mask = m_entities[entity.index].components;
-	return (mask & (u64(1) << component_type.index)) != 0;
+	return getComponentsMask(entity).has(component_type);
 }
 
 
 void World::onComponentDestroyed(EntityRef entity, ComponentType component_type, IModule* module)
 {
-	auto mask = m_entities[entity.index].components;
-	auto old_mask = mask;
-	mask &= ~((u64)1 << component_type.index);
-	ASSERT(old_mask != mask);
-	m_entities[entity.index].components = mask;
+	ComponentMask mask = getComponentsMask(entity);
+	ASSERT(mask.has(component_type));
+	mask.remove(component_type);
+	const u32 archetype = getArchetype(mask);
+	removeFromArchetype(entity);
+	addToArchetype(entity, archetype);
 	m_component_destroyed.invoke(ComponentUID(entity, component_type, module));
 }
 
@@ -1023,10 +1112,60 @@ void World::destroyComponent(EntityRef entity, ComponentType type)
 void World::onComponentCreated(EntityRef entity, ComponentType component_type, IModule* module)
 {
 	ComponentUID cmp(entity, component_type, module);
-	m_entities[entity.index].components |= (u64)1 << component_type.index;
+	ComponentMask mask = getComponentsMask(entity);
+	mask.add(component_type);
+	const u32 archetype = getArchetype(mask);
+	removeFromArchetype(entity);
+	addToArchetype(entity, archetype);
 	m_component_added.invoke(cmp);
 }
 
+WorldQuery::WorldQuery(const World& world, const ComponentMask& mask)
+	: world(world)
+	, mask(mask)
+{}
+
+u32 WorldQuery::next(u32 archetype) const {
+	const u32 count = world.getArchetypesCount();
+	while (archetype < count) {
+		if (world.getArchetypeEntities(archetype).length() > 0 && world.getArchetypeMask(archetype).contains(mask)) break;
+		++archetype;
+	}
+	return archetype;
+}
+
+u32 WorldQuery::count() const {
+	u32 res = 0;
+	for (Span<const EntityRef> entities : *this) res += entities.length();
+	return res;
+}
+
+WorldQuery::Iterator WorldQuery::begin() const {
+	Iterator iter;
+	iter.query = this;
+	iter.archetype = next(0);
+	return iter;
+}
+
+WorldQuery::Iterator WorldQuery::end() const {
+	Iterator iter;
+	iter.query = this;
+	iter.archetype = world.getArchetypesCount();
+	return iter;
+}
+
+void WorldQuery::Iterator::operator ++() {
+	archetype = query->next(archetype + 1);
+}
+
+bool WorldQuery::Iterator::operator !=(const Iterator& rhs) {
+	return archetype != rhs.archetype;
+}
+
+Span<const EntityRef> WorldQuery::Iterator::operator*() {
+	return query->world.getArchetypeEntities(archetype);
+}
+
 ChildrenRange World::childrenOf(EntityRef entity) const {
 	return ChildrenRange(*this, entity);
 }
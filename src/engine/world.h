@@ -4,6 +4,7 @@
 #include "engine/allocators.h"
 #include "engine/array.h"
 #include "engine/delegate_list.h"
+#include "engine/hash_map.h"
 #include "engine/lumix.h"
 #include "engine/math.h"
 
@@ -13,6 +14,7 @@ namespace Lumix {
 struct ComponentUID;
 struct IModule;
 struct ChildrenRange;
+struct WorldQuery;
 
 enum class WorldVersion : u32 {
 	EDITOR_CAMERA,
@@ -30,6 +32,56 @@ enum class WorldSerializeFlags : u32 {
 	NONE = 0
 };
 
+// set of component types, one bit per ComponentType::index
+struct ComponentMask {
+	enum { WORDS_COUNT = ComponentType::MAX_TYPES_COUNT / 64 };
+	static_assert(WORDS_COUNT * 64 == ComponentType::MAX_TYPES_COUNT);
+
+	bool has(ComponentType type) const { return (words[type.index >> 6] & ((u64)1 << (type.index & 63))) != 0; }
+	void add(ComponentType type) { words[type.index >> 6] |= (u64)1 << (type.index & 63); }
+	void remove(ComponentType type) { words[type.index >> 6] &= ~((u64)1 << (type.index & 63)); }
+
+	// true if `this` has every component from `rhs`
+	bool contains(const ComponentMask& rhs) const {
+		for (u32 i = 0; i < WORDS_COUNT; ++i) {
+			if ((words[i] & rhs.words[i]) != rhs.words[i]) return false;
+		}
+		return true;
+	}
+
+	bool intersects(const ComponentMask& rhs) const {
+		for (u32 i = 0; i < WORDS_COUNT; ++i) {
+			if (words[i] & rhs.words[i]) return true;
+		}
+		return false;
+	}
+
+	bool isEmpty() const {
+		for (u64 w : words) {
+			if (w) return false;
+		}
+		return true;
+	}
+
+	bool operator==(const ComponentMask& rhs) const {
+		for (u32 i = 0; i < WORDS_COUNT; ++i) {
+			if (words[i] != rhs.words[i]) return false;
+		}
+		return true;
+	}
+	bool operator!=(const ComponentMask& rhs) const { return !(*this == rhs); }
+
+	u64 words[WORDS_COUNT] = {};
+};
+
+struct ComponentMaskHasher {
+	static u32 get(const ComponentMask& key) {
+		u64 x = 0;
+		for (u64 w : key.words) x = x * 0x9E3779B97F4A7C15U + w;
+		return HashFunc<u64>::get(x);
+	}
+};
+
 // map one EntityPtr to another, used e.g. during additive loading or when instancing a prefab
 struct LUMIX_ENGINE_API EntityMap final {
 	EntityMap(IAllocator& allocator);
@@ -68,7 +120,7 @@ struct LUMIX_ENGINE_API World {
 	void destroyComponent(EntityRef entity, ComponentType type);
 	void onComponentCreated(EntityRef entity, ComponentType component_type, IModule* module);
 	void onComponentDestroyed(EntityRef entity, ComponentType component_type, IModule* module);
-    u64 getComponentsMask(EntityRef entity) const;
+	const ComponentMask& getComponentsMask(EntityRef entity) const;
     bool hasComponent(EntityRef entity, ComponentType component_type) const;
 	ComponentUID getComponent(EntityRef entity, ComponentType type) const;
 	ComponentUID getFirstComponent(EntityRef entity) const;
@@ -83,9 +135,17 @@ struct LUMIX_ENGINE_API World {
 	PartitionHandle getPartition(EntityRef entity);
 	void setPartition(EntityRef entity, PartitionHandle partition);
 
+	// entities with all components from `mask`, see WorldQuery
+	WorldQuery query(const ComponentMask& mask) const;
+	// archetype == set of all entities with exactly the same components
+	u32 getArchetypesCount() const { return m_archetypes.size(); }
+	const ComponentMask& getArchetypeMask(u32 archetype) const { return m_archetypes[archetype].mask; }
+	Span<const EntityRef> getArchetypeEntities(u32 archetype) const { return m_archetypes[archetype].entities; }
+
 	EntityPtr getFirstEntity() const;
 	EntityPtr getNextEntity(EntityRef entity) const;
 	const char* getEntityName(EntityRef entity) const;
+	// if there are more such entities, returns the one which got its name (or parent) first
 	EntityPtr findByName(EntityPtr parent, const char* name);
 	void setEntityName(EntityRef entity, struct StringView name);
 	bool hasEntity(EntityRef entity) const;
@@ -134,6 +194,11 @@ struct LUMIX_ENGINE_API World {
 private:
 	void transformEntity(EntityRef entity, bool update_local);
 	void updateGlobalTransform(EntityRef entity);
+	void addToNameIndex(EntityRef entity);
+	void removeFromNameIndex(EntityRef entity);
+	u32 getArchetype(const ComponentMask& mask);
+	void addToArchetype(EntityRef entity, u32 archetype);
+	void removeFromArchetype(EntityRef entity);
 
 	struct EntityData {
 		EntityData() {}
@@ -142,8 +207,10 @@ private:
 		i32 name; // index into m_names, < 0 if no name
 
 		union {
-			u64 components; // bitmask of attached components
-			static_assert(sizeof(components) * 8 == ComponentType::MAX_TYPES_COUNT);
+			struct {
+				u32 archetype; // index into m_archetypes, defines set of attached components
+				u32 archetype_idx; // index into Archetype::entities
+			};
 			struct {
 				// freelist indices
 				int prev; 
@@ -165,9 +232,18 @@ private:
 
 	struct EntityName {
 		EntityRef entity;
+		// next entity with the same key in m_name_index, in the order they were added to the index
+		EntityPtr next_same_key;
 		char name[ENTITY_NAME_MAX_LENGTH];
 	};
 
+	struct Archetype {
+		Archetype(IAllocator& allocator) : entities(allocator) {}
+
+		ComponentMask mask;
+		Array<EntityRef> entities;
+	};
+
 	struct ComponentTypeEntry {
 		IModule* module = nullptr;
 		void (*create)(IModule*, EntityRef);
@@ -176,7 +252,6 @@ private:
 
 	TagAllocator m_allocator;
 	Engine& m_engine;
-	// TODO get rid of MAX_TYPES_COUNT limit (index archetypes maybe)
 	ComponentTypeEntry m_component_type_map[ComponentType::MAX_TYPES_COUNT];
 	Array<UniquePtr<IModule>> m_modules;
 	
@@ -189,6 +264,12 @@ private:
 	Array<Hierarchy> m_hierarchy;
 	// indexed by EntityData::name
 	Array<EntityName> m_names;
+	// (parent, name) hash -> first entity in a list linked by EntityName::next_same_key
+	HashMap<u64, EntityRef> m_name_index;
+	
+	// indexed by EntityData::archetype, archetypes are never removed, m_archetypes[0] is entities without components
+	Array<Archetype> m_archetypes;
+	HashMap<ComponentMask, u32, ComponentMaskHasher> m_archetype_map;
 	
 	Array<Partition> m_partitions;
 	PartitionHandle m_partition_generator = 0;
@@ -205,6 +286,29 @@ private:
 	int m_first_free_slot;
 };
 
+// to iterate entities with given components: 
+// for (Span<const EntityRef> entities : world->query(mask)) for (EntityRef e : entities) ...
+// spans are invalidated when any entity is created, destroyed or gets a component added/removed
+struct LUMIX_ENGINE_API WorldQuery {
+	struct LUMIX_ENGINE_API Iterator {
+		void operator ++();
+		bool operator !=(const Iterator& rhs);
+		Span<const EntityRef> operator*();
+
+		const WorldQuery* query;
+		u32 archetype;
+	};
+	WorldQuery(const World& world, const ComponentMask& mask);
+	Iterator begin() const;
+	Iterator end() const;
+	u32 count() const;
+
+	const World& world;
+	ComponentMask mask;
+private:
+	u32 next(u32 archetype) const;
+};
+
 // contains necessary info to fully (==no other context needed) identify component at runtime
 struct LUMIX_ENGINE_API ComponentUID final {
 	ComponentUID() {
@@ -235,7 +235,7 @@ struct NavigationModuleImpl final : NavigationModule
 		if (!model_aabb.overlaps(zone_aabb)) return;;
 		const float walkable_threshold = cosf(degreesToRadians(45));
 
-		auto lod = model->getLODIndices()[0];
+		auto lod = model->getLODIndices()[model->getResidentLOD(0)];
 		for (int mesh_idx = lod.from; mesh_idx <= lod.to; ++mesh_idx) {
 			Mesh& mesh = model->getMesh(mesh_idx);
 			bool is16 = mesh.areIndices16();
@@ -2440,8 +2440,7 @@ struct PhysicsModuleImpl final : PhysicsModule
 
 	void onEntityMoved(EntityRef entity)
 	{
-		const u64 cmp_mask = m_world.getComponentsMask(entity);
-		if ((cmp_mask & m_physics_cmps_mask) == 0) return;
+		if (!m_world.getComponentsMask(entity).intersects(m_physics_cmps_mask)) return;
 		
 		if (m_world.hasComponent(entity, CONTROLLER_TYPE)) {
 			auto iter = m_controllers.find(entity);
@@ -3813,7 +3812,7 @@ struct PhysicsModuleImpl final : PhysicsModule
 	PxBatchQuery* m_vehicle_batch_query;
 	u8 m_vehicle_query_mem[sizeof(PxRaycastQueryResult) * 64 + sizeof(PxRaycastHit) * 64];
 	PxRaycastQueryResult* m_vehicle_results;
-	u64 m_physics_cmps_mask;
+	ComponentMask m_physics_cmps_mask;
 
 	Array<EntityRef> m_dynamic_actors;
 	RigidActor* m_update_in_progress;
@@ -3849,12 +3848,10 @@ PhysicsModuleImpl::PhysicsModuleImpl(Engine& engine, World& world, PhysicsSystem
 	, m_layers(m_system->getCollisionLayers())
 	, m_resource_actor_map(m_allocator)
 {
-	m_physics_cmps_mask = 0;
-
 	const RuntimeHash hash("physics");
 	for (const reflection::RegisteredComponent& cmp : reflection::getComponents()) {
 		if (cmp.module_hash == hash) {
-			m_physics_cmps_mask |= (u64)1 << cmp.cmp->component_type.index;
+			m_physics_cmps_mask.add(cmp.cmp->component_type);
 		}
 	}
 
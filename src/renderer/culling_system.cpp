@@ -6,11 +6,19 @@
 #include "engine/allocator.h"
 #include "engine/atomic.h"
 #include "engine/job_system.h"
+#include "engine/log.h"
 #include "engine/lumix.h"
 #include "engine/math.h"
+#include "engine/os.h"
 #include "engine/page_allocator.h"
 #include "engine/profiler.h"
 #include "engine/simd.h"
+#if defined _M_X64 || defined __x86_64__
+	#include <immintrin.h>
+#endif
+#ifdef _WIN32
+	#include <intrin.h>
+#endif
 
 
 namespace Lumix
@@ -40,32 +48,310 @@ struct CellIndicesHasher
 	// http://www.beosil.com/download/CollisionDetectionHashing_VMV03.pdf
 	static u32 get(const CellIndices& indices) {
 		// TODO indices.is_big, indices.type
-		return (u32)indices.pos.x * 73856093 + (u32)indices.pos.y * 19349663 + (u32)indices.pos.z * 83492791; 
+		return (u32)indices.pos.x * 73856093 + (u32)indices.pos.y * 19349663 + (u32)indices.pos.z * 83492791;
 	}
 };
 
 
-struct alignas(4096) CellPage {
-	struct {
-		CellPage* next = nullptr;
-		CellPage* prev = nullptr;
-		DVec3 origin;
-		CellIndices indices;
-		int count = 0;
-	} header;
+// spheres are relative to `header.origin`, pages are aligned so a sphere knows its page, see `getPage`
+// spheres are SoA, so culling kernels load a coordinate of several spheres at once
+template <typename Header>
+struct alignas(4096) SpherePage {
+	// multiple of 8 so the arrays are aligned for AVX2, kernels may read past `count`, but not past the page
+	enum { MAX_COUNT = ((PageAllocator::PAGE_SIZE - ((sizeof(Header) + 31) & ~31)) / (4 * sizeof(float) + sizeof(EntityPtr))) & ~7 };
 
-	enum { MAX_COUNT = (PageAllocator::PAGE_SIZE - sizeof(header)) / (sizeof(Sphere) + sizeof(EntityPtr)) };
-
-	Sphere spheres[MAX_COUNT];
+	Header header;
+	alignas(32) float xs[MAX_COUNT];
+	float ys[MAX_COUNT];
+	float zs[MAX_COUNT];
+	float radii[MAX_COUNT];
 	EntityPtr entities[MAX_COUNT];
+
+	Vec3 getPosition(i32 idx) const { return Vec3(xs[idx], ys[idx], zs[idx]); }
+
+	void setPosition(i32 idx, const Vec3& pos) {
+		xs[idx] = pos.x;
+		ys[idx] = pos.y;
+		zs[idx] = pos.z;
+	}
+
+	void set(i32 idx, EntityPtr entity, const Vec3& pos, float radius) {
+		setPosition(idx, pos);
+		radii[idx] = radius;
+		entities[idx] = entity;
+	}
+
+	void copy(i32 dst, i32 src) {
+		xs[dst] = xs[src];
+		ys[dst] = ys[src];
+		zs[dst] = zs[src];
+		radii[dst] = radii[src];
+		entities[dst] = entities[src];
+	}
+};
+
+
+// `entity` points to `SpherePage::entities`
+template <typename Page>
+static Page& getPage(const EntityPtr* entity)
+{
+	const intptr_t ptr = (intptr_t)entity;
+	const intptr_t page_ptr = ptr - (ptr % PageAllocator::PAGE_SIZE);
+	return *(Page*)page_ptr;
+}
+
+
+template <typename Page>
+static i32 getIndex(const Page& page, const EntityPtr* entity)
+{
+	return i32(entity - page.entities);
+}
+
+
+static void growEntityMap(Array<EntityPtr*>& map, EntityRef entity)
+{
+	if (map.size() > entity.index) return;
+	map.reserve(entity.index);
+	while (map.size() <= entity.index) {
+		map.push(nullptr);
+	}
+}
+
+
+static LUMIX_FORCE_INLINE u32 countTrailingZeros(u32 mask)
+{
+	ASSERT(mask != 0);
+	#ifdef _WIN32
+		unsigned long res;
+		_BitScanForward(&res, mask);
+		return res;
+	#else
+		return __builtin_ctz(mask);
+	#endif
+}
+
+
+// pushes entities[i + k] to results for every set bit k in `visible_mask`
+static LUMIX_FORCE_INLINE void emitVisible(u32 visible_mask
+	, const EntityPtr* LUMIX_RESTRICT entities
+	, i32 i
+	, int& cursor
+	, CullResult*& results
+	, PagedList<CullResult>& list)
+{
+	while (visible_mask) {
+		if (cursor == lengthOf(results->entities)) {
+			const u8 type = results->header.type;
+			results->header.count = cursor;
+			results = list.push();
+			results->header.type = type;
+			cursor = 0;
+		}
+		results->entities[cursor] = (EntityRef)entities[i + countTrailingZeros(visible_mask)];
+		++cursor;
+		visible_mask &= visible_mask - 1;
+	}
+}
+
+
+static constexpr u32 PLANE_COUNT = (u32)Frustum::Planes::COUNT;
+
+
+// a sphere is culled if it's completely behind any plane, i.e. min over planes of (distance + radius) is negative
+static void cullSpheres(const float* LUMIX_RESTRICT xs
+	, const float* LUMIX_RESTRICT ys
+	, const float* LUMIX_RESTRICT zs
+	, const float* LUMIX_RESTRICT radii
+	, const EntityPtr* LUMIX_RESTRICT entities
+	, i32 count
+	, const Frustum& frustum
+	, CullResult*& results
+	, PagedList<CullResult>& list)
+{
+	float4 px[PLANE_COUNT], py[PLANE_COUNT], pz[PLANE_COUNT], pd[PLANE_COUNT];
+	for (u32 j = 0; j < PLANE_COUNT; ++j) {
+		px[j] = f4Splat(frustum.xs[j]);
+		py[j] = f4Splat(frustum.ys[j]);
+		pz[j] = f4Splat(frustum.zs[j]);
+		pd[j] = f4Splat(frustum.ds[j]);
+	}
+	int cursor = results->header.count;
+
+	for (i32 i = 0; i < count; i += 4) {
+		const float4 x = f4Load(xs + i);
+		const float4 y = f4Load(ys + i);
+		const float4 z = f4Load(zs + i);
+		const float4 r = f4Load(radii + i);
+
+		float4 t = x * px[0] + y * py[0] + z * pz[0] + pd[0];
+		for (u32 j = 1; j < PLANE_COUNT; ++j) {
+			t = f4Min(t, x * px[j] + y * py[j] + z * pz[j] + pd[j]);
+		}
+		t = t + r;
+
+		const u32 valid_mask = count - i >= 4 ? 0xf : (1 << (count - i)) - 1;
+		const u32 visible_mask = ~u32(f4MoveMask(t)) & valid_mask;
+		emitVisible(visible_mask, entities, i, cursor, results, list);
+	}
+	results->header.count = cursor;
+}
+
+
+#if defined _M_X64 || defined __x86_64__
+	#define LUMIX_CULLING_AVX
+	// gcc and clang need the target to use intrinsics, msvc does not
+	#if defined _MSC_VER && !defined __clang__
+		#define LUMIX_TARGET(T)
+	#else
+		#define LUMIX_TARGET(T) __attribute__((target(T)))
+	#endif
+
+	LUMIX_TARGET("avx2,fma")
+	static void cullSpheresAVX2(const float* LUMIX_RESTRICT xs
+		, const float* LUMIX_RESTRICT ys
+		, const float* LUMIX_RESTRICT zs
+		, const float* LUMIX_RESTRICT radii
+		, const EntityPtr* LUMIX_RESTRICT entities
+		, i32 count
+		, const Frustum& frustum
+		, CullResult*& results
+		, PagedList<CullResult>& list)
+	{
+		__m256 px[PLANE_COUNT], py[PLANE_COUNT], pz[PLANE_COUNT], pd[PLANE_COUNT];
+		for (u32 j = 0; j < PLANE_COUNT; ++j) {
+			px[j] = _mm256_set1_ps(frustum.xs[j]);
+			py[j] = _mm256_set1_ps(frustum.ys[j]);
+			pz[j] = _mm256_set1_ps(frustum.zs[j]);
+			pd[j] = _mm256_set1_ps(frustum.ds[j]);
+		}
+		int cursor = results->header.count;
+
+		for (i32 i = 0; i < count; i += 8) {
+			const __m256 x = _mm256_load_ps(xs + i);
+			const __m256 y = _mm256_load_ps(ys + i);
+			const __m256 z = _mm256_load_ps(zs + i);
+			const __m256 r = _mm256_load_ps(radii + i);
+
+			__m256 t = _mm256_fmadd_ps(x, px[0], _mm256_fmadd_ps(y, py[0], _mm256_fmadd_ps(z, pz[0], pd[0])));
+			for (u32 j = 1; j < PLANE_COUNT; ++j) {
+				t = _mm256_min_ps(t, _mm256_fmadd_ps(x, px[j], _mm256_fmadd_ps(y, py[j], _mm256_fmadd_ps(z, pz[j], pd[j]))));
+			}
+			t = _mm256_add_ps(t, r);
+
+			const u32 valid_mask = count - i >= 8 ? 0xff : (1 << (count - i)) - 1;
+			const u32 visible_mask = ~u32(_mm256_movemask_ps(t)) & valid_mask;
+			emitVisible(visible_mask, entities, i, cursor, results, list);
+		}
+		results->header.count = cursor;
+	}
+
+	// unaligned loads, since MAX_COUNT is not a multiple of 16
+	LUMIX_TARGET("avx512f")
+	static void cullSpheresAVX512(const float* LUMIX_RESTRICT xs
+		, const float* LUMIX_RESTRICT ys
+		, const float* LUMIX_RESTRICT zs
+		, const float* LUMIX_RESTRICT radii
+		, const EntityPtr* LUMIX_RESTRICT entities
+		, i32 count
+		, const Frustum& frustum
+		, CullResult*& results
+		, PagedList<CullResult>& list)
+	{
+		__m512 px[PLANE_COUNT], py[PLANE_COUNT], pz[PLANE_COUNT], pd[PLANE_COUNT];
+		for (u32 j = 0; j < PLANE_COUNT; ++j) {
+			px[j] = _mm512_set1_ps(frustum.xs[j]);
+			py[j] = _mm512_set1_ps(frustum.ys[j]);
+			pz[j] = _mm512_set1_ps(frustum.zs[j]);
+			pd[j] = _mm512_set1_ps(frustum.ds[j]);
+		}
+		const __m512 zero = _mm512_setzero_ps();
+		int cursor = results->header.count;
+
+		for (i32 i = 0; i < count; i += 16) {
+			const __m512 x = _mm512_loadu_ps(xs + i);
+			const __m512 y = _mm512_loadu_ps(ys + i);
+			const __m512 z = _mm512_loadu_ps(zs + i);
+			const __m512 r = _mm512_loadu_ps(radii + i);
+
+			__m512 t = _mm512_fmadd_ps(x, px[0], _mm512_fmadd_ps(y, py[0], _mm512_fmadd_ps(z, pz[0], pd[0])));
+			for (u32 j = 1; j < PLANE_COUNT; ++j) {
+				t = _mm512_min_ps(t, _mm512_fmadd_ps(x, px[j], _mm512_fmadd_ps(y, py[j], _mm512_fmadd_ps(z, pz[j], pd[j]))));
+			}
+			t = _mm512_add_ps(t, r);
+
+			const u32 valid_mask = count - i >= 16 ? 0xffff : (1 << (count - i)) - 1;
+			const u32 visible_mask = _mm512_cmp_ps_mask(t, zero, _CMP_GE_OQ) & valid_mask;
+			emitVisible(visible_mask, entities, i, cursor, results, list);
+		}
+		results->header.count = cursor;
+	}
+#endif
+
+
+using CullSpheresFn = decltype(&cullSpheres);
+
+static CullSpheresFn getCullSpheresFn(SIMDLevel level)
+{
+	#ifdef LUMIX_CULLING_AVX
+		switch (level) {
+			case SIMDLevel::AVX512: return &cullSpheresAVX512;
+			case SIMDLevel::AVX2: return &cullSpheresAVX2;
+			case SIMDLevel::SSE2: break;
+		}
+	#endif
+	return &cullSpheres;
+}
+
+
+// selected by `CullingSystem::create`, benchmark switches it to compare kernels
+static CullSpheresFn s_cull_spheres = &cullSpheres;
+
+
+template <typename Page>
+static LUMIX_FORCE_INLINE void cullPage(const Page& page, const Frustum& frustum, CullResult*& results, PagedList<CullResult>& list)
+{
+	s_cull_spheres(page.xs, page.ys, page.zs, page.radii, page.entities, page.header.count, frustum, results, list);
+}
+
+
+// all spheres are visible
+static void copyEntities(const EntityPtr* entities, i32 count, CullResult*& result, PagedList<CullResult>& list)
+{
+	const u8 type = result->header.type;
+	int to_cpy = count;
+	int src_offset = 0;
+	while (to_cpy > 0) {
+		if(result->header.count == lengthOf(result->entities)) {
+			result = list.push();
+			result->header.type = type;
+		}
+		const int rem_space = lengthOf(result->entities) - result->header.count;
+		const int step = minimum(to_cpy, rem_space);
+		memcpy(result->entities + result->header.count, entities + src_offset, step * sizeof(entities[0]));
+		src_offset += step;
+		result->header.count += step;
+		to_cpy -= step;
+	}
+}
+
+
+struct CellPageHeader;
+using CellPage = SpherePage<CellPageHeader>;
+
+struct CellPageHeader {
+	CellPage* next = nullptr;
+	CellPage* prev = nullptr;
+	DVec3 origin;
+	CellIndices indices;
+	int count = 0;
 };
 
 static_assert(sizeof(CellPage) == PageAllocator::PAGE_SIZE);
 
 
-struct CullingSystemImpl final : CullingSystem
+struct GridCullingSystem final : CullingSystem
 {
-	CullingSystemImpl(IAllocator& allocator, PageAllocator& page_allocator) 
+	GridCullingSystem(IAllocator& allocator, PageAllocator& page_allocator)
 		: m_allocator(allocator)
 		, m_cell_map(allocator)
 		, m_entity_to_cell(allocator)
@@ -74,8 +360,8 @@ struct CullingSystemImpl final : CullingSystem
 		, m_page_allocator(page_allocator)
 	{
 	}
-	
-	~CullingSystemImpl()
+
+	~GridCullingSystem()
 	{
 		for(CellPage* page : m_cell_map) {
 			ASSERT(!page->header.prev);
@@ -92,17 +378,16 @@ struct CullingSystemImpl final : CullingSystem
 		m_cell_map.clear();
 		m_entity_to_cell.clear();
 	}
-	
-	Sphere* addToCell(CellPage& cell, EntityPtr entity, const DVec3& pos, float radius)
+
+	EntityPtr* addToCell(CellPage& cell, EntityPtr entity, const DVec3& pos, float radius)
 	{
 		const Vec3 rel_pos = Vec3(pos - cell.header.origin);
 		const int count = cell.header.count;
 
 		if(count < CellPage::MAX_COUNT - 1) {
-			cell.spheres[count] = {rel_pos, radius};
-			cell.entities[count] = entity;
+			cell.set(count, entity, rel_pos, radius);
 			++cell.header.count;
-			return &cell.spheres[count];
+			return &cell.entities[count];
 		}
 
 		void* mem = m_page_allocator.allocate(true);
@@ -111,30 +396,24 @@ struct CullingSystemImpl final : CullingSystem
 		new_cell->header.indices = cell.header.indices;
 		new_cell->header.next = &cell;
 		new_cell->header.prev = cell.header.prev;
-		
+
 		new_cell->header.next->header.prev = new_cell;
 		if (new_cell->header.prev) new_cell->header.prev->header.next = new_cell;
 
 		m_cells.push(new_cell);
 		if(!new_cell->header.prev) m_cell_map[new_cell->header.indices] = new_cell;
 
-		new_cell->spheres[0] = {rel_pos, radius};
-		new_cell->entities[0] = entity;
+		new_cell->set(0, entity, rel_pos, radius);
 		new_cell->header.count = 1;
 
-		return &new_cell->spheres[0];
+		return &new_cell->entities[0];
 	}
 
 
 	void add(EntityRef entity, u8 type, const DVec3& pos, float radius) override
 	{
-		if(m_entity_to_cell.size() <= entity.index) {
-			m_entity_to_cell.reserve(entity.index);
-			while(m_entity_to_cell.size() <= entity.index) {
-				m_entity_to_cell.push(nullptr);
-			}
-		}
-		
+		growEntityMap(m_entity_to_cell, entity);
+
 		const CellIndices i(pos, m_cell_size, type, radius > m_cell_size);
 
 		auto iter = m_cell_map.find(i);
@@ -149,8 +428,7 @@ struct CullingSystemImpl final : CullingSystem
 		}
 
 		CellPage& cell = *iter.value();
-		Sphere* sphere = addToCell(cell, entity, pos, radius);
-		m_entity_to_cell[entity.index] = sphere;
+		m_entity_to_cell[entity.index] = addToCell(cell, entity, pos, radius);
 		return;
 	}
 
@@ -158,11 +436,11 @@ struct CullingSystemImpl final : CullingSystem
 	void remove(EntityRef entity) override
 	{
 		if (m_entity_to_cell.size() <= entity.index) return;
-		
-		const Sphere* sphere = m_entity_to_cell[entity.index];
-		if (!sphere) return;
 
-		CellPage& cell = getCell(*sphere);
+		const EntityPtr* ptr = m_entity_to_cell[entity.index];
+		if (!ptr) return;
+
+		CellPage& cell = getPage<CellPage>(ptr);
 		if (cell.header.count == 1) {
 			if (!cell.header.prev) {
 				if (!cell.header.next) m_cell_map.erase(cell.header.indices);
@@ -175,38 +453,30 @@ struct CullingSystemImpl final : CullingSystem
 			m_page_allocator.deallocate(&cell, true);
 		}
 		else {
-			const int idx = int(sphere - cell.spheres);
+			const int idx = getIndex(cell, ptr);
 			EntityPtr last = cell.entities[cell.header.count - 1];
-			cell.entities[idx] = cell.entities[cell.header.count - 1];
-			cell.spheres[idx] = cell.spheres[cell.header.count - 1];
-			m_entity_to_cell[last.index] = &cell.spheres[idx];
+			cell.copy(idx, cell.header.count - 1);
+			m_entity_to_cell[last.index] = &cell.entities[idx];
 			--cell.header.count;
 		}
 		m_entity_to_cell[entity.index] = nullptr;
 	}
 
 
-	CellPage& getCell(const Sphere& sphere) const
-	{
-		const intptr_t ptr = (intptr_t)&sphere;
-		const intptr_t page_ptr = ptr - (ptr % PageAllocator::PAGE_SIZE);
-		return *(CellPage*)page_ptr;
-	}
-
-
 	void setPosition(EntityRef entity, const DVec3& pos) override
 	{
-		Sphere* sphere = m_entity_to_cell[entity.index];
-		CellPage& cell = getCell(*sphere);
+		const EntityPtr* ptr = m_entity_to_cell[entity.index];
+		CellPage& cell = getPage<CellPage>(ptr);
+		const int idx = getIndex(cell, ptr);
 
 		const IVec3 new_indices(pos * (1 / m_cell_size));
 
 		if(new_indices == cell.header.indices.pos) {
-			sphere->position = Vec3(pos - cell.header.origin);
+			cell.setPosition(idx, Vec3(pos - cell.header.origin));
 			return;
 		}
 
-		const float radius = sphere->radius;
+		const float radius = cell.radii[idx];
 		const u8 type = cell.header.indices.type;
 		remove(entity);
 		add(entity, type, pos, radius);
@@ -215,20 +485,23 @@ struct CullingSystemImpl final : CullingSystem
 
 	float getRadius(EntityRef entity) override
 	{
-		return m_entity_to_cell[entity.index]->radius;
+		const EntityPtr* ptr = m_entity_to_cell[entity.index];
+		const CellPage& cell = getPage<CellPage>(ptr);
+		return cell.radii[getIndex(cell, ptr)];
 	}
 
 	void set(EntityRef entity, const DVec3& pos, float radius) override {
-		Sphere* sphere = m_entity_to_cell[entity.index];
-		CellPage& cell = getCell(*sphere);
+		const EntityPtr* ptr = m_entity_to_cell[entity.index];
+		CellPage& cell = getPage<CellPage>(ptr);
+		const int idx = getIndex(cell, ptr);
 		const IVec3 new_indices(pos * (1 / m_cell_size));
-		
+
 		const bool was_big = cell.header.indices.is_big;
 		const bool is_big = radius > m_cell_size;
 
 		if (was_big == is_big && new_indices == cell.header.indices.pos) {
-			sphere->radius = radius;
-			sphere->position = Vec3(pos - cell.header.origin);
+			cell.radii[idx] = radius;
+			cell.setPosition(idx, Vec3(pos - cell.header.origin));
 			return;
 		}
 
@@ -236,74 +509,26 @@ struct CullingSystemImpl final : CullingSystem
 		remove(entity);
 		add(entity, type, pos, radius);
 	}
-	
+
 	void setRadius(EntityRef entity, float radius) override
 	{
-		Sphere* sphere = m_entity_to_cell[entity.index];
-		CellPage& cell = getCell(*sphere);
-		
+		const EntityPtr* ptr = m_entity_to_cell[entity.index];
+		CellPage& cell = getPage<CellPage>(ptr);
+		const int idx = getIndex(cell, ptr);
+
 		const bool was_big = cell.header.indices.is_big;
 		const bool is_big = radius > m_cell_size;
 
 		if (was_big == is_big) {
-			sphere->radius = radius;
+			cell.radii[idx] = radius;
 			return;
 		}
 		const u8 type = cell.header.indices.type;
-		const DVec3 pos = cell.header.origin + sphere->position;
+		const DVec3 pos = cell.header.origin + cell.getPosition(idx);
 		remove(entity);
 		add(entity, type, pos, radius);
 	}
 
-	LUMIX_FORCE_INLINE void doCulling(const CellPage& cell
-		, const Frustum& frustum
-		, CullResult* LUMIX_RESTRICT results
-		, PagedList<CullResult>& list
-		, u8 type)
-	{
-		const Sphere* LUMIX_RESTRICT start = cell.spheres;
-		const Sphere* LUMIX_RESTRICT end = cell.spheres + cell.header.count;
-		const EntityPtr* LUMIX_RESTRICT sphere_to_entity_map = cell.entities;
-
-		const float4 px = f4Load(frustum.xs);
-		const float4 py = f4Load(frustum.ys);
-		const float4 pz = f4Load(frustum.zs);
-		const float4 pd = f4Load(frustum.ds);
-		const float4 px2 = f4Load(&frustum.xs[4]);
-		const float4 py2 = f4Load(&frustum.ys[4]);
-		const float4 pz2 = f4Load(&frustum.zs[4]);
-		const float4 pd2 = f4Load(&frustum.ds[4]);
-		int cursor = results->header.count;
-
-		int i = 0;
-
-		for (const Sphere *sphere = start; sphere < end; ++sphere, ++i) {
-			const float4 cx = f4Splat(sphere->position.x);
-			const float4 cy = f4Splat(sphere->position.y);
-			const float4 cz = f4Splat(sphere->position.z);
-			const float4 r = f4Splat(-sphere->radius);
-
-			float4 t = cx * px + cy * py + cz * pz + pd;
-			t = t - r;
-			if (f4MoveMask(t)) continue;
-
-			t = cx * px2 + cy * py2 + cz * pz2 + pd2;
-			t = t - r;
-			if (f4MoveMask(t)) continue;
-
-			if(cursor == lengthOf(results->entities)) {
-				results->header.count = cursor;
-				results = list.push();
-				results->header.type = type;
-				cursor = 0;
-			}
-
-			results->entities[cursor] = (EntityRef)sphere_to_entity_map[i];
-			++cursor;
-		}
-		results->header.count = cursor;
-	}
-
 	CullResult* cull(const ShiftedFrustum& frustum, u8 type) override
 	{
 		ASSERT(type != 0xff); // 0xff type is reserved for `all types`
@@ -314,7 +539,7 @@ struct CullingSystemImpl final : CullingSystem
 	{
 		return cullInternal(frustum, 0xff);
 	}
-	
+
 	CullResult* cullInternal(const ShiftedFrustum& frustum, u8 type)
 	{
 		if (m_cells.empty()) return nullptr;
@@ -341,26 +566,13 @@ struct CullingSystemImpl final : CullingSystem
 
 				total_count += cell.header.count;
 				if (cell.header.indices.is_big) {
-					doCulling(cell, frustum.getRelative(cell.header.origin), result, list, cell.header.indices.type);
+					cullPage(cell, frustum.getRelative(cell.header.origin), result, list);
 				}
 				else if (frustum.containsAABB(cell.header.origin + v3_cell_size, v3_cell_size)) {
-					int to_cpy = cell.header.count;
-					int src_offset = 0;
-					while (to_cpy > 0) {
-						if(result->header.count == lengthOf(result->entities)) {
-							result = list.push();
-							result->header.type = cell.header.indices.type;
-						}
-						const int rem_space = lengthOf(result->entities) - result->header.count;
-						const int step = minimum(to_cpy, rem_space);
-						memcpy(result->entities + result->header.count, cell.entities + src_offset, step * sizeof(cell.entities[0]));
-						src_offset += step;
-						result->header.count += step;
-						to_cpy -= step;
-					}
+					copyEntities(cell.entities, cell.header.count, result, list);
 				}
 				else if (frustum.intersectsAABB(cell.header.origin - v3_cell_size, v3_2_cell_size)) {
-					doCulling(cell, frustum.getRelative(cell.header.origin), result, list, cell.header.indices.type);
+					cullPage(cell, frustum.getRelative(cell.header.origin), result, list);
 				}
 			}
 			profiler::pushInt("count", total_count);
@@ -368,7 +580,7 @@ struct CullingSystemImpl final : CullingSystem
 
 		return list.detach();
 	}
-	
+
 
 	bool isAdded(EntityRef entity) override
 	{
@@ -380,11 +592,408 @@ struct CullingSystemImpl final : CullingSystem
 	PageAllocator& m_page_allocator;
 	HashMap<CellIndices, CellPage*, CellIndicesHasher> m_cell_map;
 	Array<CellPage*> m_cells;
-	Array<Sphere*> m_entity_to_cell;
+	Array<EntityPtr*> m_entity_to_cell;
 	float m_cell_size;
 };
 
 
+struct OctreeNode;
+struct OctreePageHeader;
+using OctreePage = SpherePage<OctreePageHeader>;
+
+struct OctreePageHeader {
+	OctreePage* next = nullptr;
+	OctreePage* prev = nullptr;
+	// center of the node
+	DVec3 origin;
+	OctreeNode* node = nullptr;
+	int count = 0;
+};
+
+static_assert(sizeof(OctreePage) == PageAllocator::PAGE_SIZE);
+
+
+struct OctreeRootKey {
+	bool operator==(const OctreeRootKey& rhs) const { return pos == rhs.pos && type == rhs.type; }
+
+	IVec3 pos;
+	u8 type;
+};
+
+
+struct OctreeRootKeyHasher {
+	static u32 get(const OctreeRootKey& key) {
+		return (u32)key.pos.x * 73856093 ^ (u32)key.pos.y * 19349663 ^ (u32)key.pos.z * 83492791 ^ (u32)key.type * 2654435761;
+	}
+};
+
+
+// an object is in a node, which contains its center and whose size is at least 2 * radius
+// so loose bounds of a node, i.e. its cell enlarged by half of its size in each direction, contain all its objects
+// nodes are split only once they have too many objects, objects then go to the smallest existing node they fit in
+struct OctreeNode {
+	OctreeNode* parent = nullptr;
+	OctreeNode* children[8] = {};
+	// head of the page list, only the head can have free space
+	OctreePage* pages = nullptr;
+	DVec3 center;
+	// edge length of the cell
+	float size;
+	// half extent of loose bounds, roots can contain objects bigger than their size, so it's not always equal to `size`
+	float extent;
+	OctreeRootKey root_key;
+	// number of objects in this node, without children
+	u32 count = 0;
+	u8 child_count = 0;
+	u8 idx_in_parent = 0;
+	bool is_split = false;
+};
+
+
+struct OctreeCullingSystem final : CullingSystem
+{
+	// sizes of the smallest and the biggest nodes
+	static constexpr float LEAF_SIZE = 32.f;
+	static constexpr u32 MAX_DEPTH = 8;
+	static constexpr float ROOT_SIZE = LEAF_SIZE * (1 << MAX_DEPTH);
+	// nodes are split when they do not fit in a single page
+	static constexpr u32 SPLIT_COUNT = OctreePage::MAX_COUNT;
+
+	// result of the coarse pass, see `cullInternal`
+	struct Visit {
+		const OctreePage* page;
+		// the whole node is inside frustum, so there's no need to test spheres
+		bool inside;
+	};
+
+	OctreeCullingSystem(IAllocator& allocator, PageAllocator& page_allocator)
+		: m_allocator(allocator)
+		, m_page_allocator(page_allocator)
+		, m_roots(allocator)
+		, m_entity_to_sphere(allocator)
+	{
+	}
+
+	~OctreeCullingSystem()
+	{
+		for (OctreeNode* root : m_roots) {
+			destroyNode(root);
+		}
+	}
+
+	void destroyNode(OctreeNode* node)
+	{
+		for (OctreeNode* child : node->children) {
+			if (child) destroyNode(child);
+		}
+		OctreePage* page = node->pages;
+		while (page) {
+			OctreePage* tmp = page;
+			page = page->header.next;
+			tmp->~OctreePage();
+			m_page_allocator.deallocate(tmp, true);
+		}
+		LUMIX_DELETE(m_allocator, node);
+	}
+
+	static bool isInNode(const OctreeNode& node, const DVec3& pos, float radius)
+	{
+		const DVec3 rel = pos - node.center;
+		const double half = node.size * 0.5;
+		if (fabs(rel.x) > half || fabs(rel.y) > half || fabs(rel.z) > half) return false;
+		// would go to a smaller node
+		if (node.is_split && radius <= node.size * 0.25f) return false;
+		return !node.parent || radius <= node.size * 0.5f;
+	}
+
+	OctreeNode* getNode(u8 type, const DVec3& pos, float radius)
+	{
+		OctreeRootKey key;
+		key.pos = IVec3(i32(floor(pos.x / ROOT_SIZE)), i32(floor(pos.y / ROOT_SIZE)), i32(floor(pos.z / ROOT_SIZE)));
+		key.type = type;
+
+		OctreeNode* node;
+		auto iter = m_roots.find(key);
+		if (iter.isValid()) {
+			node = iter.value();
+		}
+		else {
+			node = LUMIX_NEW(m_allocator, OctreeNode);
+			node->center = DVec3(key.pos.x + 0.5, key.pos.y + 0.5, key.pos.z + 0.5) * double(ROOT_SIZE);
+			node->size = ROOT_SIZE;
+			node->extent = ROOT_SIZE;
+			node->root_key = key;
+			m_roots.insert(key, node);
+		}
+		// objects bigger than roots
+		node->extent = maximum(node->extent, node->size * 0.5f + radius);
+
+		while (node->is_split && radius <= node->size * 0.25f) {
+			const u8 idx = (pos.x >= node->center.x ? 1 : 0) | (pos.y >= node->center.y ? 2 : 0) | (pos.z >= node->center.z ? 4 : 0);
+			if (!node->children[idx]) {
+				OctreeNode* child = LUMIX_NEW(m_allocator, OctreeNode);
+				const double offset = node->size * 0.25;
+				child->center.x = node->center.x + (idx & 1 ? offset : -offset);
+				child->center.y = node->center.y + (idx & 2 ? offset : -offset);
+				child->center.z = node->center.z + (idx & 4 ? offset : -offset);
+				child->size = node->size * 0.5f;
+				child->extent = child->size;
+				child->root_key = node->root_key;
+				child->parent = node;
+				child->idx_in_parent = idx;
+				node->children[idx] = child;
+				++node->child_count;
+			}
+			node = node->children[idx];
+		}
+		return node;
+	}
+
+	// frees empty nodes from `node` up to its root
+	void pruneNode(OctreeNode* node)
+	{
+		while (node && !node->pages && node->child_count == 0) {
+			OctreeNode* parent = node->parent;
+			if (parent) {
+				parent->children[node->idx_in_parent] = nullptr;
+				--parent->child_count;
+			}
+			else {
+				m_roots.erase(node->root_key);
+			}
+			LUMIX_DELETE(m_allocator, node);
+			node = parent;
+		}
+	}
+
+	EntityPtr* addToNode(OctreeNode& node, EntityPtr entity, const DVec3& pos, float radius)
+	{
+		OctreePage* page = node.pages;
+		if (!page || page->header.count == OctreePage::MAX_COUNT) {
+			void* mem = m_page_allocator.allocate(true);
+			OctreePage* new_page = new (Lumix::NewPlaceholder(), mem) OctreePage;
+			new_page->header.origin = node.center;
+			new_page->header.node = &node;
+			new_page->header.next = page;
+			if (page) page->header.prev = new_page;
+			node.pages = new_page;
+			page = new_page;
+		}
+
+		const int count = page->header.count;
+		page->set(count, entity, Vec3(pos - page->header.origin), radius);
+		++page->header.count;
+		return &page->entities[count];
+	}
+
+	void insert(EntityRef entity, u8 type, const DVec3& pos, float radius)
+	{
+		OctreeNode* node = getNode(type, pos, radius);
+		m_entity_to_sphere[entity.index] = addToNode(*node, entity, pos, radius);
+		++node->count;
+		if (!node->is_split && node->count > SPLIT_COUNT && node->size > LEAF_SIZE) split(*node);
+	}
+
+	// moves objects, which fit, to children
+	void split(OctreeNode& node)
+	{
+		struct Object {
+			EntityRef entity;
+			DVec3 pos;
+			float radius;
+		};
+
+		Array<Object> objects(m_allocator);
+		objects.reserve(node.count);
+		OctreePage* page = node.pages;
+		while (page) {
+			for (i32 i = 0; i < page->header.count; ++i) {
+				objects.push({(EntityRef)page->entities[i], page->header.origin + page->getPosition(i), page->radii[i]});
+			}
+			OctreePage* tmp = page;
+			page = page->header.next;
+			tmp->~OctreePage();
+			m_page_allocator.deallocate(tmp, true);
+		}
+		node.pages = nullptr;
+		node.count = 0;
+		node.is_split = true;
+
+		// node is not pruned, since it's not empty at the end
+		for (const Object& object : objects) {
+			insert(object.entity, node.root_key.type, object.pos, object.radius);
+		}
+	}
+
+	void add(EntityRef entity, u8 type, const DVec3& pos, float radius) override
+	{
+		ASSERT(type != 0xff);
+		growEntityMap(m_entity_to_sphere, entity);
+		insert(entity, type, pos, radius);
+	}
+
+	void remove(EntityRef entity) override
+	{
+		if (m_entity_to_sphere.size() <= entity.index) return;
+
+		const EntityPtr* ptr = m_entity_to_sphere[entity.index];
+		if (!ptr) return;
+
+		OctreePage& page = getPage<OctreePage>(ptr);
+		OctreeNode* node = page.header.node;
+		--node->count;
+		if (page.header.count == 1) {
+			if (page.header.prev) page.header.prev->header.next = page.header.next;
+			else node->pages = page.header.next;
+			if (page.header.next) page.header.next->header.prev = page.header.prev;
+			page.~OctreePage();
+			m_page_allocator.deallocate(&page, true);
+			pruneNode(node);
+		}
+		else {
+			const int idx = getIndex(page, ptr);
+			const int last_idx = page.header.count - 1;
+			EntityPtr last = page.entities[last_idx];
+			page.copy(idx, last_idx);
+			m_entity_to_sphere[last.index] = &page.entities[idx];
+			--page.header.count;
+		}
+		m_entity_to_sphere[entity.index] = nullptr;
+	}
+
+	void set(EntityRef entity, const DVec3& pos, float radius) override
+	{
+		const EntityPtr* ptr = m_entity_to_sphere[entity.index];
+		OctreePage& page = getPage<OctreePage>(ptr);
+		OctreeNode* node = page.header.node;
+
+		if (isInNode(*node, pos, radius)) {
+			if (!node->parent) node->extent = maximum(node->extent, node->size * 0.5f + radius);
+			const int idx = getIndex(page, ptr);
+			page.radii[idx] = radius;
+			page.setPosition(idx, Vec3(pos - page.header.origin));
+			return;
+		}
+
+		const u8 type = node->root_key.type;
+		remove(entity);
+		insert(entity, type, pos, radius);
+	}
+
+	void setPosition(EntityRef entity, const DVec3& pos) override
+	{
+		set(entity, pos, getRadius(entity));
+	}
+
+	void setRadius(EntityRef entity, float radius) override
+	{
+		const EntityPtr* ptr = m_entity_to_sphere[entity.index];
+		const OctreePage& page = getPage<OctreePage>(ptr);
+		set(entity, page.header.origin + page.getPosition(getIndex(page, ptr)), radius);
+	}
+
+	float getRadius(EntityRef entity) override
+	{
+		const EntityPtr* ptr = m_entity_to_sphere[entity.index];
+		const OctreePage& page = getPage<OctreePage>(ptr);
+		return page.radii[getIndex(page, ptr)];
+	}
+
+	bool isAdded(EntityRef entity) override
+	{
+		return entity.index < m_entity_to_sphere.size() && m_entity_to_sphere[entity.index] != nullptr;
+	}
+
+	static void gatherVisits(const OctreeNode& node, const ShiftedFrustum& frustum, bool inside, Array<Visit>& visits)
+	{
+		if (!inside) {
+			const DVec3 min = node.center - DVec3(node.extent);
+			const Vec3 size(node.extent * 2);
+			if (!frustum.intersectsAABB(min, size)) return;
+			inside = frustum.containsAABB(min, size);
+		}
+
+		for (const OctreePage* page = node.pages; page; page = page->header.next) {
+			visits.push({page, inside});
+		}
+		for (const OctreeNode* child : node.children) {
+			if (child) gatherVisits(*child, frustum, inside, visits);
+		}
+	}
+
+	CullResult* cull(const ShiftedFrustum& frustum, u8 type) override
+	{
+		ASSERT(type != 0xff); // 0xff type is reserved for `all types`
+		return cullInternal(frustum, type);
+	}
+
+	CullResult* cull(const ShiftedFrustum& frustum) override
+	{
+		return cullInternal(frustum, 0xff);
+	}
+
+	CullResult* cullInternal(const ShiftedFrustum& frustum, u8 type)
+	{
+		if (m_roots.empty()) return nullptr;
+
+		// coarse pass, skips whole subtrees outside of frustum and marks those fully inside
+		Array<Visit> visits(m_allocator);
+		{
+			PROFILE_BLOCK("octree");
+			for (const OctreeNode* root : m_roots) {
+				if (type != 0xff && root->root_key.type != type) continue;
+				gatherVisits(*root, frustum, false, visits);
+			}
+			// results are paged by type
+			if (type == 0xff) {
+				qsort(visits.begin(), visits.size(), sizeof(visits[0]), [](const void* a, const void* b){
+					const Visit* va = (const Visit*)a;
+					const Visit* vb = (const Visit*)b;
+					return i32(va->page->header.node->root_key.type) - i32(vb->page->header.node->root_key.type);
+				});
+			}
+		}
+		if (visits.empty()) return nullptr;
+
+		AtomicI32 visit_idx = 0;
+		PagedList<CullResult> list(m_page_allocator);
+
+		jobs::runOnWorkers([&](){
+			PROFILE_BLOCK("culling");
+			CullResult* result = nullptr;
+			u32 total_count = 0;
+			for(;;) {
+				const i32 idx = visit_idx.inc();
+				if (idx >= visits.size()) break;
+
+				const Visit& visit = visits[idx];
+				const OctreePage& page = *visit.page;
+				const u8 page_type = page.header.node->root_key.type;
+				if (!result || result->header.type != page_type) {
+					result = list.push();
+					result->header.type = page_type;
+				}
+
+				total_count += page.header.count;
+				if (visit.inside) {
+					copyEntities(page.entities, page.header.count, result, list);
+				}
+				else {
+					cullPage(page, frustum.getRelative(page.header.origin), result, list);
+				}
+			}
+			profiler::pushInt("count", total_count);
+		});
+
+		return list.detach();
+	}
+
+	IAllocator& m_allocator;
+	PageAllocator& m_page_allocator;
+	HashMap<OctreeRootKey, OctreeNode*, OctreeRootKeyHasher> m_roots;
+	Array<EntityPtr*> m_entity_to_sphere;
+};
+
 
 void CullResult::free(PageAllocator& allocator)
 {
@@ -397,9 +1006,121 @@ void CullResult::free(PageAllocator& allocator)
 }
 
 
-UniquePtr<CullingSystem> CullingSystem::create(IAllocator& allocator, PageAllocator& page_allocator)
+UniquePtr<CullingSystem> CullingSystem::create(IAllocator& allocator, PageAllocator& page_allocator, Type type)
+{
+	s_cull_spheres = getCullSpheresFn(getSIMDLevel());
+	switch (type) {
+		case Type::GRID: return UniquePtr<GridCullingSystem>::create(allocator, allocator, page_allocator);
+		case Type::OCTREE: return UniquePtr<OctreeCullingSystem>::create(allocator, allocator, page_allocator);
+	}
+	ASSERT(false);
+	return {};
+}
+
+
+void CullingSystem::benchmark(IAllocator& allocator, PageAllocator& page_allocator)
 {
-	return UniquePtr<CullingSystemImpl>::create(allocator, allocator, page_allocator);
+	static constexpr u32 ENTITY_COUNT = 200'000;
+	static constexpr u32 VIEW_COUNT = 64;
+	static constexpr u8 TYPE_COUNT = 4;
+
+	struct Distribution {
+		const char* name;
+		// world extent on xz plane
+		float extent;
+		u32 cluster_count;
+		float cluster_radius;
+		// fraction of objects with radius up to `big_radius`, others have radius up to 5
+		float big_ratio;
+		float big_radius;
+	};
+
+	const Distribution distributions[] = {
+		{ "sparse terrain", 20'000, 0, 0, 0.01f, 200 },
+		{ "dense city", 2'000, 0, 0, 0.05f, 50 },
+		{ "clusters", 20'000, 32, 150, 0.01f, 100 },
+		{ "huge objects", 10'000, 0, 0, 0.1f, 5'000 },
+	};
+
+	const char* type_names[] = { "grid", "octree" };
+	const char* kernel_names[] = { "sse2", "avx2", "avx512" };
+
+	for (const Distribution& distribution : distributions) {
+		RandomGenerator rng;
+		Array<DVec3> positions(allocator);
+		Array<float> radii(allocator);
+		Array<DVec3> cluster_centers(allocator);
+		for (u32 i = 0; i < distribution.cluster_count; ++i) {
+			const float half = distribution.extent * 0.5f;
+			cluster_centers.push(DVec3(rng.randFloat(-half, half), 0, rng.randFloat(-half, half)));
+		}
+		for (u32 i = 0; i < ENTITY_COUNT; ++i) {
+			DVec3 pos;
+			if (cluster_centers.empty()) {
+				const float half = distribution.extent * 0.5f;
+				pos = DVec3(rng.randFloat(-half, half), rng.randFloat(0, 50), rng.randFloat(-half, half));
+			}
+			else {
+				const float r = distribution.cluster_radius;
+				pos = cluster_centers[rng.rand() % cluster_centers.size()] + DVec3(rng.randFloat(-r, r), rng.randFloat(0, 50), rng.randFloat(-r, r));
+			}
+			positions.push(pos);
+			const bool is_big = rng.randFloat() < distribution.big_ratio;
+			radii.push(is_big ? rng.randFloat(5, distribution.big_radius) : rng.randFloat(0.5f, 5));
+		}
+
+		ShiftedFrustum frustums[VIEW_COUNT];
+		for (ShiftedFrustum& frustum : frustums) {
+			const float half = distribution.extent * 0.5f;
+			const DVec3 pos(rng.randFloat(-half, half), 20, rng.randFloat(-half, half));
+			const float angle = rng.randFloat(0, 2 * PI);
+			const Vec3 dir(cosf(angle), -0.1f, sinf(angle));
+			frustum.computePerspective(pos, normalize(dir), Vec3(0, 1, 0), degreesToRadians(60), 16 / 9.f, 0.1f, 3'000);
+		}
+
+		for (u32 type_idx = 0; type_idx < lengthOf(type_names); ++type_idx) {
+			UniquePtr<CullingSystem> system = create(allocator, page_allocator, (Type)type_idx);
+
+			os::Timer timer;
+			for (u32 i = 0; i < ENTITY_COUNT; ++i) {
+				system->add({(i32)i}, u8(i % TYPE_COUNT), positions[i], radii[i]);
+			}
+			const float add_time = timer.tick();
+
+			// every kernel the CPU supports, the best one is left selected
+			u64 visible_count = 0;
+			float cull_times[lengthOf(kernel_names)] = {};
+			for (u32 level = 0; level <= (u32)getSIMDLevel(); ++level) {
+				s_cull_spheres = getCullSpheresFn((SIMDLevel)level);
+				timer.tick();
+				visible_count = 0;
+				for (const ShiftedFrustum& frustum : frustums) {
+					CullResult* result = system->cull(frustum);
+					if (result) {
+						visible_count += result->count();
+						result->free(page_allocator);
+					}
+				}
+				cull_times[level] = timer.tick();
+			}
+			timer.tick();
+
+			// every tenth entity moves
+			for (u32 i = 0; i < ENTITY_COUNT; i += 10) {
+				system->setPosition({(i32)i}, positions[i] + DVec3(rng.randFloat(-20, 20), 0, rng.randFloat(-20, 20)));
+			}
+			const float move_time = timer.tick();
+
+			logInfo("Culling benchmark, ", distribution.name, ", ", type_names[type_idx]
+				, ": add ", add_time * 1000, " ms"
+				, ", cull ", cull_times[(u32)getSIMDLevel()] * 1000 / VIEW_COUNT, " ms per view"
+				, ", move ", move_time * 1000, " ms"
+				, ", visible ", visible_count / VIEW_COUNT, " per view");
+			for (u32 level = 0; level <= (u32)getSIMDLevel(); ++level) {
+				logInfo("  ", kernel_names[level], " kernel: cull ", cull_times[level] * 1000 / VIEW_COUNT, " ms per view");
+			}
+		}
+	}
 }
 
-}
\ No newline at end of file
+}
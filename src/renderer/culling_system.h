@@ -62,7 +62,16 @@ struct LUMIX_RENDERER_API CullingSystem
 	CullingSystem() { }
 	virtual ~CullingSystem() { }
 
-	static UniquePtr<CullingSystem> create(IAllocator& allocator, PageAllocator& page_allocator);
+	enum class Type : u8 {
+		// uniform hash grid
+		GRID,
+		// loose octree, skips whole subtrees outside or fully inside of frustum
+		OCTREE
+	};
+
+	static UniquePtr<CullingSystem> create(IAllocator& allocator, PageAllocator& page_allocator, Type type = Type::OCTREE);
+	// compares all types on several synthetic entity distributions, results are logged
+	static void benchmark(IAllocator& allocator, PageAllocator& page_allocator);
 
 	virtual CullResult* cull(const ShiftedFrustum& frustum, u8 type) = 0;
 	virtual CullResult* cull(const ShiftedFrustum& frustum) = 0;
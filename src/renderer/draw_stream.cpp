@@ -1,10 +1,17 @@
 #include "draw_stream.h"
 #include "engine/array.h"
 #include "engine/engine.h"
+#include "engine/hash_map.h"
+#include "engine/log.h"
 #include "engine/math.h"
+#include "engine/os.h"
 #include "engine/page_allocator.h"
+#include "engine/stream.h"
 #include "engine/string.h"
 #include "renderer/renderer.h"
+#ifdef LUMIX_GPU_NULL
+	#include "renderer/gpu/gpu_null.h"
+#endif
 #ifdef _WIN32
 	#include <intrin.h>
 #endif
@@ -46,6 +53,7 @@ enum class DrawStream::Instruction : u8 {
 	CREATE_TEXTURE,
 	BIND_IMAGE_TEXTURE,
 	COPY_TEXTURE,
+	SWAP_TEXTURES,
 	COPY_BUFFER,
 	READ_TEXTURE,
 	DESTROY_BIND_GROUP,
@@ -68,7 +76,60 @@ enum class DrawStream::Instruction : u8 {
 	BEGIN_PROFILE_BLOCK,
 	END_PROFILE_BLOCK,
 	USER_ALLOC,
-	SET_TEXTURE_DEBUG_NAME
+	SET_TEXTURE_DEBUG_NAME,
+
+	COUNT
+};
+
+static const char* INSTRUCTION_NAMES[] = {
+	"end",
+	"scissor",
+	"draw indexed",
+	"bind textures",
+	"clear",
+	"viewport",
+	"bind uniform buffer",
+	"set framebuffer",
+	"set framebuffer cube",
+	"set current window",
+	"create program",
+	"draw arrays",
+	"push debug group",
+	"pop debug group",
+	"draw arrays instanced",
+	"draw indexed instanced",
+	"memory barrier",
+	"draw indirect",
+	"bind shader buffer",
+	"dispatch",
+	"create buffer",
+	"create texture",
+	"bind image texture",
+	"copy texture",
+	"swap textures",
+	"copy buffer",
+	"read texture",
+	"destroy bind group",
+	"destroy texture",
+	"destroy buffer",
+	"destroy program",
+	"generate mipmaps",
+	"update texture",
+	"update buffer",
+	"free memory",
+	"free aligned memory",
+	"start capture",
+	"stop capture",
+	"create texture view",
+	"bind",
+	"dirty cache",
+	"create bind group",
+	"function",
+	"substream",
+	"begin profile block",
+	"end profile block",
+	"user alloc",
+	"set texture debug name",
 };
 
 namespace {
@@ -156,6 +217,12 @@ struct CopyTextureData {
 	gpu::TextureHandle src;
 	u32 dst_x;
 	u32 dst_y;
+	u32 src_mip;
+};
+
+struct SwapTexturesData {
+	gpu::TextureHandle a;
+	gpu::TextureHandle b;
 };
 
 struct CopyBufferData {
@@ -240,6 +307,264 @@ static_assert(sizeof(DrawStream::Page) == PageAllocator::PAGE_SIZE);
 
 } // anonymous namespace
 
+// gpu state bound by `run`, used to skip binds of state which is already bound
+// shared by substreams, anything which can change the state behind our back invalidates it
+// it also carries the capture, so substreams are captured inline
+struct DrawStream::BoundState {
+	static constexpr u32 MAX_TEXTURES = 64;
+	static constexpr u32 MAX_UNIFORM_BUFFERS = 16;
+
+	enum : u32 {
+		PROGRAM = 1 << 0,
+		INDEX_BUFFER = 1 << 1,
+		INDIRECT_BUFFER = 1 << 2,
+		VERTEX_BUFFER0 = 1 << 3,
+		VERTEX_BUFFER1 = 1 << 4,
+		BIND_GROUP = 1 << 5,
+	};
+
+	struct UniformBuffer {
+		gpu::BufferHandle buffer;
+		size_t offset;
+		size_t size;
+	};
+
+	// commands passed to gpu:: as they are, filtered binds are counted when they are submitted
+	static bool isUnfiltered(Instruction instr) {
+		switch (instr) {
+			case Instruction::END:
+			case Instruction::BIND:
+			case Instruction::DIRTY_CACHE:
+			case Instruction::BIND_TEXTURES:
+			case Instruction::BIND_UNIFORM_BUFFER:
+			case Instruction::FREE_MEMORY:
+			case Instruction::FREE_ALIGNED_MEMORY:
+			case Instruction::FUNCTION:
+			case Instruction::SUBSTREAM:
+			case Instruction::BEGIN_PROFILE_BLOCK:
+			case Instruction::END_PROFILE_BLOCK:
+			case Instruction::USER_ALLOC:
+				return false;
+			default: return true;
+		}
+	}
+
+	// gpu objects can be recreated with the same handle, window switch changes context, functions can do anything
+	static bool invalidatesAll(Instruction instr) {
+		switch (instr) {
+			case Instruction::SET_CURRENT_WINDOW:
+			case Instruction::CREATE_PROGRAM:
+			case Instruction::CREATE_BUFFER:
+			case Instruction::CREATE_TEXTURE:
+			case Instruction::CREATE_TEXTURE_VIEW:
+			case Instruction::CREATE_BIND_GROUP:
+			case Instruction::DESTROY_BIND_GROUP:
+			case Instruction::DESTROY_TEXTURE:
+			case Instruction::DESTROY_BUFFER:
+			case Instruction::DESTROY_PROGRAM:
+			case Instruction::SWAP_TEXTURES:
+			case Instruction::FUNCTION:
+			case Instruction::START_CAPTURE:
+			case Instruction::STOP_CAPTURE:
+				return true;
+			default: return false;
+		}
+	}
+
+	void invalidate() {
+		valid = 0;
+		textures_valid = 0;
+		uniform_buffers_valid = 0;
+	}
+
+	// bind groups, textures and uniform buffers can overlap, we don't know which slots a group uses
+	void invalidateResources() {
+		valid &= ~BIND_GROUP;
+		textures_valid = 0;
+		uniform_buffers_valid = 0;
+	}
+
+	void useProgram(gpu::ProgramHandle p) {
+		if ((valid & PROGRAM) && program == p) {
+			++stats.elided;
+			return;
+		}
+		valid |= PROGRAM;
+		program = p;
+		++stats.submitted;
+		gpu::useProgram(p);
+	}
+
+	void bindIndexBuffer(gpu::BufferHandle buffer) {
+		if ((valid & INDEX_BUFFER) && index_buffer == buffer) {
+			++stats.elided;
+			return;
+		}
+		valid |= INDEX_BUFFER;
+		index_buffer = buffer;
+		++stats.submitted;
+		gpu::bindIndexBuffer(buffer);
+	}
+
+	void bindIndirectBuffer(gpu::BufferHandle buffer) {
+		if ((valid & INDIRECT_BUFFER) && indirect_buffer == buffer) {
+			++stats.elided;
+			return;
+		}
+		valid |= INDIRECT_BUFFER;
+		indirect_buffer = buffer;
+		++stats.submitted;
+		gpu::bindIndirectBuffer(buffer);
+	}
+
+	void bindVertexBuffer(u32 binding_idx, const Cache::VertexBuffer& vb) {
+		const u32 flag = VERTEX_BUFFER0 << binding_idx;
+		Cache::VertexBuffer& bound = vertex_buffers[binding_idx];
+		if ((valid & flag) && bound.buffer == vb.buffer && bound.offset == vb.offset && bound.stride == vb.stride) {
+			++stats.elided;
+			return;
+		}
+		valid |= flag;
+		bound = vb;
+		++stats.submitted;
+		gpu::bindVertexBuffer(binding_idx, vb.buffer, vb.offset, vb.stride);
+	}
+
+	void bind(gpu::BindGroupHandle group) {
+		if ((valid & BIND_GROUP) && bind_group == group) {
+			++stats.elided;
+			return;
+		}
+		invalidateResources();
+		valid |= BIND_GROUP;
+		bind_group = group;
+		++stats.submitted;
+		gpu::bind(group);
+	}
+
+	void bindTextures(const gpu::TextureHandle* handles, u32 offset, u32 count) {
+		valid &= ~BIND_GROUP;
+		u32 from = offset;
+		u32 to = offset + count;
+		if (to <= MAX_TEXTURES) {
+			// bind only the range which changed
+			while (from < to && (textures_valid & (1ull << from)) && textures[from] == handles[from - offset]) ++from;
+			while (to > from && (textures_valid & (1ull << (to - 1))) && textures[to - 1] == handles[to - 1 - offset]) --to;
+			if (from == to) {
+				++stats.elided;
+				return;
+			}
+			for (u32 i = from; i < to; ++i) {
+				textures[i] = handles[i - offset];
+				textures_valid |= 1ull << i;
+			}
+		}
+		else {
+			for (u32 i = offset; i < MAX_TEXTURES; ++i) textures_valid &= ~(1ull << i);
+		}
+		++stats.submitted;
+		gpu::bindTextures(handles + (from - offset), from, to - from);
+	}
+
+	void bindUniformBuffer(u32 ub_index, gpu::BufferHandle buffer, size_t offset, size_t size) {
+		valid &= ~BIND_GROUP;
+		if (ub_index < MAX_UNIFORM_BUFFERS) {
+			UniformBuffer& bound = uniform_buffers[ub_index];
+			const u32 bit = 1 << ub_index;
+			if ((uniform_buffers_valid & bit) && bound.buffer == buffer && bound.offset == offset && bound.size == size) {
+				++stats.elided;
+				return;
+			}
+			uniform_buffers_valid |= bit;
+			bound = {buffer, offset, size};
+		}
+		++stats.submitted;
+		gpu::bindUniformBuffer(ub_index, buffer, offset, size);
+	}
+
+	// instruction is written with its payload as it is in the page, memory referenced by the payload is appended
+	void captureInstruction(Instruction instr, const u8* payload, const u8* payload_end) {
+		switch (instr) {
+			// not gpu commands or captured elsewhere
+			case Instruction::END:
+			case Instruction::FREE_MEMORY:
+			case Instruction::FREE_ALIGNED_MEMORY:
+			case Instruction::USER_ALLOC:
+			case Instruction::SUBSTREAM:
+			case Instruction::CREATE_PROGRAM:
+				return;
+			case Instruction::FUNCTION: {
+				// function pointers are valid only in this process, so functions are captured only as markers
+				u32 payload_size;
+				memcpy(&payload_size, payload, sizeof(payload_size));
+				capture->write(instr);
+				capture->write(payload_size);
+				return;
+			}
+			default: break;
+		}
+
+		capture->write(instr);
+		capture->write(payload, payload_end - payload);
+		switch (instr) {
+			case Instruction::PUSH_DEBUG_GROUP: {
+				const char* msg;
+				memcpy(&msg, payload, sizeof(msg));
+				capture->writeString(msg);
+				break;
+			}
+			case Instruction::UPDATE_BUFFER: {
+				UpdateBufferData data;
+				memcpy(&data, payload, sizeof(data));
+				capture->write(data.data, data.size);
+				break;
+			}
+			case Instruction::UPDATE_TEXTURE: {
+				UpdateTextureData data;
+				memcpy(&data, payload, sizeof(data));
+				capture->write(data.buf, data.size);
+				break;
+			}
+			case Instruction::CREATE_BUFFER: {
+				CreateBufferData data;
+				memcpy(&data, payload, sizeof(data));
+				if (data.data) capture->write(data.data, data.size);
+				break;
+			}
+			default: break;
+		}
+	}
+
+	// payload of CREATE_PROGRAM is a pointer to data deleted by `run`, so it's serialized instead
+	void captureProgram(const CreateProgramData& data) {
+		capture->write(Instruction::CREATE_PROGRAM);
+		capture->write(data.program);
+		capture->write(data.state);
+		capture->write(data.decl);
+		capture->write(data.sources.size());
+		for (i32 i = 0; i < data.sources.size(); ++i) {
+			capture->write(data.types[i]);
+			capture->writeString(data.sources[i]);
+		}
+		capture->write(data.prefixes.size());
+		for (const String& prefix : data.prefixes) capture->writeString(prefix);
+		capture->writeString(data.name);
+	}
+
+	u32 valid = 0;
+	gpu::ProgramHandle program;
+	gpu::BufferHandle index_buffer;
+	gpu::BufferHandle indirect_buffer;
+	Cache::VertexBuffer vertex_buffers[2];
+	gpu::BindGroupHandle bind_group;
+	u64 textures_valid = 0;
+	gpu::TextureHandle textures[MAX_TEXTURES];
+	u32 uniform_buffers_valid = 0;
+	UniformBuffer uniform_buffers[MAX_UNIFORM_BUFFERS];
+	Stats stats;
+	OutputMemoryStream* capture = nullptr;
+};
+
 DrawStream::~DrawStream() {
 	allocator.lock();
 	while (first) {
@@ -293,11 +618,16 @@ void DrawStream::readTexture(gpu::TextureHandle texture, u32 mip, Span<u8> buf)
 	write(Instruction::READ_TEXTURE, data);
 }
 
-void DrawStream::copy(gpu::TextureHandle dst, gpu::TextureHandle src, u32 dst_x, u32 dst_y) {
-	CopyTextureData data = {dst, src, dst_x, dst_y};
+void DrawStream::copy(gpu::TextureHandle dst, gpu::TextureHandle src, u32 dst_x, u32 dst_y, u32 src_mip) {
+	CopyTextureData data = {dst, src, dst_x, dst_y, src_mip};
 	write(Instruction::COPY_TEXTURE, data);
 };
 
+void DrawStream::swap(gpu::TextureHandle a, gpu::TextureHandle b) {
+	SwapTexturesData data = {a, b};
+	write(Instruction::SWAP_TEXTURES, data);
+}
+
 void DrawStream::copy(gpu::BufferHandle dst, gpu::BufferHandle src, u32 dst_offset, u32 src_offset, u32 size) {
 	CopyBufferData data = {dst, src, dst_offset, src_offset, size};
 	write(Instruction::COPY_BUFFER, data);
@@ -677,7 +1007,17 @@ void DrawStream::submitCached() {
 	#undef WRITE
 }
 
-void DrawStream::run() {
+void DrawStream::run(Stats* stats, OutputMemoryStream* capture) {
+	BoundState state;
+	state.capture = capture;
+	run(state);
+	if (stats) {
+		stats->submitted += state.stats.submitted;
+		stats->elided += state.stats.elided;
+	}
+}
+
+void DrawStream::run(BoundState& state) {
 	ASSERT(!run_called);
 	const Instruction end_instr = Instruction::END;
 	memcpy(current->data + current->header.size, &end_instr, sizeof(end_instr));
@@ -689,46 +1029,49 @@ void DrawStream::run() {
 		const u8* ptr = page->data;
 		for (;;) {
 			READ(Instruction, instr);
+			const u8* payload = ptr;
+			if (BoundState::isUnfiltered(instr)) ++state.stats.submitted;
+			if (BoundState::invalidatesAll(instr)) state.invalidate();
 			switch(instr) {
 				case Instruction::END: goto next_page;
 				case Instruction::BIND: {
 					READ(Cache, cache);
-					gpu::bind(cache.group0);
-					gpu::useProgram(cache.program);
-					gpu::bindIndexBuffer(cache.index_buffer);
-					gpu::bindVertexBuffer(0, cache.vertex_buffers[0].buffer, cache.vertex_buffers[0].offset, cache.vertex_buffers[0].stride);
-					gpu::bindVertexBuffer(1, cache.vertex_buffers[1].buffer, cache.vertex_buffers[1].offset, cache.vertex_buffers[1].stride);
+					state.bind(cache.group0);
+					state.useProgram(cache.program);
+					state.bindIndexBuffer(cache.index_buffer);
+					state.bindVertexBuffer(0, cache.vertex_buffers[0]);
+					state.bindVertexBuffer(1, cache.vertex_buffers[1]);
 					break;
 				}
 				case Instruction::DIRTY_CACHE: {
 					READ(u32, dirty);
 					if (dirty & Dirty::PROGRAM) {
 						READ(gpu::ProgramHandle, program);
-						gpu::useProgram(program);
+						state.useProgram(program);
 					}
 					if (dirty & Dirty::INDEX_BUFFER) {
 						READ(gpu::BufferHandle, buf);
-						gpu::bindIndexBuffer(buf);
+						state.bindIndexBuffer(buf);
 					}
 					if (dirty & Dirty::INDIRECT_BUFFER) {
 						READ(gpu::BufferHandle, buf);
-						gpu::bindIndirectBuffer(buf);
+						state.bindIndirectBuffer(buf);
 					}
 					if (dirty & Dirty::VERTEX_BUFFER0) {
 						READ(Cache::VertexBuffer, buf);
-						gpu::bindVertexBuffer(0, buf.buffer, buf.offset, buf.stride);
+						state.bindVertexBuffer(0, buf);
 					}
 					if (dirty & Dirty::VERTEX_BUFFER1) {
 						READ(Cache::VertexBuffer, buf);
-						gpu::bindVertexBuffer(1, buf.buffer, buf.offset, buf.stride);
+						state.bindVertexBuffer(1, buf);
 					}
 					if (dirty & (Dirty::BIND_GROUP0)) {
 						READ(gpu::BindGroupHandle, group);
-						gpu::bind(group);
+						state.bind(group);
 					}
 					if (dirty & (Dirty::BIND_GROUP1)) {
 						READ(gpu::BindGroupHandle, group);
-						gpu::bind(group);
+						state.bind(group);
 					}
 					break;
 				}
@@ -772,6 +1115,7 @@ void DrawStream::run() {
 				}
 				case Instruction::CREATE_PROGRAM: {
 					READ(CreateProgramData*, data);
+					if (state.capture) state.captureProgram(*data);
 					gpu::createProgram(data->program
 						, data->state
 						, data->decl
@@ -788,6 +1132,8 @@ void DrawStream::run() {
 				case Instruction::SET_FRAMEBUFFER_CUBE: {
 					READ(SetFramebufferCubeData, data);
 					gpu::setFramebufferCube(data.cube, data.face, data.mip);
+					// gl backend binds attachments as textures
+					state.invalidateResources();
 					break;
 				}
 				case Instruction::SET_FRAMEBUFFER: {
@@ -796,23 +1142,27 @@ void DrawStream::run() {
 					READ(gpu::FramebufferFlags, flags);
 					gpu::setFramebuffer((const gpu::TextureHandle*)ptr, num, ds, flags);
 					ptr += sizeof(gpu::TextureHandle) * num;
+					// gl backend binds attachments as textures
+					state.invalidateResources();
 					break;
 				}
 				case Instruction::BIND_TEXTURES: {
 					READ(u32, offset);
 					READ(u32, count);
-					gpu::bindTextures((const gpu::TextureHandle*)ptr, offset, count);
+					state.bindTextures((const gpu::TextureHandle*)ptr, offset, count);
 					ptr += sizeof(gpu::TextureHandle) * count;
 					break;
 				}
 				case Instruction::CLEAR: {
 					READ(ClearData, data);
 					gpu::clear(data.flags, &data.color.x, data.depth);
+					// gl backend unbinds program to clear
+					state.valid &= ~BoundState::PROGRAM;
 					break;
 				}
 				case Instruction::BIND_UNIFORM_BUFFER: {
 					READ(BindUniformBufferData, data);
-					gpu::bindUniformBuffer(data.ub_index, data.buffer, data.offset, data.size);
+					state.bindUniformBuffer(data.ub_index, data.buffer, data.offset, data.size);
 					break;
 				}
 				case Instruction::DRAW_ARRAYS: {
@@ -823,6 +1173,8 @@ void DrawStream::run() {
 				case Instruction::DRAW_INDEXED_INSTANCED: {
 					READ(DrawIndexedInstancedDat, data);
 					gpu::drawIndexedInstanced(data.indices_count, data.instances_count, data.index_type);
+					// gl backend can draw big instanced batches through its own indirect buffer
+					state.valid &= ~BoundState::INDIRECT_BUFFER;
 					break;
 				}
 				case Instruction::DRAW_ARRAYS_INSTANCED: {
@@ -873,7 +1225,12 @@ void DrawStream::run() {
 				}
 				case Instruction::COPY_TEXTURE: {
 					READ(CopyTextureData, data);
-					gpu::copy(data.dst, data.src, data.dst_x, data.dst_y);
+					gpu::copy(data.dst, data.src, data.dst_x, data.dst_y, data.src_mip);
+					break;
+				}
+				case Instruction::SWAP_TEXTURES: {
+					READ(SwapTexturesData, data);
+					gpu::swap(data.a, data.b);
 					break;
 				}
 				case Instruction::COPY_BUFFER: {
@@ -940,7 +1297,7 @@ void DrawStream::run() {
 				}
 				case Instruction::SUBSTREAM: {
 					DrawStream* stream = (DrawStream*)ptr;
-					stream->run();
+					stream->run(state);
 					stream->~DrawStream();
 					ptr += sizeof(DrawStream);
 					break;
@@ -979,12 +1336,613 @@ void DrawStream::run() {
 					gpu::viewport(vec.x, vec.y, vec.z, vec.w);
 					break;
 				}
+				case Instruction::COUNT: ASSERT(false); break;
 			}
+			if (state.capture) state.captureInstruction(instr, payload, ptr);
 		}
 		next_page:
 
 		page = page->header.next;
 	}
+	#undef READ
+}
+
+namespace {
+
+// maps handles from a capture to objects created by replay
+// objects created before the capture get stand-ins, since we know nothing about them
+struct ReplayObjects {
+	static constexpr u32 STAND_IN_BUFFER_SIZE = 64 * 1024;
+
+	ReplayObjects(IAllocator& allocator)
+		: buffers(allocator)
+		, textures(allocator)
+		, programs(allocator)
+		, bind_groups(allocator)
+	{}
+
+	~ReplayObjects() {
+		for (gpu::BindGroupHandle h : bind_groups) gpu::destroy(h);
+		for (gpu::TextureHandle h : textures) gpu::destroy(h);
+		for (gpu::BufferHandle h : buffers) gpu::destroy(h);
+		for (gpu::ProgramHandle h : programs) gpu::destroy(h);
+	}
+
+	gpu::BufferHandle get(gpu::BufferHandle captured) {
+		if (!captured) return gpu::INVALID_BUFFER;
+		auto iter = buffers.find(captured);
+		if (iter.isValid()) return iter.value();
+		const u64 start = os::Timer::getRawTimestamp();
+		gpu::BufferHandle h = gpu::allocBufferHandle();
+		gpu::createBuffer(h, gpu::BufferFlags::NONE, STAND_IN_BUFFER_SIZE, nullptr);
+		buffers.insert(captured, h);
+		standInCreated(start);
+		return h;
+	}
+
+	gpu::TextureHandle get(gpu::TextureHandle captured) {
+		if (!captured) return gpu::INVALID_TEXTURE;
+		auto iter = textures.find(captured);
+		if (iter.isValid()) return iter.value();
+		const u64 start = os::Timer::getRawTimestamp();
+		gpu::TextureHandle h = gpu::allocTextureHandle();
+		gpu::createTexture(h, 4, 4, 1, gpu::TextureFormat::RGBA8, gpu::TextureFlags::NO_MIPS, "replay stand-in");
+		textures.insert(captured, h);
+		standInCreated(start);
+		return h;
+	}
+
+	gpu::ProgramHandle get(gpu::ProgramHandle captured) {
+		if (!captured) return gpu::INVALID_PROGRAM;
+		auto iter = programs.find(captured);
+		if (iter.isValid()) return iter.value();
+		const u64 start = os::Timer::getRawTimestamp();
+		gpu::ProgramHandle h = gpu::allocProgramHandle();
+		gpu::VertexDecl decl(gpu::PrimitiveType::TRIANGLES);
+		gpu::createProgram(h, gpu::StateFlags::NONE, decl, nullptr, nullptr, 0, nullptr, 0, "replay stand-in");
+		programs.insert(captured, h);
+		standInCreated(start);
+		return h;
+	}
+
+	gpu::BindGroupHandle get(gpu::BindGroupHandle captured) {
+		if (!captured) return gpu::INVALID_BIND_GROUP;
+		auto iter = bind_groups.find(captured);
+		if (iter.isValid()) return iter.value();
+		const u64 start = os::Timer::getRawTimestamp();
+		gpu::BindGroupHandle h = gpu::allocBindGroupHandle();
+		gpu::createBindGroup(h, {});
+		bind_groups.insert(captured, h);
+		standInCreated(start);
+		return h;
+	}
+
+	// handle of an object which is about to be created, replaces any previous object with the same captured handle
+	template <typename H> H created(HashMap<H, H>& map, H captured, H (*alloc)()) {
+		auto iter = map.find(captured);
+		if (iter.isValid()) {
+			gpu::destroy(iter.value());
+			map.erase(iter);
+		}
+		H h = alloc();
+		map.insert(captured, h);
+		return h;
+	}
+
+	gpu::BufferHandle created(gpu::BufferHandle captured) { return created(buffers, captured, gpu::allocBufferHandle); }
+	gpu::TextureHandle created(gpu::TextureHandle captured) { return created(textures, captured, gpu::allocTextureHandle); }
+	gpu::ProgramHandle created(gpu::ProgramHandle captured) { return created(programs, captured, gpu::allocProgramHandle); }
+	gpu::BindGroupHandle created(gpu::BindGroupHandle captured) { return created(bind_groups, captured, gpu::allocBindGroupHandle); }
+
+	// objects created before the capture and not used in it do not exist in replay
+	template <typename H> void destroy(HashMap<H, H>& map, H captured) {
+		auto iter = map.find(captured);
+		if (!iter.isValid()) return;
+		gpu::destroy(iter.value());
+		map.erase(iter);
+	}
+
+	void destroy(gpu::BufferHandle captured) { destroy(buffers, captured); }
+	void destroy(gpu::TextureHandle captured) { destroy(textures, captured); }
+	void destroy(gpu::ProgramHandle captured) { destroy(programs, captured); }
+	void destroy(gpu::BindGroupHandle captured) { destroy(bind_groups, captured); }
+
+	void standInCreated(u64 start) {
+		++stand_ins;
+		stand_in_ticks += os::Timer::getRawTimestamp() - start;
+	}
+
+	HashMap<gpu::BufferHandle, gpu::BufferHandle> buffers;
+	HashMap<gpu::TextureHandle, gpu::TextureHandle> textures;
+	HashMap<gpu::ProgramHandle, gpu::ProgramHandle> programs;
+	HashMap<gpu::BindGroupHandle, gpu::BindGroupHandle> bind_groups;
+	u32 stand_ins = 0;
+	// time spent creating stand-ins, it's not counted to commands which triggered it
+	u64 stand_in_ticks = 0;
+};
+
+} // anonymous namespace
+
+const char* DrawStream::getCommandName(u32 type) {
+	static_assert(lengthOf(INSTRUCTION_NAMES) == (u32)Instruction::COUNT);
+	static_assert((u32)Instruction::COUNT <= ReplayStats::MAX_COMMANDS);
+	if (type >= (u32)Instruction::COUNT) return "unknown";
+	return INSTRUCTION_NAMES[type];
+}
+
+bool DrawStream::replay(InputMemoryStream& blob, IAllocator& allocator, ReplayStats& stats, bool allow_stand_ins) {
+	CaptureHeader header;
+	blob.read(header);
+	if (blob.hasOverflow() || header.magic != CaptureHeader::MAGIC) {
+		logError("Not a draw stream capture");
+		return false;
+	}
+	if (header.version != CaptureHeader::VERSION) {
+		logError("Unsupported draw stream capture version ", header.version);
+		return false;
+	}
+	if (header.pointer_size != sizeof(void*)) {
+		logError("Draw stream capture was made by a build with ", header.pointer_size * 8, "-bit pointers");
+		return false;
+	}
+
+	ReplayObjects objects(allocator);
+	BoundState state;
+	Array<gpu::TextureHandle> textures(allocator);
+	Array<gpu::BindGroupEntryDesc> descs(allocator);
+	Array<const char*> srcs(allocator);
+	Array<gpu::ShaderType> types(allocator);
+	Array<const char*> prefixes(allocator);
+	Array<u8> readback(allocator);
+
+	#define READ(T, N) T N; blob.read(N)
+	while (blob.remaining() > 0) {
+		READ(Instruction, instr);
+		if (BoundState::isUnfiltered(instr)) ++state.stats.submitted;
+		if (BoundState::invalidatesAll(instr)) state.invalidate();
+		const u64 start = os::Timer::getRawTimestamp();
+		const u64 stand_in_ticks = objects.stand_in_ticks;
+		switch (instr) {
+			case Instruction::BIND: {
+				READ(Cache, cache);
+				state.bind(objects.get(cache.group0));
+				state.useProgram(objects.get(cache.program));
+				state.bindIndexBuffer(objects.get(cache.index_buffer));
+				for (u32 i = 0; i < lengthOf(cache.vertex_buffers); ++i) {
+					Cache::VertexBuffer vb = cache.vertex_buffers[i];
+					vb.buffer = objects.get(vb.buffer);
+					state.bindVertexBuffer(i, vb);
+				}
+				break;
+			}
+			case Instruction::DIRTY_CACHE: {
+				READ(u32, dirty);
+				if (dirty & Dirty::PROGRAM) {
+					READ(gpu::ProgramHandle, program);
+					state.useProgram(objects.get(program));
+				}
+				if (dirty & Dirty::INDEX_BUFFER) {
+					READ(gpu::BufferHandle, buf);
+					state.bindIndexBuffer(objects.get(buf));
+				}
+				if (dirty & Dirty::INDIRECT_BUFFER) {
+					READ(gpu::BufferHandle, buf);
+					state.bindIndirectBuffer(objects.get(buf));
+				}
+				if (dirty & Dirty::VERTEX_BUFFER0) {
+					READ(Cache::VertexBuffer, vb);
+					vb.buffer = objects.get(vb.buffer);
+					state.bindVertexBuffer(0, vb);
+				}
+				if (dirty & Dirty::VERTEX_BUFFER1) {
+					READ(Cache::VertexBuffer, vb);
+					vb.buffer = objects.get(vb.buffer);
+					state.bindVertexBuffer(1, vb);
+				}
+				if (dirty & Dirty::BIND_GROUP0) {
+					READ(gpu::BindGroupHandle, group);
+					state.bind(objects.get(group));
+				}
+				if (dirty & Dirty::BIND_GROUP1) {
+					READ(gpu::BindGroupHandle, group);
+					state.bind(objects.get(group));
+				}
+				break;
+			}
+			case Instruction::DRAW_INDIRECT: {
+				READ(DrawIndirectData, data);
+				gpu::drawIndirect(data.index_type, data.indirect_buffer_offset);
+				break;
+			}
+			case Instruction::MEMORY_BARRIER: {
+				READ(MemoryBarrierData, data);
+				gpu::memoryBarrier(data.type, objects.get(data.buffer));
+				break;
+			}
+			case Instruction::POP_DEBUG_GROUP:
+				gpu::popDebugGroup();
+				break;
+			case Instruction::PUSH_DEBUG_GROUP: {
+				READ(const char*, captured_msg);
+				const char* msg = blob.readString();
+				if (msg) gpu::pushDebugGroup(msg);
+				break;
+			}
+			case Instruction::UPDATE_BUFFER: {
+				READ(UpdateBufferData, data);
+				data.data = blob.skip(data.size);
+				gpu::update(objects.get(data.buffer), data.data, data.size);
+				break;
+			}
+			case Instruction::UPDATE_TEXTURE: {
+				READ(UpdateTextureData, data);
+				data.buf = blob.skip(data.size);
+				gpu::update(objects.get(data.texture), data.mip, data.x, data.y, data.z, data.w, data.h, data.format, data.buf, data.size);
+				break;
+			}
+			case Instruction::BIND_SHADER_BUFFER: {
+				READ(BinderShaderBufferData, data);
+				gpu::bindShaderBuffer(objects.get(data.buffer), data.binding_idx, data.flags);
+				break;
+			}
+			case Instruction::GENERATE_MIPMAPS: {
+				READ(gpu::TextureHandle, tex);
+				gpu::generateMipmaps(objects.get(tex));
+				break;
+			}
+			case Instruction::CREATE_PROGRAM: {
+				READ(gpu::ProgramHandle, program);
+				READ(gpu::StateFlags, program_state);
+				gpu::VertexDecl decl(gpu::PrimitiveType::NONE);
+				blob.read(decl);
+				READ(i32, num);
+				srcs.clear();
+				types.clear();
+				for (i32 i = 0; i < num; ++i) {
+					types.push(blob.read<gpu::ShaderType>());
+					srcs.push(blob.readString());
+				}
+				READ(i32, prefixes_count);
+				prefixes.clear();
+				for (i32 i = 0; i < prefixes_count; ++i) prefixes.push(blob.readString());
+				const char* name = blob.readString();
+				if (blob.hasOverflow()) break;
+				gpu::createProgram(objects.created(program), program_state, decl, srcs.begin(), types.begin(), num, prefixes.begin(), prefixes_count, name);
+				break;
+			}
+			case Instruction::SET_FRAMEBUFFER_CUBE: {
+				READ(SetFramebufferCubeData, data);
+				gpu::setFramebufferCube(objects.get(data.cube), data.face, data.mip);
+				state.invalidateResources();
+				break;
+			}
+			case Instruction::SET_FRAMEBUFFER: {
+				READ(u32, num);
+				READ(gpu::TextureHandle, ds);
+				READ(gpu::FramebufferFlags, flags);
+				textures.clear();
+				for (u32 i = 0; i < num; ++i) textures.push(objects.get(blob.read<gpu::TextureHandle>()));
+				gpu::setFramebuffer(textures.begin(), num, objects.get(ds), flags);
+				state.invalidateResources();
+				break;
+			}
+			case Instruction::BIND_TEXTURES: {
+				READ(u32, offset);
+				READ(u32, count);
+				textures.clear();
+				for (u32 i = 0; i < count; ++i) textures.push(objects.get(blob.read<gpu::TextureHandle>()));
+				state.bindTextures(textures.begin(), offset, count);
+				break;
+			}
+			case Instruction::CLEAR: {
+				READ(ClearData, data);
+				gpu::clear(data.flags, &data.color.x, data.depth);
+				state.valid &= ~BoundState::PROGRAM;
+				break;
+			}
+			case Instruction::BIND_UNIFORM_BUFFER: {
+				READ(BindUniformBufferData, data);
+				state.bindUniformBuffer(data.ub_index, objects.get(data.buffer), data.offset, data.size);
+				break;
+			}
+			case Instruction::DRAW_ARRAYS: {
+				READ(DrawArraysData, data);
+				gpu::drawArrays(data.offset, data.count);
+				break;
+			}
+			case Instruction::DRAW_INDEXED_INSTANCED: {
+				READ(DrawIndexedInstancedDat, data);
+				gpu::drawIndexedInstanced(data.indices_count, data.instances_count, data.index_type);
+				state.valid &= ~BoundState::INDIRECT_BUFFER;
+				break;
+			}
+			case Instruction::DRAW_ARRAYS_INSTANCED: {
+				READ(DrawArraysInstancedData, data);
+				gpu::drawArraysInstanced(data.indices_count, data.instances_count);
+				break;
+			}
+			case Instruction::DRAW_INDEXED: {
+				READ(DrawIndexedData, data);
+				gpu::drawIndexed(data.offset, data.count, data.type);
+				break;
+			}
+			case Instruction::SET_CURRENT_WINDOW: {
+				// window of the capturing process
+				READ(void*, window_handle);
+				break;
+			}
+			case Instruction::SCISSOR: {
+				READ(IVec4, vec);
+				gpu::scissor(vec.x, vec.y, vec.z, vec.w);
+				break;
+			}
+			case Instruction::SET_TEXTURE_DEBUG_NAME: {
+				READ(gpu::TextureHandle, texture);
+				READ(u32, len);
+				const char* debug_name = (const char*)blob.skip(len);
+				gpu::setDebugName(objects.get(texture), debug_name);
+				break;
+			}
+			case Instruction::CREATE_TEXTURE: {
+				READ(CreateTextureData, data);
+				READ(u32, len);
+				const char* debug_name = (const char*)blob.skip(len);
+				gpu::createTexture(objects.created(data.handle), data.w, data.h, data.depth, data.format, data.flags, debug_name);
+				break;
+			}
+			case Instruction::CREATE_BUFFER: {
+				READ(CreateBufferData, data);
+				if (data.data) data.data = blob.skip(data.size);
+				gpu::createBuffer(objects.created(data.buffer), data.flags, data.size, data.data);
+				break;
+			}
+			case Instruction::BIND_IMAGE_TEXTURE: {
+				READ(BindImageTextureData, data);
+				gpu::bindImageTexture(objects.get(data.texture), data.unit);
+				break;
+			}
+			case Instruction::COPY_TEXTURE: {
+				READ(CopyTextureData, data);
+				gpu::copy(objects.get(data.dst), objects.get(data.src), data.dst_x, data.dst_y, data.src_mip);
+				break;
+			}
+			case Instruction::SWAP_TEXTURES: {
+				READ(SwapTexturesData, data);
+				gpu::swap(objects.get(data.a), objects.get(data.b));
+				break;
+			}
+			case Instruction::COPY_BUFFER: {
+				READ(CopyBufferData, data);
+				gpu::copy(objects.get(data.dst), objects.get(data.src), data.dst_offset, data.src_offset, data.size);
+				break;
+			}
+			case Instruction::READ_TEXTURE: {
+				READ(ReadTextureData, data);
+				readback.resize(data.buf.length());
+				gpu::readTexture(objects.get(data.texture), data.mip, Span(readback.begin(), readback.end()));
+				break;
+			}
+			case Instruction::DESTROY_TEXTURE: {
+				READ(gpu::TextureHandle, texture);
+				objects.destroy(texture);
+				break;
+			}
+			case Instruction::DESTROY_BIND_GROUP: {
+				READ(gpu::BindGroupHandle, group);
+				objects.destroy(group);
+				break;
+			}
+			case Instruction::DESTROY_PROGRAM: {
+				READ(gpu::ProgramHandle, program);
+				objects.destroy(program);
+				break;
+			}
+			case Instruction::DESTROY_BUFFER: {
+				READ(gpu::BufferHandle, buffer);
+				objects.destroy(buffer);
+				break;
+			}
+			case Instruction::CREATE_BIND_GROUP: {
+				READ(gpu::BindGroupHandle, group);
+				READ(u32, size);
+				const gpu::BindGroupEntryDesc* captured = (const gpu::BindGroupEntryDesc*)blob.skip(size);
+				if (blob.hasOverflow()) break;
+				descs.clear();
+				for (u32 i = 0; i < size / sizeof(captured[0]); ++i) {
+					gpu::BindGroupEntryDesc& desc = descs.emplace(captured[i]);
+					switch (desc.type) {
+						case gpu::BindGroupEntryDesc::UNIFORM_BUFFER: desc.buffer = objects.get(desc.buffer); break;
+						case gpu::BindGroupEntryDesc::TEXTURE: desc.texture = objects.get(desc.texture); break;
+					}
+				}
+				gpu::createBindGroup(objects.created(group), descs);
+				break;
+			}
+			case Instruction::DISPATCH: {
+				READ(IVec3, size);
+				gpu::dispatch(size.x, size.y, size.z);
+				break;
+			}
+			case Instruction::FUNCTION: {
+				READ(u32, payload_size);
+				++stats.skipped_functions;
+				break;
+			}
+			case Instruction::START_CAPTURE:
+				gpu::startCapture();
+				break;
+			case Instruction::STOP_CAPTURE:
+				gpu::stopCapture();
+				break;
+			case Instruction::BEGIN_PROFILE_BLOCK: {
+				// gpu profiler belongs to renderer, blocks are only counted
+				READ(i64, link);
+				READ(u32, len);
+				blob.skip(len);
+				break;
+			}
+			case Instruction::END_PROFILE_BLOCK: break;
+			case Instruction::CREATE_TEXTURE_VIEW: {
+				READ(CreateTextureViewData, data);
+				gpu::createTextureView(objects.created(data.view), objects.get(data.texture), data.layer);
+				break;
+			}
+			case Instruction::VIEWPORT: {
+				READ(IVec4, vec);
+				gpu::viewport(vec.x, vec.y, vec.z, vec.w);
+				break;
+			}
+			// never captured
+			case Instruction::END:
+			case Instruction::FREE_MEMORY:
+			case Instruction::FREE_ALIGNED_MEMORY:
+			case Instruction::USER_ALLOC:
+			case Instruction::SUBSTREAM:
+			case Instruction::COUNT:
+			default:
+				logError("Corrupted draw stream capture, unexpected command ", (u32)instr);
+				return false;
+		}
+		if (blob.hasOverflow()) {
+			logError("Draw stream capture is truncated");
+			return false;
+		}
+		if (!allow_stand_ins && objects.stand_ins > 0) {
+			// stops before any draw uses the stand-in
+			logError("Draw stream capture uses objects created before the capture, it can be replayed only with the null GPU backend");
+			return false;
+		}
+		stats.ticks[(u32)instr] += os::Timer::getRawTimestamp() - start - (objects.stand_in_ticks - stand_in_ticks);
+		++stats.counts[(u32)instr];
+	}
+	#undef READ
+
+	stats.stream_stats.submitted += state.stats.submitted;
+	stats.stream_stats.elided += state.stats.elided;
+	stats.stand_ins += objects.stand_ins;
+	return true;
+}
+
+#ifdef LUMIX_GPU_NULL
+
+bool DrawStream::checkBindFiltering(IAllocator& allocator) {
+	// captured handles are only keys, replay creates its own objects
+	const gpu::BindGroupHandle group = (gpu::BindGroupHandle)(uintptr)0x10;
+	const gpu::ProgramHandle program0 = (gpu::ProgramHandle)(uintptr)0x20;
+	const gpu::ProgramHandle program1 = (gpu::ProgramHandle)(uintptr)0x30;
+	const gpu::BufferHandle index_buffer = (gpu::BufferHandle)(uintptr)0x40;
+	const gpu::BufferHandle vertex_buffer = (gpu::BufferHandle)(uintptr)0x50;
+	const gpu::TextureHandle texture = (gpu::TextureHandle)(uintptr)0x60;
+
+	OutputMemoryStream blob(allocator);
+	blob.write(CaptureHeader());
+
+	blob.write(Instruction::CREATE_BIND_GROUP);
+	blob.write(group);
+	blob.write(u32(0));
+	const gpu::ProgramHandle programs[] = {program0, program1};
+	for (gpu::ProgramHandle program : programs) {
+		blob.write(Instruction::CREATE_PROGRAM);
+		blob.write(program);
+		blob.write(gpu::StateFlags::NONE);
+		blob.write(gpu::VertexDecl(gpu::PrimitiveType::TRIANGLES));
+		blob.write(i32(0));
+		blob.write(i32(0));
+		blob.writeString("check");
+	}
+	const gpu::BufferHandle buffers[] = {index_buffer, vertex_buffer};
+	for (gpu::BufferHandle buffer : buffers) {
+		blob.write(Instruction::CREATE_BUFFER);
+		blob.write(CreateBufferData{buffer, gpu::BufferFlags::NONE, 64, nullptr});
+	}
+	blob.write(Instruction::CREATE_TEXTURE);
+	blob.write(CreateTextureData{texture, 4, 4, 1, gpu::TextureFormat::RGBA8, gpu::TextureFlags::NO_MIPS});
+	blob.write(u32(sizeof("check")));
+	blob.write("check", sizeof("check"));
+
+	Cache cache = {};
+	cache.group0 = group;
+	cache.program = program0;
+	cache.index_buffer = index_buffer;
+	cache.vertex_buffers[0] = {vertex_buffer, 0, 16};
+	// the second draw's binds are all elided
+	for (u32 i = 0; i < 2; ++i) {
+		blob.write(Instruction::BIND);
+		blob.write(cache);
+		blob.write(Instruction::DRAW_ARRAYS);
+		blob.write(DrawArraysData{0, 3});
+	}
+	blob.write(Instruction::DIRTY_CACHE);
+	blob.write(u32(Dirty::PROGRAM));
+	blob.write(program1);
+	// the second bind of a texture and of an uniform buffer is elided
+	for (u32 i = 0; i < 2; ++i) {
+		blob.write(Instruction::BIND_TEXTURES);
+		blob.write(u32(0));
+		blob.write(u32(1));
+		blob.write(texture);
+	}
+	for (u32 i = 0; i < 2; ++i) {
+		blob.write(Instruction::BIND_UNIFORM_BUFFER);
+		blob.write(BindUniformBufferData{0, index_buffer, 0, 16});
+	}
+	// clear changes the program, so the same program is bound again
+	blob.write(Instruction::CLEAR);
+	blob.write(ClearData{gpu::ClearFlags::COLOR, Vec4(0), 0});
+	blob.write(Instruction::DIRTY_CACHE);
+	blob.write(u32(Dirty::PROGRAM));
+	blob.write(program1);
+	blob.write(Instruction::DRAW_ARRAYS);
+	blob.write(DrawArraysData{0, 3});
+
+	using Type = gpu::null::CommandType;
+	const Type expected[] = {
+		Type::BIND_GROUP, Type::USE_PROGRAM, Type::BIND_INDEX_BUFFER, Type::BIND_VERTEX_BUFFER, Type::BIND_VERTEX_BUFFER,
+		Type::DRAW_ARRAYS,
+		Type::DRAW_ARRAYS,
+		Type::USE_PROGRAM, Type::BIND_TEXTURE, Type::BIND_UNIFORM_BUFFER,
+		Type::CLEAR,
+		Type::USE_PROGRAM, Type::DRAW_ARRAYS
+	};
+	const u32 expected_elided = 7;
+
+	gpu::null::clearRecordedCommands();
+	gpu::null::setRecording(true);
+	InputMemoryStream input(blob);
+	ReplayStats stats;
+	bool res = replay(input, allocator, stats, false);
+	gpu::null::setRecording(false);
+	if (!res) return false;
+
+	Span<const gpu::null::Command> commands = gpu::null::getRecordedCommands();
+	if (commands.length() != lengthOf(expected)) {
+		logError("Draw stream check: expected ", lengthOf(expected), " gpu commands, got ", commands.length());
+		res = false;
+	}
+	for (u32 i = 0, c = minimum(commands.length(), lengthOf(expected)); i < c; ++i) {
+		if (commands[i].type == expected[i]) continue;
+		logError("Draw stream check: gpu command ", i, " is ", (u32)commands[i].type, ", expected ", (u32)expected[i]);
+		res = false;
+	}
+	if (res && (commands[1].args[0] == commands[7].args[0] || commands[7].args[0] != commands[11].args[0])) {
+		logError("Draw stream check: wrong programs are used");
+		res = false;
+	}
+	if (stats.stream_stats.elided != expected_elided) {
+		logError("Draw stream check: expected ", expected_elided, " elided binds, got ", stats.stream_stats.elided);
+		res = false;
+	}
+	gpu::null::clearRecordedCommands();
+	return res;
 }
 
+#else
+
+bool DrawStream::checkBindFiltering(IAllocator& allocator) {
+	logError("Draw stream check needs the null GPU backend (genie --gpu-null)");
+	return false;
+}
+
+#endif
+
 } // namespace Lumix
@@ -8,6 +8,9 @@
 
 namespace Lumix {
 
+struct InputMemoryStream;
+struct OutputMemoryStream;
+
 struct DrawStream {
 	DrawStream(struct Renderer& renderer);
 	DrawStream(DrawStream&& rhs);
@@ -58,8 +61,9 @@ struct DrawStream {
 	
 	void memoryBarrier(gpu::MemoryBarrierType type, gpu::BufferHandle);
 	
-	void copy(gpu::TextureHandle dst, gpu::TextureHandle src, u32 dst_x, u32 dst_y);
+	void copy(gpu::TextureHandle dst, gpu::TextureHandle src, u32 dst_x, u32 dst_y, u32 src_mip = 0);
 	void copy(gpu::BufferHandle dst, gpu::BufferHandle src, u32 dst_offset, u32 src_offset, u32 size);
+	void swap(gpu::TextureHandle a, gpu::TextureHandle b);
 	
 	void readTexture(gpu::TextureHandle texture, u32 mip, Span<u8> buf);
 	void generateMipmaps(gpu::TextureHandle texture);
@@ -75,13 +79,59 @@ struct DrawStream {
 	u8* pushFunction(void (*func)(void*), u32 payload_size);
 	template <typename F> void pushLambda(const F& f);
 
-	void run();
+	struct Stats {
+		// commands passed to gpu::, cached binds are counted separately
+		u32 submitted = 0;
+		// binds skipped because the same state was already bound
+		u32 elided = 0;
+	};
+
+	// captures are CaptureHeader followed by commands serialized by one or more `run`
+	// handles are stored as they are, i.e. as pointers, so they can be replayed only by a build with the same pointer size
+	struct CaptureHeader {
+		static constexpr u32 MAGIC = 'LDSC';
+		// 1 - src_mip in texture copies
+		static constexpr u32 VERSION = 1;
+		u32 magic = MAGIC;
+		u32 version = VERSION;
+		u32 pointer_size = sizeof(void*);
+		u32 padding = 0;
+	};
+
+	struct ReplayStats {
+		static constexpr u32 MAX_COMMANDS = 64;
+		// indexed by command type, see `getCommandName`
+		u32 counts[MAX_COMMANDS] = {};
+		// os::Timer raw ticks, binds include redundant state filtering
+		u64 ticks[MAX_COMMANDS] = {};
+		Stats stream_stats;
+		// pushFunction/pushLambda commands, they are captured only as markers
+		u32 skipped_functions = 0;
+		// objects referenced by the capture but created before it
+		u32 stand_ins = 0;
+	};
+
+	// replays commands to gpu::, redundant binds are skipped
+	// `stats` are accumulated, including substreams
+	// executed commands, including substreams and memory they reference, are appended to `capture` if it's not null
+	void run(Stats* stats = nullptr, OutputMemoryStream* capture = nullptr);
 	void reset();
 	void merge(DrawStream& rhs);
 
+	// runs captured commands against gpu:: on the calling thread, which must be the thread gpu::init was called on
+	// objects created before the capture are replaced by stand-ins, which are meaningful only for the null backend
+	// (e.g. stand-in programs have no shaders), so without `allow_stand_ins` replay fails once it needs one
+	// `blob` must stay alive, replayed commands reference its memory
+	static bool replay(InputMemoryStream& blob, IAllocator& allocator, ReplayStats& stats, bool allow_stand_ins);
+	static const char* getCommandName(u32 type);
+	// replays a known capture with redundant binds and checks which binds reach gpu:: and how many are elided
+	// it needs command recording of the null backend, so it fails in other builds, see app -check_draw_stream
+	static bool checkBindFiltering(IAllocator& allocator);
+
 	struct Page;
 private:
 	enum class Instruction : u8;
+	struct BoundState;
 
 	DrawStream(const DrawStream& rhs) = delete;
 	void operator =(const DrawStream&) = delete;
@@ -89,6 +139,7 @@ private:
 
 	LUMIX_FORCE_INLINE u8* alloc(u32 size);
 	LUMIX_FORCE_INLINE void submitCached();
+	void run(BoundState& state);
 	
 	template <typename T>
 	LUMIX_FORCE_INLINE void write(Instruction instruction, const T& val) {
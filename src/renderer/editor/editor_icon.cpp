@@ -112,8 +112,7 @@ struct EditorIconsImpl final : EditorIcons
 	{
 		World& world = *m_editor.getWorld();
 		
-		const u64 mask = world.getComponentsMask(entity);
-		if (mask & ((u64)1 << (u64)MODEL_INSTANCE_TYPE.index)) return;
+		if (world.hasComponent(entity, MODEL_INSTANCE_TYPE)) return;
 
 		auto& icon = m_icons.insert(entity);
 		icon.entity = entity;
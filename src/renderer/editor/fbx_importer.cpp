@@ -981,6 +981,7 @@ FBXImporter::FBXImporter(StudioApp& app)
 	, m_bones(m_allocator)
 	, m_bind_pose(m_allocator)
 	, m_out_file(m_allocator)
+	, m_lod_chunks(m_allocator)
 	, m_filesystem(app.getEngine().getFileSystem())
 	, m_app(app)
 	, m_material_name_map(m_allocator)
@@ -1981,7 +1982,7 @@ Quat FBXImporter::fixOrientation(const Quat& v) const
 	return Quat(v.x, v.y, v.z, v.w);
 }
 
-void FBXImporter::writeImpostorVertices(float center_y, Vec2 bounding_cylinder)
+void FBXImporter::writeImpostorVertices(OutputMemoryStream& out, float center_y, Vec2 bounding_cylinder)
 {
 	struct Vertex
 	{
@@ -2002,40 +2003,71 @@ void FBXImporter::writeImpostorVertices(float center_y, Vec2 bounding_cylinder)
 	};
 
 	const u32 vertex_data_size = sizeof(vertices);
-	write(vertex_data_size);
+	out.write(vertex_data_size);
 	for (const Vertex& vertex : vertices) {
-		write(vertex.pos);
-		write(vertex.uv);
+		out.write(vertex.pos);
+		out.write(vertex.uv);
 	}
 }
 
 
+template <typename T>
+static void writeIndices(OutputMemoryStream& out, Span<const T> indices, bool are_indices_16_bit) {
+	if (are_indices_16_bit) {
+		const i32 index_size = sizeof(u16);
+		out.write(index_size);
+		out.write((i32)indices.length());
+		for (T i : indices) {
+			ASSERT(i <= (1 << 16));
+			out.write((u16)i);
+		}
+	}
+	else {
+		const i32 index_size = sizeof(u32);
+		out.write(index_size);
+		out.write((i32)indices.length());
+		for (T i : indices) out.write((u32)i);
+	}
+}
+
+
+// see Model::FileVersion::LOD_CHUNKS
+void FBXImporter::writeLODChunks() {
+	u32 chunk_count = 0;
+	for (const OutputMemoryStream& chunk : m_lod_chunks) {
+		if (!chunk.empty()) ++chunk_count;
+	}
+	write(chunk_count);
+
+	u64 offset = m_out_file.size() + chunk_count * (sizeof(u32) + 2 * sizeof(u64));
+	// coarsest first, so a model can be rendered as soon as the first chunk is loaded
+	for (u32 lod = m_lod_chunks.size(); lod > 0; --lod) {
+		const OutputMemoryStream& chunk = m_lod_chunks[lod - 1];
+		if (chunk.empty()) continue;
+		write(lod - 1);
+		write(offset);
+		write((u64)chunk.size());
+		offset += chunk.size();
+	}
+
+	for (u32 lod = m_lod_chunks.size(); lod > 0; --lod) {
+		const OutputMemoryStream& chunk = m_lod_chunks[lod - 1];
+		if (!chunk.empty()) write(chunk.data(), chunk.size());
+	}
+	m_lod_chunks.clear();
+}
+
+
 void FBXImporter::writeGeometry(int mesh_idx, const ImportConfig& cfg)
 {
 	PROFILE_FUNCTION();
-	OutputMemoryStream vertices_blob(m_allocator);
 	const ImportMesh& import_mesh = m_meshes[mesh_idx];
 	
-	bool are_indices_16_bit = areIndices16Bit(import_mesh, cfg);
-	if (are_indices_16_bit)
-	{
-		int index_size = sizeof(u16);
-		write(index_size);
-		write(import_mesh.indices.size());
-		for (int i : import_mesh.indices)
-		{
-			ASSERT(i <= (1 << 16));
-			u16 index = (u16)i;
-			write(index);
-		}
-	}
-	else
-	{
-		int index_size = sizeof(import_mesh.indices[0]);
-		write(index_size);
-		write(import_mesh.indices.size());
-		write(&import_mesh.indices[0], sizeof(import_mesh.indices[0]) * import_mesh.indices.size());
-	}
+	m_lod_chunks.clear();
+	OutputMemoryStream& chunk = m_lod_chunks.emplace(m_allocator);
+	writeIndices(chunk, Span<const u32>(import_mesh.indices.begin(), import_mesh.indices.size()), areIndices16Bit(import_mesh, cfg));
+	chunk.write((i32)import_mesh.vertex_data.size());
+	chunk.write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
 	
 	const Vec3 center = (import_mesh.aabb.max + import_mesh.aabb.min) * 0.5f;
 	float max_center_dist_squared = 0;
@@ -2050,9 +2082,6 @@ void FBXImporter::writeGeometry(int mesh_idx, const ImportConfig& cfg)
 		max_center_dist_squared = maximum(d, max_center_dist_squared);
 	}
 
-	write((i32)import_mesh.vertex_data.size());
-	write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
-
 	write(sqrtf(import_mesh.origin_radius_squared));
 	write(sqrtf(max_center_dist_squared));
 	write(import_mesh.aabb);
@@ -2067,7 +2096,6 @@ void FBXImporter::writeGeometry(const ImportConfig& cfg) {
 	AABB aabb = {{0, 0, 0}, {0, 0, 0}};
 	float origin_radius_squared = 0;
 	float center_radius_squared = 0;
-	OutputMemoryStream vertices_blob(m_allocator);
 
 	Vec2 bounding_cylinder = Vec2(0);
 	for (const ImportMesh& import_mesh : m_meshes) {
@@ -2103,76 +2131,39 @@ void FBXImporter::writeGeometry(const ImportConfig& cfg) {
 		bounding_cylinder.x = sqrtf(bounding_cylinder.x);
 	}
 
+	m_lod_chunks.clear();
+	for (u32 lod = 0; lod < cfg.lod_count; ++lod) m_lod_chunks.emplace(m_allocator);
+
 	for (u32 lod = 0; lod < cfg.lod_count - (cfg.create_impostor ? 1 : 0); ++lod) {
+		OutputMemoryStream& chunk = m_lod_chunks[lod];
 		for (const ImportMesh& import_mesh : m_meshes) {
 			if (!import_mesh.import) continue;
 
 			const bool are_indices_16_bit = areIndices16Bit(import_mesh, cfg);
 			
 			if (import_mesh.lod == lod && !hasAutoLOD(cfg, lod)) { 
-				if (are_indices_16_bit) {
-					const i32 index_size = sizeof(u16);
-					write(index_size);
-					write(import_mesh.indices.size());
-					for (int i : import_mesh.indices)
-					{
-						ASSERT(i <= (1 << 16));
-						u16 index = (u16)i;
-						write(index);
-					}
-				}
-				else {
-					int index_size = sizeof(import_mesh.indices[0]);
-					write(index_size);
-					write(import_mesh.indices.size());
-					write(&import_mesh.indices[0], sizeof(import_mesh.indices[0]) * import_mesh.indices.size());
-				}
+				writeIndices(chunk, Span<const u32>(import_mesh.indices.begin(), import_mesh.indices.size()), are_indices_16_bit);
 			}
 			else if (import_mesh.lod == 0 && hasAutoLOD(cfg, lod)) {
-				const auto& lod_indices = *import_mesh.autolod_indices[lod].get();
-				if (are_indices_16_bit) {
-					const i32 index_size = sizeof(u16);
-					write(index_size);
-					write(lod_indices.size());
-					for (u32 i : lod_indices)
-					{
-						ASSERT(i <= (1 << 16));
-						u16 index = (u16)i;
-						write(index);
-					}
-				}
-				else {
-					i32 index_size = sizeof(lod_indices[0]);
-					write(index_size);
-					write(lod_indices.size());
-					write(lod_indices.begin(), import_mesh.autolod_indices[lod]->byte_size());
-				}
+				const Array<u32>& lod_indices = *import_mesh.autolod_indices[lod].get();
+				writeIndices(chunk, Span<const u32>(lod_indices.begin(), lod_indices.size()), are_indices_16_bit);
+			}
+			else {
+				continue;
 			}
+
+			chunk.write((i32)import_mesh.vertex_data.size());
+			chunk.write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
 		}
 	}
 
 	if (cfg.create_impostor) {
-		const int index_size = sizeof(u16);
-		write(index_size);
+		OutputMemoryStream& chunk = m_lod_chunks[cfg.lod_count - 1];
 		const u16 indices[] = {0, 1, 2, 0, 2, 3};
-		const u32 len = lengthOf(indices);
-		write(len);
-		write(indices, sizeof(indices));
+		writeIndices(chunk, Span<const u16>(indices), true);
+		writeImpostorVertices(chunk, (aabb.max.y + aabb.min.y) * 0.5f, bounding_cylinder);
 	}
 
-	for (u32 lod = 0; lod < cfg.lod_count - (cfg.create_impostor ? 1 : 0); ++lod) {
-		for (const ImportMesh& import_mesh : m_meshes) {
-			if (!import_mesh.import) continue;
-			
-			if ((import_mesh.lod == lod && !hasAutoLOD(cfg, lod)) || (import_mesh.lod == 0 && hasAutoLOD(cfg, lod))) {
-				write((i32)import_mesh.vertex_data.size());
-				write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
-			}
-		}
-	}
-
-	if (cfg.create_impostor) writeImpostorVertices((aabb.max.y + aabb.min.y) * 0.5f, bounding_cylinder);
-
 	if (m_meshes.empty()) {
 		for (const ofbx::Object* bone : m_bones) {
 			const Matrix mtx = toLumix(bone->getGlobalTransform());
@@ -2663,6 +2654,7 @@ bool FBXImporter::writeSubmodels(const Path& src, const ImportConfig& cfg)
 		write(lod_count);
 		write(to_mesh);
 		write(factor);
+		writeLODChunks();
 
 		Path path(name, ".fbx:", src);
 
@@ -2690,6 +2682,7 @@ bool FBXImporter::writeModel(const Path& src, const ImportConfig& cfg)
 	writeGeometry(cfg);
 	writeSkeleton(cfg);
 	writeLODs(cfg);
+	writeLODChunks();
 
 	m_compiler.writeCompiledResource(Path(src), Span(m_out_file.data(), (i32)m_out_file.size()));
 	return true;
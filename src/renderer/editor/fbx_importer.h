@@ -180,13 +180,14 @@ private:
 	void fillSkinInfo(Array<Skin>& skinning, const ImportMesh& mesh) const;
 	Vec3 fixOrientation(const Vec3& v) const;
 	Quat fixOrientation(const Quat& v) const;
-	void writeImpostorVertices(float center_y, Vec2 bounding_cylinder);
+	void writeImpostorVertices(OutputMemoryStream& out, float center_y, Vec2 bounding_cylinder);
 	void writeGeometry(const ImportConfig& cfg);
 	void writeGeometry(int mesh_idx, const ImportConfig& cfg);
 	void writeImpostorMesh(StringView dir, StringView model_name);
 	void writeMeshes(const Path& src, int mesh_idx, const ImportConfig& cfg);
 	void writeSkeleton(const ImportConfig& cfg);
 	void writeLODs(const ImportConfig& cfg);
+	void writeLODChunks();
 	int getAttributeCount(const ImportMesh& mesh, const ImportConfig& cfg) const;
 	bool areIndices16Bit(const ImportMesh& mesh, const ImportConfig& cfg) const;
 	void writeModelHeader();
@@ -214,6 +215,8 @@ private:
 	Array<Matrix> m_bind_pose;
 	ofbx::IScene* m_scene;
 	OutputMemoryStream m_out_file;
+	// geometry of each LOD, written at the end of the model by writeLODChunks
+	Array<OutputMemoryStream> m_lod_chunks;
 	float m_time_scale = 1.0f;
 	float m_fbx_scale = 1.f;
 	Orientation m_orientation = Orientation::Y_UP;
@@ -324,7 +324,7 @@ static void compressBC3(Span<const u8> src, OutputMemoryStream& dst, u32 w, u32
 	});
 }
 
-static void writeLBCHeader(OutputMemoryStream& out, u32 w, u32 h, u32 slices, u32 mips, gpu::TextureFormat format, bool is_3d, bool is_cubemap) {
+static void writeLBCHeader(OutputMemoryStream& out, u32 w, u32 h, u32 slices, u32 mips, gpu::TextureFormat format, bool is_3d, bool is_cubemap, bool tail_first) {
 	LBCHeader header;
 	header.w = w;
 	header.h = h;
@@ -333,9 +333,25 @@ static void writeLBCHeader(OutputMemoryStream& out, u32 w, u32 h, u32 slices, u3
 	header.format = format;
 	if (is_3d) header.flags |= LBCHeader::IS_3D;
 	if (is_cubemap) header.flags |= LBCHeader::CUBEMAP;
+	if (tail_first) header.flags |= LBCHeader::TAIL_FIRST;
 	out.write(header);
 }
 
+// mips are compressed from the biggest one, since each is computed from the previous one, see LBCHeader::TAIL_FIRST
+static void reverseMips(OutputMemoryStream& dst, u64 offset, u32 w, u32 h, u32 mips, gpu::TextureFormat format, IAllocator& allocator) {
+	OutputMemoryStream tmp(allocator);
+	tmp.write(dst.data() + offset, dst.size() - offset);
+	const u8* src = tmp.data();
+	u8* out = dst.getMutableData() + dst.size();
+	for (u32 mip = 0; mip < mips; ++mip) {
+		const u32 mip_size = gpu::getSize(format, maximum(w >> mip, 1), maximum(h >> mip, 1));
+		out -= mip_size;
+		memcpy(out, src, mip_size);
+		src += mip_size;
+	}
+	ASSERT(out == dst.getMutableData() + offset);
+}
+
 static float computeCoverage(Span<const u8> data, u32 w, u32 h, float ref_norm) {
 	const u8 ref = u8(clamp(255 * ref_norm, 0.f, 255.f));
 
@@ -441,12 +457,15 @@ static bool isValid(const Input& src_data, const Options& options) {
 	else if (src_data.has_alpha) format = gpu::TextureFormat::BC3;
 	else format = gpu::TextureFormat::BC1;
 		
-	writeLBCHeader(dst, src_data.w, src_data.h, src_data.slices, mips, format, false, src_data.is_cubemap);
+	// only single 2D textures can be streamed, see TextureStreamer
+	const bool tail_first = src_data.slices == 1 && !src_data.is_cubemap && mips > 1;
+	writeLBCHeader(dst, src_data.w, src_data.h, src_data.slices, mips, format, false, src_data.is_cubemap, tail_first);
+	const u64 data_offset = dst.size();
 
 	if (!can_compress) {
 		compress(compressRGBA, src_data, options, dst, allocator);
 	}
-	if (src_data.is_normalmap) {
+	else if (src_data.is_normalmap) {
 		compress(compressBC5, src_data, options, dst, allocator);
 	}
 	else if (src_data.has_alpha) {
@@ -455,6 +474,7 @@ static bool isValid(const Input& src_data, const Options& options) {
 	else {
 		compress(compressBC1, src_data, options, dst, allocator);
 	}
+	if (tail_first) reverseMips(dst, data_offset, src_data.w, src_data.h, mips, format, allocator);
 	return true;
 }
 
@@ -1770,6 +1790,9 @@ struct TexturePlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin {
 		#endif
 	}
 
+	// 1 - mips of 2D textures are stored from the smallest one, see LBCHeader::TAIL_FIRST
+	u32 getVersion() const override { return 1; }
+
 	bool compile(const Path& src) override {
 		char ext[5] = {};
 		copyString(Span(ext), Path::getExtension(src));
@@ -2642,6 +2665,9 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin {
 		}, &m_subres_signal, 2);			
 	}
 
+	// 2 - geometry is stored in per-LOD chunks, see Model::FileVersion::LOD_CHUNKS
+	u32 getVersion() const override { return 2; }
+
 	bool compile(const Path& src) override {
 		ASSERT(Path::hasExtension(src, "fbx"));
 		Path filepath = Path(Path::getResource(src));
@@ -5282,6 +5308,9 @@ struct StudioAppPlugin : StudioApp::IPlugin
 		if (renderDocOption()) {
 			m_app.addToolAction(&m_renderdoc_capture_action);
 		}
+		m_draw_streams_capture_action.init("Capture draw streams", "Capture draw streams for replay", "capture_draw_streams", "", Action::GLOBAL);
+		m_draw_streams_capture_action.func.bind<&StudioAppPlugin::captureDrawStreams>(this);
+		m_app.addToolAction(&m_draw_streams_capture_action);
 
 		IAllocator& allocator = m_app.getAllocator();
 
@@ -5344,6 +5373,13 @@ struct StudioAppPlugin : StudioApp::IPlugin
 
 	void captureRenderDoc() { gpu::captureRenderDocFrame(); }
 
+	// replay with `app -replay_draw_streams draw_streams.ldc`
+	void captureDrawStreams() {
+		SystemManager& system_manager = m_app.getEngine().getSystemManager();
+		auto* renderer = (Renderer*)system_manager.getSystem("renderer");
+		renderer->captureDrawStreams(Path("draw_streams.ldc"));
+	}
+
 	void showEnvironmentProbeGizmo(WorldView& view, ComponentUID cmp) {
 		RenderModule* module = static_cast<RenderModule*>(cmp.module);
 		const World& world = module->getWorld();
@@ -5530,6 +5566,7 @@ struct StudioAppPlugin : StudioApp::IPlugin
 	~StudioAppPlugin()
 	{
 		m_app.removeAction(&m_renderdoc_capture_action);
+		m_app.removeAction(&m_draw_streams_capture_action);
 
 		AssetBrowser& asset_browser = m_app.getAssetBrowser();
 		asset_browser.removePlugin(m_model_plugin);
@@ -5567,6 +5604,7 @@ struct StudioAppPlugin : StudioApp::IPlugin
 	StudioApp& m_app;
 	FBXImporter m_fbx_importer; // only for preloading impostor shadow shader // TODO do this in a better way
 	Action m_renderdoc_capture_action;
+	Action m_draw_streams_capture_action;
 	UniquePtr<ParticleEditor> m_particle_editor;
 	EditorUIRenderPlugin m_editor_ui_render_plugin;
 	MaterialPlugin m_material_plugin;
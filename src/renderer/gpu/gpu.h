@@ -323,10 +323,13 @@ void dispatch(u32 num_groups_x, u32 num_groups_y, u32 num_groups_z);
 	
 void memoryBarrier(MemoryBarrierType type, BufferHandle);
 	
-void copy(TextureHandle dst, TextureHandle src, u32 dst_x, u32 dst_y);
+// copies mips of `src` starting with `src_mip` to mips of `dst` starting with 0
+void copy(TextureHandle dst, TextureHandle src, u32 dst_x, u32 dst_y, u32 src_mip = 0);
 void copy(BufferHandle dst, BufferHandle src, u32 dst_offset, u32 src_offset, u32 size);
 	
 void readTexture(TextureHandle texture, u32 mip, Span<u8> buf);
+// exchanges GPU objects of `a` and `b`, so a texture can be replaced without updating bind groups referencing it
+void swap(TextureHandle a, TextureHandle b);
 void generateMipmaps(TextureHandle texture);
 void setDebugName(TextureHandle texture, const char* debug_name);
 	
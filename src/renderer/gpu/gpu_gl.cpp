@@ -1225,6 +1225,18 @@ void setDebugName(gpu::TextureHandle texture, const char* debug_name) {
 	#endif
 }
 
+void swap(TextureHandle a, TextureHandle b)
+{
+	checkThread();
+	ASSERT(a);
+	ASSERT(b);
+	Texture tmp = *a;
+	*a = *b;
+	*b = tmp;
+	// `tmp` must not delete the GL texture now owned by `b`
+	tmp.gl_handle = 0;
+}
+
 void generateMipmaps(TextureHandle texture)
 {
 	GPU_PROFILE();
@@ -1556,24 +1568,25 @@ bool init(void* window_handle, InitFlags init_flags)
 bool isOriginBottomLeft() { return true; }
 
 
-void copy(TextureHandle dst, TextureHandle src, u32 dst_x, u32 dst_y) {
+void copy(TextureHandle dst, TextureHandle src, u32 dst_x, u32 dst_y, u32 src_mip) {
 	GPU_PROFILE();
 	checkThread();
 	ASSERT(dst);
 	ASSERT(src);
 	ASSERT(src->target == GL_TEXTURE_2D || src->target == GL_TEXTURE_CUBE_MAP);
 	ASSERT(src->target == dst->target);
+	ASSERT(src_mip == 0 || !u32(src->flags & TextureFlags::NO_MIPS));
 
 	u32 mip = 0;
-	while ((src->width >> mip) != 0 || (src->height >> mip) != 0) {
-		const u32 w = maximum(src->width >> mip, 1);
-		const u32 h = maximum(src->height >> mip, 1);
+	while ((src->width >> (src_mip + mip)) != 0 || (src->height >> (src_mip + mip)) != 0) {
+		const u32 w = maximum(src->width >> (src_mip + mip), 1);
+		const u32 h = maximum(src->height >> (src_mip + mip), 1);
 
 		if (src->target == GL_TEXTURE_CUBE_MAP) {
-			glCopyImageSubData(src->gl_handle, src->target, mip, 0, 0, 0, dst->gl_handle, dst->target, mip, dst_x, dst_y, 0, w, h, 6);
+			glCopyImageSubData(src->gl_handle, src->target, src_mip + mip, 0, 0, 0, dst->gl_handle, dst->target, mip, dst_x, dst_y, 0, w, h, 6);
 		}
 		else {
-			glCopyImageSubData(src->gl_handle, src->target, mip, 0, 0, 0, dst->gl_handle, dst->target, mip, dst_x, dst_y, 0, w, h, 1);
+			glCopyImageSubData(src->gl_handle, src->target, src_mip + mip, 0, 0, 0, dst->gl_handle, dst->target, mip, dst_x, dst_y, 0, w, h, 1);
 		}
 		++mip;
 		if (u32(src->flags & TextureFlags::NO_MIPS)) break;
@@ -1755,8 +1768,11 @@ void setFramebuffer(const TextureHandle* attachments, u32 num, TextureHandle ds,
 void shutdown()
 {
 	GPU_PROFILE();
-	checkThread();
-	destroy(gl->default_program);
+	// without init, e.g. renderer without a GPU device, there's only the state from preinit
+	if (gl->default_program) {
+		checkThread();
+		destroy(gl->default_program);
+	}
 	for (WindowContext& ctx : gl->contexts) {
 		if (!ctx.window_handle) continue;
 		#ifdef _WIN32
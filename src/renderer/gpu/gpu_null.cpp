@@ -0,0 +1,542 @@
+#include "gpu.h"
+#include "gpu_null.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/log.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/profiler.h"
+#include "engine/string.h"
+#include <string.h>
+
+namespace Lumix {
+
+namespace gpu {
+
+struct Buffer {
+	BufferFlags flags = BufferFlags::NONE;
+	size_t size = 0;
+	// host memory returned by `map`, allocated on the first `map`, reallocated if the buffer grows
+	u8* mapped = nullptr;
+	size_t mapped_size = 0;
+	bool created = false;
+};
+
+struct Texture {
+	u32 width = 0;
+	u32 height = 0;
+	u32 depth = 0;
+	TextureFormat format = TextureFormat::RGBA8;
+	TextureFlags flags = TextureFlags::NONE;
+	u64 bytes_size = 0;
+	bool created = false;
+};
+
+struct Program {
+	Program() : decl(PrimitiveType::NONE) {}
+
+	VertexDecl decl;
+	StateFlags state = StateFlags::NONE;
+	bool created = false;
+};
+
+struct BindGroup {};
+
+struct Query {
+	QueryType type;
+	u64 result = 0;
+};
+
+struct NullGPU {
+	NullGPU(IAllocator& allocator)
+		: allocator(allocator, "gpu null")
+		, commands(this->allocator)
+	{}
+
+	TagAllocator allocator;
+	os::ThreadID thread;
+	bool initialized = false;
+	u32 frame = 0;
+	PrimitiveType primitive_type = PrimitiveType::NONE;
+	null::Stats stats;
+	bool recording = false;
+	Array<null::Command> commands;
+	u64 buffer_allocated_mem = 0;
+	u64 texture_allocated_mem = 0;
+	u64 render_target_allocated_mem = 0;
+	// stats at the end of the previous frame, to push per-frame profiler counters
+	u32 prev_draw_calls = 0;
+	u64 prev_primitives = 0;
+};
+
+Local<NullGPU> null_gpu;
+
+static void record(null::CommandType type, u64 a0 = 0, u64 a1 = 0, u64 a2 = 0, u64 a3 = 0) {
+	if (!null_gpu->recording) return;
+	null::Command& cmd = null_gpu->commands.emplace();
+	cmd.type = type;
+	cmd.args[0] = a0;
+	cmd.args[1] = a1;
+	cmd.args[2] = a2;
+	cmd.args[3] = a3;
+}
+
+static u64 toU64(const void* handle) { return (u64)(uintptr_t)handle; }
+
+static void countDraw(u32 count, u32 instances) {
+	++null_gpu->stats.draw_calls;
+	u64 primitives = 0;
+	switch (null_gpu->primitive_type) {
+		case PrimitiveType::TRIANGLES: primitives = count / 3; break;
+		case PrimitiveType::TRIANGLE_STRIP: primitives = count > 2 ? count - 2 : 0; break;
+		case PrimitiveType::LINES: primitives = count / 2; break;
+		case PrimitiveType::POINTS: primitives = count; break;
+		case PrimitiveType::NONE: break;
+	}
+	null_gpu->stats.primitives += primitives * instances;
+}
+
+namespace null {
+
+const Stats& getStats() { return null_gpu->stats; }
+
+void resetStats() {
+	Stats& stats = null_gpu->stats;
+	stats.frames = 0;
+	stats.draw_calls = 0;
+	stats.primitives = 0;
+	stats.dispatches = 0;
+	stats.program_changes = 0;
+	stats.binds = 0;
+	stats.uploaded_bytes = 0;
+	null_gpu->prev_draw_calls = 0;
+	null_gpu->prev_primitives = 0;
+}
+
+void setRecording(bool enable) { null_gpu->recording = enable; }
+Span<const Command> getRecordedCommands() { return null_gpu->commands; }
+void clearRecordedCommands() { null_gpu->commands.clear(); }
+
+} // namespace null
+
+void checkThread() {
+	ASSERT(null_gpu->thread == os::getCurrentThreadID());
+}
+
+void preinit(IAllocator& allocator, bool load_renderdoc) {
+	null_gpu.create(allocator);
+	if (load_renderdoc) logWarning("RenderDoc is not supported by the null GPU backend");
+}
+
+IAllocator& getAllocator() { return null_gpu->allocator; }
+
+bool init(void* window_handle, InitFlags flags) {
+	null_gpu->thread = os::getCurrentThreadID();
+	null_gpu->initialized = true;
+	logInfo("Using null GPU backend, nothing is rendered");
+	return true;
+}
+
+void shutdown() {
+	// init is not called if the renderer runs without a GPU device
+	if (null_gpu->initialized) checkThread();
+	null_gpu->commands.clear();
+	null_gpu.destroy();
+}
+
+void captureRenderDocFrame() {}
+void startCapture() {}
+void stopCapture() {}
+void pushDebugGroup(const char* msg) {}
+void popDebugGroup() {}
+bool isOriginBottomLeft() { return true; }
+void setCurrentWindow(void* window_handle) { checkThread(); }
+
+bool getMemoryStats(MemoryStats& stats) {
+	stats.total_available_mem = 0;
+	stats.current_available_mem = 0;
+	stats.dedicated_vidmem = 0;
+	stats.buffer_mem = null_gpu->buffer_allocated_mem;
+	stats.texture_mem = null_gpu->texture_allocated_mem;
+	stats.render_target_mem = null_gpu->render_target_allocated_mem;
+	return true;
+}
+
+u32 swapBuffers() {
+	checkThread();
+	record(null::CommandType::SWAP_BUFFERS, null_gpu->frame);
+	++null_gpu->frame;
+	++null_gpu->stats.frames;
+
+	static u32 draw_calls_counter = profiler::createCounter("Null GPU draw calls", 0);
+	static u32 primitives_counter = profiler::createCounter("Null GPU primitives (k)", 0);
+	profiler::pushCounter(draw_calls_counter, float(null_gpu->stats.draw_calls - null_gpu->prev_draw_calls));
+	profiler::pushCounter(primitives_counter, float(null_gpu->stats.primitives - null_gpu->prev_primitives) / 1000.f);
+	null_gpu->prev_draw_calls = null_gpu->stats.draw_calls;
+	null_gpu->prev_primitives = null_gpu->stats.primitives;
+	return 0;
+}
+
+bool frameFinished(u32 frame) { return true; }
+void waitFrame(u32 frame) {}
+
+u32 getSize(TextureFormat format, u32 w, u32 h) {
+	switch (format) {
+		case TextureFormat::BC1:
+		case TextureFormat::BC4:
+			return ((w + 3) / 4) * ((h + 3) / 4) * 8;
+		case TextureFormat::BC2:
+		case TextureFormat::BC3:
+		case TextureFormat::BC5:
+			return ((w + 3) / 4) * ((h + 3) / 4) * 16;
+		case TextureFormat::RG8: return 2 * w * h;
+		case TextureFormat::D32:
+		case TextureFormat::D24S8:
+		case TextureFormat::BGRA8:
+		case TextureFormat::RG16:
+		case TextureFormat::RG16F:
+			return 4 * w * h;
+		case TextureFormat::RG32F: return 8 * w * h;
+		case TextureFormat::RGB32F: return 12 * w * h;
+		default: return getBytesPerPixel(format) * w * h;
+	}
+}
+
+TextureHandle allocTextureHandle() { return LUMIX_NEW(null_gpu->allocator, Texture); }
+BufferHandle allocBufferHandle() { return LUMIX_NEW(null_gpu->allocator, Buffer); }
+ProgramHandle allocProgramHandle() { return LUMIX_NEW(null_gpu->allocator, Program); }
+BindGroupHandle allocBindGroupHandle() { return LUMIX_NEW(null_gpu->allocator, BindGroup); }
+
+void createBuffer(BufferHandle buffer, BufferFlags flags, size_t size, const void* data) {
+	checkThread();
+	ASSERT(buffer);
+	if (buffer->created) null_gpu->buffer_allocated_mem -= buffer->size;
+	else ++null_gpu->stats.buffers;
+	buffer->flags = flags;
+	buffer->size = size;
+	buffer->created = true;
+	null_gpu->buffer_allocated_mem += size;
+	if (data) null_gpu->stats.uploaded_bytes += size;
+}
+
+void createTexture(TextureHandle handle, u32 w, u32 h, u32 depth, TextureFormat format, TextureFlags flags, const char* debug_name) {
+	checkThread();
+	ASSERT(handle);
+	ASSERT(debug_name && debug_name[0]);
+	const bool no_mips = u32(flags & TextureFlags::NO_MIPS);
+	const bool is_cubemap = u32(flags & TextureFlags::IS_CUBE);
+	const u32 mip_count = no_mips ? 1 : 1 + log2(maximum(w, h, depth));
+
+	handle->width = w;
+	handle->height = h;
+	handle->depth = depth;
+	handle->format = format;
+	handle->flags = flags;
+	handle->created = true;
+	handle->bytes_size = 0;
+	for (u32 mip = 0; mip < mip_count; ++mip) {
+		const u32 mip_w = maximum(1, w >> mip);
+		const u32 mip_h = maximum(1, h >> mip);
+		handle->bytes_size += getSize(format, mip_w, mip_h) * depth * (is_cubemap ? 6 : 1);
+	}
+	if (u32(flags & TextureFlags::RENDER_TARGET)) {
+		null_gpu->render_target_allocated_mem += handle->bytes_size;
+	}
+	else {
+		null_gpu->texture_allocated_mem += handle->bytes_size;
+	}
+	++null_gpu->stats.textures;
+}
+
+void createTextureView(TextureHandle view, TextureHandle texture, u32 layer) {
+	checkThread();
+	ASSERT(view);
+	ASSERT(texture);
+	if (!view->created) ++null_gpu->stats.textures;
+	view->width = texture->width;
+	view->height = texture->height;
+	view->depth = 1;
+	view->format = texture->format;
+	view->flags = texture->flags;
+	// views do not own memory
+	view->bytes_size = 0;
+	view->created = true;
+}
+
+void createBindGroup(BindGroupHandle group, Span<const BindGroupEntryDesc> descriptors) {
+	checkThread();
+	ASSERT(group);
+	++null_gpu->stats.bind_groups;
+}
+
+void createProgram(ProgramHandle prog, StateFlags state, const VertexDecl& decl, const char** srcs, const ShaderType* types, u32 num, const char** prefixes, u32 prefixes_count, const char* name) {
+	checkThread();
+	ASSERT(prog);
+	prog->decl = decl;
+	prog->state = state;
+	prog->created = true;
+	++null_gpu->stats.programs;
+}
+
+QueryHandle createQuery(QueryType type) {
+	checkThread();
+	Query* query = LUMIX_NEW(null_gpu->allocator, Query);
+	query->type = type;
+	++null_gpu->stats.queries;
+	return query;
+}
+
+void destroy(TextureHandle texture) {
+	checkThread();
+	if (texture->created) {
+		if (u32(texture->flags & TextureFlags::RENDER_TARGET)) {
+			null_gpu->render_target_allocated_mem -= texture->bytes_size;
+		}
+		else {
+			null_gpu->texture_allocated_mem -= texture->bytes_size;
+		}
+		--null_gpu->stats.textures;
+	}
+	LUMIX_DELETE(null_gpu->allocator, texture);
+}
+
+void destroy(BufferHandle buffer) {
+	checkThread();
+	if (buffer->created) {
+		null_gpu->buffer_allocated_mem -= buffer->size;
+		--null_gpu->stats.buffers;
+	}
+	if (buffer->mapped) null_gpu->allocator.deallocate(buffer->mapped);
+	LUMIX_DELETE(null_gpu->allocator, buffer);
+}
+
+void destroy(ProgramHandle program) {
+	checkThread();
+	if (program->created) --null_gpu->stats.programs;
+	LUMIX_DELETE(null_gpu->allocator, program);
+}
+
+void destroy(BindGroupHandle group) {
+	checkThread();
+	--null_gpu->stats.bind_groups;
+	LUMIX_DELETE(null_gpu->allocator, group);
+}
+
+void destroy(QueryHandle query) {
+	checkThread();
+	--null_gpu->stats.queries;
+	LUMIX_DELETE(null_gpu->allocator, query);
+}
+
+void setDebugName(TextureHandle texture, const char* debug_name) {}
+
+void swap(TextureHandle a, TextureHandle b) {
+	checkThread();
+	ASSERT(a);
+	ASSERT(b);
+	Texture tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+void generateMipmaps(TextureHandle texture) { ASSERT(texture); }
+
+void setFramebuffer(const TextureHandle* attachments, u32 num, TextureHandle ds, FramebufferFlags flags) {
+	checkThread();
+	record(null::CommandType::SET_FRAMEBUFFER, num, num > 0 ? toU64(attachments[0]) : 0, toU64(ds), (u64)flags);
+}
+
+void setFramebufferCube(TextureHandle cube, u32 face, u32 mip) {
+	checkThread();
+	record(null::CommandType::SET_FRAMEBUFFER, 1, toU64(cube), face, mip);
+}
+
+void viewport(u32 x, u32 y, u32 w, u32 h) {
+	checkThread();
+	record(null::CommandType::VIEWPORT, x, y, w, h);
+}
+
+void scissor(u32 x, u32 y, u32 w, u32 h) {
+	checkThread();
+	record(null::CommandType::SCISSOR, x, y, w, h);
+}
+
+void clear(ClearFlags flags, const float* color, float depth) {
+	checkThread();
+	// match gl backend, which unbinds program in clear
+	null_gpu->primitive_type = PrimitiveType::NONE;
+	record(null::CommandType::CLEAR, (u64)flags);
+}
+
+void useProgram(ProgramHandle program) {
+	checkThread();
+	null_gpu->primitive_type = program ? program->decl.primitive_type : PrimitiveType::NONE;
+	++null_gpu->stats.program_changes;
+	record(null::CommandType::USE_PROGRAM, toU64(program));
+}
+
+void bind(BindGroupHandle group) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_GROUP, toU64(group));
+}
+
+void bindIndexBuffer(BufferHandle buffer) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_INDEX_BUFFER, toU64(buffer));
+}
+
+void bindVertexBuffer(u32 binding_idx, BufferHandle buffer, u32 buffer_offset, u32 stride) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_VERTEX_BUFFER, binding_idx, toU64(buffer), buffer_offset, stride);
+}
+
+void bindTextures(const TextureHandle* handles, u32 offset, u32 count) {
+	checkThread();
+	null_gpu->stats.binds += count;
+	for (u32 i = 0; i < count; ++i) {
+		record(null::CommandType::BIND_TEXTURE, offset + i, toU64(handles[i]));
+	}
+}
+
+void bindUniformBuffer(u32 ub_index, BufferHandle buffer, size_t offset, size_t size) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_UNIFORM_BUFFER, ub_index, toU64(buffer), offset, size);
+}
+
+void bindIndirectBuffer(BufferHandle buffer) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_INDIRECT_BUFFER, toU64(buffer));
+}
+
+void bindShaderBuffer(BufferHandle buffer, u32 binding_idx, BindShaderBufferFlags flags) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_SHADER_BUFFER, toU64(buffer), binding_idx, (u64)flags);
+}
+
+void bindImageTexture(TextureHandle texture, u32 unit) {
+	checkThread();
+	++null_gpu->stats.binds;
+	record(null::CommandType::BIND_IMAGE_TEXTURE, toU64(texture), unit);
+}
+
+void drawArrays(u32 offset, u32 count) {
+	checkThread();
+	countDraw(count, 1);
+	record(null::CommandType::DRAW_ARRAYS, offset, count);
+}
+
+void drawIndirect(DataType index_type, u32 indirect_buffer_offset) {
+	checkThread();
+	++null_gpu->stats.draw_calls;
+	record(null::CommandType::DRAW_INDIRECT, (u64)index_type, indirect_buffer_offset);
+}
+
+void drawIndexed(u32 offset, u32 count, DataType type) {
+	checkThread();
+	countDraw(count, 1);
+	record(null::CommandType::DRAW_INDEXED, offset, count, (u64)type);
+}
+
+void drawArraysInstanced(u32 indices_count, u32 instances_count) {
+	checkThread();
+	countDraw(indices_count, instances_count);
+	record(null::CommandType::DRAW_ARRAYS_INSTANCED, indices_count, instances_count);
+}
+
+void drawIndexedInstanced(u32 indices_count, u32 instances_count, DataType index_type) {
+	checkThread();
+	countDraw(indices_count, instances_count);
+	record(null::CommandType::DRAW_INDEXED_INSTANCED, indices_count, instances_count, (u64)index_type);
+}
+
+void dispatch(u32 num_groups_x, u32 num_groups_y, u32 num_groups_z) {
+	checkThread();
+	++null_gpu->stats.dispatches;
+	record(null::CommandType::DISPATCH, num_groups_x, num_groups_y, num_groups_z);
+}
+
+void memoryBarrier(MemoryBarrierType type, BufferHandle buffer) {
+	checkThread();
+	record(null::CommandType::MEMORY_BARRIER, (u64)type, toU64(buffer));
+}
+
+void copy(TextureHandle dst, TextureHandle src, u32 dst_x, u32 dst_y, u32 src_mip) {
+	checkThread();
+	record(null::CommandType::COPY_TEXTURE, toU64(dst), toU64(src), dst_x, dst_y);
+}
+
+void copy(BufferHandle dst, BufferHandle src, u32 dst_offset, u32 src_offset, u32 size) {
+	checkThread();
+	record(null::CommandType::COPY_BUFFER, toU64(dst), toU64(src), dst_offset, src_offset);
+}
+
+void readTexture(TextureHandle texture, u32 mip, Span<u8> buf) {
+	checkThread();
+	ASSERT(texture);
+	memset(buf.begin(), 0, buf.length());
+}
+
+void update(TextureHandle texture, u32 mip, u32 x, u32 y, u32 z, u32 w, u32 h, TextureFormat format, const void* buf, u32 size) {
+	checkThread();
+	ASSERT(texture);
+	null_gpu->stats.uploaded_bytes += size;
+	record(null::CommandType::UPDATE_TEXTURE, toU64(texture), mip, size);
+}
+
+void update(BufferHandle buffer, const void* data, size_t size) {
+	checkThread();
+	ASSERT(buffer);
+	ASSERT(size <= buffer->size);
+	null_gpu->stats.uploaded_bytes += size;
+	record(null::CommandType::UPDATE_BUFFER, toU64(buffer), size);
+}
+
+void* map(BufferHandle buffer, size_t size) {
+	checkThread();
+	ASSERT(buffer);
+	ASSERT(u32(buffer->flags & BufferFlags::IMMUTABLE) == 0);
+	ASSERT(size <= buffer->size);
+	// transient and uniform buffers are filled by CPU through `map`, so it must return writable memory
+	if (buffer->mapped_size < buffer->size) {
+		if (buffer->mapped) null_gpu->allocator.deallocate(buffer->mapped);
+		buffer->mapped = (u8*)null_gpu->allocator.allocate(buffer->size, 16);
+		buffer->mapped_size = buffer->size;
+	}
+	null_gpu->stats.uploaded_bytes += size;
+	return buffer->mapped;
+}
+
+void unmap(BufferHandle buffer) {
+	checkThread();
+	ASSERT(buffer);
+}
+
+u64 getQueryFrequency() { return os::Timer::getFrequency(); }
+bool isQueryReady(QueryHandle query) { return true; }
+u64 getQueryResult(QueryHandle query) { return query->result; }
+
+void queryTimestamp(QueryHandle query) {
+	checkThread();
+	query->result = os::Timer::getRawTimestamp();
+}
+
+// STATS queries return number of primitives submitted between begin and end, see `countDraw`
+void beginQuery(QueryHandle query) {
+	checkThread();
+	query->result = null_gpu->stats.primitives;
+}
+
+void endQuery(QueryHandle query) {
+	checkThread();
+	query->result = null_gpu->stats.primitives - query->result;
+}
+
+} // namespace gpu
+
+} // namespace Lumix
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "gpu.h"
+
+
+namespace Lumix {
+
+template <typename T> struct Span;
+
+namespace gpu {
+
+// null backend, built instead of gpu_gl.cpp with `genie --gpu-null`
+// it implements gpu.h without a GPU, objects are only tracked and commands are counted or recorded
+// so the CPU side of the renderer can be profiled and tested without a GPU
+// engine still creates a window, so it needs X (e.g. Xvfb) on linux, except app's -replay_headless
+// everything here must be called on the render thread, i.e. the thread which called gpu::init
+namespace null {
+
+enum class CommandType : u8 {
+	SET_FRAMEBUFFER,
+	VIEWPORT,
+	SCISSOR,
+	CLEAR,
+	USE_PROGRAM,
+	BIND_GROUP,
+	BIND_INDEX_BUFFER,
+	BIND_VERTEX_BUFFER,
+	BIND_TEXTURE,
+	BIND_UNIFORM_BUFFER,
+	BIND_INDIRECT_BUFFER,
+	BIND_SHADER_BUFFER,
+	BIND_IMAGE_TEXTURE,
+	DRAW_ARRAYS,
+	DRAW_INDEXED,
+	DRAW_INDIRECT,
+	DRAW_ARRAYS_INSTANCED,
+	DRAW_INDEXED_INSTANCED,
+	DISPATCH,
+	MEMORY_BARRIER,
+	UPDATE_BUFFER,
+	UPDATE_TEXTURE,
+	COPY_BUFFER,
+	COPY_TEXTURE,
+	SWAP_BUFFERS
+};
+
+// args are command's arguments in declaration order, handles are cast to u64
+// BIND_TEXTURE is recorded once per texture unit, args are unit and texture
+struct Command {
+	CommandType type;
+	u64 args[4];
+};
+
+struct Stats {
+	// reset by `resetStats`
+	u32 frames = 0;
+	u32 draw_calls = 0;
+	u64 primitives = 0; // triangles, lines or points, indirect draws are not included
+	u32 dispatches = 0;
+	u32 program_changes = 0;
+	u32 binds = 0;
+	u64 uploaded_bytes = 0;
+
+	// live objects
+	u32 buffers = 0;
+	u32 textures = 0;
+	u32 programs = 0;
+	u32 bind_groups = 0;
+	u32 queries = 0;
+};
+
+LUMIX_RENDERER_API const Stats& getStats();
+LUMIX_RENDERER_API void resetStats();
+// recording is disabled by default, commands are recorded until `clearRecordedCommands`
+LUMIX_RENDERER_API void setRecording(bool enable);
+LUMIX_RENDERER_API Span<const Command> getRecordedCommands();
+LUMIX_RENDERER_API void clearRecordedCommands();
+
+} // namespace null
+
+} // namespace gpu
+
+} // namespace Lumix
@@ -85,20 +85,26 @@ Mesh::~Mesh() {
 	renderer.freeSortKey(sort_key);
 }
 
-static bool hasAttribute(Mesh& mesh, AttributeSemantic attribute)
+static bool hasAttribute(const AttributeSemantic (&semantics)[gpu::VertexDecl::MAX_ATTRIBUTES], AttributeSemantic attribute)
 {
-	for(const AttributeSemantic& attr : mesh.attributes_semantic) {
+	for(const AttributeSemantic& attr : semantics) {
 		if(attr == attribute) return true;
 	}
 	return false;
 }
 
 
+// not `skin.empty()`, since vertices of LODs which are not resident are not loaded
+static bool hasSkin(const AttributeSemantic (&semantics)[gpu::VertexDecl::MAX_ATTRIBUTES]) {
+	return hasAttribute(semantics, AttributeSemantic::WEIGHTS) && hasAttribute(semantics, AttributeSemantic::INDICES);
+}
+
+
 void Mesh::setMaterial(Material* new_material, Model& model, Renderer& renderer)
 {
 	if (material) material->decRefCount();
 	material = new_material;
-	type = model.getBoneCount() == 0 || skin.empty() ? Mesh::RIGID : Mesh::SKINNED;
+	type = model.getBoneCount() == 0 || !hasSkin(attributes_semantic) ? Mesh::RIGID : Mesh::SKINNED;
 }
 
 
@@ -110,6 +116,8 @@ Model::Model(const Path& path, ResourceManager& resource_manager, Renderer& rend
 	, m_allocator(allocator, m_path.c_str())
 	, m_bone_map(m_allocator)
 	, m_meshes(m_allocator)
+	, m_staging_meshes(m_allocator)
+	, m_stream_staging(m_allocator)
 	, m_bones(m_allocator)
 	, m_first_nonroot_bone_index(0)
 	, m_renderer(renderer)
@@ -159,6 +167,16 @@ static void computeSkinMatrices(const Pose& pose, const Model& model, Matrix* ma
 }
 
 
+u64 Model::getCPUMemorySize() const
+{
+	u64 size = m_bones.byte_size();
+	for (const Mesh& mesh : m_meshes) {
+		size += mesh.indices.size() + mesh.vertices.byte_size() + mesh.skin.byte_size();
+	}
+	return size;
+}
+
+
 bool Model::isSkinned() const
 {
 	ASSERT(isReady());
@@ -180,7 +198,8 @@ RayCastModelHit Model::castRay(const Vec3& origin, const Vec3& dir, const Pose*
 	Matrix matrices[256];
 	ASSERT(!pose || pose->count <= lengthOf(matrices));
 	bool is_skinned = false;
-	for (int mesh_index = m_lod_indices[0].from; mesh_index <= m_lod_indices[0].to; ++mesh_index) {
+	const LODMeshIndices& lod = m_lod_indices[m_first_resident_lod];
+	for (int mesh_index = lod.from; mesh_index <= lod.to; ++mesh_index) {
 		Mesh& mesh = m_meshes[mesh_index];
 		is_skinned = pose && !mesh.skin.empty() && pose->count <= lengthOf(matrices);
 	}
@@ -188,7 +207,7 @@ RayCastModelHit Model::castRay(const Vec3& origin, const Vec3& dir, const Pose*
 		computeSkinMatrices(*pose, *this, matrices);
 	}
 
-	for (int mesh_index = m_lod_indices[0].from; mesh_index <= m_lod_indices[0].to; ++mesh_index) {
+	for (int mesh_index = lod.from; mesh_index <= lod.to; ++mesh_index) {
 		const Mesh& mesh = m_meshes[mesh_index];
 		const bool is_mesh_skinned = !mesh.skin.empty() && is_skinned;
 		const u16* indices16 = (const u16*)mesh.indices.data();
@@ -339,7 +358,7 @@ static bool parseVertexDecl(IInputStream& file, gpu::VertexDecl* vertex_decl, At
 void Model::onBeforeReady()
 {
 	for (Mesh& mesh : m_meshes) {
-		mesh.type = getBoneCount() == 0 || mesh.skin.empty() ? Mesh::RIGID : Mesh::SKINNED;
+		mesh.type = getBoneCount() == 0 || !hasSkin(mesh.attributes_semantic) ? Mesh::RIGID : Mesh::SKINNED;
 		mesh.layer = mesh.material->getLayer();
 	}
 
@@ -428,102 +447,119 @@ int Model::getBoneIdx(const char* name)
 }
 
 
-static int getAttributeOffset(Mesh& mesh, AttributeSemantic attr)
+static int getAttributeOffset(const gpu::VertexDecl& decl, const AttributeSemantic (&semantics)[gpu::VertexDecl::MAX_ATTRIBUTES], AttributeSemantic attr)
 {
-	for (u32 i = 0; i < lengthOf(mesh.attributes_semantic); ++i) {
-		if(mesh.attributes_semantic[i] == attr) {
-			return mesh.vertex_decl.attributes[i].byte_offset;
+	for (u32 i = 0; i < lengthOf(semantics); ++i) {
+		if(semantics[i] == attr) {
+			return decl.attributes[i].byte_offset;
 		}
 	}
 	return -1;
 }
 
 
+Model::StagingMesh::StagingMesh(IAllocator& allocator)
+	: vertex_decl(gpu::PrimitiveType::TRIANGLES)
+	, name(allocator)
+	, indices(allocator)
+	, vertices(allocator)
+	, skin(allocator)
+{
+	for (AttributeSemantic& sem : semantics) sem = AttributeSemantic::NONE;
+}
+
+
+bool Model::parseIndices(InputMemoryStream& file, StagingMesh& mesh) {
+	int index_size;
+	int indices_count;
+	file.read(index_size);
+	if (index_size != 2 && index_size != 4) return false;
+	file.read(indices_count);
+	if (indices_count <= 0) return false;
+	mesh.indices.resize(index_size * indices_count);
+	mesh.indices_count = indices_count;
+	mesh.index_size = index_size;
+	file.read(mesh.indices.getMutableData(), mesh.indices.size());
+	if (file.hasOverflow()) return false;
+
+	const Renderer::MemRef mem = m_renderer.copy(mesh.indices.data(), (u32)mesh.indices.size());
+	mesh.index_memory = mem.data;
+	mesh.index_memory_size = mem.size;
+	return true;
+}
+
+
+bool Model::parseVertices(InputMemoryStream& file, StagingMesh& mesh) {
+	int data_size;
+	file.read(data_size);
+	if (data_size < 0 || mesh.vb_stride == 0) return false;
+	Renderer::MemRef vertices_mem = m_renderer.allocate(data_size);
+	mesh.vertex_memory = vertices_mem.data;
+	mesh.vertex_memory_size = vertices_mem.size;
+	file.read(vertices_mem.data, data_size);
+	if (file.hasOverflow()) return false;
+
+	int position_attribute_offset = getAttributeOffset(mesh.vertex_decl, mesh.semantics, AttributeSemantic::POSITION);
+	int weights_attribute_offset = getAttributeOffset(mesh.vertex_decl, mesh.semantics, AttributeSemantic::WEIGHTS);
+	int bone_indices_attribute_offset = getAttributeOffset(mesh.vertex_decl, mesh.semantics, AttributeSemantic::INDICES);
+	bool keep_skin = hasSkin(mesh.semantics);
+
+	int vertex_size = mesh.vb_stride;
+	int mesh_vertex_count = data_size / vertex_size;
+	mesh.vertices.resize(mesh_vertex_count);
+	if (keep_skin) mesh.skin.resize(mesh_vertex_count);
+	const u8* vertices = (const u8*)vertices_mem.data;
+	for (int j = 0; j < mesh_vertex_count; ++j)
+	{
+		int offset = j * vertex_size;
+		if (keep_skin)
+		{
+			mesh.skin[j].weights = *(const Vec4*)&vertices[offset + weights_attribute_offset];
+			memcpy(mesh.skin[j].indices,
+				&vertices[offset + bone_indices_attribute_offset],
+				sizeof(mesh.skin[j].indices));
+		}
+		mesh.vertices[j] = *(const Vec3*)&vertices[offset + position_attribute_offset];
+	}
+	return true;
+}
+
+
+// runs on a worker thread, must not create meshes, load materials or gpu buffers
 bool Model::parseMeshes(InputMemoryStream& file, FileVersion version)
 {
 	int object_count = 0;
 	file.read(object_count);
+	if (object_count < 0) return false;
 
 	ASSERT(m_meshes.empty());
-	m_meshes.reserve(object_count);
+	ASSERT(m_staging_meshes.empty());
+	m_staging_meshes.reserve(object_count);
 	for (int i = 0; i < object_count; ++i)
 	{
-		gpu::VertexDecl vertex_decl(gpu::PrimitiveType::TRIANGLES);
-		AttributeSemantic semantics[gpu::VertexDecl::MAX_ATTRIBUTES];
-		for(auto& sem : semantics) sem = AttributeSemantic::NONE;
-		u32 vb_stride;
-		if (!parseVertexDecl(file, &vertex_decl, semantics, vb_stride)) return false;
+		StagingMesh& mesh = m_staging_meshes.emplace(m_allocator);
+		if (!parseVertexDecl(file, &mesh.vertex_decl, mesh.semantics, mesh.vb_stride)) return false;
 
 		u32 mat_path_length;
 		file.read(mat_path_length);
 		const void* mat_path_v = file.skip(mat_path_length);
-		StringView mat_path((const char*)mat_path_v, mat_path_length);
-		
-		Material* material = m_resource_manager.getOwner().load<Material>(Path(mat_path));
+		mesh.material = Path(StringView((const char*)mat_path_v, mat_path_length));
 	
 		u32 str_size;
 		file.read(str_size);
 		const void* tmp = file.skip(str_size);
-
-		StringView mesh_name((const char*)tmp, str_size);
-
-		m_meshes.emplace(material, vertex_decl, vb_stride, mesh_name, semantics, m_renderer, m_allocator);
-		addDependency(*material);
+		mesh.name = StringView((const char*)tmp, str_size);
 	}
 
-	for (int i = 0; i < object_count; ++i)
-	{
-		Mesh& mesh = m_meshes[i];
-		int index_size;
-		int indices_count;
-		file.read(index_size);
-		if (index_size != 2 && index_size != 4) return false;
-		file.read(indices_count);
-		if (indices_count <= 0) return false;
-		mesh.indices.resize(index_size * indices_count);
-		mesh.indices_count = indices_count;
-		file.read(mesh.indices.getMutableData(), mesh.indices.size());
-
-		if (index_size == 2) mesh.flags |= Mesh::Flags::INDICES_16_BIT;
-		const Renderer::MemRef mem = m_renderer.copy(mesh.indices.data(), (u32)mesh.indices.size());
-		mesh.index_buffer_handle = m_renderer.createBuffer(mem, gpu::BufferFlags::IMMUTABLE);
-		mesh.index_type = index_size == 2 ? gpu::DataType::U16 : gpu::DataType::U32;
-		if (!mesh.index_buffer_handle) return false;
-	}
-
-	for (int i = 0; i < object_count; ++i)
-	{
-		Mesh& mesh = m_meshes[i];
-		int data_size;
-		file.read(data_size);
-		Renderer::MemRef vertices_mem = m_renderer.allocate(data_size);
-		file.read(vertices_mem.data, data_size);
-
-		int position_attribute_offset = getAttributeOffset(mesh, AttributeSemantic::POSITION);
-		int weights_attribute_offset = getAttributeOffset(mesh, AttributeSemantic::WEIGHTS);
-		int bone_indices_attribute_offset = getAttributeOffset(mesh, AttributeSemantic::INDICES);
-		bool keep_skin = hasAttribute(mesh, AttributeSemantic::WEIGHTS) && hasAttribute(mesh, AttributeSemantic::INDICES);
-
-		int vertex_size = mesh.vb_stride;
-		int mesh_vertex_count = data_size / vertex_size;
-		mesh.vertices.resize(mesh_vertex_count);
-		if (keep_skin) mesh.skin.resize(mesh_vertex_count);
-		const u8* vertices = (const u8*)vertices_mem.data;
-		for (int j = 0; j < mesh_vertex_count; ++j)
-		{
-			int offset = j * vertex_size;
-			if (keep_skin)
-			{
-				mesh.skin[j].weights = *(const Vec4*)&vertices[offset + weights_attribute_offset];
-				memcpy(mesh.skin[j].indices,
-					&vertices[offset + bone_indices_attribute_offset],
-					sizeof(mesh.skin[j].indices));
-			}
-			mesh.vertices[j] = *(const Vec3*)&vertices[offset + position_attribute_offset];
+	if (version <= FileVersion::LOD_CHUNKS) {
+		for (StagingMesh& mesh : m_staging_meshes) {
+			if (!parseIndices(file, mesh)) return false;
+		}
+		for (StagingMesh& mesh : m_staging_meshes) {
+			if (!parseVertices(file, mesh)) return false;
 		}
-		mesh.vertex_buffer_handle = m_renderer.createBuffer(vertices_mem, gpu::BufferFlags::IMMUTABLE);
-		if (!mesh.vertex_buffer_handle) return false;
 	}
+
 	file.read(m_origin_bounding_radius);
 	file.read(m_center_bounding_radius);
 	file.read(m_aabb);
@@ -553,7 +589,56 @@ bool Model::parseLODs(InputMemoryStream& file)
 }
 
 
-bool Model::load(Span<const u8> mem)
+bool Model::parseLODChunkTable(InputMemoryStream& file)
+{
+	m_lod_chunk_table_offset = file.getPosition();
+	u32 chunk_count;
+	file.read(chunk_count);
+	if (chunk_count > lengthOf(m_lod_chunks)) return false;
+
+	for (LODChunk& chunk : m_lod_chunks) chunk = {};
+	for (u32 i = 0; i < chunk_count; ++i) {
+		u32 lod;
+		file.read(lod);
+		if (lod >= lengthOf(m_lod_chunks)) return false;
+		file.read(m_lod_chunks[lod].offset);
+		file.read(m_lod_chunks[lod].size);
+	}
+	return !file.hasOverflow();
+}
+
+
+// parses geometry of LODs in [from_lod, to_lod) into `meshes`
+bool Model::parseLODChunks(Span<const u8> content, u32 from_lod, u32 to_lod, Span<StagingMesh> meshes)
+{
+	for (u32 lod = from_lod; lod < to_lod; ++lod) {
+		const LODMeshIndices& indices = m_lod_indices[lod];
+		if (indices.from > indices.to) continue;
+
+		const LODChunk& chunk = m_lod_chunks[lod];
+		if (chunk.size == 0 || chunk.offset + chunk.size > content.length()) return false;
+
+		InputMemoryStream file(content.begin() + chunk.offset, chunk.size);
+		for (i32 i = indices.from; i <= indices.to; ++i) {
+			if (!parseIndices(file, meshes[i])) return false;
+			if (!parseVertices(file, meshes[i])) return false;
+		}
+	}
+	return true;
+}
+
+
+u32 Model::getCoarsestLOD() const
+{
+	u32 lod = 0;
+	for (u32 i = 0; i < lengthOf(m_lod_indices); ++i) {
+		if (m_lod_indices[i].from <= m_lod_indices[i].to) lod = i;
+	}
+	return lod;
+}
+
+
+bool Model::prepare(Span<const u8> mem)
 {
 	PROFILE_FUNCTION();
 	FileHeader header;
@@ -576,19 +661,240 @@ bool Model::load(Span<const u8> mem)
 		file.read(m_root_motion_bone);
 	}
 
-	if (parseMeshes(file, (FileVersion)header.version)
-		&& parseBones(file)
-		&& parseLODs(file))
+	if (!parseMeshes(file, (FileVersion)header.version)
+		|| !parseBones(file)
+		|| !parseLODs(file))
 	{
-		return true;
+		return false;
 	}
 
-	return false;
+	m_first_resident_lod = 0;
+	if (header.version <= (u32)FileVersion::LOD_CHUNKS) return true;
+
+	if (!parseLODChunkTable(file)) return false;
+	// finer LODs are loaded later, see ModelStreamer
+	if (m_renderer.getModelStreamer().isEnabled()) m_first_resident_lod = getCoarsestLOD();
+	return parseLODChunks(mem, m_first_resident_lod, lengthOf(m_lod_indices), m_staging_meshes);
+}
+
+
+bool Model::finalize()
+{
+	PROFILE_FUNCTION();
+	ASSERT(m_meshes.empty());
+	m_meshes.reserve(m_staging_meshes.size());
+	for (StagingMesh& staging : m_staging_meshes) {
+		Material* material = m_resource_manager.getOwner().load<Material>(staging.material);
+		Mesh& mesh = m_meshes.emplace(material, staging.vertex_decl, staging.vb_stride, staging.name, staging.semantics, m_renderer, m_allocator);
+		addDependency(*material);
+
+		mesh.indices_count = 0;
+		// geometry of LODs which are not resident is not loaded
+		if (staging.index_memory) createBuffers(mesh, staging);
+	}
+	m_staging_meshes.clear();
+
+	for (u32 lod = m_first_resident_lod; lod < lengthOf(m_lod_indices); ++lod) {
+		for (i32 i = m_lod_indices[lod].from; i <= m_lod_indices[lod].to; ++i) {
+			if (!m_meshes[i].index_buffer_handle || !m_meshes[i].vertex_buffer_handle) return false;
+		}
+	}
+
+	if (m_first_resident_lod > 0) m_renderer.getModelStreamer().add(*this);
+	return true;
+}
+
+
+void Model::createBuffers(Mesh& mesh, StagingMesh& staging)
+{
+	mesh.indices = static_cast<OutputMemoryStream&&>(staging.indices);
+	mesh.indices_count = staging.indices_count;
+	mesh.vertices = staging.vertices.move();
+	mesh.skin = staging.skin.move();
+	if (staging.index_size == 2) mesh.flags |= Mesh::Flags::INDICES_16_BIT;
+	mesh.index_type = staging.index_size == 2 ? gpu::DataType::U16 : gpu::DataType::U32;
+
+	Renderer::MemRef mem;
+	mem.own = true;
+	mem.data = staging.index_memory;
+	mem.size = staging.index_memory_size;
+	m_gpu_size += mem.size + staging.vertex_memory_size;
+	staging.index_memory = nullptr;
+	mesh.index_buffer_handle = m_renderer.createBuffer(mem, gpu::BufferFlags::IMMUTABLE);
+
+	mem.data = staging.vertex_memory;
+	mem.size = staging.vertex_memory_size;
+	staging.vertex_memory = nullptr;
+	mesh.vertex_buffer_handle = m_renderer.createBuffer(mem, gpu::BufferFlags::IMMUTABLE);
+}
+
+
+void Model::requestLOD(u32 lod)
+{
+	if (m_streamer_idx < 0) return;
+
+	for (;;) {
+		const i32 prev = m_requested_lod;
+		if (prev <= (i32)lod) return;
+		if (m_requested_lod.compareExchange((i32)lod, prev)) return;
+	}
+}
+
+
+// drops LODs finer than `lod`
+void Model::evictTo(u32 lod)
+{
+	ASSERT(!m_stream_op.isValid());
+	DrawStream& stream = m_renderer.getEndFrameDrawStream();
+	for (u32 i = m_first_resident_lod; i < lod; ++i) {
+		for (i32 j = m_lod_indices[i].from; j <= m_lod_indices[i].to; ++j) {
+			Mesh& mesh = m_meshes[j];
+			m_gpu_size -= mesh.indices.size() + mesh.vertices.size() * mesh.vb_stride;
+			if (mesh.index_buffer_handle) stream.destroy(mesh.index_buffer_handle);
+			if (mesh.vertex_buffer_handle) stream.destroy(mesh.vertex_buffer_handle);
+			mesh.index_buffer_handle = gpu::INVALID_BUFFER;
+			mesh.vertex_buffer_handle = gpu::INVALID_BUFFER;
+			mesh.indices.clear();
+			mesh.indices_count = 0;
+			mesh.vertices.clear();
+			mesh.skin.clear();
+		}
+	}
+	m_first_resident_lod = lod;
+	updateMemorySize();
+}
+
+
+void Model::streamTo(u32 lod)
+{
+	ASSERT(!m_stream_op.isValid());
+	ASSERT(lod < m_first_resident_lod);
+	m_streaming_lod = lod;
+	m_stream_staging.clear();
+	m_stream_staging.reserve(m_meshes.size());
+	for (const Mesh& mesh : m_meshes) {
+		StagingMesh& staging = m_stream_staging.emplace(m_allocator);
+		staging.vertex_decl = mesh.vertex_decl;
+		staging.vb_stride = mesh.vb_stride;
+		memcpy(staging.semantics, mesh.attributes_semantic, sizeof(staging.semantics));
+	}
+
+	FileSystem& fs = m_resource_manager.getOwner().getFileSystem();
+	const Path res_path(".lumix/resources/", m_path.getHash(), ".res");
+	m_stream_op = fs.getPreparedContent(res_path
+		, makeDelegate<&Model::streamPrepare>(this)
+		, makeDelegate<&Model::streamLoaded>(this)
+		, FileSystem::Priority::LOW);
+}
+
+
+// runs on a worker thread, decompresses only chunks up to the end of `m_streaming_lod`'s chunk
+void Model::streamPrepare(Span<const u8> mem)
+{
+	m_stream_failed = true;
+
+	u64 needed_size = 0;
+	for (u32 lod = m_streaming_lod; lod < m_first_resident_lod; ++lod) {
+		needed_size = maximum(needed_size, m_lod_chunks[lod].offset + m_lod_chunks[lod].size);
+	}
+	OutputMemoryStream content(m_allocator);
+	if (!decompressCompiledResource(mem, needed_size, content, m_allocator)) return;
+	if (content.size() != needed_size) return;
+
+	// the file could change since the model was loaded
+	InputMemoryStream file(content);
+	FileHeader header;
+	file.read(header);
+	if (header.magic != FILE_MAGIC || header.version <= (u32)FileVersion::LOD_CHUNKS) return;
+	file.setPosition(m_lod_chunk_table_offset);
+	u32 chunk_count;
+	file.read(chunk_count);
+	for (u32 i = 0; i < chunk_count; ++i) {
+		u32 lod;
+		u64 offset, size;
+		file.read(lod);
+		file.read(offset);
+		file.read(size);
+		if (file.hasOverflow() || lod >= lengthOf(m_lod_chunks)) return;
+		if (m_lod_chunks[lod].offset != offset || m_lod_chunks[lod].size != size) return;
+	}
+
+	if (!parseLODChunks(Span(content.data(), (u32)content.size()), m_streaming_lod, m_first_resident_lod, m_stream_staging)) return;
+	m_stream_failed = false;
+}
+
+
+void Model::streamLoaded(Span<const u8> mem, bool success)
+{
+	m_stream_op = FileSystem::AsyncHandle::invalid();
+	const u64 prev_size = m_gpu_size;
+	if (success && !m_stream_failed) {
+		for (u32 lod = m_streaming_lod; lod < m_first_resident_lod; ++lod) {
+			for (i32 i = m_lod_indices[lod].from; i <= m_lod_indices[lod].to; ++i) {
+				createBuffers(m_meshes[i], m_stream_staging[i]);
+			}
+		}
+		m_first_resident_lod = m_streaming_lod;
+	}
+	else {
+		// do not retry until the model is reloaded
+		m_stream_failed = true;
+		logWarning("Failed to stream model ", getPath());
+	}
+	freeStaging(m_stream_staging);
+	m_stream_staging.clear();
+	updateMemorySize();
+	m_renderer.getModelStreamer().onStreamed(*this, prev_size);
+}
+
+
+bool Model::load(Span<const u8> mem)
+{
+	return prepare(mem) && finalize();
+}
+
+
+void Model::freeStaging()
+{
+	freeStaging(m_staging_meshes);
+	m_staging_meshes.clear();
+}
+
+
+void Model::freeStaging(Span<StagingMesh> meshes)
+{
+	for (StagingMesh& staging : meshes) {
+		Renderer::MemRef mem;
+		mem.own = true;
+		if (staging.index_memory) {
+			mem.data = staging.index_memory;
+			mem.size = staging.index_memory_size;
+			m_renderer.free(mem);
+			staging.index_memory = nullptr;
+		}
+		if (staging.vertex_memory) {
+			mem.data = staging.vertex_memory;
+			mem.size = staging.vertex_memory_size;
+			m_renderer.free(mem);
+			staging.vertex_memory = nullptr;
+		}
+	}
 }
 
 
 void Model::unload()
 {
+	if (isStreamed()) m_renderer.getModelStreamer().remove(*this);
+	if (m_stream_op.isValid()) {
+		m_resource_manager.getOwner().getFileSystem().cancel(m_stream_op);
+		m_stream_op = FileSystem::AsyncHandle::invalid();
+	}
+	freeStaging(m_stream_staging);
+	m_stream_staging.clear();
+	m_stream_failed = false;
+	m_first_resident_lod = 0;
+	freeStaging();
+
 	for (int i = 0; i < m_meshes.size(); ++i) {
 		removeDependency(*m_meshes[i].material);
 		m_meshes[i].material->decRefCount();
@@ -603,6 +909,102 @@ void Model::unload()
 	}
 	m_meshes.clear();
 	m_bones.clear();
+	m_bone_map.clear();
+	m_gpu_size = 0;
+}
+
+
+ModelStreamer::ModelStreamer(IAllocator& allocator)
+	: m_models(allocator)
+	, m_to_load(allocator)
+{}
+
+
+void ModelStreamer::add(Model& model) {
+	ASSERT(model.m_streamer_idx < 0);
+	model.m_streamer_idx = m_models.size();
+	model.m_requested_lod = Model::NO_LOD_REQUEST;
+	model.m_wanted_lod = model.m_first_resident_lod;
+	model.m_wanted_frame = m_frame;
+	model.m_stream_requested = false;
+	m_models.push(&model);
+	m_stats.resident_bytes += model.m_gpu_size;
+}
+
+
+void ModelStreamer::remove(Model& model) {
+	ASSERT(m_models[model.m_streamer_idx] == &model);
+	if (model.m_stream_op.isValid()) --m_stats.pending;
+	m_stats.resident_bytes -= model.m_gpu_size;
+	m_models.back()->m_streamer_idx = model.m_streamer_idx;
+	m_models.swapAndPop(model.m_streamer_idx);
+	model.m_streamer_idx = -1;
+}
+
+
+void ModelStreamer::onStreamed(Model& model, u64 prev_size) {
+	ASSERT(m_stats.pending > 0);
+	--m_stats.pending;
+	m_stats.resident_bytes -= prev_size;
+	m_stats.resident_bytes += model.m_gpu_size;
+}
+
+
+void ModelStreamer::update() {
+	PROFILE_FUNCTION();
+	static constexpr u32 MAX_PENDING = 4;
+
+	++m_frame;
+	m_stats.models = m_models.size();
+
+	m_to_load.clear();
+	for (Model* model : m_models) {
+		const u32 coarsest_lod = model->getCoarsestLOD();
+		const i32 requested = model->m_requested_lod;
+		model->m_requested_lod = Model::NO_LOD_REQUEST;
+		if (requested != Model::NO_LOD_REQUEST) {
+			const u32 lod = minimum(u32(requested), coarsest_lod);
+			model->m_stream_requested = true;
+			// requests oscillate, e.g. with camera movement, keep the finest LOD for a while
+			if (lod <= model->m_wanted_lod || m_frame - model->m_wanted_frame > m_evict_frames) {
+				model->m_wanted_lod = lod;
+				model->m_wanted_frame = m_frame;
+			}
+		}
+		else if (m_frame - model->m_wanted_frame > m_evict_frames) {
+			// models never requested by renderer, e.g. used only for raycasts, are kept fully loaded
+			model->m_wanted_lod = model->m_stream_requested ? coarsest_lod : 0;
+		}
+
+		if (model->m_stream_op.isValid() || model->m_stream_failed) continue;
+
+		if (model->m_wanted_lod > model->m_first_resident_lod) {
+			const u64 prev_size = model->m_gpu_size;
+			model->evictTo(model->m_wanted_lod);
+			m_stats.resident_bytes -= prev_size - model->m_gpu_size;
+		}
+		else if (model->m_wanted_lod < model->m_first_resident_lod) {
+			m_to_load.push(model);
+		}
+	}
+
+	// the most missing LODs first
+	qsort(m_to_load.begin(), m_to_load.size(), sizeof(m_to_load[0]), [](const void* a, const void* b){
+		const Model* ma = *(const Model**)a;
+		const Model* mb = *(const Model**)b;
+		const i32 da = i32(ma->m_first_resident_lod - ma->m_wanted_lod);
+		const i32 db = i32(mb->m_first_resident_lod - mb->m_wanted_lod);
+		return db - da;
+	});
+
+	for (Model* model : m_to_load) {
+		if (m_stats.pending >= MAX_PENDING) break;
+		model->streamTo(model->m_wanted_lod);
+		++m_stats.pending;
+	}
+
+	static const u32 resident_counter = profiler::createCounter("Model streaming resident (MB)", 0);
+	profiler::pushCounter(resident_counter, float(double(m_stats.resident_bytes) / (1024.0 * 1024.0)));
 }
 
 
@@ -3,6 +3,7 @@
 
 #include "engine/allocators.h"
 #include "engine/array.h"
+#include "engine/atomic.h"
 #include "engine/geometry.h"
 #include "engine/hash.h"
 #include "engine/hash_map.h"
@@ -134,6 +135,10 @@ public:
 	enum class FileVersion : u32
 	{
 		ROOT_MOTION_BONE,
+		// versions after this one store geometry in per-LOD chunks after LODs, coarsest first, see ModelStreamer
+		// layout: u32 chunk_count, {u32 lod, u64 offset, u64 size}[chunk_count], chunks
+		// chunk: {i32 index_size, i32 indices_count, indices, i32 vertices_size, vertices} for each mesh of the LOD
+		LOD_CHUNKS,
 
 		LATEST // keep this last
 	};
@@ -161,6 +166,8 @@ public:
 	Model(const Path& path, ResourceManager& resource_manager, Renderer& renderer, IAllocator& allocator);
 
 	ResourceType getType() const override { return TYPE; }
+	u64 getCPUMemorySize() const override;
+	u64 getGPUMemorySize() const override { return m_gpu_size; }
 
 	u32 getLODMeshIndices(float squared_distance) const {
 		if (squared_distance < m_lod_distances[0]) return 0;
@@ -190,6 +197,12 @@ public:
 	const float* getLODDistances() const { return m_lod_distances; }
 	float* getLODDistances() { return m_lod_distances; }
 	const LODMeshIndices* getLODIndices() const { return m_lod_indices; }
+	// called from render jobs, finer LODs of streamed models are loaded only when requested
+	void requestLOD(u32 lod);
+	bool isLODResident(u32 lod) const { return lod >= m_first_resident_lod; }
+	// `lod` if it's resident, otherwise the closest coarser LOD, which is always resident
+	u32 getResidentLOD(u32 lod) const { return maximum(lod, m_first_resident_lod); }
+	bool isStreamed() const { return m_streamer_idx >= 0; }
 	Vec3 evalVertexPose(const Pose& pose, u32 mesh, u32 index) const;
 	BoneNameHash getRootMotionBone() const { return m_root_motion_bone; }
 
@@ -197,21 +210,68 @@ public:
 	static constexpr u32 MAX_LOD_COUNT = 4;
 
 private:
+	friend struct ModelStreamer;
+
+	static constexpr i32 NO_LOD_REQUEST = 0xff;
+
+	struct LODChunk {
+		// offset in file content
+		u64 offset = 0;
+		u64 size = 0;
+	};
+
 	Model(const Model&);
 	void operator=(const Model&);
 
+	// mesh data parsed by `prepare` on a worker thread, `finalize` creates the actual `Mesh` from it
+	struct StagingMesh {
+		StagingMesh(IAllocator& allocator);
+
+		gpu::VertexDecl vertex_decl;
+		AttributeSemantic semantics[gpu::VertexDecl::MAX_ATTRIBUTES];
+		u32 vb_stride = 0;
+		Path material;
+		String name;
+		OutputMemoryStream indices;
+		u32 indices_count = 0;
+		u32 index_size = 0;
+		Array<Vec3> vertices;
+		Array<Mesh::Skin> skin;
+		// allocated by renderer, gpu buffers are created from these in `finalize`
+		void* index_memory = nullptr;
+		u32 index_memory_size = 0;
+		void* vertex_memory = nullptr;
+		u32 vertex_memory_size = 0;
+	};
+
 	bool parseBones(InputMemoryStream& file);
 	bool parseMeshes(InputMemoryStream& file, FileVersion version);
+	bool parseIndices(InputMemoryStream& file, StagingMesh& mesh);
+	bool parseVertices(InputMemoryStream& file, StagingMesh& mesh);
 	bool parseLODs(InputMemoryStream& file);
+	bool parseLODChunkTable(InputMemoryStream& file);
+	bool parseLODChunks(Span<const u8> content, u32 from_lod, u32 to_lod, Span<StagingMesh> meshes);
+	void createBuffers(Mesh& mesh, StagingMesh& staging);
 	int getBoneIdx(const char* name);
+	void freeStaging();
+	void freeStaging(Span<StagingMesh> meshes);
+	u32 getCoarsestLOD() const;
+	void evictTo(u32 lod);
+	void streamTo(u32 lod);
+	void streamPrepare(Span<const u8> mem);
+	void streamLoaded(Span<const u8> mem, bool success);
 
 	void unload() override;
 	bool load(Span<const u8> mem) override;
+	bool isPrepareSupported() const override { return true; }
+	bool prepare(Span<const u8> mem) override;
+	bool finalize() override;
 
 private:
 	TagAllocator m_allocator;
 	Renderer& m_renderer;
 	Array<Mesh> m_meshes;
+	Array<StagingMesh> m_staging_meshes;
 	Array<Bone> m_bones;
 	LODMeshIndices m_lod_indices[MAX_LOD_COUNT + 1];
 	float m_lod_distances[MAX_LOD_COUNT];
@@ -221,6 +281,61 @@ private:
 	AABB m_aabb;
 	BoneNameHash m_root_motion_bone;
 	int m_first_nonroot_bone_index;
+	// size of vertex and index buffers
+	u64 m_gpu_size = 0;
+
+	// LOD streaming, written by ModelStreamer on the main thread, except `m_requested_lod`
+	// resident LODs are always `m_first_resident_lod` and all coarser LODs
+	LODChunk m_lod_chunks[MAX_LOD_COUNT + 1];
+	u64 m_lod_chunk_table_offset = 0;
+	u32 m_first_resident_lod = 0;
+	i32 m_streamer_idx = -1;
+	AtomicI32 m_requested_lod = NO_LOD_REQUEST;
+	u32 m_wanted_lod = 0;
+	u32 m_wanted_frame = 0;
+	// requested at least once, models nobody requests (e.g. used only by physics) are streamed in fully
+	bool m_stream_requested = false;
+	u32 m_streaming_lod = 0;
+	FileSystem::AsyncHandle m_stream_op = FileSystem::AsyncHandle::invalid();
+	// all meshes, but only those of streamed LODs are filled
+	Array<StagingMesh> m_stream_staging;
+	bool m_stream_failed = false;
+};
+
+// keeps resident only LODs of models requested by renderer, see Model::requestLOD
+// models start with only the coarsest LOD, finer LODs are loaded on request and evicted when unused for a while
+struct LUMIX_RENDERER_API ModelStreamer {
+	struct Stats {
+		// GPU memory of streamed models
+		u64 resident_bytes = 0;
+		u32 models = 0;
+		u32 pending = 0;
+	};
+
+	explicit ModelStreamer(IAllocator& allocator);
+
+	// affects only models loaded afterwards
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() const { return m_enabled; }
+	// LODs not requested for this many frames are evicted
+	void setEvictFrames(u32 frames) { m_evict_frames = frames; }
+	const Stats& getStats() const { return m_stats; }
+	// called once per frame on the main thread
+	void update();
+
+private:
+	friend struct Model;
+
+	void add(Model& model);
+	void remove(Model& model);
+	void onStreamed(Model& model, u64 prev_size);
+
+	Array<Model*> m_models;
+	Array<Model*> m_to_load;
+	Stats m_stats;
+	bool m_enabled = false;
+	u32 m_evict_frames = 300;
+	u32 m_frame = 0;
 };
 
 
@@ -0,0 +1,365 @@
+#include "occlusion_culler.h"
+#include "engine/allocator.h"
+#include "engine/array.h"
+#include "engine/atomic.h"
+#include "engine/crt.h"
+#include "engine/geometry.h"
+#include "engine/job_system.h"
+#include "engine/math.h"
+#include "engine/profiler.h"
+#include "engine/simd.h"
+
+
+namespace Lumix
+{
+
+struct OcclusionCullerImpl final : OcclusionCuller {
+	// tiles are rasterized in parallel, each by a single worker
+	static constexpr u32 TILE_SIZE = 32;
+	static constexpr u32 TILES_X = WIDTH / TILE_SIZE;
+	static constexpr u32 TILES_Y = HEIGHT / TILE_SIZE;
+	static constexpr u32 TILE_COUNT = TILES_X * TILES_Y;
+	// hierarchical depth, one value per block, tested by `isVisible`
+	static constexpr u32 BLOCK_SIZE = 8;
+	static constexpr u32 BLOCKS_X = WIDTH / BLOCK_SIZE;
+	static constexpr u32 BLOCKS_Y = HEIGHT / BLOCK_SIZE;
+
+	static_assert(WIDTH % TILE_SIZE == 0 && HEIGHT % TILE_SIZE == 0);
+	static_assert(TILE_SIZE % BLOCK_SIZE == 0 && BLOCK_SIZE % 4 == 0);
+
+	struct Occluder {
+		Matrix mtx;
+		Span<const Vec3> vertices;
+		const void* indices;
+		u32 indices_count;
+		bool indices16;
+	};
+
+	// screen space setup, value = a * x + b * y + c
+	struct Triangle {
+		// edge functions, all are non-negative inside the triangle
+		float ea[3], eb[3], ec[3];
+		// z / w
+		float da, db, dc;
+		// pixel bounds, inclusive
+		i32 min_x, min_y, max_x, max_y;
+	};
+
+	struct BinEntry {
+		u32 tile;
+		u32 triangle;
+	};
+
+	// written by a single worker in the binning pass, read by all in the raster pass
+	struct Bins {
+		Bins(IAllocator& allocator)
+			: triangles(allocator)
+			, entries(allocator)
+			, tile_triangles(allocator)
+			, clip(allocator)
+		{}
+
+		Array<Triangle> triangles;
+		Array<BinEntry> entries;
+		// `entries` sorted by tile, tile `i` has tile_triangles[offsets[i]..offsets[i + 1]]
+		Array<u32> tile_triangles;
+		u32 offsets[TILE_COUNT + 1];
+		// clip space vertices of the current occluder
+		Array<Vec4> clip;
+	};
+
+	OcclusionCullerImpl(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_occluders(allocator)
+		, m_bins(allocator)
+	{}
+
+	void begin() override {
+		m_occluders.clear();
+		m_triangle_count = 0;
+		m_is_empty = true;
+	}
+
+	bool addOccluder(const Matrix& mtx, Span<const Vec3> vertices, const void* indices, u32 indices_count, bool indices16) override {
+		const u32 triangle_count = indices_count / 3;
+		if (m_triangle_count + triangle_count > MAX_TRIANGLES) return false;
+
+		m_triangle_count += triangle_count;
+		m_occluders.push({mtx, vertices, indices, indices_count, indices16});
+		return true;
+	}
+
+	u32 getTriangleCount() const override { return m_triangle_count; }
+
+	void setupTriangle(const Vec4& c0, const Vec4& c1, const Vec4& c2, Bins& bins) {
+		Vec3 s[3];
+		const Vec4* clip[] = { &c0, &c1, &c2 };
+		for (u32 i = 0; i < 3; ++i) {
+			const Vec4& c = *clip[i];
+			const float inv_w = 1 / c.w;
+			s[i].x = (c.x * inv_w * 0.5f + 0.5f) * WIDTH;
+			s[i].y = (0.5f - c.y * inv_w * 0.5f) * HEIGHT;
+			s[i].z = c.z * inv_w;
+		}
+
+		float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[2].x - s[0].x) * (s[1].y - s[0].y);
+		if (area == 0) return;
+		if (area < 0) {
+			swap(s[1], s[2]);
+			area = -area;
+		}
+
+		const float min_x = minimum(s[0].x, s[1].x, s[2].x);
+		const float min_y = minimum(s[0].y, s[1].y, s[2].y);
+		const float max_x = maximum(s[0].x, s[1].x, s[2].x);
+		const float max_y = maximum(s[0].y, s[1].y, s[2].y);
+		if (max_x < 0 || max_y < 0 || min_x >= WIDTH || min_y >= HEIGHT) return;
+
+		Triangle& tri = bins.triangles.emplace();
+		tri.min_x = (i32)maximum(min_x, 0.f);
+		tri.min_y = (i32)maximum(min_y, 0.f);
+		tri.max_x = (i32)minimum(max_x, float(WIDTH - 1));
+		tri.max_y = (i32)minimum(max_y, float(HEIGHT - 1));
+
+		const float inv_area = 1 / area;
+		tri.da = tri.db = tri.dc = 0;
+		for (u32 i = 0; i < 3; ++i) {
+			const Vec3& a = s[(i + 1) % 3];
+			const Vec3& b = s[(i + 2) % 3];
+			tri.ea[i] = a.y - b.y;
+			tri.eb[i] = b.x - a.x;
+			tri.ec[i] = -(tri.ea[i] * a.x + tri.eb[i] * a.y);
+			// barycentric interpolation of depth
+			tri.da += tri.ea[i] * s[i].z * inv_area;
+			tri.db += tri.eb[i] * s[i].z * inv_area;
+			tri.dc += tri.ec[i] * s[i].z * inv_area;
+		}
+
+		const u32 tri_idx = bins.triangles.size() - 1;
+		for (u32 ty = tri.min_y / TILE_SIZE; ty <= tri.max_y / TILE_SIZE; ++ty) {
+			for (u32 tx = tri.min_x / TILE_SIZE; tx <= tri.max_x / TILE_SIZE; ++tx) {
+				bins.entries.push({ty * TILES_X + tx, tri_idx});
+			}
+		}
+	}
+
+	// clips the triangle by the near plane, i.e. w - z >= 0 for reversed z
+	void clipTriangle(const Vec4 (&tri)[3], Bins& bins) {
+		float dist[3];
+		u32 inside_count = 0;
+		for (u32 i = 0; i < 3; ++i) {
+			dist[i] = tri[i].w - tri[i].z;
+			if (dist[i] >= 0) ++inside_count;
+		}
+		if (inside_count == 0) return;
+		if (inside_count == 3) {
+			setupTriangle(tri[0], tri[1], tri[2], bins);
+			return;
+		}
+
+		Vec4 poly[4];
+		u32 count = 0;
+		for (u32 i = 0; i < 3; ++i) {
+			const u32 j = (i + 1) % 3;
+			if (dist[i] >= 0) poly[count++] = tri[i];
+			if ((dist[i] >= 0) != (dist[j] >= 0)) {
+				const float t = dist[i] / (dist[i] - dist[j]);
+				poly[count++] = tri[i] + (tri[j] - tri[i]) * t;
+			}
+		}
+		for (u32 i = 2; i < count; ++i) {
+			setupTriangle(poly[0], poly[i - 1], poly[i], bins);
+		}
+	}
+
+	void binOccluder(const Occluder& occluder, Bins& bins) {
+		const u32 vertex_count = occluder.vertices.length();
+		bins.clip.resize(vertex_count);
+		for (u32 i = 0; i < vertex_count; ++i) {
+			bins.clip[i] = occluder.mtx * Vec4(occluder.vertices[i], 1);
+		}
+
+		const u16* indices16 = (const u16*)occluder.indices;
+		const u32* indices32 = (const u32*)occluder.indices;
+		for (u32 i = 0; i + 2 < occluder.indices_count; i += 3) {
+			Vec4 tri[3];
+			for (u32 j = 0; j < 3; ++j) {
+				const u32 idx = occluder.indices16 ? indices16[i + j] : indices32[i + j];
+				ASSERT(idx < vertex_count);
+				tri[j] = bins.clip[idx];
+			}
+			// trivially outside of the screen
+			if (tri[0].x > tri[0].w && tri[1].x > tri[1].w && tri[2].x > tri[2].w) continue;
+			if (tri[0].x < -tri[0].w && tri[1].x < -tri[1].w && tri[2].x < -tri[2].w) continue;
+			if (tri[0].y > tri[0].w && tri[1].y > tri[1].w && tri[2].y > tri[2].w) continue;
+			if (tri[0].y < -tri[0].w && tri[1].y < -tri[1].w && tri[2].y < -tri[2].w) continue;
+			clipTriangle(tri, bins);
+		}
+	}
+
+	// counting sort of `bins.entries` by tile
+	static void sortByTile(Bins& bins) {
+		memset(bins.offsets, 0, sizeof(bins.offsets));
+		for (const BinEntry& entry : bins.entries) ++bins.offsets[entry.tile + 1];
+		for (u32 i = 0; i < TILE_COUNT; ++i) bins.offsets[i + 1] += bins.offsets[i];
+
+		u32 cursors[TILE_COUNT];
+		memcpy(cursors, bins.offsets, sizeof(cursors));
+		bins.tile_triangles.resize(bins.entries.size());
+		for (const BinEntry& entry : bins.entries) {
+			bins.tile_triangles[cursors[entry.tile]++] = entry.triangle;
+		}
+	}
+
+	// only pixels in [x0, x1) x [y0, y1) are written
+	void rasterizeTriangle(const Triangle& tri, i32 x0, i32 y0, i32 x1, i32 y1) {
+		alignas(16) static const float lanes[] = { 0.5f, 1.5f, 2.5f, 3.5f };
+		const i32 min_x = maximum(tri.min_x, x0) & ~3;
+		const i32 min_y = maximum(tri.min_y, y0);
+		const i32 max_x = minimum(tri.max_x, x1 - 1);
+		const i32 max_y = minimum(tri.max_y, y1 - 1);
+
+		const float4 lane = f4Load(lanes);
+		const float4 zero = f4Splat(0);
+		const float4 ea0 = f4Splat(tri.ea[0]), ea1 = f4Splat(tri.ea[1]), ea2 = f4Splat(tri.ea[2]);
+		const float4 da = f4Splat(tri.da);
+
+		for (i32 y = min_y; y <= max_y; ++y) {
+			const float py = y + 0.5f;
+			const float4 row_e0 = f4Splat(tri.eb[0] * py + tri.ec[0]);
+			const float4 row_e1 = f4Splat(tri.eb[1] * py + tri.ec[1]);
+			const float4 row_e2 = f4Splat(tri.eb[2] * py + tri.ec[2]);
+			const float4 row_d = f4Splat(tri.db * py + tri.dc);
+			float* LUMIX_RESTRICT row = m_depth + y * WIDTH;
+
+			for (i32 x = min_x; x <= max_x; x += 4) {
+				const float4 px = f4Splat((float)x) + lane;
+				const float4 e0 = ea0 * px + row_e0;
+				const float4 e1 = ea1 * px + row_e1;
+				const float4 e2 = ea2 * px + row_e2;
+				// pixels on an edge shared by two triangles are inside both, so there are no holes
+				const float4 outside = f4CmpLT(f4Min(e0, f4Min(e1, e2)), zero);
+				const float4 depth = da * px + row_d;
+				const float4 prev = f4Load(row + x);
+				f4Store(row + x, f4Blend(f4Max(prev, depth), prev, outside));
+			}
+		}
+	}
+
+	void rasterizeTile(u32 tile) {
+		const i32 x0 = (tile % TILES_X) * TILE_SIZE;
+		const i32 y0 = (tile / TILES_X) * TILE_SIZE;
+		const i32 x1 = x0 + TILE_SIZE;
+		const i32 y1 = y0 + TILE_SIZE;
+
+		for (i32 y = y0; y < y1; ++y) {
+			memset(m_depth + y * WIDTH + x0, 0, TILE_SIZE * sizeof(float));
+		}
+
+		for (const Bins& bins : m_bins) {
+			for (u32 i = bins.offsets[tile], end = bins.offsets[tile + 1]; i < end; ++i) {
+				rasterizeTriangle(bins.triangles[bins.tile_triangles[i]], x0, y0, x1, y1);
+			}
+		}
+
+		// the farthest depth in each block
+		for (i32 by = y0 / BLOCK_SIZE; by < y1 / (i32)BLOCK_SIZE; ++by) {
+			for (i32 bx = x0 / BLOCK_SIZE; bx < x1 / (i32)BLOCK_SIZE; ++bx) {
+				float4 min = f4Splat(FLT_MAX);
+				for (u32 y = 0; y < BLOCK_SIZE; ++y) {
+					const float* row = m_depth + (by * BLOCK_SIZE + y) * WIDTH + bx * BLOCK_SIZE;
+					for (u32 x = 0; x < BLOCK_SIZE; x += 4) {
+						min = f4Min(min, f4Load(row + x));
+					}
+				}
+				m_blocks[by * BLOCKS_X + bx] = minimum(minimum(f4GetX(min), f4GetY(min)), minimum(f4GetZ(min), f4GetW(min)));
+			}
+		}
+	}
+
+	void rasterize() override {
+		PROFILE_FUNCTION();
+		profiler::pushInt("triangles", m_triangle_count);
+		m_is_empty = m_occluders.empty();
+		if (m_is_empty) return;
+
+		const u32 workers_count = jobs::getWorkersCount();
+		while ((u32)m_bins.size() < workers_count) m_bins.emplace(m_allocator);
+
+		AtomicI32 worker_idx = 0;
+		AtomicI32 occluder_idx = 0;
+		jobs::runOnWorkers([&](){
+			PROFILE_BLOCK("bin occluders");
+			Bins& bins = m_bins[worker_idx.inc()];
+			bins.triangles.clear();
+			bins.entries.clear();
+			for (;;) {
+				const i32 idx = occluder_idx.inc();
+				if (idx >= m_occluders.size()) break;
+				binOccluder(m_occluders[idx], bins);
+			}
+			sortByTile(bins);
+		});
+
+		AtomicI32 tile_idx = 0;
+		jobs::runOnWorkers([&](){
+			PROFILE_BLOCK("rasterize tiles");
+			for (;;) {
+				const i32 idx = tile_idx.inc();
+				if (idx >= (i32)TILE_COUNT) break;
+				rasterizeTile(idx);
+			}
+		});
+	}
+
+	bool isVisible(const Matrix& mtx, const AABB& aabb) const override {
+		if (m_is_empty) return true;
+
+		float min_x = FLT_MAX, min_y = FLT_MAX;
+		float max_x = -FLT_MAX, max_y = -FLT_MAX;
+		float max_depth = 0;
+		for (u32 i = 0; i < 8; ++i) {
+			const Vec3 corner(i & 1 ? aabb.max.x : aabb.min.x, i & 2 ? aabb.max.y : aabb.min.y, i & 4 ? aabb.max.z : aabb.min.z);
+			const Vec4 clip = mtx * Vec4(corner, 1);
+			// crosses the near plane
+			if (clip.w <= 0 || clip.w - clip.z < 0) return true;
+
+			const float inv_w = 1 / clip.w;
+			const float x = (clip.x * inv_w * 0.5f + 0.5f) * WIDTH;
+			const float y = (0.5f - clip.y * inv_w * 0.5f) * HEIGHT;
+			min_x = minimum(min_x, x);
+			min_y = minimum(min_y, y);
+			max_x = maximum(max_x, x);
+			max_y = maximum(max_y, y);
+			max_depth = maximum(max_depth, clip.z * inv_w);
+		}
+		if (max_x < 0 || max_y < 0 || min_x >= WIDTH || min_y >= HEIGHT) return true;
+
+		const u32 bx0 = u32(maximum(min_x, 0.f)) / BLOCK_SIZE;
+		const u32 by0 = u32(maximum(min_y, 0.f)) / BLOCK_SIZE;
+		const u32 bx1 = u32(minimum(max_x, float(WIDTH - 1))) / BLOCK_SIZE;
+		const u32 by1 = u32(minimum(max_y, float(HEIGHT - 1))) / BLOCK_SIZE;
+		for (u32 by = by0; by <= by1; ++by) {
+			for (u32 bx = bx0; bx <= bx1; ++bx) {
+				if (m_blocks[by * BLOCKS_X + bx] <= max_depth) return true;
+			}
+		}
+		return false;
+	}
+
+	IAllocator& m_allocator;
+	Array<Occluder> m_occluders;
+	Array<Bins> m_bins;
+	u32 m_triangle_count = 0;
+	// nothing was rasterized, everything is visible
+	bool m_is_empty = true;
+	alignas(16) float m_depth[WIDTH * HEIGHT];
+	float m_blocks[BLOCKS_X * BLOCKS_Y];
+};
+
+
+UniquePtr<OcclusionCuller> OcclusionCuller::create(IAllocator& allocator) {
+	return UniquePtr<OcclusionCullerImpl>::create(allocator, allocator);
+}
+
+} // namespace Lumix
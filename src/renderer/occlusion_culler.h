@@ -0,0 +1,43 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+template <typename T> struct Span;
+template <typename T> struct UniquePtr;
+struct AABB;
+struct IAllocator;
+struct Matrix;
+struct Vec3;
+
+// CPU software occlusion culling
+// occluders are rasterized to a small depth buffer, bounds of other objects are tested against maximal depth of 8x8 pixel blocks
+// it does not need gpu, so it can be used e.g. for visibility queries on a headless server
+// matrices are clip-from-model with reversed z, as all Lumix projections, depth is z / w, i.e. bigger is closer
+// usage: `begin`, `addOccluder`, `rasterize`, then `isVisible` from any number of threads
+struct LUMIX_RENDERER_API OcclusionCuller {
+	static constexpr u32 WIDTH = 256;
+	static constexpr u32 HEIGHT = 128;
+	// occluders over budget are ignored, so add the most important (e.g. the closest) first
+	static constexpr u32 MAX_TRIANGLES = 64 * 1024;
+
+	static UniquePtr<OcclusionCuller> create(IAllocator& allocator);
+
+	virtual ~OcclusionCuller() {}
+
+	virtual void begin() = 0;
+	// geometry is not copied, it must be alive until `rasterize` returns
+	// returns false if the triangle budget is exhausted
+	virtual bool addOccluder(const Matrix& mtx, Span<const Vec3> vertices, const void* indices, u32 indices_count, bool indices16) = 0;
+	// transforms and bins occluder triangles to tiles, then rasterizes tiles, both on all workers
+	virtual void rasterize() = 0;
+	// false if `aabb` is completely hidden behind occluders
+	virtual bool isVisible(const Matrix& mtx, const AABB& aabb) const = 0;
+	virtual u32 getTriangleCount() const = 0;
+};
+
+} // namespace Lumix
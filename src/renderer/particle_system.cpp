@@ -646,15 +646,18 @@ void ParticleSystem::run(RunningContext& ctx) {
 				Model* model = render_module->getModelInstanceModel(*m_entity);
 				if (!model || !model->isReady()) return;
 
-				u32 mesh_idx = 0; // TODO random mesh
+				// finest resident LOD, see ModelStreamer
+				u32 mesh_idx = model->getLODIndices()[model->getResidentLOD(0)].from; // TODO random mesh
 				if (mesh_idx >= (u32)model->getMeshCount()) return;
 				
 				const Mesh& mesh = model->getMesh(mesh_idx);
+				if (mesh.vertices.empty()) return;
 				if (getConstValue(index) < 0) {
 					getValue(index) = (float)rand(0, mesh.vertices.size() - 1);
 				}
 
 				const u32 idx = u32(getConstValue(index) + 0.5f);
+				if (idx >= (u32)mesh.vertices.size()) return;
 				if (model->getBoneCount() > 0) {
 					ModelInstance* mi = render_module->getModelInstance(*m_entity);
 					if (!mi->pose) return;
@@ -25,6 +25,7 @@
 #include "font.h"
 #include "material.h"
 #include "model.h"
+#include "occlusion_culler.h"
 #include "particle_system.h"
 #include "pipeline.h"
 #include "pose.h"
@@ -51,6 +52,8 @@ static constexpr u32 SORT_VALUE_TYPE_MASK = (1 << 5) - 1;
 static constexpr u64 SORT_KEY_BUCKET_SHIFT = 56;
 static constexpr u64 SORT_KEY_INSTANCED_FLAG = (u64)1 << 55;
 static constexpr u64 SORT_KEY_INSTANCER_SHIFT = 16;
+// instancer index of groups from StaticDrawList
+static constexpr u32 STATIC_DRAW_LIST_INSTANCER = 0xffFF;
 static constexpr u64 SORT_KEY_MESH_IDX_SHIFT = 40;
 static constexpr u64 SORT_KEY_EMITTER_SHIFT = 40;
 
@@ -360,6 +363,21 @@ struct ShadowAtlas {
 static const float SHADOW_CAM_FAR = 500.0f;
 
 
+// see TextureStreamer
+static void requestTextureMips(const Material& material, u32 screen_size_log2) {
+	for (i32 i = 0, c = material.getTextureCount(); i < c; ++i) {
+		Texture* texture = material.getTexture(i);
+		if (texture) texture->requestScreenSize(screen_size_log2);
+	}
+}
+
+// log2 of size in pixels of an object with bounding `radius`, `screen_size_scale` is computed in createSortKeys
+static u32 getScreenSizeLog2(float radius, float squared_distance, float screen_size_scale, bool is_ortho) {
+	const float distance = is_ortho ? 1.f : maximum(sqrtf(squared_distance), 1e-3f);
+	return log2(u32(minimum(radius * screen_size_scale / distance, 65536.f)) + 1);
+}
+
+
 ResourceType PipelineResource::TYPE("pipeline");
 
 
@@ -658,7 +676,216 @@ struct PipelineImpl final : Pipeline
 		Page* first_page = nullptr;
 		PageAllocator& page_allocator;
 	};
-	
+
+	// autoinstancing groups of unmoved meshes with settled LOD, kept across frames for each `cull` call of the pipeline
+	// each frame only instances which entered or left the view, or whose LOD changed, are patched,
+	// the rest is just validated and the instance data are refilled, since they are relative to camera
+	struct StaticDrawList {
+		static constexpr u32 MAX_ENTRY_GROUPS = 8;
+
+		struct Entry {
+			Model* model;
+			const Mesh* meshes;
+			DVec3 pos;
+			// LOD is not reevaluated until the LOD reference point travels this far, see `travel`
+			double travel_limit;
+			u32 frame;
+			u8 lod;
+			u8 wanted_lod;
+			u8 screen_size_log2;
+			u8 group_count;
+			u16 groups[MAX_ENTRY_GROUPS];
+		};
+
+		struct Change {
+			EntityRef entity;
+			Entry entry;
+		};
+
+		struct Group {
+			Group(IAllocator& allocator) : entities(allocator) {}
+
+			const Mesh* mesh;
+			Model* model;
+			u32 sort_key;
+			Array<EntityRef> entities;
+			// requests to streamers are repeated every frame, aggregated over all entities
+			u8 wanted_lod;
+			u8 screen_size_log2;
+			bool dirty = false;
+			Renderer::TransientSlice slice;
+		};
+
+		StaticDrawList(IAllocator& allocator)
+			: entries(allocator)
+			, groups(allocator)
+			, sort_key_to_group(allocator)
+		{}
+
+		void clear() {
+			entries.clear();
+			groups.clear();
+			sort_key_to_group.clear();
+			travel = 0;
+		}
+
+		// clears the list if anything but the culled set could have changed since the last frame
+		void begin(u32 frame_number, const u32 (&map)[255], bool shadow, float lod_mult, float screen_scale, const DVec3& ref_point, const Mesh** sort_key_to_mesh) {
+			bool valid = frame_number == frame + 1
+				&& shadow == is_shadow
+				&& lod_mult == lod_multiplier
+				&& screen_scale == screen_size_scale
+				&& memcmp(map, bucket_map, sizeof(bucket_map)) == 0;
+			for (const Group& group : groups) {
+				// mesh was destroyed and its sort key reused
+				valid = valid && sort_key_to_mesh[group.sort_key] == group.mesh;
+			}
+
+			if (valid) {
+				travel += length(ref_point - lod_ref_point);
+			}
+			else {
+				clear();
+				memcpy(bucket_map, map, sizeof(bucket_map));
+				is_shadow = shadow;
+				lod_multiplier = lod_mult;
+				screen_size_scale = screen_scale;
+			}
+			lod_ref_point = ref_point;
+			frame = frame_number;
+		}
+
+		// called from workers, true if `e` is still in the list
+		bool keep(EntityRef e, const ModelInstance& mi, const DVec3& pos) {
+			if (mi.flags & ModelInstance::MOVED) return false;
+			auto iter = entries.find(e);
+			if (!iter.isValid()) return false;
+
+			Entry& entry = iter.value();
+			if (entry.model != mi.model || entry.meshes != mi.meshes) return false;
+			if (entry.pos.x != pos.x || entry.pos.y != pos.y || entry.pos.z != pos.z) return false;
+			if (mi.lod != entry.lod || entry.lod != mi.model->getResidentLOD(entry.wanted_lod)) return false;
+			if (travel > entry.travel_limit) return false;
+
+			entry.frame = frame;
+			return true;
+		}
+
+		Group& getGroup(const Mesh& mesh, Model* model, u16& group_idx) {
+			auto iter = sort_key_to_group.find(mesh.sort_key);
+			if (iter.isValid()) {
+				group_idx = iter.value();
+				Group& group = groups[group_idx];
+				if (group.mesh != &mesh) {
+					// previous mesh with the same sort key was destroyed, so all its instances were already removed
+					ASSERT(group.entities.empty());
+					group.mesh = &mesh;
+					group.model = model;
+				}
+				return group;
+			}
+
+			group_idx = (u16)groups.size();
+			sort_key_to_group.insert(mesh.sort_key, group_idx);
+			Group& group = groups.emplace(groups.getAllocator());
+			group.mesh = &mesh;
+			group.model = model;
+			group.sort_key = mesh.sort_key;
+			return group;
+		}
+
+		static void merge(Group& group, const Entry& entry) {
+			group.wanted_lod = minimum(group.wanted_lod, entry.wanted_lod);
+			group.screen_size_log2 = maximum(group.screen_size_log2, entry.screen_size_log2);
+		}
+
+		// applies changes collected by workers, `changes` are instances which are not in the list or need to be reevaluated
+		// returns number of instances which were added or removed
+		u32 update(Span<const Array<Change>> changes) {
+			PROFILE_FUNCTION();
+			Array<const Change*> added(groups.getAllocator());
+			for (const Array<Change>& worker_changes : changes) {
+				for (const Change& change : worker_changes) {
+					auto iter = entries.find(change.entity);
+					if (iter.isValid()) {
+						Entry& entry = iter.value();
+						if (entry.model == change.entry.model && entry.meshes == change.entry.meshes && entry.lod == change.entry.lod) {
+							// only LOD distance changed, groups are the same
+							u16 tmp[MAX_ENTRY_GROUPS];
+							const u8 group_count = entry.group_count;
+							memcpy(tmp, entry.groups, sizeof(tmp));
+							entry = change.entry;
+							entry.group_count = group_count;
+							memcpy(entry.groups, tmp, sizeof(tmp));
+							for (u32 i = 0; i < group_count; ++i) merge(groups[tmp[i]], entry);
+							continue;
+						}
+					}
+					added.push(&change);
+				}
+			}
+
+			u32 removed_count = 0;
+			for (auto iter = entries.begin(), end = entries.end(); iter != end; ++iter) {
+				const Entry& entry = iter.value();
+				if (entry.frame == frame) continue;
+				for (u32 i = 0; i < entry.group_count; ++i) groups[entry.groups[i]].dirty = true;
+				++removed_count;
+			}
+			if (removed_count > 0) {
+				const u32 f = frame;
+				entries.eraseIf([f](const Entry& entry){ return entry.frame != f; });
+			}
+
+			for (Group& group : groups) {
+				if (!group.dirty) continue;
+				group.dirty = false;
+				group.wanted_lod = 0xff;
+				group.screen_size_log2 = 0;
+				for (i32 i = group.entities.size() - 1; i >= 0; --i) {
+					auto iter = entries.find(group.entities[i]);
+					if (iter.isValid()) merge(group, iter.value());
+					else group.entities.swapAndPop(i);
+				}
+			}
+
+			for (const Change* change : added) {
+				Entry entry = change->entry;
+				entry.group_count = 0;
+				const LODMeshIndices& lod = entry.model->getLODIndices()[entry.lod];
+				for (i32 mesh_idx = lod.from; mesh_idx <= lod.to; ++mesh_idx) {
+					const Mesh& mesh = entry.meshes[mesh_idx];
+					if (bucket_map[mesh.layer] >= 0xff) continue;
+
+					Group& group = getGroup(mesh, entry.model, entry.groups[entry.group_count]);
+					++entry.group_count;
+					if (group.entities.empty()) {
+						group.wanted_lod = 0xff;
+						group.screen_size_log2 = 0;
+					}
+					group.entities.push(change->entity);
+					merge(group, entry);
+				}
+				entries.insert(change->entity, entry);
+			}
+
+			return added.size() + removed_count;
+		}
+
+		HashMap<EntityRef, Entry> entries;
+		Array<Group> groups;
+		HashMap<u32, u16> sort_key_to_group;
+		u32 bucket_map[255];
+		bool is_shadow = false;
+		float lod_multiplier = 0;
+		float screen_size_scale = 0;
+		DVec3 lod_ref_point;
+		// distance the LOD reference point traveled since the list was created
+		double travel = 0;
+		u32 frame = 0xffFFffFF;
+		AtomicI32 busy = 0;
+	};
+
 	struct View {
 		View(LinearAllocator& allocator, PageAllocator& page_allocator) 
 			: sorter(allocator, page_allocator)
@@ -674,6 +901,8 @@ struct PipelineImpl final : Pipeline
 		Array<AutoInstancer> instancers;
 		Sorter sorter;
 		CullResult* renderables = nullptr;
+		StaticDrawList* static_draw_list = nullptr;
+		u32 frame_number;
 		CameraParams cp;
 		u8 layer_to_bucket[255];
 		jobs::Signal ready;
@@ -706,6 +935,7 @@ struct PipelineImpl final : Pipeline
 		, m_textures(m_allocator)
 		, m_buffers(m_allocator)
 		, m_views(m_allocator)
+		, m_static_draw_lists(m_allocator)
 		, m_render_states(m_allocator)
 		, m_base_vertex_decl(gpu::PrimitiveType::TRIANGLES)
 		, m_base_line_vertex_decl(gpu::PrimitiveType::LINES)
@@ -1440,6 +1670,7 @@ struct PipelineImpl final : Pipeline
 		RenderModule* module = world ? (RenderModule*)world->getModule("renderer") : nullptr;
 		if (m_module == module) return;
 		m_module = module;
+		m_static_draw_lists.clear();
 		if (m_lua_state && m_module) callInitModule();
 	}
 	
@@ -1810,11 +2041,12 @@ struct PipelineImpl final : Pipeline
 				for (const Terrain::GrassType& type : terrain->m_grass_types) {
 					if (!type.m_grass_model || !type.m_grass_model->isReady()) continue;
 
-					const i32 to_mesh = type.m_grass_model->getLODIndices()[0].to;
+					type.m_grass_model->requestLOD(0);
+					const LODMeshIndices& lod = type.m_grass_model->getLODIndices()[type.m_grass_model->getResidentLOD(0)];
 					const HashMap<u64, Terrain::GrassQuad>& quads = type.m_quads;
 					if (quads.empty()) continue;
 
-					for (i32 i = 0; i <= to_mesh; ++i) {
+					for (i32 i = lod.from; i <= lod.to; ++i) {
 						const Mesh& mesh = type.m_grass_model->getMesh(i);
 
 						Shader* shader = mesh.material->getShader();
@@ -2386,6 +2618,9 @@ struct PipelineImpl final : Pipeline
 			const InstancedModel& im = iter.value();
 			Model* m = im.model;
 			if (!m || !m->isReady()) continue;
+			// LODs are selected on GPU, so all of them must be resident
+			m->requestLOD(0);
+			if (!m->isLODResident(0)) continue;
 
 			auto getDrawDistance = [](const Model& model) {
 				const LODMeshIndices* lod_indices = model.getLODIndices();
@@ -2571,7 +2806,15 @@ struct PipelineImpl final : Pipeline
 		LinearAllocator& allocator = pipeline->m_renderer.getCurrentFrameAllocator();
 		view = UniquePtr<View>::create(allocator, allocator, pipeline->m_renderer.getEngine().getPageAllocator());
 		view->cp = cp;
+		view->frame_number = pipeline->m_renderer.frameNumber();
 		memset(view->layer_to_bucket, 0xff, sizeof(view->layer_to_bucket));
+		if (pipeline->m_renderer.isStaticDrawListsEnabled()) {
+			const i32 view_idx = pipeline->m_views.size() - 1;
+			while (pipeline->m_static_draw_lists.size() <= view_idx) {
+				pipeline->m_static_draw_lists.push(UniquePtr<StaticDrawList>::create(pipeline->m_allocator, pipeline->m_allocator));
+			}
+			view->static_draw_list = pipeline->m_static_draw_lists[view_idx].get();
+		}
 
 		view->buckets.reserve(bucket_count);
 		for (i32 i = 0; i < bucket_count; ++i) {
@@ -2627,12 +2870,18 @@ struct PipelineImpl final : Pipeline
 			view_ptr->renderables = pipeline->m_module->getRenderables(view_ptr->cp.frustum);
 			
 			if (view_ptr->renderables) {
+				// previous frame can still use the list
+				if (view_ptr->static_draw_list && !view_ptr->static_draw_list->busy.compareExchange(1, 0)) view_ptr->static_draw_list = nullptr;
+
+				if (pipeline->m_renderer.isOcclusionCullingEnabled()) pipeline->occlusionCull(*view_ptr);
 				pipeline->createSortKeys(*view_ptr);
 				view_ptr->renderables->free(pipeline->m_renderer.getEngine().getPageAllocator());
 				if (!view_ptr->sorter.keys.empty()) {
 					pipeline->radixSort(view_ptr->sorter.keys.begin(), view_ptr->sorter.values.begin(), view_ptr->sorter.keys.size());
 					pipeline->createCommands(*view_ptr);
 				}
+
+				if (view_ptr->static_draw_list) view_ptr->static_draw_list->busy = 0;
 			}
 
 			jobs::setGreen(&view_ptr->ready);
@@ -2769,9 +3018,22 @@ struct PipelineImpl final : Pipeline
 					if (sort_keys[i] & SORT_KEY_INSTANCED_FLAG) {
 						const u32 group_idx = renderables[i] & 0xffFF;
 						const u32 instancer_idx = (renderables[i] >> SORT_KEY_INSTANCER_SHIFT) & 0xffFF;
-						const AutoInstancer::Instances& instances = view.instancers[instancer_idx].instances[group_idx];
-						const u32 total_count = instances.end->offset + instances.end->count;
-						const Mesh& mesh = *sort_key_to_mesh[group_idx];
+						u32 total_count;
+						Renderer::TransientSlice slice;
+						const Mesh* mesh_ptr;
+						if (instancer_idx == STATIC_DRAW_LIST_INSTANCER) {
+							const StaticDrawList::Group& group = view.static_draw_list->groups[group_idx];
+							total_count = group.entities.size();
+							slice = group.slice;
+							mesh_ptr = group.mesh;
+						}
+						else {
+							const AutoInstancer::Instances& instances = view.instancers[instancer_idx].instances[group_idx];
+							total_count = instances.end->offset + instances.end->count;
+							slice = instances.slice;
+							mesh_ptr = sort_key_to_mesh[group_idx];
+						}
+						const Mesh& mesh = *mesh_ptr;
 
 						const Material* material = mesh.material;
 						Shader* shader = material->getShader();
@@ -2783,7 +3045,7 @@ struct PipelineImpl final : Pipeline
 						stream->bind(0, material->m_bind_group);
 						stream->bindIndexBuffer(mesh.index_buffer_handle);
 						stream->bindVertexBuffer(0, mesh.vertex_buffer_handle, 0, mesh.vb_stride);
-						stream->bindVertexBuffer(1, instances.slice.buffer, instances.slice.offset, 48);
+						stream->bindVertexBuffer(1, slice.buffer, slice.offset, 48);
 						stream->drawIndexedInstanced(mesh.indices_count, total_count, mesh.index_type);
 					}
 					else {
@@ -3489,6 +3751,100 @@ struct PipelineImpl final : Pipeline
 		return setRenderTargets(L, true, false);
 	}
 
+	// removes meshes hidden behind occluders from `view.renderables`, see OcclusionCuller
+	void occlusionCull(View& view) {
+		// shadows can be cast by objects the camera does not see
+		if (view.cp.is_shadow) return;
+		// views are prepared in parallel, but there's only one culler, other views are not occlusion culled
+		if (!m_occlusion_culler_busy.compareExchange(1, 0)) return;
+
+		PROFILE_FUNCTION();
+		if (!m_occlusion_culler) m_occlusion_culler = OcclusionCuller::create(m_allocator);
+		OcclusionCuller& culler = *m_occlusion_culler.get();
+		const ModelInstance* LUMIX_RESTRICT model_instances = m_module->getModelInstances().begin();
+		const Transform* LUMIX_RESTRICT transforms = m_module->getWorld().getTransforms();
+		const DVec3 camera_pos = view.cp.pos;
+		const Matrix view_projection = view.cp.projection * view.cp.view;
+
+		auto get_mtx = [&](EntityRef e){
+			const Transform& tr = transforms[e.index];
+			Matrix mtx(Vec3(tr.pos - camera_pos), tr.rot);
+			mtx.multiply3x3(tr.scale);
+			return view_projection * mtx;
+		};
+
+		struct Occluder {
+			EntityRef entity;
+			float squared_distance;
+		};
+
+		Array<Occluder> occluders(m_renderer.getCurrentFrameAllocator());
+		for (const CullResult* page = view.renderables; page; page = page->header.next) {
+			if ((RenderableTypes)page->header.type != RenderableTypes::MESH) continue;
+			for (u32 i = 0, c = page->header.count; i < c; ++i) {
+				const EntityRef e = page->entities[i];
+				if (model_instances[e.index].flags & ModelInstance::OCCLUDER) {
+					occluders.push({e, float(squaredLength(transforms[e.index].pos - camera_pos))});
+				}
+			}
+		}
+
+		if (!occluders.empty()) {
+			// the closest occluders first, the rest can be over the triangle budget
+			qsort(occluders.begin(), occluders.size(), sizeof(occluders[0]), [](const void* a, const void* b){
+				const float da = ((const Occluder*)a)->squared_distance;
+				const float db = ((const Occluder*)b)->squared_distance;
+				return da < db ? -1 : (da > db ? 1 : 0);
+			});
+
+			culler.begin();
+			const float lod_multiplier_rcp = 1 / m_renderer.getLODMultiplier();
+			for (const Occluder& occluder : occluders) {
+				const ModelInstance& mi = model_instances[occluder.entity.index];
+				// the same LOD as drawn
+				const u32 lod_idx = mi.model->getResidentLOD(mi.model->getLODMeshIndices(occluder.squared_distance * lod_multiplier_rcp));
+				const LODMeshIndices& lod = mi.model->getLODIndices()[lod_idx];
+				const Matrix mtx = get_mtx(occluder.entity);
+				bool is_over_budget = false;
+				for (i32 mesh_idx = lod.from; mesh_idx <= lod.to && !is_over_budget; ++mesh_idx) {
+					const Mesh& mesh = mi.meshes[mesh_idx];
+					is_over_budget = !culler.addOccluder(mtx, mesh.vertices, mesh.indices.data(), mesh.indices_count, mesh.areIndices16());
+				}
+				if (is_over_budget) break;
+			}
+			culler.rasterize();
+
+			PagedListIterator<CullResult> iterator(view.renderables);
+			AtomicI32 occluded_count = 0;
+			jobs::runOnWorkers([&](){
+				PROFILE_BLOCK("test occludees");
+				u32 occluded = 0;
+				for (;;) {
+					CullResult* page = iterator.next();
+					if (!page) break;
+					const RenderableTypes type = (RenderableTypes)page->header.type;
+					// bounds of skinned meshes are not reliable
+					if (type != RenderableTypes::MESH && type != RenderableTypes::MESH_MATERIAL_OVERRIDE) continue;
+
+					u32 count = 0;
+					for (u32 i = 0, c = page->header.count; i < c; ++i) {
+						const EntityRef e = page->entities[i];
+						const ModelInstance& mi = model_instances[e.index];
+						if ((mi.flags & ModelInstance::OCCLUDER) == 0 && !culler.isVisible(get_mtx(e), mi.model->getAABB())) continue;
+						page->entities[count] = e;
+						++count;
+					}
+					occluded += page->header.count - count;
+					page->header.count = count;
+				}
+				occluded_count.add(occluded);
+			});
+			profiler::pushInt("occluded", occluded_count);
+		}
+
+		m_occlusion_culler_busy = 0;
+	}
+
 	void createSortKeys(PipelineImpl::View& view) {
 		if (view.renderables->header.count == 0 && !view.renderables->header.next) return;
 		PagedListIterator<const CullResult> iterator(view.renderables);
@@ -3503,6 +3859,12 @@ struct PipelineImpl final : Pipeline
 		const float global_lod_multiplier_rcp = 1 / global_lod_multiplier;
 		const float time_delta = m_renderer.getEngine().getLastTimeDelta();
 		AtomicI32 worker_idx = 0;
+		
+		// demand of texture mips, from the same distance as LODs
+		const bool stream_textures = !view.cp.is_shadow && m_renderer.getTextureStreamer().isEnabled();
+		const float screen_size_scale = m_viewport.is_ortho
+			? m_viewport.h / maximum(m_viewport.ortho_size, 1e-3f)
+			: m_viewport.h / maximum(tanf(m_viewport.fov * 0.5f), 1e-3f);
 
 		u32 bucket_map[255];
 		for (u32 i = 0; i < 255; ++i) {
@@ -3514,6 +3876,15 @@ struct PipelineImpl final : Pipeline
 				bucket_map[i] |= 0x100;
 			}
 		}
+
+		StaticDrawList* static_draw_list = view.static_draw_list;
+		Array<Array<StaticDrawList::Change>> static_changes(allocator);
+		if (static_draw_list) {
+			static_draw_list->begin(view.frame_number, bucket_map, view.cp.is_shadow, global_lod_multiplier, screen_size_scale, m_viewport.pos, m_renderer.getSortKeyToMeshMap());
+			static_changes.reserve(jobs::getWorkersCount());
+			for (u8 i = 0; i < jobs::getWorkersCount(); ++i) static_changes.emplace(allocator);
+		}
+
 		jobs::runOnWorkers([&](){
 			PROFILE_BLOCK("create keys");
 			int total = 0;
@@ -3573,11 +3944,20 @@ struct PipelineImpl final : Pipeline
 							ModelInstance& mi = model_instances[e.index];
 							const float squared_length = float(squaredLength(pos - lod_ref_point));
 								
-							const u32 lod_idx = mi.model->getLODMeshIndices(squared_length * global_lod_multiplier_rcp);
+							const u32 wanted_lod_idx = mi.model->getLODMeshIndices(squared_length * global_lod_multiplier_rcp);
+							mi.model->requestLOD(wanted_lod_idx);
+							const u32 lod_idx = mi.model->getResidentLOD(wanted_lod_idx);
+							u32 screen_size_log2 = 0;
+							if (stream_textures) {
+								const Vec3 scale = transforms[e.index].scale;
+								const float radius = mi.model->getOriginBoundingRadius() * maximum(scale.x, scale.y, scale.z);
+								screen_size_log2 = getScreenSizeLog2(radius, squared_length, screen_size_scale, m_viewport.is_ortho);
+							}
 
 							auto create_key = [&](const LODMeshIndices& lod){
 								for (int mesh_idx = lod.from; mesh_idx <= lod.to; ++mesh_idx) {
 									const Mesh& mesh = mi.meshes[mesh_idx];
+									if (stream_textures) requestTextureMips(mi.custom_material ? *mi.custom_material : *mesh.material, screen_size_log2);
 									const u8 layer = mi.custom_material ? mi.custom_material->getLayer() : mesh.layer;
 									const u32 bucket = bucket_map[layer];
 									const u32 mesh_sort_key = mi.custom_material ? 0x00FFffFF : mesh.sort_key;
@@ -3613,8 +3993,9 @@ struct PipelineImpl final : Pipeline
 									else {
 										mi.lod += d / ad * time_delta;
 										const u32 cur_lod_idx = u32(mi.lod);
-										create_key(mi.model->getLODIndices()[cur_lod_idx]);
-										if (cur_lod_idx < 3) create_key(mi.model->getLODIndices()[cur_lod_idx + 1]);
+										// `mi.lod` can be stale, e.g. after the instance was culled for a while
+										create_key(mi.model->getLODIndices()[mi.model->getResidentLOD(cur_lod_idx)]);
+										if (cur_lod_idx < 3 && mi.model->isLODResident(cur_lod_idx)) create_key(mi.model->getLODIndices()[cur_lod_idx + 1]);
 									}
 								}
 							}
@@ -3631,13 +4012,57 @@ struct PipelineImpl final : Pipeline
 							const EntityRef e = renderables[i];
 							const DVec3 pos = transforms[e.index].pos;
 							ModelInstance& mi = model_instances[e.index];
+							if (static_draw_list && static_draw_list->keep(e, mi, pos)) continue;
+
 							const float squared_length = float(squaredLength(pos - lod_ref_point));
 								
-							const u32 lod_idx = mi.model->getLODMeshIndices(squared_length * global_lod_multiplier_rcp);
+							const u32 wanted_lod_idx = mi.model->getLODMeshIndices(squared_length * global_lod_multiplier_rcp);
+							mi.model->requestLOD(wanted_lod_idx);
+							const u32 lod_idx = mi.model->getResidentLOD(wanted_lod_idx);
+							u32 screen_size_log2 = 0;
+							if (stream_textures) {
+								const Vec3 scale = transforms[e.index].scale;
+								const float radius = mi.model->getOriginBoundingRadius() * maximum(scale.x, scale.y, scale.z);
+								screen_size_log2 = getScreenSizeLog2(radius, squared_length, screen_size_scale, m_viewport.is_ortho);
+							}
+
+							if (static_draw_list && mi.lod == lod_idx && !(mi.flags & ModelInstance::MOVED)) {
+								const LODMeshIndices& lod = mi.model->getLODIndices()[lod_idx];
+								u32 group_count = 0;
+								bool depth_sorted = false;
+								for (int mesh_idx = lod.from; mesh_idx <= lod.to; ++mesh_idx) {
+									const u32 bucket = bucket_map[mi.meshes[mesh_idx].layer];
+									if (bucket < 0xff) ++group_count;
+									else if (bucket < 0xffFF) depth_sorted = true;
+								}
+
+								if (!depth_sorted && group_count <= StaticDrawList::MAX_ENTRY_GROUPS) {
+									const float* lod_distances = mi.model->getLODDistances();
+									const float distance = sqrtf(squared_length);
+									const float lod_min = wanted_lod_idx > 0 ? sqrtf(lod_distances[wanted_lod_idx - 1] * global_lod_multiplier) : 0;
+									const float lod_max = wanted_lod_idx < Model::MAX_LOD_COUNT ? sqrtf(lod_distances[wanted_lod_idx] * global_lod_multiplier) : FLT_MAX;
+									// texture streaming screen size depends on distance too, so it can't be cached for too long
+									const float slack = minimum(distance - lod_min, lod_max - distance, distance * 0.25f);
+
+									StaticDrawList::Change& change = static_changes[instancer_idx].emplace();
+									change.entity = e;
+									change.entry.model = mi.model;
+									change.entry.meshes = mi.meshes;
+									change.entry.pos = pos;
+									change.entry.travel_limit = static_draw_list->travel + maximum(slack, 0.f);
+									change.entry.frame = static_draw_list->frame;
+									change.entry.lod = (u8)lod_idx;
+									change.entry.wanted_lod = (u8)wanted_lod_idx;
+									change.entry.screen_size_log2 = (u8)screen_size_log2;
+									change.entry.group_count = 0;
+									continue;
+								}
+							}
 
 							auto create_key = [&](const LODMeshIndices& lod){
 								for (int mesh_idx = lod.from; mesh_idx <= lod.to; ++mesh_idx) {
 									const Mesh& mesh = mi.meshes[mesh_idx];
+									if (stream_textures) requestTextureMips(*mesh.material, screen_size_log2);
 									const u32 bucket = bucket_map[mesh.layer];
 									ASSERT(!mi.custom_material);
 									const u64 subrenderable = e.index | type_mask | ((u64)mesh_idx << SORT_KEY_MESH_IDX_SHIFT);
@@ -3672,8 +4097,9 @@ struct PipelineImpl final : Pipeline
 								else {
 									if (!is_shadow) mi.lod += d / ad * time_delta;
 									const u32 cur_lod_idx = u32(mi.lod);
-									create_key(mi.model->getLODIndices()[cur_lod_idx]);
-									if (cur_lod_idx < 3) create_key(mi.model->getLODIndices()[cur_lod_idx + 1]);
+									// `mi.lod` can be stale, e.g. after the instance was culled for a while
+									create_key(mi.model->getLODIndices()[mi.model->getResidentLOD(cur_lod_idx)]);
+									if (cur_lod_idx < 3 && mi.model->isLODResident(cur_lod_idx)) create_key(mi.model->getLODIndices()[cur_lod_idx + 1]);
 								}
 							}
 							else {
@@ -3734,9 +4160,63 @@ struct PipelineImpl final : Pipeline
 			}
 		});
 
+		if (static_draw_list) {
+			const u32 change_count = static_draw_list->update(static_changes);
+			profiler::pushInt("static draw list changes", change_count);
+			fillStaticDrawList(view, stream_textures);
+		}
+
 		view.sorter.pack();
 	}
 
+	void fillStaticDrawList(View& view, bool stream_textures) {
+		PROFILE_FUNCTION();
+		StaticDrawList& list = *view.static_draw_list;
+		const ModelInstance* LUMIX_RESTRICT model_instances = m_module->getModelInstances().begin();
+		const Transform* LUMIX_RESTRICT transforms = m_module->getWorld().getTransforms();
+		const DVec3 camera_pos = view.cp.pos;
+
+		jobs::forEach(list.groups.size(), 16, [&](i32 from, i32 to){
+			PROFILE_BLOCK("fill instance data");
+			for (i32 group_idx = from; group_idx < to; ++group_idx) {
+				StaticDrawList::Group& group = list.groups[group_idx];
+				if (group.entities.empty()) continue;
+
+				group.model->requestLOD(group.wanted_lod);
+				if (stream_textures) requestTextureMips(*group.mesh->material, group.screen_size_log2);
+
+				group.slice = m_renderer.allocTransient(group.entities.size() * (3 * sizeof(Vec4)));
+				u8* instance_data = group.slice.ptr;
+				const float mesh_lod = group.mesh->lod;
+				for (EntityRef e : group.entities) {
+					const Transform& tr = transforms[e.index];
+					const Vec3 lpos = Vec3(tr.pos - camera_pos);
+					const float lod_d = model_instances[e.index].lod - mesh_lod;
+					memcpy(instance_data, &tr.rot, sizeof(tr.rot));
+					instance_data += sizeof(tr.rot);
+					memcpy(instance_data, &lpos, sizeof(lpos));
+					instance_data += sizeof(lpos);
+					memcpy(instance_data, &lod_d, sizeof(lod_d));
+					instance_data += sizeof(lod_d);
+					memcpy(instance_data, &tr.scale, sizeof(tr.scale));
+					instance_data += sizeof(tr.scale) + sizeof(float) /*padding to vec4*/;
+				}
+			}
+		});
+
+		Sorter::Inserter inserter(view.sorter);
+		for (u32 group_idx = 0, c = list.groups.size(); group_idx < c; ++group_idx) {
+			const StaticDrawList::Group& group = list.groups[group_idx];
+			if (group.entities.empty()) continue;
+
+			const u8 bucket = view.layer_to_bucket[group.mesh->layer];
+			inserter.push(SORT_KEY_INSTANCED_FLAG | group.sort_key | ((u64)bucket << SORT_KEY_BUCKET_SHIFT), group_idx | ((u64)STATIC_DRAW_LIST_INSTANCER << SORT_KEY_INSTANCER_SHIFT));
+		}
+	}
+
+	// arrays with less than 4 chunks are sorted by `radixSortSerial`
+	static constexpr i32 RADIX_SORT_CHUNK_SIZE = 16 * 1024;
+
 	struct Histogram {
 		static constexpr u32 BITS = 11;
 		static constexpr u32 SIZE = 1 << BITS;
@@ -3792,12 +4272,119 @@ struct PipelineImpl final : Pipeline
 	};
 
 
-	void radixSort(u64* _keys, u64* _values, int size) {
+	// stable LSD radix sort of `keys` with `values`
+	// big arrays are split in chunks, histograms of chunks are computed and chunks are scattered in parallel
+	void radixSort(u64* keys, u64* values, int size) {
 		PROFILE_FUNCTION();
 		profiler::pushInt("count", size);
 		if (size == 0) return;
+		if (size < RADIX_SORT_CHUNK_SIZE * 4) {
+			radixSortSerial(keys, values, size);
+			return;
+		}
+
+		LinearAllocator& allocator = m_renderer.getCurrentFrameAllocator();
+		const i32 chunk_count = (size + RADIX_SORT_CHUNK_SIZE - 1) / RADIX_SORT_CHUNK_SIZE;
+
+		struct ChunkInfo {
+			u64 and_mask;
+			u64 or_mask;
+			bool sorted;
+		};
+
+		ChunkInfo* infos = (ChunkInfo*)allocator.allocate(chunk_count * sizeof(ChunkInfo), alignof(ChunkInfo));
+		jobs::forEach(chunk_count, 1, [&](i32 from, i32 to){
+			PROFILE_BLOCK("radix sort analyze");
+			for (i32 chunk = from; chunk < to; ++chunk) {
+				const i32 begin = chunk * RADIX_SORT_CHUNK_SIZE;
+				const i32 end = minimum(size, begin + RADIX_SORT_CHUNK_SIZE);
+				ChunkInfo& info = infos[chunk];
+				info.and_mask = ~u64(0);
+				info.or_mask = 0;
+				info.sorted = true;
+				u64 prev_key = keys[begin > 0 ? begin - 1 : 0];
+				for (i32 i = begin; i < end; ++i) {
+					const u64 key = keys[i];
+					info.and_mask &= key;
+					info.or_mask |= key;
+					info.sorted &= prev_key <= key;
+					prev_key = key;
+				}
+			}
+		});
+
+		u64 and_mask = ~u64(0);
+		u64 or_mask = 0;
+		bool sorted = true;
+		for (i32 i = 0; i < chunk_count; ++i) {
+			and_mask &= infos[i].and_mask;
+			or_mask |= infos[i].or_mask;
+			sorted &= infos[i].sorted;
+		}
+		if (sorted) return;
+
+		// digits, which are the same in all keys, do not need a pass
+		const u64 varying_bits = and_mask ^ or_mask;
+		u32* histograms = (u32*)allocator.allocate(chunk_count * Histogram::SIZE * sizeof(u32), alignof(u32));
+		u64* tmp = (u64*)allocator.allocate(size * 2 * sizeof(u64), alignof(u64));
+		u64* src_keys = keys;
+		u64* src_values = values;
+		u64* dst_keys = tmp;
+		u64* dst_values = tmp + size;
+
+		for (u32 shift = 0; shift < 64; shift += Histogram::BITS) {
+			if (((varying_bits >> shift) & Histogram::BIT_MASK) == 0) continue;
+
+			jobs::forEach(chunk_count, 1, [&](i32 from, i32 to){
+				PROFILE_BLOCK("radix sort histogram");
+				for (i32 chunk = from; chunk < to; ++chunk) {
+					u32* LUMIX_RESTRICT histogram = histograms + chunk * Histogram::SIZE;
+					memset(histogram, 0, Histogram::SIZE * sizeof(u32));
+					const i32 end = minimum(size, (chunk + 1) * RADIX_SORT_CHUNK_SIZE);
+					for (i32 i = chunk * RADIX_SORT_CHUNK_SIZE; i < end; ++i) {
+						++histogram[(src_keys[i] >> shift) & Histogram::BIT_MASK];
+					}
+				}
+			});
+
+			// chunks are consecutive in each digit, so the sort is stable
+			u32 offset = 0;
+			for (u32 digit = 0; digit < Histogram::SIZE; ++digit) {
+				for (i32 chunk = 0; chunk < chunk_count; ++chunk) {
+					u32& h = histograms[chunk * Histogram::SIZE + digit];
+					const u32 count = h;
+					h = offset;
+					offset += count;
+				}
+			}
+
+			jobs::forEach(chunk_count, 1, [&](i32 from, i32 to){
+				PROFILE_BLOCK("radix sort scatter");
+				for (i32 chunk = from; chunk < to; ++chunk) {
+					u32* LUMIX_RESTRICT offsets = histograms + chunk * Histogram::SIZE;
+					const i32 end = minimum(size, (chunk + 1) * RADIX_SORT_CHUNK_SIZE);
+					for (i32 i = chunk * RADIX_SORT_CHUNK_SIZE; i < end; ++i) {
+						const u64 key = src_keys[i];
+						const u32 dest = offsets[(key >> shift) & Histogram::BIT_MASK]++;
+						dst_keys[dest] = key;
+						dst_values[dest] = src_values[i];
+					}
+				}
+			});
+
+			swap(src_keys, dst_keys);
+			swap(src_values, dst_values);
+		}
+
+		if (src_keys != keys) {
+			memcpy(keys, src_keys, size * sizeof(keys[0]));
+			memcpy(values, src_values, size * sizeof(values[0]));
+		}
+	}
 
-		Array<u64> tmp_mem(m_allocator);
+	// used for small arrays, only histograms are parallel
+	void radixSortSerial(u64* _keys, u64* _values, int size) {
+		Array<u64> tmp_mem(m_renderer.getCurrentFrameAllocator());
 
 		u64* keys = _keys;
 		u64* values = _values;
@@ -4092,6 +4679,8 @@ struct PipelineImpl final : Pipeline
 	Draw2D m_draw2d;
 	Shader* m_draw2d_shader;
 	Array<UniquePtr<View>> m_views;
+	// indexed by view, i.e. by order of `cull` calls
+	Array<UniquePtr<StaticDrawList>> m_static_draw_lists;
 	jobs::Signal m_buckets_ready;
 	Viewport m_viewport;
 	bool m_is_pixel_jitter_enabled = false;
@@ -4111,6 +4700,8 @@ struct PipelineImpl final : Pipeline
 	Array<gpu::BufferHandle> m_buffers;
 	os::Timer m_timer;
 	AtomicI32 m_indirect_buffer_offset = 0;
+	UniquePtr<OcclusionCuller> m_occlusion_culler;
+	AtomicI32 m_occlusion_culler_busy = 0;
 	gpu::BufferHandle m_instanced_meshes_buffer;
 	gpu::BufferHandle m_indirect_buffer;
 	gpu::VertexDecl m_base_vertex_decl;
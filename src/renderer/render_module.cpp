@@ -1461,8 +1461,7 @@ struct RenderModuleImpl final : RenderModule {
 
 	void onEntityMoved(EntityRef entity)
 	{
-		const u64 cmp_mask = m_world.getComponentsMask(entity);
-		if ((cmp_mask & m_render_cmps_mask) == 0) {
+		if (!m_world.getComponentsMask(entity).intersects(m_render_cmps_mask)) {
 			return;
 		}
 
@@ -1915,6 +1914,18 @@ struct RenderModuleImpl final : RenderModule {
 	}
 
 
+	bool isModelInstanceOccluder(EntityRef entity) override
+	{
+		return m_model_instances[entity.index].flags & ModelInstance::OCCLUDER;
+	}
+
+
+	void setModelInstanceOccluder(EntityRef entity, bool is_occluder) override
+	{
+		setFlag(m_model_instances[entity.index].flags, ModelInstance::OCCLUDER, is_occluder);
+	}
+
+
 	void enableModelInstance(EntityRef entity, bool enable) override
 	{
 		ModelInstance& model_instance = m_model_instances[entity.index];
@@ -3237,7 +3248,7 @@ struct RenderModuleImpl final : RenderModule {
 	Renderer& m_renderer;
 	Engine& m_engine;
 	UniquePtr<CullingSystem> m_culling_system;
-	u64 m_render_cmps_mask;
+	ComponentMask m_render_cmps_mask;
 
 	EntityPtr m_active_global_light_entity;
 	HashMap<EntityRef, PointLight> m_point_lights;
@@ -3399,6 +3410,7 @@ void RenderModule::reflect() {
 		.LUMIX_CMP(ModelInstance, "model_instance", "Render / Mesh")
 			.LUMIX_FUNC_EX(RenderModule::getModelInstanceModel, "getModel")
 			.prop<&RenderModule::isModelInstanceEnabled, &RenderModule::enableModelInstance>("Enabled")
+			.prop<&RenderModule::isModelInstanceOccluder, &RenderModule::setModelInstanceOccluder>("Occluder")
 			.prop<&RenderModule::getModelInstanceMaterialOverride,&RenderModule::setModelInstanceMaterialOverride>("Material").noUIAttribute()
 			.LUMIX_PROP(ModelInstancePath, "Source").resourceAttribute(Model::TYPE)
 		.LUMIX_CMP(Environment, "environment", "Render / Environment")
@@ -3483,15 +3495,13 @@ RenderModuleImpl::RenderModuleImpl(Renderer& renderer,
 	m_culling_system = CullingSystem::create(m_allocator, engine.getPageAllocator());
 	m_model_instances.reserve(1024);
 
-	m_render_cmps_mask = 0;
-
 	Renderer::MemRef mem;
 	m_reflection_probes_texture = renderer.createTexture(128, 128, 32, gpu::TextureFormat::BC3, gpu::TextureFlags::IS_CUBE, mem, "reflection_probes");
 
 	const RuntimeHash hash("renderer");
 	for (const reflection::RegisteredComponent& cmp : reflection::getComponents()) {
 		if (cmp.module_hash == hash) {
-			m_render_cmps_mask |= (u64)1 << cmp.cmp->component_type.index;
+			m_render_cmps_mask.add(cmp.cmp->component_type);
 		}
 	}
 }
@@ -161,6 +161,8 @@ struct ModelInstance {
 		ENABLED = 1 << 1,
 		VALID = 1 << 2,
 		MOVED = 1 << 3,
+		// rasterized by software occlusion culling, see OcclusionCuller
+		OCCLUDER = 1 << 4,
 	};
 
 	Model* model;
@@ -362,6 +364,8 @@ struct LUMIX_RENDERER_API RenderModule : IModule
 
 	virtual void enableModelInstance(EntityRef entity, bool enable) = 0;
 	virtual bool isModelInstanceEnabled(EntityRef entity) = 0;
+	virtual void setModelInstanceOccluder(EntityRef entity, bool is_occluder) = 0;
+	virtual bool isModelInstanceOccluder(EntityRef entity) = 0;
 	virtual ModelInstance* getModelInstance(EntityRef entity) = 0;
 	virtual Span<const ModelInstance> getModelInstances() const = 0;
 	virtual Span<ModelInstance> getModelInstances() = 0;
@@ -17,6 +17,7 @@
 #include "engine/resource_manager.h"
 #include "engine/string.h"
 #include "engine/world.h"
+#include "renderer/culling_system.h"
 #include "renderer/draw_stream.h"
 #include "renderer/font.h"
 #include "renderer/material.h"
@@ -368,6 +369,8 @@ struct RendererImpl final : Renderer
 		: m_engine(engine)
 		, m_allocator(engine.getAllocator(), "renderer")
 		, m_texture_manager("textures", *this, m_allocator)
+		, m_texture_streamer(m_allocator)
+		, m_model_streamer(m_allocator)
 		, m_pipeline_manager("pipelines", *this, m_allocator)
 		, m_model_manager("models", *this, m_allocator)
 		, m_particle_emitter_manager("particle emitters", *this, m_allocator)
@@ -399,6 +402,15 @@ struct RendererImpl final : Renderer
 
 	float getLODMultiplier() const override { return m_lod_multiplier; }
 	void setLODMultiplier(float value) override { m_lod_multiplier = maximum(0.f, value); }
+	bool isOcclusionCullingEnabled() const override { return m_occlusion_culling; }
+	void setOcclusionCullingEnabled(bool enable) override { m_occlusion_culling = enable; }
+	bool isStaticDrawListsEnabled() const override { return m_static_draw_lists; }
+	void setStaticDrawListsEnabled(bool enable) override { m_static_draw_lists = enable; }
+
+	void captureDrawStreams(const Path& path) override {
+		jobs::MutexGuard guard(m_render_mutex);
+		m_draw_streams_capture_path = path;
+	}
 
 	void serialize(OutputMemoryStream& stream) const override {}
 	bool deserialize(i32 version, InputMemoryStream& stream) override { return version == 0; }
@@ -419,6 +431,11 @@ struct RendererImpl final : Renderer
 		frame();
 
 		waitForRender();
+		if (m_engine.isGPUDisabled()) {
+			// gpu::init was not called, this only frees the state from gpu::preinit
+			gpu::shutdown();
+			return;
+		}
 		
 		jobs::Signal signal;
 		jobs::runLambda([this]() {
@@ -506,11 +523,50 @@ struct RendererImpl final : Renderer
 			else if (cmd_line_parser.currentEquals("-debug_opengl")) {
 				flags = flags | gpu::InitFlags::DEBUG_OUTPUT;
 			}
+			else if (cmd_line_parser.currentEquals("-texture_streaming")) {
+				if (!cmd_line_parser.next()) {
+					logError("command line option '-texture_streaming` without value");
+					break;
+				}
+				char tmp[32];
+				cmd_line_parser.getCurrent(tmp, sizeof(tmp));
+				u64 budget_mb = 0;
+				fromCString(tmp, budget_mb);
+				m_texture_streamer.setBudget(budget_mb * 1024 * 1024);
+			}
+			else if (cmd_line_parser.currentEquals("-culling_benchmark")) {
+				CullingSystem::benchmark(m_allocator, m_engine.getPageAllocator());
+			}
+			else if (cmd_line_parser.currentEquals("-occlusion_culling")) {
+				m_occlusion_culling = true;
+			}
+			else if (cmd_line_parser.currentEquals("-static_draw_lists")) {
+				m_static_draw_lists = true;
+			}
+			else if (cmd_line_parser.currentEquals("-model_lod_streaming")) {
+				m_model_streamer.setEnabled(true);
+			}
+			else if (cmd_line_parser.currentEquals("-model_lod_evict_frames")) {
+				if (!cmd_line_parser.next()) {
+					logError("command line option '-model_lod_evict_frames` without value");
+					break;
+				}
+				char tmp[32];
+				cmd_line_parser.getCurrent(tmp, sizeof(tmp));
+				u32 frames = 0;
+				fromCString(tmp, frames);
+				m_model_streamer.setEvictFrames(frames);
+			}
 		}
 
 		jobs::Signal signal;
 		jobs::runLambda([this, flags]() {
 			PROFILE_BLOCK("init_render");
+			if (m_engine.isGPUDisabled()) {
+				// commands are still recorded to draw streams, but they are dropped instead of rendered, see `render`
+				logInfo("Renderer runs without a GPU device");
+				return;
+			}
 			void* window_handle = m_engine.getWindowHandle();
 			if (!gpu::init(window_handle, flags)) {
 				os::messageBox("Failed to initialize renderer. More info in lumix.log.");
@@ -561,6 +617,8 @@ struct RendererImpl final : Renderer
 		ResourceManagerHub& manager = m_engine.getResourceManager();
 		m_pipeline_manager.create(PipelineResource::TYPE, manager);
 		m_texture_manager.create(Texture::TYPE, manager);
+		// big textures should not block small shaders and materials
+		m_texture_manager.setLoadPriority(FileSystem::Priority::LOW);
 		m_model_manager.create(Model::TYPE, manager);
 		m_material_manager.create(Material::TYPE, manager);
 		m_particle_emitter_manager.create(ParticleSystemResource::TYPE, manager);
@@ -780,6 +838,8 @@ struct RendererImpl final : Renderer
 
 
 	ResourceManager& getTextureManager() override { return m_texture_manager; }
+	TextureStreamer& getTextureStreamer() override { return m_texture_streamer; }
+	ModelStreamer& getModelStreamer() override { return m_model_streamer; }
 	FontManager& getFontManager() override { return *m_font_manager; }
 
 	void createModules(World& world) override
@@ -853,6 +913,16 @@ struct RendererImpl final : Renderer
 		}
 		
 		FrameData& frame = *m_gpu_frame;
+		if (m_engine.isGPUDisabled()) {
+			// memory which would be freed by FREE_MEMORY commands leaks, it's meant for tools which do not render frames
+			frame.begin_frame_draw_stream.reset();
+			frame.draw_stream.reset();
+			frame.end_frame_draw_stream.reset();
+			frame.linear_allocator.reset();
+			jobs::setGreen(&frame.can_setup);
+			m_gpu_frame = next_frame;
+			return;
+		}
 		profiler::pushInt("GPU Frame", getFrameIndex(m_gpu_frame));
 		frame.transient_buffer.prepareToRender();
 		frame.uniform_buffer.prepareToRender();
@@ -876,16 +946,36 @@ struct RendererImpl final : Renderer
 			profiler::pushCounter(rt_counter, to_MB(mem_stats.render_target_mem));
 		}
 
+		OutputMemoryStream capture(m_allocator);
+		const bool capturing = !m_draw_streams_capture_path.isEmpty();
+		if (capturing) capture.write(DrawStream::CaptureHeader());
+
 		m_profiler.beginQuery("frame", 0, false);
-		frame.begin_frame_draw_stream.run();
+		DrawStream::Stats stream_stats;
+		frame.begin_frame_draw_stream.run(&stream_stats, capturing ? &capture : nullptr);
 		frame.begin_frame_draw_stream.reset();
 
-		frame.draw_stream.run();
+		frame.draw_stream.run(&stream_stats, capturing ? &capture : nullptr);
 		frame.draw_stream.reset();
 
-		frame.end_frame_draw_stream.run();
+		frame.end_frame_draw_stream.run(&stream_stats, capturing ? &capture : nullptr);
 		frame.end_frame_draw_stream.reset();
 
+		if (capturing) {
+			if (m_engine.getFileSystem().saveContentSync(m_draw_streams_capture_path, capture)) {
+				logInfo("Draw streams captured to ", m_draw_streams_capture_path, ", ", capture.size() / 1024, " KB");
+			}
+			else {
+				logError("Failed to save draw streams capture ", m_draw_streams_capture_path);
+			}
+			m_draw_streams_capture_path = "";
+		}
+
+		static u32 submitted_counter = profiler::createCounter("Submitted GPU commands", 0);
+		static u32 elided_counter = profiler::createCounter("Elided redundant binds", 0);
+		profiler::pushCounter(submitted_counter, (float)stream_stats.submitted);
+		profiler::pushCounter(elided_counter, (float)stream_stats.elided);
+
 		frame.linear_allocator.reset();
 		m_profiler.endQuery();
 
@@ -989,6 +1079,9 @@ struct RendererImpl final : Renderer
 			plugin->frame(*this);
 		}
 
+		m_texture_streamer.update();
+		m_model_streamer.update();
+
 		jobs::runLambda([this](){
 			render();
 		}, &m_last_render, 1);
@@ -1008,11 +1101,17 @@ struct RendererImpl final : Renderer
 	RenderResourceManager<PipelineResource> m_pipeline_manager;
 	RenderResourceManager<Shader> m_shader_manager;
 	RenderResourceManager<Texture> m_texture_manager;
+	TextureStreamer m_texture_streamer;
+	ModelStreamer m_model_streamer;
 	Array<u32> m_free_sort_keys;
 	Array<const Mesh*> m_sort_key_to_mesh_map;
 	u32 m_max_sort_key = 0;
 	u32 m_frame_number = 0;
 	float m_lod_multiplier = 1;
+	bool m_occlusion_culling = false;
+	bool m_static_draw_lists = false;
+	// set by captureDrawStreams, protected by m_render_mutex
+	Path m_draw_streams_capture_path;
 	jobs::Signal m_init_signal;
 	HashMap<RuntimeHash, String> m_semantic_defines;
 
@@ -53,6 +53,13 @@ struct LUMIX_RENDERER_API Renderer : ISystem {
 	virtual struct Engine& getEngine() = 0;
 	virtual float getLODMultiplier() const = 0;
 	virtual void setLODMultiplier(float value) = 0;
+	// software occlusion culling of main views, see OcclusionCuller
+	virtual bool isOcclusionCullingEnabled() const = 0;
+	virtual void setOcclusionCullingEnabled(bool enable) = 0;
+	// static meshes keep their autoinstancing groups across frames, see StaticDrawList in pipeline.cpp
+	// disabled by default, enabled with -static_draw_lists
+	virtual bool isStaticDrawListsEnabled() const = 0;
+	virtual void setStaticDrawListsEnabled(bool enable) = 0;
 	
 	virtual struct LinearAllocator& getCurrentFrameAllocator() = 0;
 	virtual IAllocator& getAllocator() = 0;
@@ -79,6 +86,8 @@ struct LUMIX_RENDERER_API Renderer : ISystem {
 
 	virtual struct FontManager& getFontManager() = 0;
 	virtual struct ResourceManager& getTextureManager() = 0;
+	virtual struct TextureStreamer& getTextureStreamer() = 0;
+	virtual struct ModelStreamer& getModelStreamer() = 0;
 	
 	virtual u32 createMaterialConstants(Span<const float> data) = 0;
 	virtual void destroyMaterialConstants(u32 id) = 0;
@@ -100,6 +109,8 @@ struct LUMIX_RENDERER_API Renderer : ISystem {
 
 	virtual void beginProfileBlock(const char* name, i64 link, bool stats = false) = 0;
 	virtual void endProfileBlock() = 0;
+	// saves draw streams of the next rendered frame, see DrawStream::replay
+	virtual void captureDrawStreams(const struct Path& path) = 0;
 
 protected:
 	virtual void setupJob(void* user_ptr, void(*task)(void*)) = 0;
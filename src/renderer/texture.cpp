@@ -66,6 +66,18 @@ void Texture::setFlags(u32 flags)
 }
 
 
+u64 Texture::getGPUMemorySize() const
+{
+	if (!handle) return 0;
+
+	u64 size = 0;
+	for (u32 mip = resident_mip; mip < mips; ++mip) {
+		size += gpu::getSize(format, maximum(width >> mip, 1u), maximum(height >> mip, 1u));
+	}
+	return size * depth * (is_cubemap ? 6 : 1);
+}
+
+
 void Texture::destroy()
 {
 	doUnload();
@@ -262,7 +274,7 @@ void Texture::onDataUpdated(u32 x, u32 y, u32 w, u32 h)
 	stream.freeMemory(mem.data, renderer.getAllocator());
 }
 
-static bool loadRaw(Texture& texture, InputMemoryStream& file, IAllocator& allocator)
+static bool prepareRaw(Texture& texture, InputMemoryStream& file, Texture::Staging& staging)
 {
 	PROFILE_FUNCTION();
 	RawTextureHeader header;
@@ -276,28 +288,31 @@ static bool loadRaw(Texture& texture, InputMemoryStream& file, IAllocator& alloc
 		return false;
 	}
 
-	texture.width = header.width;
-	texture.height = header.height;
-	texture.depth = header.depth;
+	gpu::TextureDesc& desc = staging.desc;
+	desc.width = header.width;
+	desc.height = header.height;
+	desc.depth = header.depth;
+	desc.mips = 1;
+	desc.is_cubemap = false;
 	switch(header.channel_type) {
 		case RawTextureHeader::ChannelType::FLOAT:
 			switch (header.channels_count) {
-				case 1: texture.format = gpu::TextureFormat::R32F; break;
-				case 4: texture.format = gpu::TextureFormat::RGBA32F; break;
+				case 1: desc.format = gpu::TextureFormat::R32F; break;
+				case 4: desc.format = gpu::TextureFormat::RGBA32F; break;
 				default: ASSERT(false); return false;
 			}
 			break;
 		case RawTextureHeader::ChannelType::U8:
 			switch (header.channels_count) {
-				case 1: texture.format = gpu::TextureFormat::R8; break;
-				case 4: texture.format = gpu::TextureFormat::RGBA8; break;
+				case 1: desc.format = gpu::TextureFormat::R8; break;
+				case 4: desc.format = gpu::TextureFormat::RGBA8; break;
 				default: ASSERT(false); return false;
 			}
 			break;
 		case RawTextureHeader::ChannelType::U16:
 			switch (header.channels_count) {
-				case 1: texture.format = gpu::TextureFormat::R16; break;
-				case 4: texture.format = gpu::TextureFormat::RGBA16; break;
+				case 1: desc.format = gpu::TextureFormat::R16; break;
+				case 4: desc.format = gpu::TextureFormat::RGBA16; break;
 				default: ASSERT(false); return false;
 			}
 			break;
@@ -312,19 +327,12 @@ static bool loadRaw(Texture& texture, InputMemoryStream& file, IAllocator& alloc
 	}
 
 	const Renderer::MemRef dst_mem = texture.renderer.copy(data, (u32)size);
-
+	staging.memory = dst_mem.data;
+	staging.size = dst_mem.size;
+	staging.is_raw = true;
 	const gpu::TextureFlags flag_3d = header.depth > 1 && !header.is_array ? gpu::TextureFlags::IS_3D : gpu::TextureFlags::NONE;
-
-	texture.handle = texture.renderer.createTexture(texture.width
-		, texture.height
-		, texture.depth
-		, texture.format
-		, (texture.getGPUFlags() & ~gpu::TextureFlags::SRGB) | flag_3d | gpu::TextureFlags::NO_MIPS 
-		, dst_mem
-		, texture.getPath().c_str());
-	texture.mips = 1;
-	texture.is_cubemap = false;
-	return texture.handle;
+	staging.gpu_flags = flag_3d | gpu::TextureFlags::NO_MIPS;
+	return true;
 }
 
 void Texture::addDataReference()
@@ -360,7 +368,36 @@ u8* Texture::getLBCInfo(const void* data, gpu::TextureDesc& desc) {
 	return (u8*)data + sizeof(*hdr);
 }
 
-static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc& desc, const Renderer::MemRef& memory, gpu::TextureFlags flags, const char* debug_name)
+// size of mips from `first_mip` to the last one, of a single 2D texture
+static u64 getMipChainSize(gpu::TextureFormat format, u32 width, u32 height, u32 mips, u32 first_mip) {
+	u64 size = 0;
+	for (u32 mip = first_mip; mip < mips; ++mip) {
+		size += gpu::getSize(format, maximum(width >> mip, 1u), maximum(height >> mip, 1u));
+	}
+	return size;
+}
+
+static u64 getMipChainSize(const gpu::TextureDesc& desc, u32 first_mip) {
+	return getMipChainSize(desc.format, desc.width, desc.height, desc.mips, first_mip);
+}
+
+// desc of texture made of mips from `first_mip` to the last one
+static gpu::TextureDesc getMipsDesc(const gpu::TextureDesc& desc, u32 first_mip) {
+	gpu::TextureDesc res = desc;
+	res.width = maximum(desc.width >> first_mip, 1u);
+	res.height = maximum(desc.height >> first_mip, 1u);
+	res.mips = desc.mips - first_mip;
+	return res;
+}
+
+// the biggest mip, which is still always resident, see TextureStreamer::TAIL_SIZE
+static u32 getTailMip(u32 width, u32 height, u32 mips) {
+	u32 mip = 0;
+	while (mip + 1 < mips && maximum(width >> mip, height >> mip) > TextureStreamer::TAIL_SIZE) ++mip;
+	return mip;
+}
+
+static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc& desc, const Renderer::MemRef& memory, gpu::TextureFlags flags, bool tail_first, const char* debug_name)
 {
 	ASSERT(memory.size > 0);
 
@@ -373,15 +410,28 @@ static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc
 	stream.createTexture(handle, desc.width, desc.height, desc.depth, desc.format, flags, debug_name);
 				
 	const u8* ptr = (const u8*)memory.data;
-	for (u32 layer = 0; layer < desc.depth; ++layer) {
-		for(int side = 0; side < (desc.is_cubemap ? 6 : 1); ++side) {
-			const u32 z = layer * (desc.is_cubemap ? 6 : 1) + side;
-			for (u32 mip = 0; mip < desc.mips; ++mip) {
-				const u32 w = maximum(desc.width >> mip, 1);
-				const u32 h = maximum(desc.height >> mip, 1);
-				const u32 mip_size_bytes = gpu::getSize(desc.format, w, h);
-				stream.update(handle, mip, 0, 0, z, w, h, desc.format, ptr, mip_size_bytes);
-				ptr += mip_size_bytes;
+	if (tail_first) {
+		// see LBCHeader::TAIL_FIRST
+		ASSERT(desc.depth == 1 && !desc.is_cubemap);
+		for (u32 mip = desc.mips; mip > 0; --mip) {
+			const u32 w = maximum(desc.width >> (mip - 1), 1);
+			const u32 h = maximum(desc.height >> (mip - 1), 1);
+			const u32 mip_size_bytes = gpu::getSize(desc.format, w, h);
+			stream.update(handle, mip - 1, 0, 0, 0, w, h, desc.format, ptr, mip_size_bytes);
+			ptr += mip_size_bytes;
+		}
+	}
+	else {
+		for (u32 layer = 0; layer < desc.depth; ++layer) {
+			for(int side = 0; side < (desc.is_cubemap ? 6 : 1); ++side) {
+				const u32 z = layer * (desc.is_cubemap ? 6 : 1) + side;
+				for (u32 mip = 0; mip < desc.mips; ++mip) {
+					const u32 w = maximum(desc.width >> mip, 1);
+					const u32 h = maximum(desc.height >> mip, 1);
+					const u32 mip_size_bytes = gpu::getSize(desc.format, w, h);
+					stream.update(handle, mip, 0, 0, z, w, h, desc.format, ptr, mip_size_bytes);
+					ptr += mip_size_bytes;
+				}
 			}
 		}
 	}
@@ -391,7 +441,7 @@ static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc
 }
 
 #ifdef LUMIX_BASIS_UNIVERSAL
-	static bool loadBasisU(Texture& texture, IInputStream& file)
+	static bool prepareBasisU(Texture& texture, IInputStream& file, Texture::Staging& staging)
 	{
 		if(texture.data_reference > 0) {
 			logError("Unsupported texture format ", texture.getPath(), " to access on CPU. Use uncompressed TGA without mipmaps or RAW.");
@@ -411,7 +461,7 @@ static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc
 				basist::basisu_file_info fileInfo;
 				transcoder.get_file_info(data, size, fileInfo);
 				if (transcoder.start_transcoding(data, size)) {
-					gpu::TextureDesc desc;
+					gpu::TextureDesc& desc = staging.desc;
 					desc.width = info.m_width;
 					desc.height = info.m_height;
 					desc.depth = 1;
@@ -449,18 +499,10 @@ static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc
 						ptr += mip_blocks * block_bytes_size; 
 					}
 					
-					Renderer::MemRef mem = texture.renderer.copy(tmp.data(), (u32)tmp.size());
-					texture.handle = loadTexture(texture.renderer, desc, mem, texture.getGPUFlags(), texture.getPath().c_str());
-					if (texture.handle) {
-						texture.mips = info.m_total_levels;
-						texture.width = desc.width;
-						texture.height = desc.height;
-						texture.mips = desc.mips;
-						texture.depth = desc.depth;
-						texture.is_cubemap = desc.is_cubemap;
-					}
-
-					return texture.handle;
+					const Renderer::MemRef mem = texture.renderer.copy(tmp.data(), (u32)tmp.size());
+					staging.memory = mem.data;
+					staging.size = mem.size;
+					return true;
 				}
 			}
 		}
@@ -469,9 +511,9 @@ static gpu::TextureHandle loadTexture(Renderer& renderer, const gpu::TextureDesc
 #endif
 
 
-static bool loadLBC(Texture& texture, const u8* data, u32 size)
+static bool prepareLBC(Texture& texture, const u8* data, u32 size, Texture::Staging& staging)
 {
-	gpu::TextureDesc desc;
+	gpu::TextureDesc& desc = staging.desc;
 	const u8* image_data = Texture::getLBCInfo(data, desc);
 	if (!image_data) {
 		logError("Corrupted or unsupported texture ", texture.getPath());
@@ -480,6 +522,31 @@ static bool loadLBC(Texture& texture, const u8* data, u32 size)
 
 	const u32 offset = u32(image_data - data);
 	if (offset >= size) return false;
+	staging.tail_first = ((const LBCHeader*)data)->flags & LBCHeader::TAIL_FIRST;
+
+	const u32 tail_mip = getTailMip(desc.width, desc.height, desc.mips);
+	const bool streamed = texture.renderer.getTextureStreamer().isEnabled()
+		&& texture.data_reference == 0
+		&& desc.depth == 1
+		&& !desc.is_cubemap
+		&& tail_mip > 0
+		&& !startsWith(texture.getPath(), ".lumix/asset_tiles/");
+	if (streamed) {
+		// upload only the tail, TextureStreamer loads the rest on demand
+		const u64 total_size = getMipChainSize(desc, 0);
+		if (total_size > size - offset) {
+			logError("Corrupted texture ", texture.getPath());
+			return false;
+		}
+		const u64 tail_size = getMipChainSize(desc, tail_mip);
+		const u64 tail_offset = staging.tail_first ? 0 : total_size - tail_size;
+		const Renderer::MemRef mem = texture.renderer.copy(image_data + tail_offset, (u32)tail_size);
+		staging.memory = mem.data;
+		staging.size = mem.size;
+		staging.first_mip = tail_mip;
+		staging.streamed = true;
+		return true;
+	}
 
 	if(texture.data_reference > 0) {
 		if (desc.format != gpu::TextureFormat::RGBA8) {
@@ -491,18 +558,10 @@ static bool loadLBC(Texture& texture, const u8* data, u32 size)
 		}
 	}
 
-	Renderer::MemRef mem = texture.renderer.copy(image_data, size - offset);
-	texture.handle = loadTexture(texture.renderer, desc, mem, texture.getGPUFlags(), texture.getPath().c_str());
-	if (texture.handle) {
-		texture.width = desc.width;
-		texture.height = desc.height;
-		texture.mips = desc.mips;
-		texture.depth = desc.depth;
-		texture.is_cubemap = desc.is_cubemap;
-		texture.format = desc.format;
-	}
-
-	return texture.handle;
+	const Renderer::MemRef mem = texture.renderer.copy(image_data, size - offset);
+	staging.memory = mem.data;
+	staging.size = mem.size;
+	return true;
 }
 
 gpu::TextureFlags Texture::getGPUFlags() const
@@ -531,20 +590,27 @@ gpu::TextureFlags Texture::getGPUFlags() const
 
 
 bool Texture::load(Span<const u8> mem)
+{
+	return prepare(mem) && finalize();
+}
+
+
+bool Texture::prepare(Span<const u8> mem)
 {
 	PROFILE_FUNCTION();
 	profiler::pushString(getPath().c_str());
 	
 	char ext[4] = {};
 	InputMemoryStream file(mem);
+	m_staging = Staging();
 	if (!file.read(ext, 3)) return false;
-	if (!file.read(&flags, sizeof(flags))) return false;
+	if (!file.read(&m_staging.flags, sizeof(m_staging.flags))) return false;
 
-	bool loaded = false;
+	bool prepared = false;
 
 	#ifdef LUMIX_BASIS_UNIVERSAL
 		if (equalIStrings(ext, "bsu")) {
-			loaded = loadBasisU(*this, file);
+			prepared = prepareBasisU(*this, file, m_staging);
 		} else 
 	#endif
 
@@ -554,31 +620,363 @@ bool Texture::load(Span<const u8> mem)
 	}
 	
 	if (equalIStrings(ext, "lbc")) {
-		loaded = loadLBC(*this, (const u8*)file.getData() + file.getPosition(), u32(file.remaining()));
+		prepared = prepareLBC(*this, (const u8*)file.getData() + file.getPosition(), u32(file.remaining()), m_staging);
 	}
 	else if (equalIStrings(ext, "raw")) {
-		loaded = loadRaw(*this, file, allocator);
+		prepared = prepareRaw(*this, file, m_staging);
 	}
 	else {
 		logWarning(getPath(), ": unknown extentions", ext);
 	}
-	if (!loaded) {
+	if (!prepared) {
+		logWarning("Error loading texture ", getPath());
+		freeStaging();
+		return false;
+	}
+
+	return true;
+}
+
+
+bool Texture::finalize()
+{
+	PROFILE_FUNCTION();
+	ASSERT(m_staging.memory);
+	flags = m_staging.flags;
+	const gpu::TextureDesc& desc = m_staging.desc;
+	Renderer::MemRef mem;
+	mem.data = m_staging.memory;
+	mem.size = m_staging.size;
+	mem.own = true;
+	// renderer frees the memory
+	m_staging.memory = nullptr;
+
+	if (m_staging.is_raw) {
+		handle = renderer.createTexture(desc.width
+			, desc.height
+			, desc.depth
+			, desc.format
+			, (getGPUFlags() & ~gpu::TextureFlags::SRGB) | m_staging.gpu_flags
+			, mem
+			, getPath().c_str());
+	}
+	else {
+		handle = loadTexture(renderer, getMipsDesc(desc, m_staging.first_mip), mem, getGPUFlags(), m_staging.tail_first, getPath().c_str());
+	}
+
+	if (!handle) {
 		logWarning("Error loading texture ", getPath());
 		return false;
 	}
 
+	width = desc.width;
+	height = desc.height;
+	depth = desc.depth;
+	mips = desc.mips;
+	is_cubemap = desc.is_cubemap;
+	format = desc.format;
+	resident_mip = m_staging.first_mip;
+	m_tail_first = m_staging.tail_first;
+	if (m_staging.streamed) renderer.getTextureStreamer().add(*this);
 	return true;
 }
 
 
+u64 Texture::getMipChainSize(u32 first_mip) const {
+	return Lumix::getMipChainSize(format, width, height, mips, first_mip);
+}
+
+
+void Texture::requestScreenSize(u32 screen_size_log2) {
+	if (m_streamer_idx < 0) return;
+
+	const i32 mip = maximum(i32(log2(maximum(width, height))) - i32(screen_size_log2), 0);
+	for (;;) {
+		const i32 prev = m_requested_mip;
+		if (prev <= mip) return;
+		if (m_requested_mip.compareExchange(mip, prev)) return;
+	}
+}
+
+
+void Texture::streamTo(u32 mip) {
+	ASSERT(!m_stream_op.isValid());
+	m_streaming_mip = mip;
+	FileSystem& fs = m_resource_manager.getOwner().getFileSystem();
+	const Path res_path(".lumix/resources/", m_path.getHash(), ".res");
+	m_stream_op = fs.getPreparedContent(res_path
+		, makeDelegate<&Texture::streamPrepare>(this)
+		, makeDelegate<&Texture::streamLoaded>(this)
+		, FileSystem::Priority::LOW);
+}
+
+
+// runs on a worker thread, decompresses only what's needed for mips from `m_streaming_mip`
+void Texture::streamPrepare(Span<const u8> mem) {
+	m_stream_staging = Staging();
+
+	const u64 header_size = 3 + sizeof(u32) + sizeof(LBCHeader);
+	const u64 chain_size = getMipChainSize(m_streaming_mip);
+	const u64 skipped_size = m_tail_first ? 0 : getMipChainSize(0) - chain_size;
+	const u64 needed_size = header_size + skipped_size + chain_size;
+	OutputMemoryStream content(allocator);
+	if (!decompressCompiledResource(mem, needed_size, content, allocator)) return;
+	if (content.size() != needed_size || memcmp(content.data(), "lbc", 3) != 0) return;
+
+	// the file could change since the texture was loaded
+	const LBCHeader* header = (const LBCHeader*)(content.data() + 3 + sizeof(u32));
+	if (header->magic != LBCHeader::MAGIC
+		|| header->w != width
+		|| header->h != height
+		|| header->mips != mips
+		|| header->format != format
+		|| bool(header->flags & LBCHeader::TAIL_FIRST) != m_tail_first)
+	{
+		return;
+	}
+
+	const Renderer::MemRef dst = renderer.copy(content.data() + header_size + skipped_size, (u32)chain_size);
+	m_stream_staging.memory = dst.data;
+	m_stream_staging.size = dst.size;
+	m_stream_staging.first_mip = m_streaming_mip;
+}
+
+
+void Texture::streamLoaded(Span<const u8> mem, bool success) {
+	m_stream_op = FileSystem::AsyncHandle::invalid();
+	const u32 prev_mip = resident_mip;
+	if (success && m_stream_staging.memory) {
+		gpu::TextureDesc desc;
+		desc.format = format;
+		desc.width = width;
+		desc.height = height;
+		desc.depth = 1;
+		desc.mips = mips;
+		desc.is_cubemap = false;
+
+		Renderer::MemRef mem;
+		mem.data = m_stream_staging.memory;
+		mem.size = m_stream_staging.size;
+		mem.own = true;
+		// renderer frees the memory
+		m_stream_staging.memory = nullptr;
+		
+		// bind groups reference `handle`, so we swap GPU objects instead of replacing the handle
+		const gpu::TextureHandle tmp = loadTexture(renderer, getMipsDesc(desc, m_streaming_mip), mem, getGPUFlags(), m_tail_first, getPath().c_str());
+		if (tmp) {
+			renderer.getDrawStream().swap(handle, tmp);
+			renderer.getEndFrameDrawStream().destroy(tmp);
+			resident_mip = m_streaming_mip;
+		}
+	}
+	else {
+		logWarning("Failed to stream texture ", getPath());
+	}
+	freeStaging(m_stream_staging);
+	if (resident_mip != prev_mip) updateMemorySize();
+	renderer.getTextureStreamer().onStreamed(*this, prev_mip);
+}
+
+
+// lower mips are already on GPU, so they are copied to a smaller texture instead of reading the file again
+bool Texture::evictTo(u32 mip) {
+	ASSERT(mip > resident_mip && mip < mips);
+	ASSERT(!m_stream_op.isValid());
+	const gpu::TextureHandle tmp = gpu::allocTextureHandle();
+	if (!tmp) return false;
+
+	gpu::TextureFlags gpu_flags = getGPUFlags();
+	if (mips - mip < 2) gpu_flags = gpu_flags | gpu::TextureFlags::NO_MIPS;
+	DrawStream& stream = renderer.getDrawStream();
+	stream.createTexture(tmp, maximum(width >> mip, 1), maximum(height >> mip, 1), 1, format, gpu_flags, getPath().c_str());
+	stream.copy(tmp, handle, 0, 0, mip - resident_mip);
+	// bind groups reference `handle`, see streamLoaded
+	stream.swap(handle, tmp);
+	renderer.getEndFrameDrawStream().destroy(tmp);
+	resident_mip = mip;
+	updateMemorySize();
+	return true;
+}
+
+
+void Texture::freeStaging()
+{
+	freeStaging(m_staging);
+}
+
+
+void Texture::freeStaging(Staging& staging)
+{
+	if (!staging.memory) return;
+
+	Renderer::MemRef mem;
+	mem.data = staging.memory;
+	mem.size = staging.size;
+	mem.own = true;
+	renderer.free(mem);
+	staging.memory = nullptr;
+}
+
+
 void Texture::unload()
 {
+	if (isStreamed()) renderer.getTextureStreamer().remove(*this);
+	if (m_stream_op.isValid()) {
+		m_resource_manager.getOwner().getFileSystem().cancel(m_stream_op);
+		m_stream_op = FileSystem::AsyncHandle::invalid();
+	}
+	freeStaging(m_stream_staging);
+	resident_mip = 0;
+
 	if (handle) {
 		renderer.getEndFrameDrawStream().destroy(handle);
 		handle = gpu::INVALID_TEXTURE;
 	}
+	// prepared, but not finalized
+	freeStaging();
 	data.clear();
 }
 
 
+TextureStreamer::TextureStreamer(IAllocator& allocator)
+	: m_textures(allocator)
+	, m_to_load(allocator)
+{}
+
+
+i64 TextureStreamer::getPendingBytes(const Texture& texture, u32 from_mip) {
+	return i64(texture.getMipChainSize(texture.m_streaming_mip)) - i64(texture.getMipChainSize(from_mip));
+}
+
+
+void TextureStreamer::add(Texture& texture) {
+	ASSERT(texture.m_streamer_idx < 0);
+	texture.m_streamer_idx = m_textures.size();
+	texture.m_requested_mip = Texture::NO_MIP_REQUEST;
+	texture.m_wanted_mip = texture.resident_mip;
+	texture.m_wanted_frame = m_frame;
+	texture.m_stream_requested = false;
+	m_textures.push(&texture);
+	m_stats.resident_bytes += texture.getMipChainSize(texture.resident_mip);
+}
+
+
+void TextureStreamer::remove(Texture& texture) {
+	ASSERT(m_textures[texture.m_streamer_idx] == &texture);
+	if (texture.m_stream_op.isValid()) {
+		--m_stats.pending;
+		m_pending_bytes -= getPendingBytes(texture, texture.resident_mip);
+	}
+	m_stats.resident_bytes -= texture.getMipChainSize(texture.resident_mip);
+	m_textures.back()->m_streamer_idx = texture.m_streamer_idx;
+	m_textures.swapAndPop(texture.m_streamer_idx);
+	texture.m_streamer_idx = -1;
+}
+
+
+void TextureStreamer::onStreamed(Texture& texture, u32 prev_mip) {
+	ASSERT(m_stats.pending > 0);
+	--m_stats.pending;
+	m_pending_bytes -= getPendingBytes(texture, prev_mip);
+	m_stats.resident_bytes -= texture.getMipChainSize(prev_mip);
+	m_stats.resident_bytes += texture.getMipChainSize(texture.resident_mip);
+}
+
+
+void TextureStreamer::update() {
+	PROFILE_FUNCTION();
+	// how long are mips kept after they are no longer requested
+	static constexpr u32 KEEP_FRAMES = 60;
+	static constexpr u32 MAX_PENDING = 4;
+	static constexpr u32 MAX_MIP_BIAS = 16;
+
+	++m_frame;
+	m_stats.textures = m_textures.size();
+
+	u64 requested_bytes = 0;
+	for (Texture* texture : m_textures) {
+		const u32 tail_mip = getTailMip(texture->width, texture->height, texture->mips);
+		const i32 requested = texture->m_requested_mip;
+		texture->m_requested_mip = Texture::NO_MIP_REQUEST;
+		if (requested != Texture::NO_MIP_REQUEST) {
+			const u32 mip = minimum(u32(requested), tail_mip);
+			texture->m_stream_requested = true;
+			// requests oscillate, e.g. with camera movement, keep the best mip for a while
+			if (mip <= texture->m_wanted_mip || m_frame - texture->m_wanted_frame > KEEP_FRAMES) {
+				texture->m_wanted_mip = mip;
+				texture->m_wanted_frame = m_frame;
+			}
+		}
+		else if (m_frame - texture->m_wanted_frame > KEEP_FRAMES) {
+			// textures used only by something else than meshes, e.g. UI, are never requested, we keep all their mips
+			texture->m_wanted_mip = texture->m_stream_requested ? tail_mip : 0;
+		}
+		requested_bytes += texture->getMipChainSize(texture->m_wanted_mip);
+	}
+	m_stats.requested_bytes = requested_bytes;
+
+	// over budget - drop the same number of mips from all requested textures
+	auto getTargetMip = [](const Texture& texture, u32 bias){
+		if (!texture.m_stream_requested) return texture.m_wanted_mip;
+		return minimum(texture.m_wanted_mip + bias, getTailMip(texture.width, texture.height, texture.mips));
+	};
+	u32 bias = 0;
+	u64 biased_bytes = requested_bytes;
+	while (biased_bytes > m_stats.budget && bias < MAX_MIP_BIAS) {
+		++bias;
+		biased_bytes = 0;
+		for (Texture* texture : m_textures) {
+			biased_bytes += texture->getMipChainSize(getTargetMip(*texture, bias));
+		}
+	}
+	m_stats.mip_bias = bias;
+
+	// evict first, so there's space for loading
+	for (Texture* texture : m_textures) {
+		if (texture->m_stream_op.isValid()) continue;
+		const u32 target = getTargetMip(*texture, bias);
+		if (target <= texture->resident_mip) continue;
+		
+		const u32 prev_mip = texture->resident_mip;
+		if (!texture->evictTo(target)) continue;
+		m_stats.resident_bytes -= texture->getMipChainSize(prev_mip);
+		m_stats.resident_bytes += texture->getMipChainSize(target);
+	}
+
+	m_to_load.clear();
+	for (Texture* texture : m_textures) {
+		if (texture->m_stream_op.isValid()) continue;
+		const u32 target = getTargetMip(*texture, bias);
+		if (target < texture->resident_mip) {
+			texture->m_streaming_mip = target;
+			m_to_load.push(texture);
+		}
+	}
+	// the most blurry first
+	qsort(m_to_load.begin(), m_to_load.size(), sizeof(m_to_load[0]), [](const void* a, const void* b){
+		const Texture* ta = *(const Texture**)a;
+		const Texture* tb = *(const Texture**)b;
+		const i32 da = i32(ta->resident_mip - ta->m_streaming_mip);
+		const i32 db = i32(tb->resident_mip - tb->m_streaming_mip);
+		return db - da;
+	});
+
+	for (Texture* texture : m_to_load) {
+		if (m_stats.pending >= MAX_PENDING) break;
+		const u32 target = texture->m_streaming_mip;
+		const i64 size = i64(texture->getMipChainSize(target)) - i64(texture->getMipChainSize(texture->resident_mip));
+		if (i64(m_stats.resident_bytes) + m_pending_bytes + size > i64(m_stats.budget)) continue;
+
+		texture->streamTo(target);
+		++m_stats.pending;
+		m_pending_bytes += size;
+	}
+
+	static const u32 resident_counter = profiler::createCounter("Texture streaming resident (MB)", 0);
+	static const u32 requested_counter = profiler::createCounter("Texture streaming requested (MB)", 0);
+	profiler::pushCounter(resident_counter, float(double(m_stats.resident_bytes) / (1024.0 * 1024.0)));
+	profiler::pushCounter(requested_counter, float(double(m_stats.requested_bytes) / (1024.0 * 1024.0)));
+}
+
+
 } // namespace Lumix
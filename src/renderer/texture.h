@@ -2,6 +2,8 @@
 
 
 #include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/atomic.h"
 #include "engine/resource.h"
 #include "engine/stream.h"
 #include "gpu/gpu.h"
@@ -34,7 +36,9 @@ struct LBCHeader {
 	static constexpr u32 MAGIC = 'LBC_';
 	enum Flags {
 		CUBEMAP = 1 << 0,
-		IS_3D = 1 << 1
+		IS_3D = 1 << 1,
+		// mips are stored from the smallest one, so low mips can be read without the rest, see TextureStreamer
+		TAIL_FIRST = 1 << 2
 	};
 	u32 magic = MAGIC;
 	u32 version = 0;
@@ -84,6 +88,8 @@ struct LUMIX_RENDERER_API Texture final : Resource {
 	Texture(const Path& path, ResourceManager& resource_manager, Renderer& renderer, IAllocator& allocator);
 
 	ResourceType getType() const override { return TYPE; }
+	u64 getCPUMemorySize() const override { return data.size(); }
+	u64 getGPUMemorySize() const override;
 
 	bool create(u32 w, u32 h, gpu::TextureFormat format, const void* data, u32 size);
 	void destroy();
@@ -98,6 +104,9 @@ struct LUMIX_RENDERER_API Texture final : Resource {
 	void setFlags(u32 flags);
 	bool getFlag(Flags flag);
 	void setFlag(Flags flag, bool value);
+	// called from render jobs, `screen_size_log2` is log2 of the size in pixels of an object using the texture
+	void requestScreenSize(u32 screen_size_log2);
+	bool isStreamed() const { return m_streamer_idx >= 0; }
 	u32 getPixelNearest(u32 x, u32 y) const;
 	u32 getPixel(float x, float y) const;
 	gpu::TextureFlags getGPUFlags() const;
@@ -114,6 +123,21 @@ struct LUMIX_RENDERER_API Texture final : Resource {
 
 	static const ResourceType TYPE;
 
+	// filled by `prepare` on a worker thread, used by `finalize` on the main thread
+	struct Staging {
+		gpu::TextureDesc desc;
+		u32 flags = 0;
+		gpu::TextureFlags gpu_flags = gpu::TextureFlags::NONE;
+		// allocated by renderer
+		void* memory = nullptr;
+		u32 size = 0;
+		bool is_raw = false;
+		bool tail_first = false;
+		// mips before `first_mip` are not in `memory`, see TextureStreamer
+		u32 first_mip = 0;
+		bool streamed = false;
+	};
+
 	u32 width;
 	u32 height;
 	u32 depth;
@@ -126,10 +150,82 @@ struct LUMIX_RENDERER_API Texture final : Resource {
 	u32 data_reference;
 	OutputMemoryStream data;
 	Renderer& renderer;
+	// first mip uploaded to GPU, mips before it are not resident, see TextureStreamer
+	u32 resident_mip = 0;
 
 private:
+	friend struct TextureStreamer;
+
+	static constexpr i32 NO_MIP_REQUEST = 0xff;
+
 	void unload() override;
 	bool load(Span<const u8> mem) override;
+	bool isPrepareSupported() const override { return true; }
+	bool prepare(Span<const u8> mem) override;
+	bool finalize() override;
+	void freeStaging();
+	void freeStaging(Staging& staging);
+	u64 getMipChainSize(u32 first_mip) const;
+	void streamTo(u32 mip);
+	bool evictTo(u32 mip);
+	void streamPrepare(Span<const u8> mem);
+	void streamLoaded(Span<const u8> mem, bool success);
+
+	Staging m_staging;
+	// mip streaming, written by TextureStreamer on the main thread, except `m_requested_mip`
+	i32 m_streamer_idx = -1;
+	bool m_tail_first = false;
+	AtomicI32 m_requested_mip = NO_MIP_REQUEST;
+	u32 m_wanted_mip = 0;
+	u32 m_wanted_frame = 0;
+	// requested at least once, textures nobody requests (e.g. UI) are streamed in fully
+	bool m_stream_requested = false;
+	u32 m_streaming_mip = 0;
+	FileSystem::AsyncHandle m_stream_op = FileSystem::AsyncHandle::invalid();
+	Staging m_stream_staging;
+};
+
+// keeps resident on GPU only mips of textures requested by renderer, see Texture::requestScreenSize
+// textures start with only small mips resident and high mips are loaded or evicted within a global memory budget
+struct LUMIX_RENDERER_API TextureStreamer {
+	// mips up to this size are always resident
+	static constexpr u32 TAIL_SIZE = 64;
+
+	struct Stats {
+		u64 budget = 0;
+		// GPU memory of mips of streamed textures
+		u64 resident_bytes = 0;
+		// GPU memory needed to have all requested mips resident
+		u64 requested_bytes = 0;
+		u32 textures = 0;
+		u32 pending = 0;
+		// added to requested mips to fit in the budget
+		u32 mip_bias = 0;
+	};
+
+	explicit TextureStreamer(IAllocator& allocator);
+
+	// 0 disables streaming, affects only textures loaded afterwards
+	void setBudget(u64 bytes) { m_stats.budget = bytes; }
+	bool isEnabled() const { return m_stats.budget != 0; }
+	const Stats& getStats() const { return m_stats; }
+	// called once per frame on the main thread
+	void update();
+
+private:
+	friend struct Texture;
+
+	void add(Texture& texture);
+	void remove(Texture& texture);
+	void onStreamed(Texture& texture, u32 prev_mip);
+	static i64 getPendingBytes(const Texture& texture, u32 from_mip);
+
+	Array<Texture*> m_textures;
+	Array<Texture*> m_to_load;
+	Stats m_stats;
+	u32 m_frame = 0;
+	// how much stream requests in flight add to resident_bytes once finished
+	i64 m_pending_bytes = 0;
 };
 
 